@@ -0,0 +1,89 @@
+
+#include <ipcmq_posixqueue.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bsl_cstdlib.h>
+#include <bsl_iostream.h>
+#include <bsl_string.h>
+
+#include <bsls_assert.h>
+#include <bsls_timeinterval.h>
+
+// This program compares two ways of interleaving non-blocking and blocking
+// operations on one 'ipcmq::PosixQueue':
+//
+//: o "toggle" switches the descriptor's mode with 'setNonBlocking' around
+//:   every operation, which is what 'QueueSender::trySend' and
+//:   'QueueReceiver::tryReceive' used to do.
+//: o "percall" uses 'trySend' and 'tryReceive', which are non-blocking for
+//:   one call without modifying the descriptor.
+//
+// Usage:
+//
+//     blockingmodebench <queue name> toggle|percall [<iterations>]
+//
+// Each iteration does one non-blocking send followed by one blocking receive.
+// Run it under 'strace -c -f' to see the system calls made per message; the
+// "toggle" mode makes one 'mq_setattr' per mode switch (it used to be an
+// 'mq_getattr' and an 'mq_setattr'), while "percall" makes none.
+
+using namespace BloombergLP;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 4) {
+        bsl::cerr << "usage: " << argv[0]
+                  << " <queue name> toggle|percall [<iterations>]\n";
+        return 1;
+    }
+
+    const bsl::string name       = argv[1];
+    const bsl::string mode       = argv[2];
+    const long        iterations = argc == 4 ? bsl::atol(argv[3]) : 1000000;
+    if (mode != "toggle" && mode != "percall") {
+        bsl::cerr << "unknown mode: " << mode << '\n';
+        return 1;
+    }
+
+    using namespace ipcmq::PosixQueueTypes;
+
+    ipcmq::PosixQueue queue;
+    if (const Open::Result rc =
+            queue.open(name, ReadWrite(), OpenOrCreate())) {
+        bsl::cerr << "Unable to open queue: " << ipcmq::description(rc)
+                  << '\n';
+        return 2;
+    }
+
+    const bool        toggle = mode == "toggle";
+    const bsl::string payload(64, 'x');
+    bsl::string       message;
+
+    const bsls::TimeInterval start = bdlt::CurrentTime::now();
+    for (long i = 0; i < iterations; ++i) {
+        int rc;
+        if (toggle) {
+            queue.setNonBlocking(true);
+            rc = queue.send(payload);
+            queue.setNonBlocking(false);
+        }
+        else {
+            rc = queue.trySend(payload);
+        }
+        BSLS_ASSERT(rc == 0);
+
+        rc = queue.receive(&message);
+        BSLS_ASSERT(rc == 0);
+    }
+    const bsls::TimeInterval elapsed = bdlt::CurrentTime::now() - start;
+
+    ipcmq::PosixQueue::unlink(name);
+
+    bsl::cout << "mode: " << mode << '\n'
+              << "iterations: " << iterations << '\n'
+              << "seconds: " << elapsed.totalSecondsAsDouble() << '\n'
+              << "messages/sec: "
+              << iterations / elapsed.totalSecondsAsDouble() << '\n'
+              << "mq_setattr calls/message: " << (toggle ? 2 : 0) << '\n';
+}
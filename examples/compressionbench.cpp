@@ -0,0 +1,134 @@
+
+#include <ipcmq_formatutil.h>
+
+#include <bsl_cstdlib.h>
+#include <bsl_iostream.h>
+#include <bsl_sstream.h>
+#include <bsl_string.h>
+
+#include <bsls_stopwatch.h>
+
+// This program measures the throughput of the compressed message format's
+// encoder and decoder, without a queue, for a payload of text that compresses
+// well and for a payload of random bytes that does not. Each decoded payload
+// is checked against the original.
+//
+// Usage:
+//
+//     compressionbench [<payload bytes> [<max message size> [<iterations>]]]
+
+using namespace BloombergLP;
+
+namespace {
+
+bsl::string makeText(bsl::size_t length)
+    // Return a payload of the specified 'length' resembling a series of JSON
+    // records.
+{
+    bsl::ostringstream stream;
+    for (unsigned i = 0; stream.tellp() < long(length); ++i) {
+        stream << "{\"id\":" << i << ",\"symbol\":\"IBM\",\"price\":"
+               << bsl::rand() % 100000 << ",\"side\":\""
+               << (i % 3 ? "BUY" : "SELL") << "\"},";
+    }
+
+    return stream.str().substr(0, length);
+}
+
+bsl::string makeRandom(bsl::size_t length)
+    // Return a payload of the specified 'length' random bytes.
+{
+    bsl::string payload(length, '\0');
+    for (bsl::size_t i = 0; i < length; ++i) {
+        payload[i] = char(bsl::rand());
+    }
+
+    return payload;
+}
+
+int measure(const char         *name,
+            const bsl::string&  payload,
+            long                maxMessageSize,
+            int                 iterations)
+    // Encode and decode the specified 'payload' the specified 'iterations'
+    // times, as for a queue having the specified 'maxMessageSize', and print
+    // the results labeled by the specified 'name'. Return zero on success or
+    // a nonzero value otherwise.
+{
+    bsls::Stopwatch encodeStopwatch;
+    bsls::Stopwatch decodeStopwatch;
+    bsl::string     buffer;
+    bsl::string     decoded;
+    bsl::size_t     encodedLength = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+        bslstl::StringRef message(payload);
+
+        encodeStopwatch.start();
+        if (const int rc = ipcmq::FormatUtil::encodeCompressed(
+                maxMessageSize, &message, &buffer)) {
+            bsl::cerr << "Error: " << ipcmq::FormatUtil::description(rc)
+                      << '\n';
+            return 1;                                                 // RETURN
+        }
+        encodeStopwatch.stop();
+
+        encodedLength = message.length();
+        decoded.assign(message.data(), message.length());
+
+        decodeStopwatch.start();
+        if (const int rc = ipcmq::FormatUtil::decodeCompressed(&decoded)) {
+            bsl::cerr << "Error: " << ipcmq::FormatUtil::description(rc)
+                      << '\n';
+            return 2;                                                 // RETURN
+        }
+        decodeStopwatch.stop();
+
+        if (decoded != payload) {
+            bsl::cerr << "Error: the decoded payload differs.\n";
+            return 3;                                                 // RETURN
+        }
+    }
+
+    const double megabytes = double(payload.size()) * iterations / 1e6;
+
+    bsl::cout << name << ":\n"
+              << "    encoded bytes: " << encodedLength << '\n'
+              << "    stays in the queue: "
+              << (long(encodedLength) <= maxMessageSize) << '\n'
+              << "    encode (MB/s): "
+              << megabytes / encodeStopwatch.elapsedTime() << '\n'
+              << "    decode (MB/s): "
+              << megabytes / decodeStopwatch.elapsedTime() << '\n';
+    return 0;
+}
+
+}  // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc > 4) {
+        bsl::cerr << "usage: " << argv[0]
+                  << " [<payload bytes> [<max message size>"
+                     " [<iterations>]]]\n";
+        return 1;
+    }
+
+    const long length         = argc > 1 ? bsl::atol(argv[1]) : 16 * 1024;
+    const long maxMessageSize = argc > 2 ? bsl::atol(argv[2]) : 8192;
+    const int  iterations     = argc > 3 ? bsl::atoi(argv[3]) : 10000;
+
+    bsl::cout << "payload bytes: " << length << '\n'
+              << "max message size: " << maxMessageSize << '\n'
+              << "iterations: " << iterations << '\n';
+
+    if (measure("text", makeText(length), maxMessageSize, iterations)) {
+        return 2;
+    }
+
+    // A random payload larger than a message goes to a temporary file, which
+    // is deleted as it is decoded.
+    if (measure("random", makeRandom(length), maxMessageSize, iterations)) {
+        return 3;
+    }
+}
@@ -0,0 +1,117 @@
+
+#include <ipcmq_consumer.h>
+#include <ipcmq_format.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuesender.h>
+
+#include <bdlf_bind.h>
+#include <bdlf_placeholder.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bslmt_threadutil.h>
+
+#include <bsl_cstdlib.h>
+#include <bsl_iostream.h>
+#include <bsl_string.h>
+
+#include <bsls_assert.h>
+#include <bsls_atomic.h>
+#include <bsls_timeinterval.h>
+
+// This program measures the throughput of an 'ipcmq::Consumer' configured
+// with a given number of receiving threads and worker threads, where the
+// callback simulates a handler that takes a fixed amount of time per message.
+//
+// Usage:
+//
+//     consumerbench <queue name> <receivers> <workers> [<messages> [<work>]]
+//
+// where <work> is the number of microseconds each callback spends busy
+// (default 50). To see how throughput scales with cores, run for instance
+//
+//     for n in 1 2 4 8 16; do consumerbench /bench 1 $n; done
+//     for n in 1 2 4 8 16; do consumerbench /bench $n 0; done
+//
+// on an otherwise idle machine, optionally pinning with 'taskset -c 0-$n'.
+
+using namespace BloombergLP;
+
+namespace {
+
+bsls::AtomicInt64 numProcessed(0);
+
+void spinFor(const bsls::TimeInterval& duration)
+{
+    const bsls::TimeInterval deadline = bdlt::CurrentTime::now() + duration;
+    while (bdlt::CurrentTime::now() < deadline) {
+    }
+}
+
+void handleMessage(const bsls::TimeInterval *work, bsl::string *, unsigned)
+{
+    spinFor(*work);
+    ++numProcessed;
+}
+
+}  // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4 || argc > 6) {
+        bsl::cerr << "usage: " << argv[0]
+                  << " <queue name> <receivers> <workers> [<messages> "
+                     "[<work>]]\n";
+        return 1;
+    }
+
+    const bsl::string name         = argv[1];
+    const int         numReceivers = bsl::atoi(argv[2]);
+    const int         numWorkers   = bsl::atoi(argv[3]);
+    const long        numMessages  = argc > 4 ? bsl::atol(argv[4]) : 100000;
+    const long        workMicros   = argc > 5 ? bsl::atol(argv[5]) : 50;
+    const bsls::TimeInterval work(0, workMicros * 1000);
+
+    ipcmq::QueueSender sender(name, ipcmq::Format::e_RAW);
+    if (!sender) {
+        bsl::cerr << "Unable to open queue: "
+                  << sender.description(sender.openResult()) << '\n';
+        return 2;
+    }
+
+    ipcmq::Consumer::Options options;
+    options.d_numReceiverThreads = numReceivers;
+    options.d_numWorkerThreads   = numWorkers;
+
+    using namespace bdlf::PlaceHolders;
+    const bsl::string        payload(64, 'x');
+    const bsls::TimeInterval start = bdlt::CurrentTime::now();
+    {
+        ipcmq::Consumer consumer(
+            name,
+            ipcmq::Format::e_RAW,
+            bdlf::BindUtil::bind(&handleMessage, &work, _1, _2),
+            options);
+
+        for (long i = 0; i < numMessages; ++i) {
+            const int rc = sender.send(payload);
+            BSLS_ASSERT(rc == 0);
+            (void)rc;
+        }
+
+        while (numProcessed.load() < numMessages) {
+            bslmt::ThreadUtil::microSleep(1000);
+        }
+    }
+    const bsls::TimeInterval elapsed = bdlt::CurrentTime::now() - start;
+
+    ipcmq::PosixQueue::unlink(name);
+
+    bsl::cout << "receivers: " << numReceivers << '\n'
+              << "workers: " << numWorkers << '\n'
+              << "messages: " << numMessages << '\n'
+              << "work (us): " << work.totalMicroseconds() << '\n'
+              << "seconds: " << elapsed.totalSecondsAsDouble() << '\n'
+              << "messages/sec: "
+              << numMessages / elapsed.totalSecondsAsDouble() << '\n';
+}
@@ -0,0 +1,147 @@
+#include <ipcmq_consumer.h>
+#include <ipcmq_format.h>
+#include <ipcmq_messagepool.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuesender.h>
+
+#include <bdlf_bind.h>
+#include <bdlf_placeholder.h>
+
+#include <bslmf_movableref.h>
+
+#include <bslmt_lockguard.h>
+#include <bslmt_mutex.h>
+#include <bslmt_threadutil.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_cstdlib.h>
+#include <bsl_deque.h>
+#include <bsl_iostream.h>
+#include <bsl_string.h>
+
+#include <bsls_assert.h>
+#include <bsls_atomic.h>
+#include <bsls_types.h>
+
+// This program shows that an 'ipcmq::Consumer' hands messages to the
+// application without copying them, and that in steady state it allocates no
+// memory for them. Its callback keeps the most recent <kept> messages by
+// moving their handles into a queue, releasing the oldest as it goes, as an
+// application that processes messages later would. The program sends
+// <messages> messages of <size> bytes, twice, and prints the counts of the
+// consumer's message pool after each round. The first round creates the
+// buffers and grows them; the second allocates nothing.
+//
+// Usage:
+//
+//     consumerhandoff <queue name> [<messages> [<kept> [<size>]]]
+
+using namespace BloombergLP;
+
+namespace {
+
+class Keeper {
+    // This class keeps the handles of the most recent messages delivered to
+    // it, up to a maximum.
+
+    // DATA
+    bslmt::Mutex                     d_mutex;
+    bsl::deque<ipcmq::MessageHandle> d_kept;
+    bsl::size_t                      d_maxKept;
+    bsls::AtomicInt64                d_numReceived;
+
+  public:
+    // CREATORS
+    explicit Keeper(bsl::size_t maxKept)
+    : d_maxKept(maxKept)
+    , d_numReceived(0)
+    {
+    }
+
+    // MANIPULATORS
+    void handle(ipcmq::MessageHandle& message, unsigned)
+        // Keep the specified 'message' without copying it, and release the
+        // oldest message kept if there are too many.
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+        d_kept.push_back(bslmf::MovableRefUtil::move(message));
+        if (d_kept.size() > d_maxKept) {
+            d_kept.pop_front();
+        }
+        ++d_numReceived;
+    }
+
+    void clear()
+        // Release every message kept.
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+        d_kept.clear();
+    }
+
+    // ACCESSORS
+    bsls::Types::Int64 numReceived() const
+        // Return the number of messages delivered to this object.
+    {
+        return d_numReceived.load();
+    }
+};
+
+void printPool(int round, const ipcmq::MessagePool& pool)
+    // Print the counts of the specified 'pool' after the specified 'round'.
+{
+    bsl::cout << "after round " << round << ": buffers " << pool.numBuffers()
+              << ", in use " << pool.numBuffersInUse()
+              << ", bytes allocated " << pool.numBytesAllocated()
+              << ", bytes in use " << pool.numBytesInUse() << '\n';
+}
+
+}  // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 5) {
+        bsl::cerr << "usage: " << argv[0]
+                  << " <queue name> [<messages> [<kept> [<size>]]]\n";
+        return 1;
+    }
+
+    const bsl::string name        = argv[1];
+    const long        numMessages = argc > 2 ? bsl::atol(argv[2]) : 100000;
+    const int         numKept     = argc > 3 ? bsl::atoi(argv[3]) : 100;
+    const int         size        = argc > 4 ? bsl::atoi(argv[4]) : 1024;
+
+    ipcmq::QueueSender sender(name, ipcmq::Format::e_RAW);
+    if (!sender) {
+        bsl::cerr << "Unable to open queue: "
+                  << sender.description(sender.openResult()) << '\n';
+        return 2;
+    }
+
+    using namespace bdlf::PlaceHolders;
+    const bsl::string payload(size, 'x');
+    Keeper            keeper(numKept);
+    {
+        ipcmq::Consumer consumer(
+            name,
+            ipcmq::Format::e_RAW,
+            bdlf::BindUtil::bind(&Keeper::handle, &keeper, _1, _2));
+
+        for (int round = 1; round <= 2; ++round) {
+            for (long i = 0; i < numMessages; ++i) {
+                const int rc = sender.send(payload);
+                BSLS_ASSERT(rc == 0);
+                (void)rc;
+            }
+
+            while (keeper.numReceived() < round * numMessages) {
+                bslmt::ThreadUtil::microSleep(1000);
+            }
+            printPool(round, consumer.messagePool());
+        }
+
+        // Every handle must be released before the consumer is destroyed.
+        keeper.clear();
+    }
+
+    ipcmq::PosixQueue::unlink(name);
+}
@@ -0,0 +1,78 @@
+
+#include <ipcmq_consumer.h>
+#include <ipcmq_format.h>
+#include <ipcmq_posixqueue.h>
+
+#include <bslmt_threadutil.h>
+
+#include <bsl_cstdlib.h>
+#include <bsl_iostream.h>
+#include <bsl_string.h>
+
+#include <bsls_stopwatch.h>
+
+// This program measures how long it takes to destroy an idle
+// 'ipcmq::Consumer', which is how long its receiving threads take to notice
+// that they should stop.
+//
+// Usage:
+//
+//     consumershutdown <queue name> [<receivers> [<iterations>]]
+//
+// Run it under 'perf stat' or 'strace -c -f' to see that an idle consumer
+// makes no system calls between starting and stopping.
+
+using namespace BloombergLP;
+
+namespace {
+
+void ignoreMessage(bsl::string *, unsigned)
+{
+}
+
+}  // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4) {
+        bsl::cerr << "usage: " << argv[0]
+                  << " <queue name> [<receivers> [<iterations>]]\n";
+        return 1;
+    }
+
+    const bsl::string name       = argv[1];
+    const int         receivers  = argc > 2 ? bsl::atoi(argv[2]) : 1;
+    const int         iterations = argc > 3 ? bsl::atoi(argv[3]) : 100;
+
+    ipcmq::Consumer::Options options;
+    options.d_numReceiverThreads = receivers;
+
+    double totalSeconds = 0;
+    double maxSeconds   = 0;
+    for (int i = 0; i < iterations; ++i) {
+        ipcmq::Consumer *consumer = new ipcmq::Consumer(
+                   name, ipcmq::Format::e_RAW, &ignoreMessage, options);
+
+        // Give the receiving threads time to block.
+        bslmt::ThreadUtil::microSleep(10 * 1000);
+
+        bsls::Stopwatch stopwatch;
+        stopwatch.start();
+        delete consumer;
+        stopwatch.stop();
+
+        const double seconds = stopwatch.elapsedTime();
+        totalSeconds += seconds;
+        if (seconds > maxSeconds) {
+            maxSeconds = seconds;
+        }
+    }
+
+    ipcmq::PosixQueue::unlink(name);
+
+    bsl::cout << "receivers: " << receivers << '\n'
+              << "iterations: " << iterations << '\n'
+              << "mean shutdown (us): " << totalSeconds / iterations * 1e6
+              << '\n'
+              << "max shutdown (us): " << maxSeconds * 1e6 << '\n';
+}
@@ -0,0 +1,111 @@
+
+#include <ipcmq_format.h>
+#include <ipcmq_payload.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuereceiver.h>
+#include <ipcmq_queuesender.h>
+
+#include <bsl_cstdlib.h>
+#include <bsl_iostream.h>
+#include <bsl_string.h>
+
+#include <bsls_stopwatch.h>
+
+// This program compares receiving a large extended format message into a
+// 'bsl::string', which reads the external file into memory, with receiving it
+// into an 'ipcmq::Payload', which maps the file into memory. Each payload is
+// summed after it is received, so that both ways touch every byte.
+//
+// Usage:
+//
+//     largepayload <queue name> [<megabytes> [<iterations>]]
+//
+// Run it under '/usr/bin/time -v' with each half commented out to compare
+// peak resident memory.
+
+using namespace BloombergLP;
+
+namespace {
+
+unsigned checksum(const char *data, bsl::size_t length)
+{
+    unsigned sum = 0;
+    for (bsl::size_t i = 0; i < length; ++i) {
+        sum += static_cast<unsigned char>(data[i]);
+    }
+    return sum;
+}
+
+}  // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4) {
+        bsl::cerr << "usage: " << argv[0]
+                  << " <queue name> [<megabytes> [<iterations>]]\n";
+        return 1;
+    }
+
+    const bsl::string name       = argv[1];
+    const long        megabytes  = argc > 2 ? bsl::atol(argv[2]) : 500;
+    const int         iterations = argc > 3 ? bsl::atoi(argv[3]) : 3;
+
+    const bsl::string message(megabytes * 1024 * 1024, 'x');
+
+    ipcmq::QueueSender   sender(name, ipcmq::Format::e_EXTENDED);
+    ipcmq::QueueReceiver receiver(name, ipcmq::Format::e_EXTENDED);
+    if (!sender || !receiver) {
+        bsl::cerr << "Unable to open queue.\n";
+        return 2;
+    }
+
+    double   stringSeconds  = 0;
+    double   payloadSeconds = 0;
+    unsigned sum            = 0;
+    for (int i = 0; i < iterations; ++i) {
+        bsls::Stopwatch stopwatch;
+
+        if (const int rc = sender.send(message)) {
+            bsl::cerr << "Error: " << sender.description(rc) << '\n';
+            return 3;
+        }
+        {
+            stopwatch.start();
+            bsl::string received;
+            if (const int rc = receiver.receive(&received)) {
+                bsl::cerr << "Error: " << receiver.description(rc) << '\n';
+                return 4;
+            }
+            sum += checksum(received.data(), received.size());
+            stopwatch.stop();
+            stringSeconds += stopwatch.elapsedTime();
+        }
+
+        if (const int rc = sender.send(message)) {
+            bsl::cerr << "Error: " << sender.description(rc) << '\n';
+            return 3;
+        }
+        {
+            stopwatch.reset();
+            stopwatch.start();
+            ipcmq::Payload received;
+            if (const int rc = receiver.receive(&received)) {
+                bsl::cerr << "Error: " << receiver.description(rc) << '\n';
+                return 4;
+            }
+            sum += checksum(received.data(), received.length());
+            stopwatch.stop();
+            payloadSeconds += stopwatch.elapsedTime();
+        }
+    }
+
+    ipcmq::PosixQueue::unlink(name);
+
+    bsl::cout << "megabytes: " << megabytes << '\n'
+              << "iterations: " << iterations << '\n'
+              << "checksum: " << sum << '\n'
+              << "mean bsl::string receive (s): "
+              << stringSeconds / iterations << '\n'
+              << "mean ipcmq::Payload receive (s): "
+              << payloadSeconds / iterations << '\n';
+}
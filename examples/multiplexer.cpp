@@ -0,0 +1,54 @@
+
+#include <ipcmq_format.h>
+#include <ipcmq_multiplexer.h>
+#include <ipcmq_posixqueue.h>
+
+#include <bdlf_bind.h>
+#include <bdlf_placeholder.h>
+
+#include <bsl_iostream.h>
+#include <bsl_memory.h>
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+using namespace BloombergLP;
+
+void handleMessage(const bsl::string *queueName,
+                   bsl::string       *message,
+                   unsigned           priority)
+{
+    bsl::cout << "Received a priority " << priority << " message from "
+              << *queueName << ":\n"
+              << *message << '\n';
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace bdlf::PlaceHolders;
+    using namespace ipcmq::PosixQueueTypes;
+
+    // Open each queue named on the command line and receive from all of them
+    // on one thread.
+    ipcmq::Multiplexer                               multiplexer;
+    bsl::vector<bsl::shared_ptr<ipcmq::PosixQueue> > queues;
+    for (const char *const *arg = argv + 1; *arg; ++arg) {
+        queues.push_back(bsl::make_shared<ipcmq::PosixQueue>());
+        ipcmq::PosixQueue& queue = *queues.back();
+        if (const Open::Result rc =
+                queue.open(*arg, ReadOnly(), OpenOrCreate())) {
+            bsl::cerr << "Unable to open " << *arg << ": "
+                      << ipcmq::description(rc) << '\n';
+            return 1;
+        }
+
+        multiplexer.add(&queue,
+                        ipcmq::Format::e_EXTENDED,
+                        bdlf::BindUtil::bind(
+                            &handleMessage, &queue.name(), _1, _2));
+    }
+
+    multiplexer.start();
+
+    bsl::cerr << "Enter any text to exit.\n";
+    bsl::cin.get();
+}
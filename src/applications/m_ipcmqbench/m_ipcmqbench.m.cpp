@@ -0,0 +1,418 @@
+#include <m_ipcmqbench_report.h>
+#include <m_ipcmqbench_runner.h>
+#include <m_ipcmqbench_scenario.h>
+
+#include <ipcmq_format.h>
+
+#include <bsls_types.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_cctype.h>
+#include <bsl_cstddef.h>
+#include <bsl_cstdlib.h>
+#include <bsl_fstream.h>
+#include <bsl_iostream.h>
+#include <bsl_sstream.h>
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <unistd.h>
+
+// This program measures the throughput and latency of 'ipcmq' across a
+// matrix of scenarios, and prints the outcome of each as JSON (see
+// 'm_ipcmqbench_report'). Every option takes a comma separated list, and
+// each dimension that is not specified takes all of the values shown as its
+// default.
+//
+// Usage:
+//
+//     m_ipcmqbench [--api=POSIX_QUEUE,QUEUE_SENDER,QUEUE,CONSUMER,
+//                        SPINNING_CONSUMER,PINNED_CONSUMER,SHM_MPMC]
+//                  [--format=RAW,EXTENDED]
+//                  [--size=16,1K,64K,1M,100M]
+//                  [--mode=BLOCKING,TIMED,TRY]
+//                  [--topology=1:1,4:1,1:4]
+//                  [--execution=THREADS,PROCESSES]
+//                  [--priorities=1,4]
+//                  [--messages=100000]
+//                  [--bytes=64M]
+//                  [--output=<file>]
+//
+// where a topology is a number of senders and a number of receivers, and
+// each sender sends '--messages' messages, or fewer if they would add up to
+// more than '--bytes' bytes. Names are not case sensitive, sizes may have a
+// 'K', 'M', or 'G' suffix, and 'ipcmq::PosixQueue' and
+// 'ipcmq::ShmMpmcQueue' are measured only with the raw format, which is the
+// only one they have. The JSON is printed to standard output unless
+// '--output' is specified, and progress is printed to standard error. For
+// example, to compare the formats for large payloads using threads:
+//
+//     m_ipcmqbench --api=queue_sender --format=raw,extended,compressed \
+//                  --size=64K,1M --execution=threads --output=large.json
+//
+// or to compare the contention of the shared memory queue with that of the
+// message queue, from 1 to 32 processes on each side:
+//
+//     m_ipcmqbench --api=posix_queue,shm_mpmc --size=64 --mode=blocking \
+//                  --topology=1:1,2:2,4:4,8:8,16:16,32:32,32:1,1:32    \
+//                  --execution=processes --priorities=1
+//
+// or to see what polling before blocking does to the latency of a consumer,
+// and what it costs in CPU time:
+//
+//     m_ipcmqbench --api=consumer,spinning_consumer --format=raw --size=64 \
+//                  --topology=1:1 --execution=processes --priorities=1
+//
+// or to see what placing the consumer's threads does to the tail of the
+// latency, the jitter, by comparing the "p99" and "p999" of each (run with
+// 'CAP_SYS_NICE' for real-time scheduling, or see the warnings logged):
+//
+//     m_ipcmqbench --api=consumer,pinned_consumer --format=raw --size=64 \
+//                  --topology=1:1 --execution=processes --priorities=1
+
+using namespace BloombergLP;
+using namespace BloombergLP::m_ipcmqbench;
+
+namespace {
+
+struct Topology {
+    // This 'struct' is a number of senders and a number of receivers.
+
+    // DATA
+    int d_numSenders;
+    int d_numReceivers;
+};
+
+struct Options {
+    // This 'struct' holds the parsed command line.
+
+    // DATA
+    bsl::vector<Api>           d_apis;
+    bsl::vector<ipcmq::Format> d_formats;
+    bsl::vector<bsl::size_t>   d_sizes;
+    bsl::vector<Mode>          d_modes;
+    bsl::vector<Topology>      d_topologies;
+    bsl::vector<Execution>     d_executions;
+    bsl::vector<int>           d_priorities;
+    long                       d_numMessages;
+    bsls::Types::Int64         d_numBytes;
+    bsl::string                d_output;
+};
+
+bsl::vector<bsl::string> split(const bsl::string& list)
+    // Return the comma separated elements of the specified 'list'.
+{
+    bsl::vector<bsl::string> result;
+    bsl::size_t              begin = 0;
+    for (;;) {
+        const bsl::size_t end = list.find(',', begin);
+        result.push_back(list.substr(begin, end - begin));
+        if (end == bsl::string::npos) {
+            return result;                                            // RETURN
+        }
+        begin = end + 1;
+    }
+}
+
+template <typename ENUM>
+int parseEnums(bsl::vector<ENUM> *result, const bsl::string& list)
+    // Load into the specified 'result' the enumerators named in the
+    // specified comma separated 'list', ignoring case and treating '-' as
+    // '_'. Return zero on success or a nonzero value otherwise.
+{
+    const bsl::vector<bsl::string> names = split(list);
+
+    result->clear();
+    for (bsl::size_t i = 0; i < names.size(); ++i) {
+        bsl::string name = names[i];
+        for (bsl::size_t j = 0; j < name.size(); ++j) {
+            name[j] = name[j] == '-'
+                          ? '_'
+                          : char(bsl::toupper((unsigned char)name[j]));
+        }
+
+        ENUM value;
+        if (value.fromString(name)) {
+            return 1;                                                 // RETURN
+        }
+        result->push_back(value);
+    }
+    return 0;
+}
+
+int parseNumber(bsls::Types::Int64 *result, const bsl::string& text)
+    // Load into the specified 'result' the positive number in the specified
+    // 'text', which may have a 'K', 'M', or 'G' suffix denoting a power of
+    // 1024. Return zero on success or a nonzero value otherwise.
+{
+    char                     *end;
+    const bsls::Types::Int64  value = bsl::strtoll(text.c_str(), &end, 10);
+    if (end == text.c_str() || value <= 0) {
+        return 1;                                                     // RETURN
+    }
+
+    int shift = 0;
+    switch (bsl::toupper((unsigned char)*end)) {
+      case '\0': break;
+      case 'K': shift = 10; ++end; break;
+      case 'M': shift = 20; ++end; break;
+      case 'G': shift = 30; ++end; break;
+      default: return 1;                                              // RETURN
+    }
+
+    *result = value << shift;
+    return *end != '\0';
+}
+
+template <typename NUMBER>
+int parseNumbers(bsl::vector<NUMBER> *result, const bsl::string& list)
+    // Load into the specified 'result' the numbers in the specified comma
+    // separated 'list' (see 'parseNumber'). Return zero on success or a
+    // nonzero value otherwise.
+{
+    const bsl::vector<bsl::string> texts = split(list);
+
+    result->clear();
+    for (bsl::size_t i = 0; i < texts.size(); ++i) {
+        bsls::Types::Int64 value;
+        if (parseNumber(&value, texts[i])) {
+            return 1;                                                 // RETURN
+        }
+        result->push_back(NUMBER(value));
+    }
+    return 0;
+}
+
+int parseTopologies(bsl::vector<Topology> *result, const bsl::string& list)
+    // Load into the specified 'result' the topologies in the specified comma
+    // separated 'list', each of the form "<senders>:<receivers>". Return
+    // zero on success or a nonzero value otherwise.
+{
+    const bsl::vector<bsl::string> texts = split(list);
+
+    result->clear();
+    for (bsl::size_t i = 0; i < texts.size(); ++i) {
+        const bsl::size_t colon = texts[i].find(':');
+        if (colon == bsl::string::npos) {
+            return 1;                                                 // RETURN
+        }
+
+        bsls::Types::Int64 numSenders;
+        bsls::Types::Int64 numReceivers;
+        if (parseNumber(&numSenders, texts[i].substr(0, colon)) ||
+            parseNumber(&numReceivers, texts[i].substr(colon + 1))) {
+            return 1;                                                 // RETURN
+        }
+
+        const Topology topology = { int(numSenders), int(numReceivers) };
+        result->push_back(topology);
+    }
+    return 0;
+}
+
+int parseOptions(Options *options, int argc, char *argv[])
+    // Load into the specified 'options' the command line having the
+    // specified 'argc' arguments at the specified 'argv'. Return zero on
+    // success or a nonzero value otherwise.
+{
+    for (int i = 1; i < argc; ++i) {
+        const bsl::string argument = argv[i];
+        const bsl::size_t equals   = argument.find('=');
+        if (argument.compare(0, 2, "--") || equals == bsl::string::npos) {
+            return 1;                                                 // RETURN
+        }
+
+        const bsl::string key   = argument.substr(2, equals - 2);
+        const bsl::string value = argument.substr(equals + 1);
+
+        bsls::Types::Int64 number;
+        int                rc;
+        if (key == "api") {
+            rc = parseEnums(&options->d_apis, value);
+        }
+        else if (key == "format") {
+            rc = parseEnums(&options->d_formats, value);
+        }
+        else if (key == "size") {
+            rc = parseNumbers(&options->d_sizes, value);
+        }
+        else if (key == "mode") {
+            rc = parseEnums(&options->d_modes, value);
+        }
+        else if (key == "topology") {
+            rc = parseTopologies(&options->d_topologies, value);
+        }
+        else if (key == "execution") {
+            rc = parseEnums(&options->d_executions, value);
+        }
+        else if (key == "priorities") {
+            rc = parseNumbers(&options->d_priorities, value);
+        }
+        else if (key == "messages") {
+            rc = parseNumber(&number, value);
+            options->d_numMessages = long(number);
+        }
+        else if (key == "bytes") {
+            rc = parseNumber(&number, value);
+            options->d_numBytes = number;
+        }
+        else if (key == "output") {
+            rc = value.empty();
+            options->d_output = value;
+        }
+        else {
+            rc = 1;
+        }
+
+        if (rc) {
+            bsl::cerr << "Invalid argument: " << argument << '\n';
+            return rc;                                                // RETURN
+        }
+    }
+    return 0;
+}
+
+void setDefaults(Options *options)
+    // Load into the specified 'options' the defaults described at the top
+    // of this file.
+{
+    const char *const apis       = "POSIX_QUEUE,QUEUE_SENDER,QUEUE,CONSUMER,"
+                                   "SPINNING_CONSUMER,PINNED_CONSUMER,"
+                                   "SHM_MPMC";
+    const char *const modes      = "BLOCKING,TIMED,TRY";
+    const char *const executions = "THREADS,PROCESSES";
+
+    parseEnums(&options->d_apis, apis);
+    parseEnums(&options->d_formats, "RAW,EXTENDED");
+    parseNumbers(&options->d_sizes, "16,1K,64K,1M,100M");
+    parseEnums(&options->d_modes, modes);
+    parseTopologies(&options->d_topologies, "1:1,4:1,1:4");
+    parseEnums(&options->d_executions, executions);
+    parseNumbers(&options->d_priorities, "1,4");
+    options->d_numMessages = 100000;
+    options->d_numBytes    = bsls::Types::Int64(64) << 20;
+}
+
+template <typename FIELD, typename VALUE>
+void expand(bsl::vector<Scenario>    *scenarios,
+            FIELD Scenario::         *field,
+            const bsl::vector<VALUE>& values)
+    // Replace each of the specified 'scenarios' with a copy of it for each of
+    // the specified 'values', having that value as its specified 'field'.
+{
+    bsl::vector<Scenario> result;
+    for (bsl::size_t i = 0; i < scenarios->size(); ++i) {
+        for (bsl::size_t j = 0; j < values.size(); ++j) {
+            result.push_back((*scenarios)[i]);
+            result.back().*field = values[j];
+        }
+    }
+    scenarios->swap(result);
+}
+
+void makeScenarios(bsl::vector<Scenario> *scenarios, const Options& options)
+    // Load into the specified 'scenarios' every combination of the values
+    // in the specified 'options'.
+{
+    scenarios->assign(1, Scenario());
+
+    expand(scenarios, &Scenario::d_api, options.d_apis);
+    expand(scenarios, &Scenario::d_format, options.d_formats);
+
+    // 'ipcmq::PosixQueue' and 'ipcmq::ShmMpmcQueue' have only the raw
+    // format, so each is measured once.
+    bsl::vector<Scenario> result;
+    for (bsl::size_t i = 0; i < scenarios->size(); ++i) {
+        Scenario& scenario = (*scenarios)[i];
+        if (scenario.d_api != Api::e_POSIX_QUEUE &&
+            scenario.d_api != Api::e_SHM_MPMC) {
+            result.push_back(scenario);
+        }
+        else if (scenario.d_format == options.d_formats.front()) {
+            result.push_back(scenario);
+            result.back().d_format = ipcmq::Format::e_RAW;
+        }
+    }
+    scenarios->swap(result);
+
+    expand(scenarios, &Scenario::d_messageSize, options.d_sizes);
+    expand(scenarios, &Scenario::d_mode, options.d_modes);
+
+    result.clear();
+    for (bsl::size_t i = 0; i < scenarios->size(); ++i) {
+        for (bsl::size_t j = 0; j < options.d_topologies.size(); ++j) {
+            result.push_back((*scenarios)[i]);
+            result.back().d_numSenders = options.d_topologies[j].d_numSenders;
+            result.back().d_numReceivers =
+                                       options.d_topologies[j].d_numReceivers;
+        }
+    }
+    scenarios->swap(result);
+
+    expand(scenarios, &Scenario::d_execution, options.d_executions);
+    expand(scenarios, &Scenario::d_numPriorities, options.d_priorities);
+
+    // Each sender sends the requested number of messages, unless together
+    // they would send more than the requested number of bytes.
+    for (bsl::size_t i = 0; i < scenarios->size(); ++i) {
+        Scenario&                scenario  = (*scenarios)[i];
+        const bsls::Types::Int64 perSender =
+                                 options.d_numBytes / scenario.d_numSenders;
+        const bsls::Types::Int64 budget    =
+                       perSender / bsls::Types::Int64(scenario.d_messageSize);
+
+        const bsls::Types::Int64 numMessages =
+                  bsl::min<bsls::Types::Int64>(options.d_numMessages, budget);
+
+        scenario.d_numMessages = long(bsl::max<bsls::Types::Int64>(numMessages,
+                                                                   1));
+    }
+}
+
+}  // close unnamed namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    setDefaults(&options);
+    if (parseOptions(&options, argc, argv)) {
+        bsl::cerr << "See the top of m_ipcmqbench.m.cpp for usage.\n";
+        return 1;
+    }
+
+    bsl::ofstream file;
+    bsl::ostream *output = &bsl::cout;
+    if (!options.d_output.empty()) {
+        file.open(options.d_output.c_str());
+        if (!file) {
+            bsl::cerr << "Unable to open " << options.d_output << '\n';
+            return 2;
+        }
+        output = &file;
+    }
+
+    bsl::vector<Scenario> scenarios;
+    makeScenarios(&scenarios, options);
+
+    bsl::ostringstream queueName;
+    queueName << "/ipcmqbench-" << getpid();
+
+    ReportUtil::printHeader(*output);
+
+    for (bsl::size_t i = 0; i < scenarios.size(); ++i) {
+        const Scenario& scenario = scenarios[i];
+
+        bsl::cerr << '[' << i + 1 << '/' << scenarios.size() << "] "
+                  << scenario.d_api << ' ' << scenario.d_format << ' '
+                  << scenario.d_messageSize << ' ' << scenario.d_mode << ' '
+                  << scenario.d_numSenders << ':' << scenario.d_numReceivers
+                  << ' ' << scenario.d_execution << ' '
+                  << scenario.d_numPriorities << '\n';
+
+        Result result;
+        RunnerUtil::run(&result, scenario, queueName.str());
+        ReportUtil::printResult(*output, scenario, result, i == 0);
+    }
+
+    ReportUtil::printFooter(*output);
+}
@@ -0,0 +1,106 @@
+
+#include <m_ipcmqbench_report.h>
+
+#include <ipcmq_posixqueue.h>
+
+#include <bdlt_currenttime.h>
+#include <bdlt_iso8601util.h>
+
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace m_ipcmqbench {
+namespace {
+
+typedef bsls::Types::Int64 Int64;
+
+void printString(bsl::ostream& stream, const bslstl::StringRef& value)
+    // Print to the specified 'stream' the specified 'value' as a JSON string.
+{
+    stream << '"';
+    for (bsl::size_t i = 0; i < value.length(); ++i) {
+        if (value[i] == '"' || value[i] == '\\') {
+            stream << '\\';
+        }
+        stream << value[i];
+    }
+    stream << '"';
+}
+
+Int64 perSecond(double amount, double seconds)
+    // Return the specified 'amount' divided by the specified 'seconds',
+    // rounded down, or zero if 'seconds' is not positive.
+{
+    return seconds > 0 ? Int64(amount / seconds) : 0;
+}
+
+}  // close unnamed namespace
+
+                             // -----------------
+                             // struct ReportUtil
+                             // -----------------
+
+// CLASS METHODS
+void ReportUtil::printHeader(bsl::ostream& stream)
+{
+    stream << "{\n"
+           << "  \"benchmark\": \"ipcmqbench\",\n"
+           << "  \"startTime\": \"";
+    bdlt::Iso8601Util::generate(stream, bdlt::CurrentTime::utc());
+    stream << "Z\",\n"
+           << "  \"defaultMaxMessageSize\": "
+           << ipcmq::PosixQueue::defaultMaxMessageSize() << ",\n"
+           << "  \"defaultMaxMessages\": "
+           << ipcmq::PosixQueue::defaultMaxMessages() << ",\n"
+           << "  \"results\": [" << bsl::flush;
+}
+
+void ReportUtil::printResult(bsl::ostream&   stream,
+                             const Scenario& scenario,
+                             const Result&   result,
+                             bool            isFirst)
+{
+    stream << (isFirst ? "\n" : ",\n") << "    {\"api\": \"" << scenario.d_api
+           << "\", \"format\": \"" << scenario.d_format
+           << "\", \"messageSize\": " << scenario.d_messageSize
+           << ", \"mode\": \"" << scenario.d_mode
+           << "\", \"senders\": " << scenario.d_numSenders
+           << ", \"receivers\": " << scenario.d_numReceivers
+           << ", \"execution\": \"" << scenario.d_execution
+           << "\", \"priorities\": " << scenario.d_numPriorities
+           << ", \"messages\": " << scenario.d_numMessages;
+
+    if (!result.d_skipReason.empty()) {
+        stream << ", \"skipped\": ";
+        printString(stream, result.d_skipReason);
+        stream << '}' << bsl::flush;
+        return;                                                       // RETURN
+    }
+
+    const ipcu::Histogram& latency = result.d_latency;
+
+    stream << ", \"sent\": " << result.d_numSent
+           << ", \"received\": " << result.d_numReceived
+           << ", \"errors\": " << result.d_numErrors
+           << ", \"seconds\": " << result.d_seconds
+           << ", \"cpuSeconds\": " << result.d_cpuSeconds
+           << ", \"messagesPerSecond\": "
+           << perSecond(double(result.d_numReceived), result.d_seconds)
+           << ", \"bytesPerSecond\": "
+           << perSecond(double(result.d_numBytesReceived), result.d_seconds)
+           << ", \"latencyNanoseconds\": {\"min\": " << latency.min()
+           << ", \"mean\": " << Int64(latency.mean())
+           << ", \"p50\": " << latency.percentile(50)
+           << ", \"p90\": " << latency.percentile(90)
+           << ", \"p99\": " << latency.percentile(99)
+           << ", \"p999\": " << latency.percentile(99.9)
+           << ", \"max\": " << latency.max() << "}}" << bsl::flush;
+}
+
+void ReportUtil::printFooter(bsl::ostream& stream)
+{
+    stream << "\n  ]\n}\n" << bsl::flush;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
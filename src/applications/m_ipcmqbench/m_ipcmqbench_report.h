@@ -0,0 +1,58 @@
+#ifndef INCLUDED_M_IPCMQBENCH_REPORT
+#define INCLUDED_M_IPCMQBENCH_REPORT
+
+#include <m_ipcmqbench_scenario.h>
+
+#include <bsl_ostream.h>
+
+namespace BloombergLP {
+namespace m_ipcmqbench {
+
+                              // =================
+                              // struct ReportUtil
+                              // =================
+
+struct ReportUtil {
+    // This 'struct' provides a namespace for functions that print the
+    // outcome of a run of the benchmark as a JSON object, so that it can be
+    // tracked over time. The object describes the machine's message queue
+    // defaults and has a "results" array with an element for each scenario,
+    // each printed on its own line as soon as the scenario has run. For
+    // example:
+    //..
+    //  {
+    //    "benchmark": "ipcmqbench",
+    //    "startTime": "2026-10-16T09:30:00.000Z",
+    //    "defaultMaxMessageSize": 8192,
+    //    "defaultMaxMessages": 10,
+    //    "results": [
+    //      {"api": "QUEUE", "format": "RAW", "messageSize": 16, ...},
+    //      {"api": "QUEUE", "format": "RAW", "messageSize": 100000000,
+    //       ..., "skipped": "a payload does not fit in a message"}
+    //    ]
+    //  }
+    //..
+    // Latencies are in nanoseconds, and rates are per second.
+
+    // CLASS METHODS
+    static void printHeader(bsl::ostream& stream);
+        // Print to the specified 'stream' the beginning of the JSON object,
+        // up to and including the opening of its "results" array.
+
+    static void printResult(bsl::ostream&   stream,
+                            const Scenario& scenario,
+                            const Result&   result,
+                            bool            isFirst);
+        // Print to the specified 'stream' the element of the "results" array
+        // describing the specified 'scenario' and its specified 'result',
+        // and flush 'stream'. The specified 'isFirst' indicates whether this
+        // is the first element of the array.
+
+    static void printFooter(bsl::ostream& stream);
+        // Print to the specified 'stream' the end of the JSON object.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
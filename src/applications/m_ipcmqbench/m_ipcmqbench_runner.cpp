@@ -0,0 +1,984 @@
+
+#include <m_ipcmqbench_runner.h>
+
+#include <ipcmq_consumer.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queue.h>
+#include <ipcmq_queuereceiver.h>
+#include <ipcmq_queuesender.h>
+#include <ipcmq_receiver.h>
+#include <ipcmq_sender.h>
+#include <ipcmq_shmmpmcqueue.h>
+
+#include <bdlf_bind.h>
+#include <bdlf_placeholder.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bslma_default.h>
+#include <bslma_managedptr.h>
+
+#include <bslmt_barrier.h>
+#include <bslmt_semaphore.h>
+#include <bslmt_threadutil.h>
+
+#include <bsls_assert.h>
+#include <bsls_atomic.h>
+#include <bsls_timeinterval.h>
+#include <bsls_timeutil.h>
+#include <bsls_types.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_cstring.h>
+#include <bsl_vector.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace BloombergLP {
+namespace m_ipcmqbench {
+namespace {
+
+typedef bsls::Types::Int64  Int64;
+typedef bsls::Types::Uint64 Uint64;
+
+const Int64 k_STOP = 0;
+    // A message whose timestamp is 'k_STOP' tells its receiver to stop.
+
+const int k_TIMEOUT_SECONDS = 10;
+    // Timed sends and receives retry after this long. It is long, because a
+    // sender using an extended format stores a large payload outside of the
+    // queue again on each attempt.
+
+const int k_MAX_CONSECUTIVE_ERRORS = 100;
+    // A receiver gives up after failing this many times in a row.
+
+const int k_STOP_INTERVAL_MILLISECONDS = 10;
+    // Stop messages are sent this often until every receiver has stopped.
+
+const bsls::TimeInterval k_MAX_SPIN(0, 100 * 1000);
+    // A 'SPINNING_CONSUMER' polls for at most this long before it blocks.
+
+const int k_FIFO_PRIORITY = 1;
+    // A 'PINNED_CONSUMER' receives at this real-time priority, if permitted.
+
+const bsl::size_t k_MAX_SHM_MESSAGE_SIZE = 1024 * 1024;
+    // An 'ipcmq::ShmMpmcQueue' has slots for payloads of the size of the
+    // scenario, but no larger than this.
+
+const bsl::size_t k_SHM_QUEUE_SIZE = 64 * 1024 * 1024;
+    // An 'ipcmq::ShmMpmcQueue' has as many slots as fit in about this many
+    // bytes, but no more than its default.
+
+struct Counters {
+    // This 'struct' counts what one sender or receiver did. It is copied as
+    // bytes from a child process to its parent.
+
+    // DATA
+    Int64 d_numMessages;
+    Int64 d_numBytes;
+    Int64 d_numErrors;
+    Int64 d_lastTime;     // timer value when the last message was received
+};
+
+                         // ========================
+                         // class PosixQueueEndpoint
+                         // ========================
+
+class PosixQueueEndpoint : public ipcmq::Sender, public ipcmq::Receiver {
+    // This class implements the 'Sender' and 'Receiver' protocols by sending
+    // and receiving each payload as a message of an 'ipcmq::PosixQueue', so
+    // that the queue itself can be measured in the same way as the rest of
+    // 'ipcmq'.
+
+    // DATA
+    ipcmq::PosixQueue d_queue;
+
+  public:
+    // CREATORS
+    explicit PosixQueueEndpoint(const bslstl::StringRef& name)
+        // Open for reading and for writing the existing message queue having
+        // the specified 'name'.
+    {
+        d_queue.open(name,
+                     ipcmq::PosixQueue::OpenMode::ReadWrite(),
+                     ipcmq::PosixQueue::CreateMode::OpenOnly());
+    }
+
+    // MANIPULATORS
+    int send(const bslstl::StringRef& payload)
+    {
+        return d_queue.send(payload);
+    }
+
+    int send(const bslstl::StringRef& payload, int priority)
+    {
+        return d_queue.send(payload, priority);
+    }
+
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout)
+    {
+        return send(payload, relativeTimeout, 0);
+    }
+
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout,
+             int                       priority)
+    {
+        return d_queue.send(payload,
+                            bdlt::CurrentTime::now() + relativeTimeout,
+                            priority);
+    }
+
+    int trySend(const bslstl::StringRef& payload)
+    {
+        return d_queue.trySend(payload);
+    }
+
+    int trySend(const bslstl::StringRef& payload, int priority)
+    {
+        return d_queue.trySend(payload, priority);
+    }
+
+    int receive(bsl::string *payload)
+    {
+        return d_queue.receive(payload);
+    }
+
+    int receive(bsl::string *payload, unsigned *priority)
+    {
+        return d_queue.receive(payload, priority);
+    }
+
+    int receive(bsl::string               *payload,
+                const bsls::TimeInterval&  relativeTimeout)
+    {
+        return d_queue.receive(payload,
+                               bdlt::CurrentTime::now() + relativeTimeout);
+    }
+
+    int receive(bsl::string               *payload,
+                const bsls::TimeInterval&  relativeTimeout,
+                unsigned                  *priority)
+    {
+        return d_queue.receive(payload,
+                               bdlt::CurrentTime::now() + relativeTimeout,
+                               priority);
+    }
+
+    int tryReceive(bsl::string *payload)
+    {
+        return d_queue.tryReceive(payload);
+    }
+
+    int tryReceive(bsl::string *payload, unsigned *priority)
+    {
+        return d_queue.tryReceive(payload, priority);
+    }
+
+    // ACCESSORS
+    bool isOpen() const
+        // Return whether this object represents an open message queue.
+    {
+        return d_queue.isOpen();
+    }
+};
+
+bool isConsumer(Api api)
+    // Return whether the specified 'api' receives using an 'ipcmq::Consumer'.
+{
+    return api == Api::e_CONSUMER || api == Api::e_SPINNING_CONSUMER ||
+           api == Api::e_PINNED_CONSUMER;
+}
+
+template <typename ENDPOINT, typename PROTOCOL>
+int adopt(bslma::ManagedPtr<PROTOCOL> *result, ENDPOINT *endpoint)
+    // Load the specified 'endpoint' into the specified 'result', which then
+    // owns it, and return zero if 'endpoint' is open or a nonzero value
+    // otherwise. The behavior is undefined unless 'endpoint' was allocated
+    // using the default allocator.
+{
+    bslma::ManagedPtr<ENDPOINT> owner(endpoint, bslma::Default::allocator());
+    if (!owner->isOpen()) {
+        return 1;                                                     // RETURN
+    }
+
+    *result = owner;
+    return 0;
+}
+
+int openSender(bslma::ManagedPtr<ipcmq::Sender> *result,
+               const Scenario&                   scenario,
+               const bsl::string&                name)
+    // Open for writing the queue having the specified 'name' using the API
+    // and format of the specified 'scenario', and load the sender into the
+    // specified 'result'. Return zero on success or a nonzero value
+    // otherwise.
+{
+    bslma::Allocator *allocator = bslma::Default::allocator();
+
+    const ipcmq::Format format = scenario.d_format;
+    int                 rc;
+
+    switch (scenario.d_api) {
+      case Api::e_POSIX_QUEUE:
+        rc = adopt(result, new (*allocator) PosixQueueEndpoint(name));
+        break;
+      case Api::e_QUEUE:
+        rc = adopt(result, new (*allocator) ipcmq::Queue(name, format));
+        break;
+      case Api::e_SHM_MPMC:
+        rc = adopt(result, new (*allocator) ipcmq::ShmMpmcQueue(name));
+        break;
+      default:
+        rc = adopt(result, new (*allocator) ipcmq::QueueSender(name, format));
+    }
+
+    return rc;
+}
+
+int openReceiver(bslma::ManagedPtr<ipcmq::Receiver> *result,
+                 const Scenario&                     scenario,
+                 const bsl::string&                  name)
+    // Open for reading the queue having the specified 'name' using the API
+    // and format of the specified 'scenario', and load the receiver into the
+    // specified 'result'. Return zero on success or a nonzero value
+    // otherwise. The behavior is undefined if the API of 'scenario' receives
+    // using an 'ipcmq::Consumer'.
+{
+    BSLS_ASSERT(!isConsumer(scenario.d_api));
+
+    bslma::Allocator *allocator = bslma::Default::allocator();
+
+    const ipcmq::Format format = scenario.d_format;
+    int                 rc;
+
+    switch (scenario.d_api) {
+      case Api::e_POSIX_QUEUE:
+        rc = adopt(result, new (*allocator) PosixQueueEndpoint(name));
+        break;
+      case Api::e_QUEUE:
+        rc = adopt(result, new (*allocator) ipcmq::Queue(name, format));
+        break;
+      case Api::e_SHM_MPMC:
+        rc = adopt(result, new (*allocator) ipcmq::ShmMpmcQueue(name));
+        break;
+      default:
+        rc = adopt(result,
+                   new (*allocator) ipcmq::QueueReceiver(name, format));
+    }
+
+    return rc;
+}
+
+int createShmQueue(bslma::ManagedPtr<ipcmq::ShmMpmcQueue> *result,
+                   const Scenario&                         scenario,
+                   const bsl::string&                      name)
+    // Create the shared memory queue having the specified 'name', replacing
+    // any queue left behind by an earlier run, with slots for the payloads of
+    // the specified 'scenario', and load it into the specified 'result'.
+    // Return zero on success or a nonzero value otherwise.
+{
+    const bsl::size_t maxMessageSize =
+                  bsl::min(scenario.d_messageSize, k_MAX_SHM_MESSAGE_SIZE);
+    const bsl::size_t numSlots = bsl::min<bsl::size_t>(
+                                 ipcmq::ShmMpmcQueue::k_DEFAULT_NUM_SLOTS,
+                                 k_SHM_QUEUE_SIZE / maxMessageSize);
+
+    ipcmq::ShmMpmcQueue::unlink(name);
+    return adopt(result,
+                 new (*bslma::Default::allocator())
+                     ipcmq::ShmMpmcQueue(name, numSlots, maxMessageSize));
+}
+
+int sendOne(ipcmq::Sender            *sender,
+            const bslstl::StringRef&  payload,
+            int                       priority,
+            Mode                      mode)
+    // Send the specified 'payload' having the specified 'priority' using the
+    // specified 'sender' in the specified 'mode', retrying while a timed send
+    // times out or a nonblocking send finds the queue full. Return zero on
+    // success or a nonzero value otherwise.
+{
+    const bsls::TimeInterval timeout(k_TIMEOUT_SECONDS, 0);
+    int                      rc;
+
+    switch (mode) {
+      case Mode::e_BLOCKING:
+        return sender->send(payload, priority);                       // RETURN
+      case Mode::e_TIMED:
+        do {
+            rc = sender->send(payload, timeout, priority);
+        } while (rc == ipcmq::PosixQueue::Send::e_TIMED_OUT);
+        return rc;                                                    // RETURN
+      default:
+        BSLS_ASSERT(mode == Mode::e_TRY);
+        while ((rc = sender->trySend(payload, priority)) ==
+                                             ipcmq::PosixQueue::Send::e_FULL) {
+            bslmt::ThreadUtil::yield();
+        }
+        return rc;
+    }
+}
+
+int receiveOne(ipcmq::Receiver *receiver, bsl::string *payload, Mode mode)
+    // Load into the specified 'payload' the next payload received using the
+    // specified 'receiver' in the specified 'mode', retrying while a timed
+    // receive times out or a nonblocking receive finds the queue empty.
+    // Return zero on success or a nonzero value otherwise.
+{
+    const bsls::TimeInterval timeout(k_TIMEOUT_SECONDS, 0);
+    int                      rc;
+
+    switch (mode) {
+      case Mode::e_BLOCKING:
+        return receiver->receive(payload);                            // RETURN
+      case Mode::e_TIMED:
+        do {
+            rc = receiver->receive(payload, timeout);
+        } while (rc == ipcmq::PosixQueue::Receive::e_TIMED_OUT);
+        return rc;                                                    // RETURN
+      default:
+        BSLS_ASSERT(mode == Mode::e_TRY);
+        while ((rc = receiver->tryReceive(payload)) ==
+                                         ipcmq::PosixQueue::Receive::e_EMPTY) {
+            bslmt::ThreadUtil::yield();
+        }
+        return rc;
+    }
+}
+
+void sendAll(Counters        *counters,
+             ipcmq::Sender   *sender,
+             const Scenario&  scenario)
+    // Send the messages of one sender of the specified 'scenario' using the
+    // specified 'sender', and count them in the specified 'counters'.
+{
+    bsl::string payload(scenario.d_messageSize, 'x');
+
+    for (long i = 0; i < scenario.d_numMessages; ++i) {
+        const Int64 now = bsls::TimeUtil::getTimer();
+        bsl::memcpy(&payload[0], &now, sizeof now);
+
+        const int priority = int(i % scenario.d_numPriorities);
+        if (sendOne(sender, payload, priority, scenario.d_mode)) {
+            ++counters->d_numErrors;
+        }
+        else {
+            ++counters->d_numMessages;
+            counters->d_numBytes += payload.size();
+        }
+    }
+}
+
+bool record(Counters           *counters,
+            ipcu::Histogram    *latency,
+            const bsl::string&  payload)
+    // Count the specified 'payload' in the specified 'counters' and record
+    // its latency in the specified 'latency'. Return 'false' if 'payload' is
+    // a stop message, or 'true' otherwise.
+{
+    const Int64 now = bsls::TimeUtil::getTimer();
+
+    Int64 sent;
+    if (payload.size() < sizeof sent) {
+        ++counters->d_numErrors;
+        return true;                                                  // RETURN
+    }
+
+    bsl::memcpy(&sent, payload.data(), sizeof sent);
+    if (sent == k_STOP) {
+        return false;                                                 // RETURN
+    }
+
+    ++counters->d_numMessages;
+    counters->d_numBytes += payload.size();
+    counters->d_lastTime  = now;
+    latency->record(now > sent ? Uint64(now - sent) : 0);
+    return true;
+}
+
+void receiveAll(Counters        *counters,
+                ipcu::Histogram *latency,
+                ipcmq::Receiver *receiver,
+                Mode             mode)
+    // Receive messages using the specified 'receiver' in the specified
+    // 'mode', counting them in the specified 'counters' and recording their
+    // latencies in the specified 'latency', until a stop message is received
+    // or too many receives in a row fail.
+{
+    bsl::string payload;
+    int         consecutiveErrors = 0;
+
+    while (consecutiveErrors < k_MAX_CONSECUTIVE_ERRORS) {
+        if (receiveOne(receiver, &payload, mode)) {
+            ++counters->d_numErrors;
+            ++consecutiveErrors;
+        }
+        else if (!record(counters, latency, payload)) {
+            return;                                                   // RETURN
+        }
+        else {
+            consecutiveErrors = 0;
+        }
+    }
+}
+
+                            // ===================
+                            // class ConsumerState
+                            // ===================
+
+class ConsumerState {
+    // This class records the messages delivered by an 'ipcmq::Consumer' until
+    // it delivers a stop message.
+
+    // DATA
+    Counters         *d_counters_p;
+    ipcu::Histogram  *d_latency_p;
+    bool              d_isStopped;   // accessed only by the consumer thread
+    bslmt::Semaphore  d_stopped;
+
+  public:
+    // CREATORS
+    ConsumerState(Counters *counters, ipcu::Histogram *latency)
+        // Create a 'ConsumerState' that counts messages in the specified
+        // 'counters' and records their latencies in the specified 'latency'.
+    : d_counters_p(counters)
+    , d_latency_p(latency)
+    , d_isStopped(false)
+    {
+    }
+
+    // MANIPULATORS
+    void handle(bsl::string *payload, unsigned)
+        // Record the specified 'payload', or signal 'wait' if it is the first
+        // stop message.
+    {
+        if (!d_isStopped && !record(d_counters_p, d_latency_p, *payload)) {
+            d_isStopped = true;
+            d_stopped.post();
+        }
+    }
+
+    void wait()
+        // Block until a stop message is handled.
+    {
+        d_stopped.wait();
+    }
+};
+
+void waitForStart(bslmt::Barrier *barrier, int startFd)
+    // Block until the benchmark starts, which is signalled by the specified
+    // 'barrier' if it is not zero, or otherwise by the end of the pipe whose
+    // read end is the specified 'startFd'.
+{
+    if (barrier) {
+        barrier->wait();
+        return;                                                       // RETURN
+    }
+
+    char byte;
+    while (read(startFd, &byte, sizeof byte) == -1 && errno == EINTR) {
+    }
+}
+
+void participate(Counters           *counters,
+                 ipcu::Histogram    *latency,
+                 bool                isSender,
+                 const Scenario&     scenario,
+                 const bsl::string&  name,
+                 bslmt::Barrier     *barrier,
+                 int                 startFd)
+    // Open the queue having the specified 'name' as a sender of the specified
+    // 'scenario' if the specified 'isSender' is 'true', or as a receiver
+    // otherwise, wait for the benchmark to start as described by the
+    // specified 'barrier' and 'startFd' (see 'waitForStart'), and then send
+    // or receive, counting messages in the specified 'counters' and recording
+    // latencies in the specified 'latency'.
+{
+    if (isSender) {
+        bslma::ManagedPtr<ipcmq::Sender> sender;
+        const int rc = openSender(&sender, scenario, name);
+        waitForStart(barrier, startFd);
+        if (rc) {
+            ++counters->d_numErrors;
+        }
+        else {
+            sendAll(counters, sender.get(), scenario);
+        }
+    }
+    else if (isConsumer(scenario.d_api)) {
+        using namespace bdlf::PlaceHolders;
+
+        ipcmq::ConsumerOptions options;
+        if (scenario.d_api == Api::e_SPINNING_CONSUMER) {
+            options.d_maxSpin = k_MAX_SPIN;
+        }
+        else if (scenario.d_api == Api::e_PINNED_CONSUMER) {
+            // On a machine with one NUMA node, this pins nothing, and only
+            // the scheduling policy differs.
+            options.d_threadOptions.d_numaNode     = 0;
+            options.d_threadOptions.d_fifoPriority = k_FIFO_PRIORITY;
+            options.d_threadOptions.d_name         = "ipcmqbench-recv";
+        }
+
+        ConsumerState   state(counters, latency);
+        ipcmq::Consumer consumer(name,
+                                 scenario.d_format,
+                                 bdlf::BindUtil::bind(&ConsumerState::handle,
+                                                      &state,
+                                                      _1,
+                                                      _2),
+                                 options);
+        waitForStart(barrier, startFd);
+        if (!consumer.isOpen()) {
+            ++counters->d_numErrors;
+        }
+        else {
+            state.wait();
+        }
+    }
+    else {
+        bslma::ManagedPtr<ipcmq::Receiver> receiver;
+        const int rc = openReceiver(&receiver, scenario, name);
+        waitForStart(barrier, startFd);
+        if (rc) {
+            ++counters->d_numErrors;
+        }
+        else {
+            receiveAll(counters, latency, receiver.get(), scenario.d_mode);
+        }
+    }
+}
+
+void participateInThread(Counters           *counters,
+                         ipcu::Histogram    *latency,
+                         bool                isSender,
+                         const Scenario     *scenario,
+                         const bsl::string  *name,
+                         bslmt::Barrier     *barrier,
+                         bsls::AtomicInt    *numReceiversFinished)
+    // Call 'participate' with the specified 'counters', 'latency',
+    // 'isSender', 'scenario', 'name', and 'barrier', and then, if 'isSender'
+    // is 'false', increment the specified 'numReceiversFinished'.
+{
+    participate(counters, latency, isSender, *scenario, *name, barrier, -1);
+    if (!isSender) {
+        ++*numReceiversFinished;
+    }
+}
+
+void sendStop(ipcmq::Sender *sender)
+    // Send a stop message using the specified 'sender' if the queue is not
+    // full.
+{
+    const char stop[sizeof k_STOP] = {};
+    sender->trySend(bslstl::StringRef(stop, sizeof stop), 0);
+}
+
+int writeAll(int fd, const void *data, bsl::size_t length)
+    // Write the specified 'length' bytes at the specified 'data' to the
+    // specified 'fd'. Return zero on success or a nonzero value otherwise.
+{
+    const char *next = static_cast<const char *>(data);
+    while (length) {
+        const ssize_t rc = write(fd, next, length);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            return 1;                                                 // RETURN
+        }
+        next   += rc;
+        length -= rc;
+    }
+    return 0;
+}
+
+int readAll(int fd, void *data, bsl::size_t length)
+    // Read the specified 'length' bytes from the specified 'fd' into the
+    // specified 'data'. Return zero on success or a nonzero value otherwise.
+{
+    char *next = static_cast<char *>(data);
+    while (length) {
+        const ssize_t rc = read(fd, next, length);
+        if (rc == -1 && errno == EINTR) {
+            continue;
+        }
+        if (rc <= 0) {
+            return 1;                                                 // RETURN
+        }
+        next   += rc;
+        length -= rc;
+    }
+    return 0;
+}
+
+int writeResult(int                    fd,
+                const Counters&        counters,
+                const ipcu::Histogram& latency)
+    // Write the specified 'counters' and 'latency' to the specified 'fd'.
+    // The latencies are written as the least value of each nonempty bucket
+    // and its count. Return zero on success or a nonzero value otherwise.
+{
+    if (writeAll(fd, &counters, sizeof counters)) {
+        return 1;                                                     // RETURN
+    }
+
+    bsl::vector<Uint64> buckets;
+    for (int i = 0; i < latency.numBuckets(); ++i) {
+        if (latency.bucketCount(i)) {
+            buckets.push_back(latency.bucketLowest(i));
+            buckets.push_back(latency.bucketCount(i));
+        }
+    }
+
+    const Uint64 size = buckets.size();
+    if (writeAll(fd, &size, sizeof size)) {
+        return 1;                                                     // RETURN
+    }
+
+    return size ? writeAll(fd, &buckets[0], size * sizeof(Uint64)) : 0;
+}
+
+int readResult(Counters *counters, ipcu::Histogram *latency, int fd)
+    // Read from the specified 'fd' what 'writeResult' wrote, loading it into
+    // the specified 'counters' and 'latency'. Return zero on success or a
+    // nonzero value otherwise.
+{
+    Uint64 size;
+    if (readAll(fd, counters, sizeof *counters)
+     || readAll(fd, &size, sizeof size)) {
+        return 1;                                                     // RETURN
+    }
+
+    bsl::vector<Uint64> buckets(size);
+    if (size && readAll(fd, &buckets[0], size * sizeof(Uint64))) {
+        return 1;                                                     // RETURN
+    }
+
+    for (bsl::size_t i = 0; i + 1 < buckets.size(); i += 2) {
+        latency->record(buckets[i], buckets[i + 1]);
+    }
+    return 0;
+}
+
+void runInThreads(bsl::vector<Counters>        *counters,
+                  bsl::vector<ipcu::Histogram> *latencies,
+                  Int64                        *startTime,
+                  ipcmq::Sender                *stopper,
+                  const Scenario&               scenario,
+                  const bsl::string&            name)
+    // Run the specified 'scenario' using the queue having the specified
+    // 'name' in a thread for each sender and receiver, loading their outcomes
+    // into the specified 'counters' and 'latencies', senders first, and the
+    // time at which they started into the specified 'startTime'. Send stop
+    // messages using the specified 'stopper'.
+{
+    const int numParticipants = scenario.d_numSenders +
+                                scenario.d_numReceivers;
+
+    bslmt::Barrier                         barrier(numParticipants + 1);
+    bsls::AtomicInt                        numReceiversFinished(0);
+    bsl::vector<bslmt::ThreadUtil::Handle> threads(numParticipants);
+
+    for (int i = 0; i < numParticipants; ++i) {
+        const bool isSender = i < scenario.d_numSenders;
+        const int  rc       = bslmt::ThreadUtil::create(
+                                  &threads[i],
+                                  bdlf::BindUtil::bind(&participateInThread,
+                                                       &(*counters)[i],
+                                                       &(*latencies)[i],
+                                                       isSender,
+                                                       &scenario,
+                                                       &name,
+                                                       &barrier,
+                                                       &numReceiversFinished));
+        BSLS_ASSERT_OPT(0 == rc);
+    }
+
+    barrier.wait();
+    *startTime = bsls::TimeUtil::getTimer();
+
+    for (int i = 0; i < scenario.d_numSenders; ++i) {
+        bslmt::ThreadUtil::join(threads[i]);
+    }
+
+    while (numReceiversFinished < scenario.d_numReceivers) {
+        sendStop(stopper);
+        bslmt::ThreadUtil::microSleep(k_STOP_INTERVAL_MILLISECONDS * 1000);
+    }
+
+    for (int i = scenario.d_numSenders; i < numParticipants; ++i) {
+        bslmt::ThreadUtil::join(threads[i]);
+    }
+}
+
+void runInProcesses(bsl::vector<Counters>        *counters,
+                    bsl::vector<ipcu::Histogram> *latencies,
+                    Int64                        *startTime,
+                    ipcmq::Sender                *stopper,
+                    const Scenario&               scenario,
+                    const bsl::string&            name)
+    // Run the specified 'scenario' using the queue having the specified
+    // 'name' in a child process for each sender and receiver, loading their
+    // outcomes into the specified 'counters' and 'latencies', senders first,
+    // and the time at which they started into the specified 'startTime'.
+    // Send stop messages using the specified 'stopper'.
+{
+    const int numParticipants = scenario.d_numSenders +
+                                scenario.d_numReceivers;
+
+    // Each child blocks reading 'startPipe' until the parent closes its
+    // write end, and writes its outcome to its own result pipe before
+    // exiting.
+    int startPipe[2];
+    BSLS_ASSERT_OPT(0 == pipe(startPipe));
+
+    bsl::vector<pid_t> pids(numParticipants, -1);
+    bsl::vector<int>   resultFds(numParticipants, -1);
+
+    for (int i = 0; i < numParticipants; ++i) {
+        int resultPipe[2];
+        if (pipe(resultPipe)) {
+            ++(*counters)[i].d_numErrors;
+            continue;
+        }
+
+        const bool isSender = i < scenario.d_numSenders;
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            close(startPipe[1]);
+            close(resultPipe[0]);
+
+            Counters        childCounters = {};
+            ipcu::Histogram childLatency;
+            participate(&childCounters,
+                        &childLatency,
+                        isSender,
+                        scenario,
+                        name,
+                        0,
+                        startPipe[0]);
+            _exit(writeResult(resultPipe[1], childCounters, childLatency));
+        }
+
+        close(resultPipe[1]);
+        if (pids[i] == -1) {
+            close(resultPipe[0]);
+            ++(*counters)[i].d_numErrors;
+        }
+        else {
+            resultFds[i] = resultPipe[0];
+        }
+    }
+
+    close(startPipe[0]);
+    *startTime = bsls::TimeUtil::getTimer();
+    close(startPipe[1]);
+
+    // Gather the result of each child once it is readable. A receiver's
+    // result is not waited for until it is readable, since the receiver
+    // does not finish until it receives a stop message.
+    bsl::vector<pollfd> pollFds;
+    for (int i = 0; i < numParticipants; ++i) {
+        if (resultFds[i] != -1) {
+            pollfd entry = { resultFds[i], POLLIN, 0 };
+            pollFds.push_back(entry);
+        }
+    }
+
+    int numSendersRunning = 0;
+    for (int i = 0; i < scenario.d_numSenders; ++i) {
+        numSendersRunning += resultFds[i] != -1;
+    }
+
+    while (!pollFds.empty()) {
+        if (numSendersRunning == 0) {
+            sendStop(stopper);
+        }
+
+        if (poll(&pollFds[0], pollFds.size(), k_STOP_INTERVAL_MILLISECONDS)
+                                                                       <= 0) {
+            continue;
+        }
+
+        for (bsl::size_t j = 0; j < pollFds.size(); ++j) {
+            if (!pollFds[j].revents) {
+                continue;
+            }
+
+            const int i = int(bsl::find(resultFds.begin(),
+                                        resultFds.end(),
+                                        pollFds[j].fd) - resultFds.begin());
+            if (readResult(&(*counters)[i], &(*latencies)[i], resultFds[i])) {
+                ++(*counters)[i].d_numErrors;
+            }
+            close(resultFds[i]);
+            waitpid(pids[i], 0, 0);
+            numSendersRunning -= i < scenario.d_numSenders;
+
+            pollFds.erase(pollFds.begin() + j);
+            --j;
+        }
+    }
+}
+
+double cpuSeconds()
+    // Return the user and system time used so far by this process and by
+    // its children that have been waited for.
+{
+    double result = 0;
+
+    const int who[] = { RUSAGE_SELF, RUSAGE_CHILDREN };
+    for (bsl::size_t i = 0; i < sizeof who / sizeof *who; ++i) {
+        rusage usage;
+        if (getrusage(who[i], &usage) == 0) {
+            result += double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                      double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) /
+                          1e6;
+        }
+    }
+
+    return result;
+}
+
+const char *skipReason(const Scenario& scenario, long maxMessageSize)
+    // Return a description of why the specified 'scenario' cannot be run
+    // using a queue whose messages are at most the specified 'maxMessageSize'
+    // bytes, or zero if it can be.
+{
+    const long size = long(scenario.d_messageSize);
+
+    if (scenario.d_messageSize < sizeof k_STOP) {
+        return "a payload is too small to hold a timestamp";          // RETURN
+    }
+
+    if ((scenario.d_api == Api::e_POSIX_QUEUE ||
+         scenario.d_api == Api::e_SHM_MPMC ||
+         scenario.d_format == ipcmq::Format::e_RAW) &&
+        size > maxMessageSize) {
+        return "a payload does not fit in a message";                 // RETURN
+    }
+
+    if (scenario.d_numReceivers > 1 &&
+        (scenario.d_format == ipcmq::Format::e_FRAGMENTED ||
+         scenario.d_format == ipcmq::Format::e_TAGGED) &&
+        size >= maxMessageSize) {
+        return "fragments of a payload require a single receiver";    // RETURN
+    }
+
+    return 0;
+}
+
+}  // close unnamed namespace
+
+                             // -----------------
+                             // struct RunnerUtil
+                             // -----------------
+
+// CLASS METHODS
+void RunnerUtil::run(Result             *result,
+                     const Scenario&     scenario,
+                     const bsl::string&  queueName)
+{
+    BSLS_ASSERT(result);
+    BSLS_ASSERT(scenario.d_numSenders > 0);
+    BSLS_ASSERT(scenario.d_numReceivers > 0);
+    BSLS_ASSERT(scenario.d_numPriorities > 0);
+
+    *result = Result();
+
+    // Create the queue before any sender or receiver opens it, replacing any
+    // queue left behind by an earlier run, and keep it open until the end.
+    ipcmq::PosixQueue::unlink(queueName);
+
+    ipcmq::PosixQueue queue;
+    if (queue.open(queueName,
+                   ipcmq::PosixQueue::OpenMode::ReadWrite(),
+                   ipcmq::PosixQueue::CreateMode::CreateOnly())) {
+        result->d_skipReason = "unable to create the queue";
+        return;                                                       // RETURN
+    }
+
+    // An 'ipcmq::ShmMpmcQueue' is created in the same way, in place of the
+    // message queue, and its slots determine the largest payload instead.
+    bslma::ManagedPtr<ipcmq::ShmMpmcQueue> shmQueue;
+    bslma::ManagedPtr<ipcmq::Sender>       stopper;
+
+    const bool isShm = scenario.d_api == Api::e_SHM_MPMC;
+    if (isShm && createShmQueue(&shmQueue, scenario, queueName)) {
+        result->d_skipReason = "unable to create the queue";
+    }
+    else if (const char *reason = skipReason(
+                                      scenario,
+                                      isShm ? long(shmQueue->maxMessageSize())
+                                            : queue.maxMessageSize())) {
+        result->d_skipReason = reason;
+    }
+    else if (openSender(&stopper, scenario, queueName)) {
+        result->d_skipReason = "unable to open the queue";
+    }
+    else {
+        const int numParticipants = scenario.d_numSenders +
+                                    scenario.d_numReceivers;
+
+        Counters                     zero = {};
+        bsl::vector<Counters>        counters(numParticipants, zero);
+        bsl::vector<ipcu::Histogram> latencies(numParticipants);
+        Int64                        startTime = 0;
+        const double                 startCpu  = cpuSeconds();
+
+        if (scenario.d_execution == Execution::e_THREADS) {
+            runInThreads(&counters,
+                         &latencies,
+                         &startTime,
+                         stopper.get(),
+                         scenario,
+                         queueName);
+        }
+        else {
+            runInProcesses(&counters,
+                           &latencies,
+                           &startTime,
+                           stopper.get(),
+                           scenario,
+                           queueName);
+        }
+        result->d_cpuSeconds = cpuSeconds() - startCpu;
+
+        Int64 lastTime = startTime;
+        for (int i = 0; i < numParticipants; ++i) {
+            const Counters& participant = counters[i];
+
+            result->d_numErrors += participant.d_numErrors;
+            if (i < scenario.d_numSenders) {
+                result->d_numSent += participant.d_numMessages;
+            }
+            else {
+                result->d_numReceived      += participant.d_numMessages;
+                result->d_numBytesReceived += participant.d_numBytes;
+                result->d_latency.add(latencies[i]);
+                lastTime = bsl::max(lastTime, participant.d_lastTime);
+            }
+        }
+
+        result->d_seconds = double(lastTime - startTime) / 1e9;
+    }
+
+    stopper.reset();
+    queue.close();
+    ipcmq::PosixQueue::unlink(queueName);
+    if (shmQueue) {
+        shmQueue->unlink();
+        shmQueue.reset();
+    }
+}
+
+}  // close package namespace
+}  // close enterprise namespace
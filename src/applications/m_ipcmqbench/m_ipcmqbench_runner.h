@@ -0,0 +1,43 @@
+#ifndef INCLUDED_M_IPCMQBENCH_RUNNER
+#define INCLUDED_M_IPCMQBENCH_RUNNER
+
+#include <m_ipcmqbench_scenario.h>
+
+#include <bsl_string.h>
+
+namespace BloombergLP {
+namespace m_ipcmqbench {
+
+                             // =================
+                             // struct RunnerUtil
+                             // =================
+
+struct RunnerUtil {
+    // This 'struct' provides a namespace for a function that runs a benchmark
+    // scenario. Each sender sends its messages as fast as it can, each
+    // stamped with the time at which its send began, and each receiver
+    // records the latency of each message it receives. Once every sender has
+    // finished, receivers are sent "stop" messages, which have the lowest
+    // priority and so follow every other message. Latency and the time of
+    // each message are measured using the monotonic clock, which is shared by
+    // every process on the machine.
+
+    // CLASS METHODS
+    static void run(Result             *result,
+                    const Scenario&     scenario,
+                    const bsl::string&  queueName);
+        // Run the specified 'scenario' using a new message queue having the
+        // specified 'queueName', which is unlinked afterward, and load its
+        // outcome into the specified 'result'. If the scenario cannot be run,
+        // for example because its payloads do not fit in a message of a queue
+        // using its format, load the reason into 'result->d_skipReason'
+        // instead. Note that with 'Execution::e_PROCESSES', the minimum and
+        // maximum latencies are known only to within the precision of
+        // 'result->d_latency', since they are copied from each child process
+        // bucket by bucket.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
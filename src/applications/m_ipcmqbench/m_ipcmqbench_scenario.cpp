@@ -0,0 +1,41 @@
+
+#include <m_ipcmqbench_scenario.h>
+
+namespace BloombergLP {
+namespace m_ipcmqbench {
+
+                              // ---------------
+                              // struct Scenario
+                              // ---------------
+
+// CREATORS
+Scenario::Scenario()
+: d_api(Api::e_QUEUE_SENDER)
+, d_format(ipcmq::Format::e_EXTENDED)
+, d_messageSize(16)
+, d_mode(Mode::e_BLOCKING)
+, d_numSenders(1)
+, d_numReceivers(1)
+, d_execution(Execution::e_THREADS)
+, d_numPriorities(1)
+, d_numMessages(1000)
+{
+}
+
+                               // -------------
+                               // struct Result
+                               // -------------
+
+// CREATORS
+Result::Result()
+: d_numSent(0)
+, d_numReceived(0)
+, d_numBytesReceived(0)
+, d_numErrors(0)
+, d_seconds(0)
+, d_cpuSeconds(0)
+{
+}
+
+}  // close package namespace
+}  // close enterprise namespace
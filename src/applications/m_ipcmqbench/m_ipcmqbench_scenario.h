@@ -0,0 +1,116 @@
+#ifndef INCLUDED_M_IPCMQBENCH_SCENARIO
+#define INCLUDED_M_IPCMQBENCH_SCENARIO
+
+#include <ipcmq_format.h>
+
+#include <ipcu_enum.h>
+#include <ipcu_histogram.h>
+
+#include <bsls_types.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+
+namespace BloombergLP {
+namespace m_ipcmqbench {
+
+                                 // =========
+                                 // class Api
+                                 // =========
+
+IPCU_DEFINE_ENUM(Api,
+                 POSIX_QUEUE,
+                 QUEUE_SENDER,
+                 QUEUE,
+                 CONSUMER,
+                 SPINNING_CONSUMER,
+                 PINNED_CONSUMER,
+                 SHM_MPMC);
+    // 'POSIX_QUEUE' sends and receives using 'ipcmq::PosixQueue' directly.
+    // 'QUEUE_SENDER' uses an 'ipcmq::QueueSender' and an
+    // 'ipcmq::QueueReceiver'. 'QUEUE' uses an 'ipcmq::Queue' at either end.
+    // 'CONSUMER' sends using an 'ipcmq::QueueSender' and receives using an
+    // 'ipcmq::Consumer'. 'SPINNING_CONSUMER' is 'CONSUMER' with receiving
+    // threads that poll before they block (see
+    // 'ipcmq::ConsumerOptions::d_maxSpin'). 'PINNED_CONSUMER' is 'CONSUMER'
+    // with threads kept on the CPUs and memory of NUMA node zero and run
+    // under 'SCHED_FIFO' where permitted (see 'ipcmq::ThreadOptions'), so
+    // that its latency percentiles show the jitter that placement removes.
+    // 'SHM_MPMC' uses an 'ipcmq::ShmMpmcQueue' at either end, in place of
+    // the message queue.
+
+                                // ==========
+                                // class Mode
+                                // ==========
+
+IPCU_DEFINE_ENUM(Mode, BLOCKING, TIMED, TRY);
+    // 'BLOCKING' sends and receives without a timeout. 'TIMED' sends and
+    // receives with a timeout, retrying when it expires. 'TRY' sends and
+    // receives without blocking, retrying while the queue is full or empty.
+    // An 'ipcmq::Consumer' always receives in its own way.
+
+                              // ===============
+                              // class Execution
+                              // ===============
+
+IPCU_DEFINE_ENUM(Execution, THREADS, PROCESSES);
+    // 'THREADS' runs each sender and receiver in a thread of this process.
+    // 'PROCESSES' runs each in a child process.
+
+                              // ===============
+                              // struct Scenario
+                              // ===============
+
+struct Scenario {
+    // This 'struct' describes one run of the benchmark.
+
+    // DATA
+    Api           d_api;
+    ipcmq::Format d_format;         // 'RAW' for 'POSIX_QUEUE' and 'SHM_MPMC'
+    bsl::size_t   d_messageSize;    // bytes in each payload
+    Mode          d_mode;
+    int           d_numSenders;
+    int           d_numReceivers;
+    Execution     d_execution;
+    int           d_numPriorities;  // messages cycle through '[0, this)'
+    long          d_numMessages;    // sent by each sender
+
+    // CREATORS
+    Scenario();
+        // Create a 'Scenario' describing one sender blocking to send 1000
+        // messages of 16 bytes, all of priority zero, to one receiver in
+        // another thread, using 'ipcmq::QueueSender', 'ipcmq::QueueReceiver',
+        // and the extended format.
+};
+
+                               // =============
+                               // struct Result
+                               // =============
+
+struct Result {
+    // This 'struct' is the outcome of running a 'Scenario'.
+
+    // DATA
+    bsl::string         d_skipReason;   // empty unless the scenario did not
+                                        // run
+    bsls::Types::Int64  d_numSent;
+    bsls::Types::Int64  d_numReceived;
+    bsls::Types::Int64  d_numBytesReceived;
+    bsls::Types::Int64  d_numErrors;    // failed sends and receives
+    double              d_seconds;      // from the start until the last
+                                        // message was received
+    double              d_cpuSeconds;   // user and system time of this
+                                        // process and its children
+    ipcu::Histogram     d_latency;      // in nanoseconds, from the start of
+                                        // a send until its message was
+                                        // received
+
+    // CREATORS
+    Result();
+        // Create a 'Result' of a scenario that sent and received nothing.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -0,0 +1,69 @@
+
+#include <ipcmq_adaptivespinner.h>
+#include <ipcmq_waitutil.h>
+
+#include <bsls_timeinterval.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+// Each wait moves the average one over this much of the way toward it, so
+// that the average reflects roughly the last few waits.
+const bsls::Types::Int64 k_WEIGHT = 8;
+
+// The budget is at least this long, so that a message sent just as the
+// previous one was received is received without blocking.
+const bsls::Types::Int64 k_MIN_BUDGET_NANOSECONDS = 1000;
+
+}  // close unnamed namespace
+
+                           // ---------------------
+                           // class AdaptiveSpinner
+                           // ---------------------
+
+// CREATORS
+AdaptiveSpinner::AdaptiveSpinner(const bsls::TimeInterval& maxSpin)
+: d_maxNanoseconds(maxSpin > bsls::TimeInterval() ? maxSpin.totalNanoseconds()
+                                                  : 0)
+, d_meanWaitNanoseconds(0)
+, d_numPauses(1)
+{
+}
+
+// MANIPULATORS
+bsls::Types::Int64 AdaptiveSpinner::begin()
+{
+    d_numPauses = 1;
+
+    if (d_meanWaitNanoseconds > d_maxNanoseconds) {
+        return 0;                                                     // RETURN
+    }
+
+    const bsls::Types::Int64 budget =
+                      2 * d_meanWaitNanoseconds + k_MIN_BUDGET_NANOSECONDS;
+    return budget < d_maxNanoseconds ? budget : d_maxNanoseconds;
+}
+
+void AdaptiveSpinner::backoff()
+{
+    for (int i = 0; i < d_numPauses; ++i) {
+        WaitUtil::pause();
+    }
+
+    if (d_numPauses < k_MAX_PAUSES) {
+        d_numPauses *= 2;
+    }
+}
+
+void AdaptiveSpinner::recordWait(bsls::Types::Int64 nanoseconds)
+{
+    if (nanoseconds < 0) {
+        nanoseconds = 0;
+    }
+
+    d_meanWaitNanoseconds += (nanoseconds - d_meanWaitNanoseconds) / k_WEIGHT;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,91 @@
+#ifndef INCLUDED_IPCMQ_ADAPTIVESPINNER
+#define INCLUDED_IPCMQ_ADAPTIVESPINNER
+
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bsls { class TimeInterval; }
+namespace ipcmq {
+
+                           // =====================
+                           // class AdaptiveSpinner
+                           // =====================
+
+class AdaptiveSpinner {
+    // This mechanism decides for how long a thread about to block waiting for
+    // a message should instead poll for one, based on how long its recent
+    // waits lasted. Blocking costs a wake-up and a trip through the
+    // scheduler, often tens of microseconds, which polling avoids if a
+    // message arrives while it lasts, at the cost of a CPU for as long as it
+    // lasts. So polling pays only when waits are usually short: the spinner
+    // keeps a moving average of the recent waits, and its budget is twice
+    // that average, up to a maximum, or zero while the average exceeds the
+    // maximum, so that the thread blocks at once. Every wait is recorded,
+    // whether it ended while polling or after blocking, so the budget
+    // returns once messages arrive close together again. Between polls, the
+    // thread pauses for twice as long each time, up to a limit, so that a
+    // long spin polls less often. This class is not thread-safe; each
+    // receiving thread has its own.
+
+    // DATA
+    bsls::Types::Int64 d_maxNanoseconds;       // zero if disabled
+    bsls::Types::Int64 d_meanWaitNanoseconds;  // moving average
+    int                d_numPauses;            // before the next poll
+
+  public:
+    // PUBLIC CONSTANTS
+    enum { k_MAX_PAUSES = 64 };
+
+    // CREATORS
+    explicit AdaptiveSpinner(const bsls::TimeInterval& maxSpin);
+        // Create an 'AdaptiveSpinner' whose budget is at most the specified
+        // 'maxSpin', and is always zero if 'maxSpin' is not positive.
+
+    // MANIPULATORS
+    bsls::Types::Int64 begin();
+        // Begin to poll, and return the number of nanoseconds for which to
+        // poll before blocking, which is zero if the calling thread should
+        // block at once.
+
+    void backoff();
+        // Pause the calling thread between two polls, for twice as long as
+        // the previous time since 'begin', up to 'k_MAX_PAUSES' pause
+        // instructions.
+
+    void recordWait(bsls::Types::Int64 nanoseconds);
+        // Record that a wait for a message lasted the specified
+        // 'nanoseconds', whether it ended while polling or after blocking.
+
+    // ACCESSORS
+    bool isEnabled() const;
+        // Return whether this spinner ever has a budget.
+
+    bsls::Types::Int64 meanWaitNanoseconds() const;
+        // Return the moving average of the waits recorded.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                           // ---------------------
+                           // class AdaptiveSpinner
+                           // ---------------------
+
+// ACCESSORS
+inline
+bool AdaptiveSpinner::isEnabled() const
+{
+    return d_maxNanoseconds > 0;
+}
+
+inline
+bsls::Types::Int64 AdaptiveSpinner::meanWaitNanoseconds() const
+{
+    return d_meanWaitNanoseconds;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -0,0 +1,77 @@
+
+#include <ipcmq_codecregistry.h>
+
+#include <ball_log.h>
+
+#include <bslma_default.h>
+
+#include <bslmt_lockguard.h>
+#include <bslmt_once.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.CODECREGISTRY";
+
+}  // close unnamed namespace
+
+                            // -------------------
+                            // class CodecRegistry
+                            // -------------------
+
+// CLASS METHODS
+CodecRegistry& CodecRegistry::defaultRegistry()
+{
+    static CodecRegistry *ptr = 0;
+    BSLMT_ONCE_DO
+    {
+        static CodecRegistry registry(bslma::Default::globalAllocator());
+        ptr = &registry;
+    }
+
+    BSLS_ASSERT_SAFE(ptr);
+    return *ptr;
+}
+
+// CREATORS
+CodecRegistry::CodecRegistry(bslma::Allocator *basicAllocator)
+: d_storage(basicAllocator)
+{
+}
+
+// MANIPULATORS
+int CodecRegistry::registerCodec(unsigned char tag, const Codec& codec)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(codec.d_decoder);
+    BSLS_ASSERT(codec.d_bufferDecoder);
+
+    if (tag < k_MIN_APPLICATION_TAG) {
+        BALL_LOG_ERROR << "Unable to register the codec \"" << codec.d_name
+                       << "\" under the tag " << int(tag)
+                       << ", which is reserved." << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (const Codec *const existing = d_codecs[tag].loadRelaxed()) {
+        BALL_LOG_ERROR << "Unable to register the codec \"" << codec.d_name
+                       << "\" under the tag " << int(tag)
+                       << ", which is already used by the codec \""
+                       << existing->d_name << "\"." << BALL_LOG_END;
+        return 2;                                                     // RETURN
+    }
+
+    // 'bsl::deque' does not move its elements when appended to, so the
+    // pointer published below stays valid.
+    d_storage.push_back(codec);
+    d_codecs[tag].storeRelease(&d_storage.back());
+    return 0;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
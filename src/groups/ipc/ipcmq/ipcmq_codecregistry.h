@@ -0,0 +1,130 @@
+#ifndef INCLUDED_IPCMQ_CODECREGISTRY
+#define INCLUDED_IPCMQ_CODECREGISTRY
+
+#include <ipcmq_posixqueue.h>
+
+#include <bsl_deque.h>
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bslmt_mutex.h>
+
+#include <bsls_atomic.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+class MessageBuffer;
+class Payload;
+
+                                // ============
+                                // struct Codec
+                                // ============
+
+struct Codec {
+    // This 'struct' is a set of functions that encode payloads as messages
+    // and decode messages back into payloads (a "codec"). Each message ends
+    // with a byte (its "tag") that identifies the codec that can decode it.
+    // Each decoder is given the whole message, including its tag, and
+    // decodes it in place.
+
+    // TYPES
+    typedef int (*Encoder)(long               maxMessageSize,
+                           bslstl::StringRef *originalAndOutput,
+                           bsl::string       *messageBuffer);
+
+    typedef int (*Decoder)(bsl::string *originalAndOutput);
+
+    typedef int (*BufferDecoder)(MessageBuffer *originalAndOutput);
+
+    typedef int (*PayloadDecoder)(Payload *originalAndOutput);
+
+    typedef int (*BatchDecoder)(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+
+    // DATA
+    const char     *d_name;            // for diagnostics
+    Encoder         d_encoder;         // may be 0 if the codec only decodes
+    Decoder         d_decoder;
+    BufferDecoder   d_bufferDecoder;
+    PayloadDecoder  d_payloadDecoder;  // may be 0 to use 'd_bufferDecoder'
+    BatchDecoder    d_batchDecoder;    // may be 0 to decode each message of a
+                                       // batch using 'd_bufferDecoder'
+};
+
+                            // ===================
+                            // class CodecRegistry
+                            // ===================
+
+class CodecRegistry {
+    // This class is a table of codecs indexed by tag. Applications register
+    // their codecs under tags of their choosing, and receivers using the
+    // 'Format::e_TAGGED' format then decode each message using the codec
+    // registered under the message's tag, so one receiver can decode messages
+    // encoded by any mix of codecs. Looking up a codec is an index into an
+    // array, and does not lock. Tags below 'k_MIN_APPLICATION_TAG' are
+    // reserved for the codecs of this package, which are not stored in a
+    // registry (see 'FormatUtil::tagCodec'). This class is thread-safe.
+
+  public:
+    // PUBLIC CONSTANTS
+    static const int k_NUM_TAGS            = 256;
+    static const int k_MIN_APPLICATION_TAG = 16;
+
+  private:
+    // DATA
+    bsls::AtomicPointer<const Codec> d_codecs[k_NUM_TAGS];
+    bsl::deque<Codec>                d_storage;  // owns the registered codecs
+    bslmt::Mutex                     d_mutex;    // serializes registration
+
+    CodecRegistry(const CodecRegistry&);             // = delete
+    CodecRegistry& operator=(const CodecRegistry&);  // = delete
+
+  public:
+    // CLASS METHODS
+    static CodecRegistry& defaultRegistry();
+        // Return a reference to the registry consulted by the 'FormatUtil'
+        // functions that decode the 'Format::e_TAGGED' format. The registry
+        // is created the first time this function is called.
+
+    // CREATORS
+    explicit CodecRegistry(bslma::Allocator *basicAllocator = 0);
+        // Create a 'CodecRegistry' having no codecs. Optionally specify a
+        // 'basicAllocator' used to supply memory.
+
+    // MANIPULATORS
+    int registerCodec(unsigned char tag, const Codec& codec);
+        // Register a copy of the specified 'codec' under the specified 'tag'.
+        // Return zero on success, or a nonzero value if 'tag' is reserved or a
+        // codec is already registered under 'tag'. The behavior is undefined
+        // unless 'codec' has a decoder and a buffer decoder. Note that a codec
+        // that encodes messages ending with several tags is registered under
+        // each of them.
+
+    // ACCESSORS
+    const Codec *lookup(unsigned char tag) const;
+        // Return the address of the codec registered under the specified
+        // 'tag', or zero if there is none.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                            // -------------------
+                            // class CodecRegistry
+                            // -------------------
+
+// ACCESSORS
+inline
+const Codec *CodecRegistry::lookup(unsigned char tag) const
+{
+    return d_codecs[tag].loadAcquire();
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
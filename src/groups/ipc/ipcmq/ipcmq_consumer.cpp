@@ -3,11 +3,32 @@
 
 #include <ball_log.h>
 
+#include <bdlf_bind.h>
 #include <bdlf_memfn.h>
 
+#include <bsl_algorithm.h>
+#include <bsl_deque.h>
+
+#include <bslma_default.h>
 #include <bslma_stdallocator.h>
 
+#include <bslmt_barrier.h>
+#include <bslmt_threadattributes.h>
+
+#include <bsls_assert.h>
+#include <bsls_platform.h>
 #include <bsls_timeinterval.h>
+#include <bsls_timeutil.h>
+#include <bsls_types.h>
+
+#include <errno.h>   // errno, EINTR
+#include <string.h>  // strerror
+#include <unistd.h>  // close, write
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+#include <poll.h>         // poll
+#include <sys/eventfd.h>  // eventfd
+#endif
 
 namespace BloombergLP {
 namespace ipcmq {
@@ -15,11 +36,80 @@ namespace {
 
 const char k_LOG_CATEGORY[] = "IPCMQ.CONSUMER";
 
-// Poll at most once every 100 milliseconds.
+// Where a receiving thread cannot be woken for shutdown, check for shutdown
+// at least once every 100 milliseconds.
 const bsls::TimeInterval k_TIMEOUT(0, 100 * 1000 * 1000);
 
+void placeWorker(const ThreadOptions *options, bslmt::Barrier *barrier)
+    // Apply the specified 'options' to the calling worker thread, and then
+    // wait for the specified 'barrier', so that the worker does not take the
+    // job meant for another.
+{
+    ThreadOptionsUtil::applyToSelf(*options);
+    barrier->wait();
+}
+
 }  // close unnamed namespace
 
+                           // ----------------------
+                           // struct ConsumerOptions
+                           // ----------------------
+
+// CREATORS
+ConsumerOptions::ConsumerOptions()
+: d_numReceiverThreads(1)
+, d_numWorkerThreads(0)
+, d_maxInFlight(0)
+{
+}
+
+                            // -------------------
+                            // struct ConsumerBand
+                            // -------------------
+
+// CREATORS
+ConsumerBand::ConsumerBand()
+: d_minPriority(0)
+, d_callback()
+, d_numWorkerThreads(0)
+{
+}
+
+                         // ==========================
+                         // struct Consumer::BandState
+                         // ==========================
+
+struct Consumer::BandState {
+    // This 'struct' holds the messages handed to one band of a 'Consumer'
+    // and not yet processed, and everything needed to process them.
+
+    // DATA
+    unsigned            d_minPriority;
+    MessageCallback     d_callback;
+    bool                d_isShared;    // processed by shared worker threads
+    bsl::deque<Pending> d_pending;     // protected by 'd_bandMutex'
+    bslmt::Condition    d_condition;   // signaled when a message is handed
+                                       // to this band, or on stopping
+    Metrics             d_metrics;
+
+    // CREATORS
+    BandState(const Band&             band,
+              const MessageCallback&  defaultCallback,
+              bslma::Allocator       *allocator)
+    : d_minPriority(band.d_minPriority)
+    , d_callback(bsl::allocator_arg_t(),
+                 bsl::allocator<MessageCallback>(allocator),
+                 band.d_callback ? band.d_callback : defaultCallback)
+    , d_isShared(band.d_numWorkerThreads == 0)
+    , d_pending(allocator)
+    {
+    }
+};
+
+                               // --------------
+                               // class Consumer
+                               // --------------
+
 // CREATORS
 Consumer::Consumer(const bslstl::StringRef&       name,
                    Format                         format,
@@ -28,68 +118,744 @@ Consumer::Consumer(const bslstl::StringRef&       name,
                    int                            filePermissions,
                    bslma::Allocator              *allocator)
 : d_shuttingDown(false)
-, d_messageBuffer(allocator)
 , d_receiver(name, format, attributes, filePermissions, allocator)
 , d_callback(bsl::allocator_arg_t(),
              bsl::allocator<MessageCallback>(allocator),
              callback)
-, d_thread(bslmt::ThreadUtil::invalidHandle())
+, d_pool(allocator)
+, d_receiverThreads(allocator)
+, d_eventFd(-1)
+, d_bands(allocator)
+, d_bandsStopping(false)
+, d_bandThreads(allocator)
+, d_maxAgeTicks(0)
+, d_isStarted(false)
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    d_isStarted = start(name, Options()) == 0;
+}
+
+Consumer::Consumer(const bslstl::StringRef&       name,
+                   Format                         format,
+                   const MessageCallback&         callback,
+                   const Options&                 options,
+                   const PosixQueue::Attributes&  attributes,
+                   int                            filePermissions,
+                   bslma::Allocator              *allocator)
+: d_shuttingDown(false)
+, d_receiver(name, format, attributes, filePermissions, allocator)
+, d_callback(bsl::allocator_arg_t(),
+             bsl::allocator<MessageCallback>(allocator),
+             callback)
+, d_pool(allocator)
+, d_receiverThreads(allocator)
+, d_eventFd(-1)
+, d_bands(allocator)
+, d_bandsStopping(false)
+, d_bandThreads(allocator)
+, d_maxAgeTicks(0)
+, d_isStarted(false)
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    d_isStarted = start(name, options) == 0;
+}
+
+Consumer::Consumer(const bslstl::StringRef&       name,
+                   Format                         format,
+                   const MessageCallback&         callback,
+                   const bsl::vector<Band>&       bands,
+                   const Options&                 options,
+                   const PosixQueue::Attributes&  attributes,
+                   int                            filePermissions,
+                   bslma::Allocator              *allocator)
+: d_shuttingDown(false)
+, d_receiver(name, format, attributes, filePermissions, allocator)
+, d_callback(bsl::allocator_arg_t(),
+             bsl::allocator<MessageCallback>(allocator),
+             callback)
+, d_pool(allocator)
+, d_receiverThreads(allocator)
+, d_eventFd(-1)
+, d_bands(allocator)
+, d_bandsStopping(false)
+, d_bandThreads(allocator)
+, d_maxAgeTicks(0)
+, d_isStarted(false)
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    // Receiving does not begin unless every band can process its messages,
+    // since a message handed to a band without threads would never return
+    // its work buffer.
+    d_isStarted = startBands(bands, options) == 0 &&
+                  start(name, options) == 0;
+}
+
+Consumer::~Consumer()
+{
+    stop();
+
+    // Every thread is done, so every work buffer is free. Return them to the
+    // pool, which must have all of its buffers back before it is destroyed.
+    if (d_freeWorkBuffers_mp) {
+        d_freeWorkBuffers_mp->enablePopFront();
+
+        bsl::string *buffer;
+        while (d_freeWorkBuffers_mp->tryPopFront(&buffer) == 0) {
+            d_pool.releaseBuffer(buffer);
+        }
+    }
+
+    if (d_eventFd != -1) {
+        close(d_eventFd);
+    }
+}
+
+// MANIPULATORS
+int Consumer::start(const bslstl::StringRef& name, const Options& options)
 {
     BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(options.d_numReceiverThreads > 0);
+    BSLS_ASSERT(options.d_numWorkerThreads >= 0);
+    BSLS_ASSERT(options.d_maxInFlight >= 0);
+
+    d_maxSpin = options.d_maxSpin;
+
+    bslmt::ThreadAttributes attributes;
+    ThreadOptionsUtil::loadAttributes(&attributes, options.d_threadOptions);
 
-    const int rc = bslmt::ThreadUtil::create(
-                  &d_thread, bdlf::MemFnUtil::memFn(&Consumer::consume, this));
-    if (rc) {
+#ifdef BSLS_PLATFORM_OS_LINUX
+    if (d_receiver.posixQueue().fileDescriptor() != -1) {
+        d_eventFd = eventfd(0, EFD_CLOEXEC);
+        if (d_eventFd == -1) {
+            BALL_LOG_WARN << "Unable to create eventfd, so the consumer of "
+                             "the message queue "
+                          << name << " will poll for shutdown: "
+                          << strerror(errno) << BALL_LOG_END;
+        }
+    }
+#endif
+
+    bslmt::ThreadUtil::Invokable receiveLoop;
+    if (!d_bands.empty()) {
+        // The worker threads of the bands are already running.
+        const int numWorkerThreads = bsl::max(1, d_bandThreads.numThreads());
+        createWorkBuffers(options.d_maxInFlight ? options.d_maxInFlight
+                                                : 2 * numWorkerThreads);
+
+        receiveLoop =
+            bdlf::MemFnUtil::memFn(&Consumer::consumeAndRoute, this);
+    }
+    else if (options.d_numWorkerThreads == 0) {
+        receiveLoop = bdlf::MemFnUtil::memFn(&Consumer::consume, this);
+    }
+    else {
+        const int maxInFlight = options.d_maxInFlight
+                                    ? options.d_maxInFlight
+                                    : 2 * options.d_numWorkerThreads;
+        createWorkBuffers(maxInFlight);
+
+        // Since receiving threads never hand off more than 'maxInFlight'
+        // jobs, the worker pool's queue never fills.
+        d_workers_mp.load(new (*d_allocator_p) bdlmt::FixedThreadPool(
+                              attributes,
+                              options.d_numWorkerThreads,
+                              maxInFlight,
+                              d_allocator_p),
+                          d_allocator_p);
+        if (const int rc = d_workers_mp->start()) {
+            BALL_LOG_ERROR << "Unable to start worker threads for consumer of "
+                              "the message queue "
+                           << name << ". rc=" << rc << BALL_LOG_END;
+            d_workers_mp.reset();
+            stop();
+            return rc;                                                // RETURN
+        }
+
+        if (options.d_threadOptions.hasPlacement()) {
+            // A worker thread runs only jobs, so each is given a job that
+            // places it and then waits until every worker has one, so that
+            // none takes two.
+            bslmt::Barrier barrier(options.d_numWorkerThreads + 1);
+            for (int i = 0; i < options.d_numWorkerThreads; ++i) {
+                const int rc = d_workers_mp->enqueueJob(
+                      bdlf::BindUtil::bind(&placeWorker,
+                                           &options.d_threadOptions,
+                                           &barrier));
+                BSLS_ASSERT_OPT(rc == 0);
+            }
+            barrier.wait();
+        }
+
+        receiveLoop =
+            bdlf::MemFnUtil::memFn(&Consumer::consumeAndDispatch, this);
+    }
+
+    const int numStarted = d_receiverThreads.addThreads(
+                          bdlf::BindUtil::bind(&ThreadOptionsUtil::run,
+                                               options.d_threadOptions,
+                                               receiveLoop),
+                          options.d_numReceiverThreads,
+                          attributes);
+    if (numStarted != options.d_numReceiverThreads) {
         BALL_LOG_ERROR << "Unable to start consumer thread for consumer of "
                           "the message queue "
-                       << name << BALL_LOG_END;
+                       << name << ". Started " << numStarted << " of "
+                       << options.d_numReceiverThreads
+                       << ". The consumer is stopped." << BALL_LOG_END;
+        stop();
+        return -1;                                                    // RETURN
     }
+
+    return 0;
 }
 
-Consumer::~Consumer()
+void Consumer::createWorkBuffers(int maxInFlight)
+{
+    BSLS_ASSERT(maxInFlight > 0);
+
+    // Each message in flight occupies one buffer from the time it's received
+    // until its callback returns, so the number of buffers bounds the work in
+    // flight. A buffer whose handle the callback keeps is replaced by another
+    // from the pool, so the number stays the same.
+    d_freeWorkBuffers_mp.load(
+        new (*d_allocator_p) bdlcc::FixedQueue<bsl::string *>(maxInFlight,
+                                                              d_allocator_p),
+        d_allocator_p);
+    for (int i = 0; i < maxInFlight; ++i) {
+        d_freeWorkBuffers_mp->pushBack(d_pool.getBuffer());
+    }
+}
+
+int Consumer::startBands(const bsl::vector<Band>& bands,
+                         const Options&           options)
 {
     BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(!bands.empty());
+    BSLS_ASSERT(bands.back().d_minPriority == 0);
 
-    if (d_thread == bslmt::ThreadUtil::invalidHandle()) {
-        // Thread never started. Nothing to join.
-        return;                                                       // RETURN
+    if (options.d_maxAge > bsls::TimeInterval()) {
+        d_maxAgeTicks = options.d_maxAge.totalNanoseconds();
     }
 
+    bslmt::ThreadAttributes attributes;
+    ThreadOptionsUtil::loadAttributes(&attributes, options.d_threadOptions);
+
+    bool hasSharedBand = false;
+    for (bsl::size_t i = 0; i < bands.size(); ++i) {
+        const Band& band = bands[i];
+        BSLS_ASSERT(i == 0 || band.d_minPriority < bands[i - 1].d_minPriority);
+        BSLS_ASSERT(band.d_numWorkerThreads >= 0);
+
+        d_bands.push_back(bsl::allocate_shared<BandState>(
+            d_allocator_p, band, d_callback, d_allocator_p));
+        hasSharedBand = hasSharedBand || band.d_numWorkerThreads == 0;
+    }
+
+    bool isShort = false;
+    for (int i = 0; i < int(bands.size()); ++i) {
+        const int numThreads = bands[i].d_numWorkerThreads;
+        if (numThreads == 0) {
+            continue;
+        }
+
+        const int numStarted = d_bandThreads.addThreads(
+            bdlf::BindUtil::bind(
+                &ThreadOptionsUtil::run,
+                options.d_threadOptions,
+                bslmt::ThreadUtil::Invokable(
+                    bdlf::BindUtil::bind(&Consumer::processBand, this, i))),
+            numThreads,
+            attributes);
+        if (numStarted != numThreads) {
+            BALL_LOG_ERROR << "Unable to start worker thread for priority "
+                              "band "
+                           << i << ". Started " << numStarted << " of "
+                           << numThreads << BALL_LOG_END;
+            isShort = true;
+        }
+    }
+
+    if (hasSharedBand) {
+        BSLS_ASSERT(options.d_numWorkerThreads > 0);
+
+        const int numStarted = d_bandThreads.addThreads(
+            bdlf::BindUtil::bind(
+                &ThreadOptionsUtil::run,
+                options.d_threadOptions,
+                bslmt::ThreadUtil::Invokable(
+                    bdlf::MemFnUtil::memFn(&Consumer::processShared, this))),
+            options.d_numWorkerThreads,
+            attributes);
+        if (numStarted != options.d_numWorkerThreads) {
+            BALL_LOG_ERROR << "Unable to start shared worker thread for "
+                              "priority bands. Started "
+                           << numStarted << " of "
+                           << options.d_numWorkerThreads << BALL_LOG_END;
+            isShort = true;
+        }
+    }
+
+    if (isShort) {
+        // Nothing has been received yet, so the threads that did start have
+        // nothing to process.
+        BALL_LOG_ERROR << "The consumer is stopped." << BALL_LOG_END;
+        stopBands();
+        return -1;                                                    // RETURN
+    }
+
+    return 0;
+}
+
+void Consumer::stop()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
     d_shuttingDown = true;
-    const int rc   = bslmt::ThreadUtil::join(d_thread);
-    if (rc) {
-        BALL_LOG_ERROR << "Unable to join consumer thread. "
-                          "This most likely means that a deadlock was "
-                          "detected. The unjoined thread might access data "
-                          "members of this object after it is destroyed, so "
-                          "the program might now be in a bad state. "
-                          "bslmt::ThreadUtil::join returned rc="
-                       << rc << BALL_LOG_END;
+
+    // Wake every receiving thread. The eventfd is never read, so it remains
+    // readable, and each thread sees it the next time it waits.
+    if (d_eventFd != -1) {
+        const bsls::Types::Uint64 one = 1;
+        if (write(d_eventFd, &one, sizeof one) == -1) {
+            BALL_LOG_ERROR << "Unable to signal the consumer threads: "
+                           << strerror(errno) << BALL_LOG_END;
+        }
+    }
+
+    // Wake any receiving thread waiting for a free work buffer.
+    if (d_freeWorkBuffers_mp) {
+        d_freeWorkBuffers_mp->disablePopFront();
+    }
+
+    d_receiverThreads.joinAll();
+
+    if (!d_bands.empty()) {
+        stopBands();
+    }
+
+    if (d_workers_mp) {
+        // Process the messages already handed to the workers, and then join
+        // them.
+        d_workers_mp->stop();
+        d_workers_mp.reset();
     }
 }
 
-// MANIPULATORS
-void Consumer::consume()
+void Consumer::stopBands()
+{
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_bandMutex);
+        d_bandsStopping = true;
+        d_sharedCondition.broadcast();
+        for (bsl::size_t i = 0; i < d_bands.size(); ++i) {
+            d_bands[i]->d_condition.broadcast();
+        }
+    }
+
+    d_bandThreads.joinAll();
+}
+
+int Consumer::receive(bsl::string     *buffer,
+                      unsigned        *priority,
+                      AdaptiveSpinner *spinner)
+{
+    BSLS_ASSERT(spinner);
+
+    if (!spinner->isEnabled()) {
+        return waitAndReceive(buffer, priority);                      // RETURN
+    }
+
+    // The wait is recorded however it ends, so that the spinner sees the
+    // gaps between messages even while it does not poll.
+    const bsls::Types::Int64 start = bsls::TimeUtil::getTimer();
+    int                      rc    = spin(buffer, priority, spinner);
+    if (rc == int(PosixQueue::Receive::e_EMPTY)) {
+        rc = waitAndReceive(buffer, priority);
+    }
+    if (rc == 0) {
+        spinner->recordWait(bsls::TimeUtil::getTimer() - start);
+    }
+
+    return rc;
+}
+
+int Consumer::spin(bsl::string     *buffer,
+                   unsigned        *priority,
+                   AdaptiveSpinner *spinner)
 {
     BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
 
-    while (!d_shuttingDown.load()) {
-        unsigned  priority;
-        const int rc =
-            d_receiver.receive(&d_messageBuffer, k_TIMEOUT, &priority);
-        if (rc == 0) {
-            d_callback(&d_messageBuffer, priority);
-        }
-        else if (rc != int(PosixQueue::Receive::e_TIMED_OUT)) {
-            // Note that the condition above assumes that
-            // 'QueueReceiver::receive' returns a 'PosixQueue::Receive::Result'
-            // cast to an 'int', which we are not allowed to assume based on
-            // the contract. But it does, so we will.
+    const bsls::Types::Int64 budget = spinner->begin();
+    if (!budget) {
+        return PosixQueue::Receive::e_EMPTY;                          // RETURN
+    }
+
+    const bsls::Types::Int64 start = bsls::TimeUtil::getTimer();
+    bsls::Types::Int64       now;
+    int                      rc;
+    for (;;) {
+        rc  = d_receiver.tryReceive(buffer, priority);
+        now = bsls::TimeUtil::getTimer();
+
+        if (rc != int(PosixQueue::Receive::e_EMPTY) || now - start >= budget ||
+            d_shuttingDown.load()) {
+            break;
+        }
+        spinner->backoff();
+    }
+
+    d_callbackMetrics.recordSpin(now - start, rc == 0);
+
+    // A failed receive may have taken a message off the queue, so its error
+    // is reported here rather than hidden by receiving another.
+    if (rc && rc != int(PosixQueue::Receive::e_EMPTY)) {
+        BALL_LOG_ERROR << "Unable to receive message from message queue: "
+                       << d_receiver.description(rc) << BALL_LOG_END;
+    }
+    return rc;
+}
+
+int Consumer::waitAndReceive(bsl::string *buffer, unsigned *priority)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    // Note that the conditions below assume that 'QueueReceiver::receive'
+    // returns a 'PosixQueue::Receive::Result' cast to an 'int', which we are
+    // not allowed to assume based on the contract. But it does, so we will.
+
+    if (d_eventFd == -1) {
+        const int rc = d_receiver.receive(buffer, k_TIMEOUT, priority);
+        if (rc && rc != int(PosixQueue::Receive::e_TIMED_OUT)) {
             BALL_LOG_ERROR << "Unable to receive message from message queue: "
                            << d_receiver.description(rc) << BALL_LOG_END;
         }
+        return rc;                                                    // RETURN
+    }
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    // Payloads unpacked from a packed message do not make the queue
+    // readable, so they are delivered without waiting.
+    if (d_receiver.hasUnpackedPayloads() &&
+        d_receiver.tryReceive(buffer, priority) == 0) {
+        return 0;                                                     // RETURN
+    }
+
+    pollfd descriptors[2];
+    descriptors[0].fd     = d_receiver.posixQueue().fileDescriptor();
+    descriptors[0].events = POLLIN;
+    descriptors[1].fd     = d_eventFd;
+    descriptors[1].events = POLLIN;
+
+    if (poll(descriptors, 2, -1) == -1) {
+        if (errno != EINTR) {
+            BALL_LOG_ERROR << "Unable to wait for message queue: "
+                           << strerror(errno) << BALL_LOG_END;
+        }
+        return -1;                                                    // RETURN
+    }
+
+    if (descriptors[1].revents) {
+        // shutting down
+        return -1;                                                    // RETURN
+    }
+
+    // The queue is readable, but when there are several receiving threads,
+    // all of them are woken, and only one gets the message. The others find
+    // the queue empty and wait again.
+    const int rc = d_receiver.tryReceive(buffer, priority);
+    if (rc && rc != int(PosixQueue::Receive::e_EMPTY)) {
+        BALL_LOG_ERROR << "Unable to receive message from message queue: "
+                       << d_receiver.description(rc) << BALL_LOG_END;
+    }
+    return rc;
+#else
+    BSLS_ASSERT_OPT(!"unreachable");
+    return -1;
+#endif
+}
+
+void Consumer::consume()
+{
+    // Each receiving thread has its own buffer, which keeps its capacity from
+    // one message to the next unless the callback keeps it.
+    bsl::string     *buffer = d_pool.getBuffer();
+    AdaptiveSpinner  spinner(d_maxSpin);
+
+    while (!d_shuttingDown.load()) {
+        Pending message;
+        message.d_buffer = buffer;
+        if (receive(buffer, &message.d_priority, &spinner) == 0) {
+            message.d_receivedAt = bsls::TimeUtil::getTimer();
+            buffer               = invokeCallback(message);
+        }
+    }
+
+    d_pool.releaseBuffer(buffer);
+}
+
+void Consumer::consumeAndDispatch()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(d_workers_mp);
+    BSLS_ASSERT(d_freeWorkBuffers_mp);
+
+    AdaptiveSpinner spinner(d_maxSpin);
+
+    while (!d_shuttingDown.load()) {
+        // Wait for a free buffer. This is what bounds the work in flight.
+        bsl::string *buffer;
+        if (d_freeWorkBuffers_mp->popFront(&buffer)) {
+            // shutting down
+            return;                                                   // RETURN
+        }
+
+        Pending message;
+        message.d_buffer = buffer;
+        if (receive(buffer, &message.d_priority, &spinner) == 0) {
+            message.d_receivedAt = bsls::TimeUtil::getTimer();
+            if (d_workers_mp->enqueueJob(bdlf::BindUtil::bind(
+                    &Consumer::process, this, message)) == 0) {
+                continue;
+            }
+
+            BALL_LOG_ERROR << "Unable to hand a message to a worker thread. "
+                              "The message is dropped."
+                           << BALL_LOG_END;
+        }
+
+        d_freeWorkBuffers_mp->pushBack(buffer);
+    }
+}
+
+void Consumer::consumeAndRoute()
+{
+    BSLS_ASSERT(d_freeWorkBuffers_mp);
+
+    AdaptiveSpinner spinner(d_maxSpin);
+
+    while (!d_shuttingDown.load()) {
+        // Wait for a free buffer. This is what bounds the work in flight.
+        bsl::string *buffer;
+        if (d_freeWorkBuffers_mp->popFront(&buffer)) {
+            // shutting down
+            return;                                                   // RETURN
+        }
+
+        Pending message;
+        message.d_buffer = buffer;
+        if (receive(buffer, &message.d_priority, &spinner) != 0) {
+            d_freeWorkBuffers_mp->pushBack(buffer);
+            continue;
+        }
+        message.d_receivedAt = bsls::TimeUtil::getTimer();
+
+        BandState& band = *d_bands[bandIndex(message.d_priority)];
+
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_bandMutex);
+        band.d_pending.push_back(message);
+        if (band.d_isShared) {
+            d_sharedCondition.signal();
+        }
+        else {
+            band.d_condition.signal();
+        }
+    }
+}
+
+void Consumer::processBand(int band)
+{
+    BandState& state = *d_bands[band];
+
+    for (;;) {
+        Pending message;
+        {
+            bslmt::LockGuard<bslmt::Mutex> guard(&d_bandMutex);
+            while (state.d_pending.empty() && !d_bandsStopping) {
+                state.d_condition.wait(&d_bandMutex);
+            }
+            if (state.d_pending.empty()) {
+                // stopping, and nothing left to process
+                return;                                               // RETURN
+            }
+            message = state.d_pending.front();
+            state.d_pending.pop_front();
+        }
+
+        processInBand(&state, message);
     }
 }
 
+void Consumer::processShared()
+{
+    for (;;) {
+        BandState *band;
+        Pending    message;
+        {
+            bslmt::LockGuard<bslmt::Mutex> guard(&d_bandMutex);
+            while (0 == (band = nextSharedBand()) && !d_bandsStopping) {
+                d_sharedCondition.wait(&d_bandMutex);
+            }
+            if (!band) {
+                // stopping, and nothing left to process
+                return;                                               // RETURN
+            }
+            message = band->d_pending.front();
+            band->d_pending.pop_front();
+        }
+
+        processInBand(band, message);
+    }
+}
+
+void Consumer::process(const Pending& message)
+{
+    d_freeWorkBuffers_mp->pushBack(invokeCallback(message));
+}
+
+void Consumer::processInBand(BandState *band, const Pending& message)
+{
+    BSLS_ASSERT(band);
+
+    // Once the callback is invoked, the buffer may belong to the
+    // application, so it is measured first.
+    band->d_metrics.recordMessage(message.d_buffer->length());
+
+    const bsls::Types::Int64  start = bsls::TimeUtil::getTimer();
+    bsl::string              *next  = handOff(band->d_callback, message);
+    const bsls::Types::Int64  end   = bsls::TimeUtil::getTimer();
+
+    band->d_metrics.recordCallbackTime(end - start);
+    band->d_metrics.recordLatency(end - message.d_receivedAt);
+    d_callbackMetrics.recordCallbackTime(end - start);
+    d_callbackMetrics.recordLatency(end - message.d_receivedAt);
+
+    d_freeWorkBuffers_mp->pushBack(next);
+}
+
+bsl::string *Consumer::invokeCallback(const Pending& message)
+{
+    const bsls::Types::Int64  start = bsls::TimeUtil::getTimer();
+    bsl::string              *next  = handOff(d_callback, message);
+    const bsls::Types::Int64  end   = bsls::TimeUtil::getTimer();
+
+    d_callbackMetrics.recordCallbackTime(end - start);
+    d_callbackMetrics.recordLatency(end - message.d_receivedAt);
+
+    return next;
+}
+
+bsl::string *Consumer::handOff(const MessageCallback& callback,
+                               const Pending&         message)
+{
+    MessageHandle handle(message.d_buffer, &d_pool);
+    callback(handle, message.d_priority);
+
+    if (handle.get() == message.d_buffer) {
+        // The callback did not keep the message, so its buffer is reused
+        // as it is, without a trip through the pool.
+        return handle.release();                                      // RETURN
+    }
+
+    // The buffer belongs to the application now, or is back in the pool,
+    // and whatever the callback left in 'handle' returns to the pool.
+    return d_pool.getBuffer();
+}
+
+Consumer::BandState *Consumer::nextSharedBand()
+{
+    // The highest band having a message goes first, unless the oldest
+    // message of any band has waited too long, in which case it goes first.
+    BandState          *highest    = 0;
+    BandState          *oldest     = 0;
+    bsls::Types::Int64  oldestTime = 0;
+    for (bsl::size_t i = 0; i < d_bands.size(); ++i) {
+        BandState& band = *d_bands[i];
+        if (!band.d_isShared || band.d_pending.empty()) {
+            continue;
+        }
+
+        if (!highest) {
+            highest = &band;
+            if (!d_maxAgeTicks) {
+                break;
+            }
+        }
+
+        const bsls::Types::Int64 receivedAt =
+                                         band.d_pending.front().d_receivedAt;
+        if (!oldest || receivedAt < oldestTime) {
+            oldest     = &band;
+            oldestTime = receivedAt;
+        }
+    }
+
+    if (oldest && bsls::TimeUtil::getTimer() - oldestTime > d_maxAgeTicks) {
+        return oldest;                                                // RETURN
+    }
+
+    return highest;
+}
+
+void Consumer::resetMetrics()
+{
+    d_receiver.resetMetrics();
+    d_callbackMetrics.reset();
+    for (bsl::size_t i = 0; i < d_bands.size(); ++i) {
+        d_bands[i]->d_metrics.reset();
+    }
+}
+
+// ATTRIBUTES
+bool Consumer::isOpen() const
+{
+    return d_isStarted && d_receiver.isOpen();
+}
+
+void Consumer::loadMetrics(MetricsSnapshot *result) const
+{
+    BSLS_ASSERT(result);
+
+    d_receiver.loadMetrics(result);
+
+    MetricsSnapshot callbacks;
+    d_callbackMetrics.loadSnapshot(&callbacks);
+    result->d_callbackNanoseconds = callbacks.d_callbackNanoseconds;
+    result->d_latencyNanoseconds  = callbacks.d_latencyNanoseconds;
+    result->d_numSpinHits         = callbacks.d_numSpinHits;
+    result->d_numSpinMisses       = callbacks.d_numSpinMisses;
+    result->d_spinNanoseconds     = callbacks.d_spinNanoseconds;
+}
+
+int Consumer::numBands() const
+{
+    return int(d_bands.size());
+}
+
+const MessagePool& Consumer::messagePool() const
+{
+    return d_pool;
+}
+
+void Consumer::loadBandMetrics(MetricsSnapshot *result, int band) const
+{
+    BSLS_ASSERT(result);
+    BSLS_ASSERT(0 <= band);
+    BSLS_ASSERT(band < numBands());
+
+    d_bands[band]->d_metrics.loadSnapshot(result);
+}
+
+int Consumer::bandIndex(unsigned priority) const
+{
+    // There are few bands, so a linear search is fastest. The last band
+    // holds priority zero, so the search always succeeds.
+    int index = 0;
+    while (priority < d_bands[index]->d_minPriority) {
+        ++index;
+    }
+
+    return index;
+}
+
 }  // close package namespace
 }  // close enterprise namespace
@@ -1,35 +1,235 @@
 #ifndef INCLUDED_IPCMQ_CONSUMER
 #define INCLUDED_IPCMQ_CONSUMER
 
+#include <ipcmq_adaptivespinner.h>
+#include <ipcmq_messagepool.h>
+#include <ipcmq_metrics.h>
 #include <ipcmq_posixqueue.h>
 #include <ipcmq_queuereceiver.h>
+#include <ipcmq_threadoptions.h>
+
+#include <bdlcc_fixedqueue.h>
+
+#include <bdlmt_fixedthreadpool.h>
 
 #include <bsl_functional.h>
+#include <bsl_memory.h>
 #include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bslma_managedptr.h>
 
-#include <bslmt_threadutil.h>
+#include <bslmt_condition.h>
+#include <bslmt_mutex.h>
+#include <bslmt_threadgroup.h>
 
 #include <bsls_atomic.h>
+#include <bsls_timeinterval.h>
+#include <bsls_types.h>
 
 namespace BloombergLP {
 namespace bslma { class Allocator; }
 namespace ipcmq {
 
+                           // ======================
+                           // struct ConsumerOptions
+                           // ======================
+
+struct ConsumerOptions {
+    // This 'struct' describes the threads used by a 'Consumer'. By default, a
+    // 'Consumer' has one thread that both receives messages and invokes the
+    // callback with each.
+
+    // DATA
+    int d_numReceiverThreads;
+        // the number of threads receiving from the queue concurrently
+
+    int d_numWorkerThreads;
+        // the number of threads invoking the callback, or zero if the
+        // receiving threads invoke the callback themselves
+
+    int d_maxInFlight;
+        // the maximum number of messages received but not yet processed by a
+        // worker thread, or zero to use twice the number of worker threads.
+        // Ignored if there are no worker threads.
+
+    bsls::TimeInterval d_maxAge;
+        // if positive, how long a message of a band without threads of its
+        // own may wait for a shared worker thread before it is processed
+        // ahead of the messages of higher bands, so that a busy band does not
+        // starve the bands below it. Ignored if there are no bands.
+
+    bsls::TimeInterval d_maxSpin;
+        // if positive, the most time for which a receiving thread polls the
+        // queue before it blocks, adapted to how long its recent waits for a
+        // message lasted (see 'AdaptiveSpinner'), so that a message that
+        // arrives soon is received without the cost of waking the thread, at
+        // the cost of a CPU while polling
+
+    ThreadOptions d_threadOptions;
+        // the CPUs, NUMA node, scheduling policy, stack size, and name of
+        // every thread of the 'Consumer', receiving or worker. A message
+        // buffer first grows on the receiving thread that uses it, so its
+        // memory is on the NUMA node of that thread. Options that are not
+        // permitted are logged and ignored (see 'ThreadOptionsUtil').
+
+    // CREATORS
+    ConsumerOptions();
+        // Create a 'ConsumerOptions' object describing one receiving thread,
+        // no worker threads, no aging, no polling, and threads that run as
+        // any other.
+};
+
+                            // ===================
+                            // struct ConsumerBand
+                            // ===================
+
+struct ConsumerBand {
+    // This 'struct' describes a band of message priorities that a 'Consumer'
+    // processes apart from the others, using a callback and worker threads
+    // of its own, and whose metrics it keeps separately.
+
+    // PUBLIC TYPES
+    typedef bsl::function<void(MessageHandle&, unsigned)> MessageCallback;
+
+    // DATA
+    unsigned d_minPriority;
+        // the least priority of the messages in this band, which holds every
+        // priority from this one up to, but not including, the least
+        // priority of the next higher band
+
+    MessageCallback d_callback;
+        // invoked with a handle to each message in this band and its
+        // priority, or empty to invoke the callback of the 'Consumer'
+
+    int d_numWorkerThreads;
+        // the number of worker threads that process only the messages of
+        // this band, or zero for the shared worker threads to process them.
+        // A band having threads of its own is a fast lane: its messages never
+        // wait behind those of another band.
+
+    // CREATORS
+    ConsumerBand();
+        // Create a 'ConsumerBand' object describing every priority, processed
+        // by the callback of the 'Consumer' on the shared worker threads.
+};
+
+                               // ==============
+                               // class Consumer
+                               // ==============
+
 class Consumer {
-    // This class manages a thread that receives messages from a message queue,
-    // invoking a callback function with each message received.
+    // This class manages threads that receive messages from a message queue,
+    // invoking a callback function with each message received. By default,
+    // one thread both receives and invokes the callback, so that messages are
+    // processed one at a time in the order received. Optionally, several
+    // threads can receive from the queue concurrently, each with its own
+    // message buffer, and the callback can be invoked by a pool of worker
+    // threads instead, so that a slow callback does not delay receiving. In
+    // either case, the callback may be invoked concurrently from different
+    // threads, and messages may be processed out of order.
+    //
+    // Optionally, the priorities can be divided into bands, each processed
+    // by worker threads of its own, or by shared worker threads. A message is
+    // handed to the band of its priority as soon as it is received, so that
+    // a slow callback in one band does not delay the messages of another.
+    // The shared worker threads take the oldest message of the highest band
+    // that has any, unless aging is enabled and a message of a lower band has
+    // waited too long. Note that every band draws on the same bounded number
+    // of messages in flight, so a band whose callback cannot keep up with
+    // its messages eventually delays receiving the messages of every band;
+    // such a band should be given enough threads.
+    //
+    // On Linux, the receiving threads block in 'poll' on the queue's
+    // descriptor and on an 'eventfd' used to signal shutdown, so that an idle
+    // 'Consumer' uses no CPU and is destroyed without delay. On other
+    // platforms, the receiving threads wake every 100 milliseconds to check
+    // for shutdown. Optionally, a receiving thread first polls the queue
+    // without blocking, for a time adapted to the recent gaps between
+    // messages, which lowers the latency of messages that arrive close
+    // together; the metrics count the polls that found a message and those
+    // that did not, and record how long each lasted, which is the CPU time
+    // spent on polling.
+    //
+    // Messages are received into buffers drawn from a 'MessagePool', and the
+    // callback is given a 'MessageHandle' that owns the buffer. A callback
+    // that needs the message after it returns moves the handle, rather than
+    // copying the message, and the buffer returns to the pool when the
+    // handle is destroyed or reset, on any thread; otherwise the buffer is
+    // reused for the next message as soon as the callback returns. A handle
+    // converts to a 'bsl::string *', so a callback taking a 'bsl::string *'
+    // works as well, but cannot keep the message. Every handle must be
+    // released before the 'Consumer' is destroyed. Once the pool has as many
+    // buffers as are ever in use at once, and each has held a message as
+    // large as any received, receiving allocates no memory for messages,
+    // which 'messagePool' shows.
 
   public:
     // PUBLIC TYPES
-    typedef bsl::function<void(bsl::string *, unsigned)> MessageCallback;
+    typedef bsl::function<void(MessageHandle&, unsigned)> MessageCallback;
+
+    typedef ConsumerOptions Options;
+
+    typedef ConsumerBand Band;
 
   private:
+    // PRIVATE TYPES
+    struct BandState;
+
+    struct Pending {
+        // This 'struct' describes a message received but not yet processed.
+
+        bsl::string        *d_buffer;      // from 'd_pool'
+        unsigned            d_priority;
+        bsls::Types::Int64  d_receivedAt;  // 'bsls::TimeUtil::getTimer'
+    };
+
     // DATA
-    bsls::AtomicInt           d_shuttingDown;
-    bsl::string               d_messageBuffer;
-    QueueReceiver             d_receiver;
-    MessageCallback           d_callback;  // message, priority
-    bslmt::ThreadUtil::Handle d_thread;
+    bsls::AtomicInt                                     d_shuttingDown;
+    QueueReceiver                                       d_receiver;
+    MessageCallback                                     d_callback;
+        // message, priority
+
+    MessagePool                                         d_pool;
+        // supplies every message buffer, and outlives the threads
+
+    bslma::ManagedPtr<bdlcc::FixedQueue<bsl::string *> > d_freeWorkBuffers_mp;
+    bslma::ManagedPtr<bdlmt::FixedThreadPool>           d_workers_mp;
+        // null unless the callback is invoked by worker threads
+
+    bslmt::ThreadGroup                                  d_receiverThreads;
+    int                                                 d_eventFd;
+        // readable once shutdown begins, or -1 if not supported
+
+    Metrics                                             d_callbackMetrics;
+        // the time spent in the callback with each message, and from its
+        // receipt until the callback returned, and the time spent polling
+
+    bsls::TimeInterval                                  d_maxSpin;
+        // the most time for which a receiving thread polls, or zero
+
+    bsl::vector<bsl::shared_ptr<BandState> >            d_bands;
+        // in decreasing order of priority, or empty if there are no bands
+
+    bslmt::Mutex                                        d_bandMutex;
+        // protects the pending messages of every band, and the below
+
+    bslmt::Condition                                    d_sharedCondition;
+        // signaled when a message is handed to a band without threads of its
+        // own, or when the worker threads must stop
+
+    bool                                                d_bandsStopping;
+    bslmt::ThreadGroup                                  d_bandThreads;
+    bsls::Types::Int64                                  d_maxAgeTicks;
+        // 'd_maxAge' in nanoseconds, or zero for no aging
+
+    bool                                                d_isStarted;
+        // whether every thread of this object started
+
+    bslma::Allocator                                   *d_allocator_p;
+
+    Consumer(const Consumer&);             // = delete
+    Consumer& operator=(const Consumer&);  // = delete
 
   public:
     // CREATORS
@@ -40,24 +240,206 @@ class Consumer {
         const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
         int                            filePermissions = 0,
         bslma::Allocator              *allocator       = 0);
+    Consumer(
+        const bslstl::StringRef&       name,
+        Format                         format,
+        const MessageCallback&         callback,
+        const Options&                 options,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
         // Create a 'Consumer' object that receives from the message queue with
         // the specified 'name' in the specified 'format', invoking the
         // specified 'callback' with every message received and its priority.
+        // Optionally specify 'options' describing the threads to use.
         // Optionally specify 'attributes' and 'filePermissions', which will be
         // used when creating the queue if the queue does not already exist.
-        // This object will begin consuming messages immediately.
+        // This object will begin consuming messages immediately. If any of
+        // its threads cannot be started, this object stops those that did
+        // and consumes nothing, and 'isOpen' returns 'false'. The behavior
+        // is undefined unless '0 < options.d_numReceiverThreads',
+        // '0 <= options.d_numWorkerThreads', and
+        // '0 <= options.d_maxInFlight'.
+
+    Consumer(
+        const bslstl::StringRef&       name,
+        Format                         format,
+        const MessageCallback&         callback,
+        const bsl::vector<Band>&       bands,
+        const Options&                 options,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+        // Create a 'Consumer' object that receives from the message queue with
+        // the specified 'name' in the specified 'format', handing every
+        // message received to the band of its priority among the specified
+        // 'bands', which invokes its callback, or the specified 'callback',
+        // with the message and its priority. Use the specified 'options' to
+        // describe the receiving threads and the worker threads shared by the
+        // bands that have none of their own. Optionally specify 'attributes'
+        // and 'filePermissions', which will be used when creating the queue if
+        // the queue does not already exist. This object will begin consuming
+        // messages immediately. If any of its threads, receiving or worker,
+        // cannot be started, this object stops those that did and consumes
+        // nothing, and 'isOpen' returns 'false'. The behavior is undefined
+        // unless 'bands' is not empty, the 'd_minPriority' of its elements
+        // strictly decrease and that of the last is zero,
+        // '0 <= d_numWorkerThreads' for each band,
+        // '0 < options.d_numWorkerThreads' if any band has no threads of its
+        // own, '0 < options.d_numReceiverThreads', and
+        // '0 <= options.d_maxInFlight'.
 
     ~Consumer();
-        // Send a "stop" notification to the thread managed by this object and
-        // wait for it to finish. Then destroy this object.
+        // Send a "stop" notification to the threads managed by this object and
+        // wait for them to finish. Messages already handed to worker threads,
+        // or to bands, are processed before this function returns. Then
+        // destroy this object. The behavior is undefined unless every
+        // 'MessageHandle' moved out of a callback has been released.
+
+    // MANIPULATORS
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero.
 
     // ATTRIBUTES
     bool isOpen() const;
-        // Return whether the queue consumed by this object is open.
+        // Return whether the queue consumed by this object is open and every
+        // thread of this object started, so that it is consuming messages.
+
+    void loadMetrics(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the messages received by this
+        // object, the attempts to receive that failed, the time taken to
+        // decode each message, the time spent in the callback with each, the
+        // time from receiving each until its callback returned, and the polls
+        // before receiving and the time spent in each. Note that when several
+        // threads receive, an attempt that finds that another thread took
+        // the message counts as an attempt that would block, as does each
+        // poll that finds the queue empty.
+
+    int numBands() const;
+        // Return the number of priority bands of this object, which is zero
+        // unless it was created with bands.
+
+    const MessagePool& messagePool() const;
+        // Return a reference providing non-modifiable access to the pool of
+        // the message buffers of this object, whose counts show how much
+        // memory the buffers take, and that receiving in steady state
+        // allocates none.
+
+    void loadBandMetrics(MetricsSnapshot *result, int band) const;
+        // Load into the specified 'result' the messages processed by the
+        // specified 'band', their bytes, the time spent in the callback with
+        // each, and the time from receiving each until its callback returned.
+        // The other counts are zero. The behavior is undefined unless
+        // '0 <= band < numBands()', where bands are numbered in the order
+        // given to the constructor.
 
   private:
     // PRIVATE MANIPULATORS
+    int start(const bslstl::StringRef& name, const Options& options);
+        // Start the threads described by the specified 'options' for
+        // consuming the queue having the specified 'name'. Return zero on
+        // success, or, if any thread cannot be started, 'stop' and return a
+        // nonzero value.
+
+    int receive(bsl::string     *buffer,
+                unsigned        *priority,
+                AdaptiveSpinner *spinner);
+        // Receive the next message into the specified 'buffer' and load its
+        // priority into the specified 'priority', first polling for as long
+        // as the specified 'spinner' says, and then blocking until a message
+        // might be available or until shutdown begins. Return zero if a
+        // message was received, or a nonzero value otherwise. Log any
+        // unexpected error.
+
+    int spin(bsl::string     *buffer,
+             unsigned        *priority,
+             AdaptiveSpinner *spinner);
+        // Poll for the next message, receiving it into the specified 'buffer'
+        // and loading its priority into the specified 'priority', for as long
+        // as the specified 'spinner' says. Return zero if a message was
+        // received, 'PosixQueue::Receive::e_EMPTY' if none was found, or
+        // another nonzero value, after logging it, if an error occurred.
+
+    int waitAndReceive(bsl::string *buffer, unsigned *priority);
+        // Receive the next message into the specified 'buffer' and load its
+        // priority into the specified 'priority'. Block until a message might
+        // be available or until shutdown begins. Return zero if a message was
+        // received, or a nonzero value otherwise. Log any unexpected error.
+
     void consume();
+        // Receive messages and invoke the callback with each until shutdown.
+
+    void consumeAndDispatch();
+        // Receive messages into free work buffers and hand each to a worker
+        // thread until shutdown.
+
+    void consumeAndRoute();
+        // Receive messages into free work buffers and hand each to the band
+        // of its priority until shutdown.
+
+    void processBand(int band);
+        // Process the messages of the specified 'band' until the worker
+        // threads must stop and the band has no more messages.
+
+    void processShared();
+        // Process the messages of the bands without threads of their own
+        // until the worker threads must stop and those bands have no more
+        // messages.
+
+    void process(const Pending& message);
+        // Invoke the callback with the specified 'message' and its priority,
+        // and then return a buffer to the free work buffers in place of that
+        // of 'message'.
+
+    void processInBand(BandState *band, const Pending& message);
+        // Invoke the callback of the specified 'band' with the specified
+        // 'message' and its priority, record the times in the metrics of
+        // 'band' as well, and then return a buffer to the free work buffers
+        // in place of that of 'message'.
+
+    bsl::string *invokeCallback(const Pending& message);
+        // Invoke the callback with the specified 'message' and its priority,
+        // and record the time it takes and the time since 'message' was
+        // received. Return the buffer to receive the next message into, as
+        // 'handOff' does.
+
+    bsl::string *handOff(const MessageCallback& callback,
+                         const Pending&         message);
+        // Invoke the specified 'callback' with a handle owning the buffer of
+        // the specified 'message', and its priority. Return that buffer if
+        // the callback did not keep the handle, or otherwise a buffer from
+        // the pool, to receive the next message into.
+
+    void createWorkBuffers(int maxInFlight);
+        // Draw the specified 'maxInFlight' work buffers from the pool, all of
+        // them free.
+
+    int startBands(const bsl::vector<Band>& bands, const Options& options);
+        // Create the specified 'bands' and start their worker threads, and
+        // the shared worker threads described by the specified 'options' if
+        // any band has no threads of its own. Return zero on success, or, if
+        // any thread cannot be started, stop those that did and return a
+        // nonzero value.
+
+    void stop();
+        // Stop the receiving threads, let the worker threads process every
+        // message handed to them, and join them. Do nothing for threads
+        // already stopped.
+
+    void stopBands();
+        // Let the band worker threads process every message handed to them,
+        // and then join them.
+
+    BandState *nextSharedBand();
+        // Return the band whose first message a shared worker thread should
+        // process next, or zero if no band without threads of its own has a
+        // message. The behavior is undefined unless the calling thread has
+        // locked 'd_bandMutex'.
+
+    // PRIVATE ACCESSORS
+    int bandIndex(unsigned priority) const;
+        // Return the index within 'd_bands' of the band of the specified
+        // 'priority'.
 };
 
 }  // close package namespace
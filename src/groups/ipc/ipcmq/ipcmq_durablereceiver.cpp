@@ -0,0 +1,210 @@
+
+#include <ipcmq_durablereceiver.h>
+
+#include <ball_log.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsls_assert.h>
+#include <bsls_timeinterval.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.DURABLERECEIVER";
+
+}  // close unnamed namespace
+
+                           // ---------------------
+                           // class DurableReceiver
+                           // ---------------------
+
+// CREATORS
+DurableReceiver::DurableReceiver(
+    const bslstl::StringRef&       name,
+    const bslstl::StringRef&       logPath,
+    const PosixQueue::Attributes&  attributes,
+    int                            filePermissions,
+    bslma::Allocator              *allocator)
+: d_receiver(name, Format::e_RAW, attributes, filePermissions, allocator)
+, d_logPath(logPath, allocator)
+, d_isLogOpen(false)
+, d_numDuplicates(0)
+{
+}
+
+// MANIPULATORS
+int DurableReceiver::receive(bsl::string *payload,
+                             Receipt     *receipt,
+                             unsigned    *priority)
+{
+    BSLS_ASSERT(payload);
+    BSLS_ASSERT(receipt);
+
+    bsl::string message;
+    for (;;) {
+        if (const int rc = d_receiver.receive(&message)) {
+            return rc;                                                // RETURN
+        }
+
+        const int rc = deliver(payload, receipt, priority, message);
+        if (rc >= 0) {
+            return rc;                                                // RETURN
+        }
+    }
+}
+
+int DurableReceiver::receive(bsl::string               *payload,
+                             Receipt                   *receipt,
+                             const bsls::TimeInterval&  relativeTimeout,
+                             unsigned                  *priority)
+{
+    BSLS_ASSERT(payload);
+    BSLS_ASSERT(receipt);
+
+    // The timeout applies to the skipped locations as well.
+    const bsls::TimeInterval deadline =
+                                  bdlt::CurrentTime::now() + relativeTimeout;
+
+    bsl::string message;
+    for (;;) {
+        if (const int rc = d_receiver.receive(
+                &message, deadline - bdlt::CurrentTime::now())) {
+            return rc;                                                // RETURN
+        }
+
+        const int rc = deliver(payload, receipt, priority, message);
+        if (rc >= 0) {
+            return rc;                                                // RETURN
+        }
+    }
+}
+
+int DurableReceiver::tryReceive(bsl::string *payload,
+                                Receipt     *receipt,
+                                unsigned    *priority)
+{
+    BSLS_ASSERT(payload);
+    BSLS_ASSERT(receipt);
+
+    bsl::string message;
+    for (;;) {
+        if (const int rc = d_receiver.tryReceive(&message)) {
+            return rc;                                                // RETURN
+        }
+
+        const int rc = deliver(payload, receipt, priority, message);
+        if (rc >= 0) {
+            return rc;                                                // RETURN
+        }
+    }
+}
+
+int DurableReceiver::acknowledge(const Receipt& receipt)
+{
+    if (!d_isLogOpen.load()) {
+        return 1;                                                     // RETURN
+    }
+
+    return d_log.acknowledge(receipt);
+}
+
+int DurableReceiver::unlink()
+{
+    return d_receiver.unlink();
+}
+
+void DurableReceiver::resetMetrics()
+{
+    d_receiver.resetMetrics();
+    d_numDuplicates = 0;
+}
+
+int DurableReceiver::deliver(bsl::string        *payload,
+                             Receipt            *receipt,
+                             unsigned           *priority,
+                             const bsl::string&  message)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    using namespace PosixQueueTypes;
+
+    if (WriteAheadLog::decode(receipt, message)) {
+        BALL_LOG_ERROR << "Received a message of " << message.length()
+                       << " bytes, which is not the location of a record in "
+                          "a write-ahead log."
+                       << BALL_LOG_END;
+        return Receive::e_CORRUPTED_MESSAGE;                          // RETURN
+    }
+
+    // The sender creates the log before it enqueues any location, so the
+    // log exists now even if it did not when this object was created.
+    if (!openLog()) {
+        return Receive::e_CORRUPTED_MESSAGE;                          // RETURN
+    }
+
+    int recordPriority;
+    if (d_log.read(payload, &recordPriority, *receipt)) {
+        BALL_LOG_DEBUG << "Skipping the record having sequence number "
+                       << receipt->d_sequence
+                       << ", which is no longer pending." << BALL_LOG_END;
+        d_numDuplicates.addRelaxed(1);
+        return -1;                                                    // RETURN
+    }
+
+    if (priority) {
+        *priority = recordPriority;
+    }
+    return 0;
+}
+
+bool DurableReceiver::openLog()
+{
+    if (d_isLogOpen.load()) {
+        return true;                                                  // RETURN
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_logMutex);
+    if (!d_isLogOpen.load() && !d_log.openForReading(d_logPath)) {
+        d_isLogOpen = true;
+    }
+
+    return d_isLogOpen.load();
+}
+
+// ACCESSORS
+void DurableReceiver::loadMetrics(MetricsSnapshot *result) const
+{
+    d_receiver.loadMetrics(result);
+}
+
+bsls::Types::Int64 DurableReceiver::numDuplicates() const
+{
+    return d_numDuplicates.loadRelaxed();
+}
+
+bool DurableReceiver::isOpen() const
+{
+    return d_receiver.isOpen();
+}
+
+IPCU_DEFINE_OPERATOR_BOOL(DurableReceiver)
+{
+    IPCU_RETURN_OPERATOR_BOOL(DurableReceiver, isOpen());
+}
+
+const PosixQueue& DurableReceiver::posixQueue() const
+{
+    return d_receiver.posixQueue();
+}
+
+// CLASS METHODS
+const char *DurableReceiver::description(int errorCode)
+{
+    return QueueReceiver::description(errorCode);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
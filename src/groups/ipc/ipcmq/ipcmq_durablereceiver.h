@@ -0,0 +1,156 @@
+#ifndef INCLUDED_IPCMQ_DURABLERECEIVER
+#define INCLUDED_IPCMQ_DURABLERECEIVER
+
+#include <ipcmq_metrics.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuereceiver.h>
+#include <ipcmq_writeaheadlog.h>
+#include <ipcu_operatorbool.h>
+
+#include <bsl_string.h>
+
+#include <bslmt_mutex.h>
+
+#include <bsls_atomic.h>
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace bsls { class TimeInterval; }
+namespace ipcmq {
+
+                           // =====================
+                           // class DurableReceiver
+                           // =====================
+
+class DurableReceiver {
+    // This class receives the payloads sent by a 'DurableSender'. Each
+    // message in the queue is the location of a record in the sender's
+    // write-ahead log, from which the payload is read. A payload received is
+    // accompanied by a "receipt", which the receiving process passes to
+    // 'acknowledge' once it is done with the payload. Until then, the payload
+    // remains pending in the log, and is enqueued again the next time a
+    // 'DurableSender' opens the log. A location whose record was already
+    // acknowledged, as happens when the sender enqueues again a payload that
+    // was not lost after all, is skipped. A location whose record is still
+    // pending is not: its payload is read again, even while another receiver
+    // holds it, so a payload may be received more than once.
+    //
+    // This class does not implement the 'Receiver' protocol, since a payload
+    // received without its receipt could never be acknowledged.
+
+  public:
+    // PUBLIC TYPES
+    typedef WriteAheadLog::Location Receipt;
+
+  private:
+    // DATA
+    QueueReceiver     d_receiver;
+    WriteAheadLog     d_log;
+    bsl::string       d_logPath;
+    bslmt::Mutex      d_logMutex;       // serializes opening the log
+    bsls::AtomicBool  d_isLogOpen;
+    bsls::AtomicInt64 d_numDuplicates;
+
+    DurableReceiver(const DurableReceiver&);             // = delete
+    DurableReceiver& operator=(const DurableReceiver&);  // = delete
+
+  public:
+    // CREATORS
+    DurableReceiver(
+        const bslstl::StringRef&       name,
+        const bslstl::StringRef&       logPath,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+        // Open for reading the message queue having the specified 'name',
+        // whose payloads are in the write-ahead log at the specified
+        // 'logPath'. If the queue does not already exist, create it having
+        // the optionally specified 'attributes' and 'filePermissions'. The
+        // log is opened once it exists, so this object may be created before
+        // the first 'DurableSender' creates the log.
+
+    // MANIPULATORS
+    int receive(bsl::string *payload,
+                Receipt     *receipt,
+                unsigned    *priority = 0);
+    int receive(bsl::string               *payload,
+                Receipt                   *receipt,
+                const bsls::TimeInterval&  relativeTimeout,
+                unsigned                  *priority = 0);
+        // Assign through the specified 'payload' the next payload from the
+        // queue represented by this object, and through the specified
+        // 'receipt' what acknowledges it. Assign through the optionally
+        // specified 'priority' the priority with which it was sent. Block for
+        // no longer than the optionally specified 'relativeTimeout', relative
+        // to the beginning of the invocation of this function. Return zero if
+        // a payload is received or a nonzero value otherwise.
+
+    int tryReceive(bsl::string *payload,
+                   Receipt     *receipt,
+                   unsigned    *priority = 0);
+        // Assign through the specified 'payload' the next payload from the
+        // queue represented by this object, and through the specified
+        // 'receipt' what acknowledges it. Assign through the optionally
+        // specified 'priority' the priority with which it was sent. Do not
+        // block. Return zero if a payload is received or a nonzero value
+        // otherwise.
+
+    int acknowledge(const Receipt& receipt);
+        // Mark consumed the payload received with the specified 'receipt', so
+        // that it is not delivered again. Return zero on success, or a nonzero
+        // value if it was already acknowledged.
+
+    int unlink();
+        // Mark for deletion the message queue opened by this object. Return
+        // zero on success or a nonzero value otherwise. Note that the
+        // write-ahead log is not removed.
+
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero.
+
+    // ACCESSORS
+    void loadMetrics(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the locations received by this
+        // object, including those skipped, and the attempts that failed.
+
+    bsls::Types::Int64 numDuplicates() const;
+        // Return the number of locations skipped because their payload was
+        // already acknowledged.
+
+    bool isOpen() const;
+        // Return whether this object represents an open message queue.
+
+    IPCU_DECLARE_OPERATOR_BOOL(DurableReceiver);
+        // Return 'isOpen()'.
+
+    const PosixQueue& posixQueue() const;
+        // Return a reference providing non-modifiable access to the
+        // 'PosixQueue' instance used to implement this object.
+
+    // CLASS METHODS
+    static const char *description(int errorCode);
+        // Return a pointer to a null terminated string that describes the
+        // specified 'errorCode'. The behavior is undefined unless 'errorCode'
+        // has the same value as the result of a previous invocation of one of
+        // the methods of an instance of this class.
+
+  private:
+    // PRIVATE MANIPULATORS
+    int deliver(bsl::string        *payload,
+                Receipt            *receipt,
+                unsigned           *priority,
+                const bsl::string&  message);
+        // Load into the specified 'payload', 'receipt', and, unless it is
+        // zero, 'priority' the record whose location is the specified
+        // 'message'. Return zero on success, a negative value if the record
+        // was already acknowledged, or a positive error code otherwise.
+
+    bool openLog();
+        // Open the log unless it is already open. Return whether it is open.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
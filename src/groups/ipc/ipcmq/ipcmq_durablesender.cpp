@@ -0,0 +1,411 @@
+
+#include <ipcmq_durablesender.h>
+
+#include <ball_log.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsls_assert.h>
+#include <bsls_timeinterval.h>
+
+#include <bsl_vector.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.DURABLESENDER";
+
+int appendError(int rc)
+    // Return the result of sending a payload that could not be appended to
+    // the log for the specified reason 'rc', as returned by
+    // 'WriteAheadLog::append'.
+{
+    using namespace PosixQueueTypes;
+
+    return rc == 1 ? Send::e_FULL : Send::e_MESSAGE_TOO_LARGE;
+}
+
+}  // close unnamed namespace
+
+                        // ---------------------------
+                        // struct DurableSenderOptions
+                        // ---------------------------
+
+// CREATORS
+DurableSenderOptions::DurableSenderOptions()
+: d_logCapacity(64 * 1024 * 1024)
+, d_syncBeforeSend(true)
+{
+}
+
+                            // -------------------
+                            // class DurableSender
+                            // -------------------
+
+// CREATORS
+DurableSender::DurableSender(const bslstl::StringRef&       name,
+                             const bslstl::StringRef&       logPath,
+                             const PosixQueue::Attributes&  attributes,
+                             int                            filePermissions,
+                             bslma::Allocator              *allocator)
+: d_sender(name, Format::e_RAW, attributes, filePermissions, allocator)
+, d_syncBeforeSend(Options().d_syncBeforeSend)
+, d_syncedSequence(0)
+, d_isSyncing(false)
+, d_numSyncs(0)
+, d_numReplayed(0)
+, d_replays(allocator)
+, d_replayPriorities(allocator)
+, d_numReplaysDone(0)
+, d_hasReplays(false)
+, d_allocator_p(allocator)
+{
+    start(logPath, Options(), filePermissions);
+}
+
+DurableSender::DurableSender(const bslstl::StringRef&       name,
+                             const bslstl::StringRef&       logPath,
+                             const Options&                 options,
+                             const PosixQueue::Attributes&  attributes,
+                             int                            filePermissions,
+                             bslma::Allocator              *allocator)
+: d_sender(name, Format::e_RAW, attributes, filePermissions, allocator)
+, d_syncBeforeSend(options.d_syncBeforeSend)
+, d_syncedSequence(0)
+, d_isSyncing(false)
+, d_numSyncs(0)
+, d_numReplayed(0)
+, d_replays(allocator)
+, d_replayPriorities(allocator)
+, d_numReplaysDone(0)
+, d_hasReplays(false)
+, d_allocator_p(allocator)
+{
+    start(logPath, options, filePermissions);
+}
+
+// MANIPULATORS
+int DurableSender::send(const bslstl::StringRef& payload, int priority)
+{
+    WriteAheadLog::Location location;
+    if (const int rc = record(&location, payload, priority)) {
+        return rc;                                                    // RETURN
+    }
+
+    char encoded[WriteAheadLog::k_ENCODED_LOCATION_SIZE];
+    WriteAheadLog::encode(encoded, location);
+    return settle(
+        location,
+        d_sender.send(bslstl::StringRef(encoded, sizeof encoded), priority));
+}
+
+int DurableSender::send(const bslstl::StringRef&  payload,
+                        const bsls::TimeInterval& relativeTimeout,
+                        int                       priority)
+{
+    WriteAheadLog::Location location;
+    if (const int rc = record(&location, payload, priority)) {
+        return rc;                                                    // RETURN
+    }
+
+    char encoded[WriteAheadLog::k_ENCODED_LOCATION_SIZE];
+    WriteAheadLog::encode(encoded, location);
+    return settle(location,
+                  d_sender.send(bslstl::StringRef(encoded, sizeof encoded),
+                                relativeTimeout,
+                                priority));
+}
+
+int DurableSender::trySend(const bslstl::StringRef& payload, int priority)
+{
+    WriteAheadLog::Location location;
+    if (const int rc = record(&location, payload, priority)) {
+        return rc;                                                    // RETURN
+    }
+
+    char encoded[WriteAheadLog::k_ENCODED_LOCATION_SIZE];
+    WriteAheadLog::encode(encoded, location);
+    return settle(location,
+                  d_sender.trySend(bslstl::StringRef(encoded, sizeof encoded),
+                                   priority));
+}
+
+int DurableSender::sendBatch(const bslstl::StringRef *begin,
+                             const bslstl::StringRef *end,
+                             bsl::size_t             *numSent,
+                             int                      priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(begin <= end);
+    BSLS_ASSERT(numSent);
+
+    *numSent = 0;
+    if (!d_log.isOpen()) {
+        return Send::e_UNKNOWN;                                       // RETURN
+    }
+
+    replayPending();
+
+    bsl::vector<WriteAheadLog::Location> locations(d_allocator_p);
+    locations.reserve(end - begin);
+
+    int appendRc = 0;
+    for (const bslstl::StringRef *payload = begin; payload != end;
+         ++payload) {
+        WriteAheadLog::Location location;
+        if (const int rc = d_log.append(&location, *payload, priority)) {
+            appendRc = appendError(rc);
+            break;
+        }
+        locations.push_back(location);
+    }
+
+    if (locations.empty()) {
+        return appendRc;                                              // RETURN
+    }
+
+    if (d_syncBeforeSend && syncThrough(locations.back().d_sequence)) {
+        for (bsl::size_t i = 0; i < locations.size(); ++i) {
+            d_log.acknowledge(locations[i]);
+        }
+        return Send::e_UNKNOWN;                                       // RETURN
+    }
+
+    // Every location is encoded into one buffer, so that the batch is sent
+    // using one call.
+    bsl::vector<char> encoded(
+        locations.size() * WriteAheadLog::k_ENCODED_LOCATION_SIZE,
+        d_allocator_p);
+    bsl::vector<bslstl::StringRef> messages(d_allocator_p);
+    messages.reserve(locations.size());
+    for (bsl::size_t i = 0; i < locations.size(); ++i) {
+        char *const message =
+            &encoded[i * WriteAheadLog::k_ENCODED_LOCATION_SIZE];
+        WriteAheadLog::encode(message, locations[i]);
+        messages.push_back(bslstl::StringRef(
+            message, WriteAheadLog::k_ENCODED_LOCATION_SIZE));
+    }
+
+    const int sendRc = d_sender.sendBatch(
+        messages.data(), messages.data() + messages.size(), numSent, priority);
+    for (bsl::size_t i = *numSent; i < locations.size(); ++i) {
+        d_log.acknowledge(locations[i]);
+    }
+
+    return sendRc ? sendRc : appendRc;
+}
+
+int DurableSender::replayPending()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    using namespace PosixQueueTypes;
+
+    if (!d_hasReplays.loadAcquire()) {
+        return 0;                                                     // RETURN
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_replayMutex);
+
+    int rc = 0;
+    while (d_numReplaysDone < d_replays.size()) {
+        char encoded[WriteAheadLog::k_ENCODED_LOCATION_SIZE];
+        WriteAheadLog::encode(encoded, d_replays[d_numReplaysDone]);
+        rc = d_sender.trySend(bslstl::StringRef(encoded, sizeof encoded),
+                              d_replayPriorities[d_numReplaysDone]);
+        if (rc) {
+            break;
+        }
+
+        ++d_numReplaysDone;
+        d_numReplayed.addRelaxed(1);
+    }
+
+    if (rc == Send::e_FULL) {
+        // Try again later.
+        return rc;                                                    // RETURN
+    }
+
+    if (rc) {
+        BALL_LOG_ERROR << "Unable to enqueue pending messages from the "
+                          "write-ahead log: "
+                       << d_sender.description(rc)
+                       << ". They remain pending." << BALL_LOG_END;
+    }
+
+    // Release the memory of the replays, which are not needed again.
+    bsl::vector<WriteAheadLog::Location>(d_allocator_p).swap(d_replays);
+    bsl::vector<int>(d_allocator_p).swap(d_replayPriorities);
+    d_numReplaysDone = 0;
+    d_hasReplays.storeRelease(false);
+    return rc;
+}
+
+int DurableSender::sync()
+{
+    if (!d_log.isOpen()) {
+        return PosixQueueTypes::Send::e_UNKNOWN;                      // RETURN
+    }
+
+    return syncThrough(d_log.lastSequence());
+}
+
+void DurableSender::resetMetrics()
+{
+    d_sender.resetMetrics();
+    d_numSyncs    = 0;
+    d_numReplayed = 0;
+}
+
+void DurableSender::start(const bslstl::StringRef& logPath,
+                          const Options&           options,
+                          int                      filePermissions)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    if (!d_sender.isOpen()) {
+        return;                                                       // RETURN
+    }
+
+    const bsl::string path(logPath, d_allocator_p);
+    if (d_log.openForWriting(path,
+                             options.d_logCapacity,
+                             filePermissions ? filePermissions : 0600)) {
+        return;                                                       // RETURN
+    }
+
+    // Whatever is pending was appended by a previous process, which may or
+    // may not have enqueued it, and the queue may since have been lost.
+    // Enqueuing it again delivers it again unless it is acknowledged first,
+    // which is within the at-least-once contract.
+    // The queue may not have room for all of it, and a receiver may not be
+    // running yet, so enqueue only as much as fits now, and the rest before
+    // later sends.
+    d_log.loadPending(&d_replays, &d_replayPriorities);
+    if (d_replays.empty()) {
+        return;                                                       // RETURN
+    }
+
+    BALL_LOG_INFO << "Enqueuing again " << d_replays.size()
+                  << " pending messages from the write-ahead log \"" << path
+                  << "\"" << BALL_LOG_END;
+
+    d_hasReplays.storeRelease(true);
+    if (replayPending() == PosixQueueTypes::Send::e_FULL) {
+        BALL_LOG_INFO << d_replays.size() - d_numReplaysDone
+                      << " pending messages do not fit in the queue, and will "
+                         "be enqueued again as it has room."
+                      << BALL_LOG_END;
+    }
+}
+
+int DurableSender::record(WriteAheadLog::Location  *location,
+                          const bslstl::StringRef&  payload,
+                          int                       priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(location);
+
+    if (!d_log.isOpen()) {
+        return Send::e_UNKNOWN;                                       // RETURN
+    }
+
+    replayPending();
+
+    if (const int rc = d_log.append(location, payload, priority)) {
+        return appendError(rc);                                       // RETURN
+    }
+
+    if (d_syncBeforeSend && syncThrough(location->d_sequence)) {
+        d_log.acknowledge(*location);
+        return Send::e_UNKNOWN;                                       // RETURN
+    }
+
+    return 0;
+}
+
+int DurableSender::settle(const WriteAheadLog::Location& location, int rc)
+{
+    if (rc) {
+        // Nobody will receive the location, so the record would otherwise
+        // be enqueued again by the next 'DurableSender' to open the log.
+        d_log.acknowledge(location);
+    }
+
+    return rc;
+}
+
+int DurableSender::syncThrough(bsls::Types::Uint64 sequence)
+{
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_syncMutex);
+
+    while (d_syncedSequence < sequence) {
+        if (d_isSyncing) {
+            // Another thread is synchronizing, possibly not far enough.
+            d_syncCondition.wait(&d_syncMutex);
+            continue;
+        }
+
+        // Synchronize on behalf of every record appended so far, including
+        // those of threads that arrive while this one waits for storage.
+        d_isSyncing = true;
+        const bsls::Types::Uint64 target = d_log.lastSequence();
+
+        d_syncMutex.unlock();
+        const int rc = d_log.sync();
+        d_syncMutex.lock();
+
+        d_isSyncing = false;
+        d_numSyncs.addRelaxed(1);
+        if (!rc && target > d_syncedSequence) {
+            d_syncedSequence = target;
+        }
+        d_syncCondition.broadcast();
+
+        if (rc) {
+            return PosixQueueTypes::Send::e_UNKNOWN;                  // RETURN
+        }
+    }
+
+    return 0;
+}
+
+// ACCESSORS
+void DurableSender::loadMetrics(MetricsSnapshot *result) const
+{
+    d_sender.loadMetrics(result);
+}
+
+bsls::Types::Int64 DurableSender::numSyncs() const
+{
+    return d_numSyncs.loadRelaxed();
+}
+
+bsls::Types::Int64 DurableSender::numReplayed() const
+{
+    return d_numReplayed.loadRelaxed();
+}
+
+bool DurableSender::isOpen() const
+{
+    return d_sender.isOpen() && d_log.isOpen();
+}
+
+IPCU_DEFINE_OPERATOR_BOOL(DurableSender)
+{
+    IPCU_RETURN_OPERATOR_BOOL(DurableSender, isOpen());
+}
+
+const PosixQueue& DurableSender::posixQueue() const
+{
+    return d_sender.posixQueue();
+}
+
+// CLASS METHODS
+const char *DurableSender::description(int errorCode)
+{
+    return QueueSender::description(errorCode);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,281 @@
+#ifndef INCLUDED_IPCMQ_DURABLESENDER
+#define INCLUDED_IPCMQ_DURABLESENDER
+
+#include <ipcmq_metrics.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuesender.h>
+#include <ipcmq_sender.h>
+#include <ipcmq_writeaheadlog.h>
+#include <ipcu_operatorbool.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bslmt_condition.h>
+#include <bslmt_mutex.h>
+
+#include <bsls_atomic.h>
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace bsls { class TimeInterval; }
+namespace ipcmq {
+
+                        // ===========================
+                        // struct DurableSenderOptions
+                        // ===========================
+
+struct DurableSenderOptions {
+    // This 'struct' describes the write-ahead log of a 'DurableSender'.
+
+    // DATA
+    bsl::size_t d_logCapacity;
+        // the number of bytes of records in the log if it is created, which
+        // bounds the payloads that can be pending at once, including a 24
+        // byte header for each, rounded up to a multiple of eight
+
+    bool d_syncBeforeSend;
+        // whether each payload is on storage before it is enqueued, so that
+        // it survives a crash of the system, rather than only a crash of the
+        // sending or receiving process
+
+    // CREATORS
+    DurableSenderOptions();
+        // Create a 'DurableSenderOptions' object describing a log of 64
+        // mebibytes that is synchronized before each send.
+};
+
+                            // ===================
+                            // class DurableSender
+                            // ===================
+
+class DurableSender : public Sender {
+    // This class implements the 'Sender' protocol by appending each payload
+    // to a 'WriteAheadLog' and then enqueuing, using a 'QueueSender', only
+    // the location of the payload in the log. A 'DurableReceiver' reads the
+    // payload from the log, and the payload remains pending in the log until
+    // the receiving process acknowledges it. When a 'DurableSender' is
+    // created, every payload still pending in its log is enqueued again, so
+    // payloads lost along with the message queue, or with a receiving process
+    // that crashed before acknowledging them, are delivered at least once.
+    // Delivery is at least once, not exactly once: a payload still in the
+    // queue when its location is enqueued again may be delivered twice,
+    // possibly to two receivers at the same time, so the receiving process
+    // must tolerate duplicates. A receiver skips only the locations of
+    // payloads already acknowledged.
+    //
+    // Pending payloads are enqueued again without blocking, so that creating
+    // a 'DurableSender' does not wait for a receiver to make room. Those that
+    // do not fit in the queue remain pending, and are enqueued again, in
+    // order, before the payloads of later sends, or by 'replayPending'.
+    //
+    // If the log is synchronized before sending, threads sending at the same
+    // time share one synchronization: the first waits for storage on behalf
+    // of every payload appended so far, and the others wait for it. A batch
+    // sent using 'sendBatch' is likewise synchronized once.
+
+  public:
+    // PUBLIC TYPES
+    typedef DurableSenderOptions Options;
+
+  private:
+    // DATA
+    QueueSender         d_sender;
+    WriteAheadLog       d_log;
+    bool                d_syncBeforeSend;
+    bslmt::Mutex        d_syncMutex;
+    bslmt::Condition    d_syncCondition;
+        // signaled when a synchronization finishes
+
+    bsls::Types::Uint64 d_syncedSequence;  // last record on storage
+    bool                d_isSyncing;
+    bsls::AtomicInt64   d_numSyncs;
+    bsls::AtomicInt64   d_numReplayed;
+
+    bslmt::Mutex                         d_replayMutex;
+    bsl::vector<WriteAheadLog::Location> d_replays;
+        // pending payloads still to be enqueued again
+    bsl::vector<int>                     d_replayPriorities;
+    bsl::size_t                          d_numReplaysDone;
+        // leading elements of 'd_replays' already enqueued
+    bsls::AtomicBool                     d_hasReplays;
+
+    bslma::Allocator                    *d_allocator_p;
+
+    DurableSender(const DurableSender&);             // = delete
+    DurableSender& operator=(const DurableSender&);  // = delete
+
+  public:
+    // CREATORS
+    DurableSender(
+        const bslstl::StringRef&       name,
+        const bslstl::StringRef&       logPath,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+    DurableSender(
+        const bslstl::StringRef&       name,
+        const bslstl::StringRef&       logPath,
+        const Options&                 options,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+        // Create a 'DurableSender' object that sends to the message queue
+        // with the specified 'name', logging to the write-ahead log at the
+        // specified 'logPath', which should be on a file system backed by
+        // storage rather than memory. Optionally specify 'options' describing
+        // the log. Optionally specify 'attributes' and 'filePermissions',
+        // which will be used when creating the queue or the log if either
+        // does not already exist. The message size of the queue need only
+        // hold the location of a payload. If the queue and the log are
+        // opened, enqueue again, without blocking, every payload pending in
+        // the log that fits in the queue, leaving the rest for later sends
+        // or 'replayPending'.
+
+    // MANIPULATORS
+    int send(const bslstl::StringRef& payload);                // override
+    int send(const bslstl::StringRef& payload, int priority);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout,
+             int                       priority);  // override
+    int trySend(const bslstl::StringRef& payload);                // override
+    int trySend(const bslstl::StringRef& payload, int priority);  // override
+        // Append to the log a record of the specified 'payload' having the
+        // optionally specified 'priority', synchronize the log if so
+        // configured, and then enqueue the location of the record onto the
+        // queue represented by this object. Block for no longer than the
+        // optionally specified 'relativeTimeout' for the queue, or do not
+        // block for the queue if the function is 'trySend'. Return zero on
+        // success, 'PosixQueueTypes::Send::e_FULL' if the log is full,
+        // 'PosixQueueTypes::Send::e_MESSAGE_TOO_LARGE' if the payload is
+        // larger than the log, or another nonzero value otherwise. If the
+        // location is not enqueued, the record is discarded. Note that
+        // payloads still to be enqueued again are first enqueued as
+        // 'replayPending' does.
+
+    int sendBatch(const bslstl::StringRef *begin,
+                  const bslstl::StringRef *end,
+                  bsl::size_t             *numSent,
+                  int                      priority = 0);
+        // Append to the log, in order, a record for each payload in the
+        // specified range '[begin, end)', each having the optionally
+        // specified 'priority', synchronize the log once if so configured,
+        // and then enqueue their locations, blocking until there is room.
+        // Load into the specified 'numSent' the number of payloads enqueued.
+        // Return zero if every payload was sent, or the nonzero result of the
+        // first that could not be, in which case none of the subsequent
+        // payloads are sent either. Note that payloads still to be enqueued
+        // again are first enqueued as 'replayPending' does.
+
+    int replayPending();
+        // Enqueue again, in order and without blocking, the locations of the
+        // payloads pending in the log when this object was created that did
+        // not yet fit in the queue, stopping at the first that does not fit.
+        // Return zero if every such payload has been enqueued again,
+        // 'PosixQueueTypes::Send::e_FULL' if some still do not fit, or
+        // another nonzero value if enqueuing failed otherwise, in which case
+        // the remaining payloads are left pending in the log for the next
+        // 'DurableSender' to open it.
+
+    int sync();
+        // Block until every record appended to the log so far is on storage.
+        // Return zero on success or a nonzero value otherwise.
+
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero.
+
+    // ACCESSORS
+    void loadMetrics(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the locations enqueued by this
+        // object and the attempts that failed.
+
+    bsls::Types::Int64 numSyncs() const;
+        // Return the number of times the log was synchronized.
+
+    bsls::Types::Int64 numReplayed() const;
+        // Return the number of payloads pending in the log when this object
+        // was created that have since been enqueued again.
+
+    bool isOpen() const;
+        // Return whether this object represents an open message queue and an
+        // open write-ahead log.
+
+    IPCU_DECLARE_OPERATOR_BOOL(DurableSender);
+        // Return 'isOpen()'.
+
+    const PosixQueue& posixQueue() const;
+        // Return a reference providing non-modifiable access to the
+        // 'PosixQueue' instance used to implement this object.
+
+    // CLASS METHODS
+    static const char *description(int errorCode);
+        // Return a pointer to a null terminated string that describes the
+        // specified 'errorCode'. The behavior is undefined unless 'errorCode'
+        // has the same value as the result of a previous invocation of one of
+        // the methods of an instance of this class.
+
+  private:
+    // PRIVATE MANIPULATORS
+    void start(const bslstl::StringRef& logPath,
+               const Options&           options,
+               int                      filePermissions);
+        // Open the log at the specified 'logPath' as described by the
+        // specified 'options', creating it with the specified
+        // 'filePermissions' if need be, and enqueue again, without blocking,
+        // as many pending payloads as fit.
+
+    int record(WriteAheadLog::Location  *location,
+               const bslstl::StringRef&  payload,
+               int                       priority);
+        // Enqueue again any pending payloads that did not yet fit in the
+        // queue, as 'replayPending' does, then append to the log a record of
+        // the specified 'payload' and 'priority', load its location into the
+        // specified 'location', and synchronize the log if so configured.
+        // Return zero on success or a nonzero value otherwise, in which case
+        // the record is discarded.
+
+    int settle(const WriteAheadLog::Location& location, int rc);
+        // Discard the record at the specified 'location' unless the specified
+        // 'rc', the result of enqueuing its location, is zero. Return 'rc'.
+
+    int syncThrough(bsls::Types::Uint64 sequence);
+        // Block until the record having the specified 'sequence' number is on
+        // storage, synchronizing the log unless another thread already is.
+        // Return zero on success or a nonzero value otherwise.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                            // -------------------
+                            // class DurableSender
+                            // -------------------
+
+inline
+int DurableSender::send(const bslstl::StringRef& payload)
+{
+    return send(payload, 0);
+}
+
+inline
+int DurableSender::send(const bslstl::StringRef&  payload,
+                        const bsls::TimeInterval& relativeTimeout)
+{
+    return send(payload, relativeTimeout, 0);
+}
+
+inline
+int DurableSender::trySend(const bslstl::StringRef& payload)
+{
+    return trySend(payload, 0);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -10,7 +10,14 @@ namespace ipcmq {
                                 // class Format
                                 // ============
 
-IPCU_DEFINE_ENUM(Format, RAW, EXTENDED);
+IPCU_DEFINE_ENUM(Format,
+                 RAW,
+                 EXTENDED,
+                 SHARED_MEMORY,
+                 FRAGMENTED,
+                 COMPRESSED,
+                 TAGGED,
+                 PACKED);
 
 }  // close package namespace
 }  // close enterprise namespace
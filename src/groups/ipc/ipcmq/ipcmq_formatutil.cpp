@@ -1,6 +1,11 @@
 
 #include <ipcmq_formatutil.h>
+#include <ipcmq_messagebuffer.h>
+#include <ipcmq_payload.h>
 #include <ipcmq_posixqueueerrors.h>
+#include <ipcmq_sharedmemorypool.h>
+
+#include <ipcu_lzutil.h>
 
 #include <ball_log.h>
 
@@ -16,11 +21,14 @@
 #include <bsl_cstring.h>
 #include <bsl_iomanip.h>
 
+#include <bslmf_assert.h>
+
 #include <bsls_assert.h>
+#include <bsls_atomic.h>
 
 #include <fcntl.h>     // open and related constants
 #include <sys/stat.h>  // open and related constants
-#include <unistd.h>    // close, write
+#include <unistd.h>    // close, getpid, write
 
 namespace BloombergLP {
 namespace ipcmq {
@@ -46,6 +54,103 @@ const char *errorOverflow(int errorCode)
 
 const char k_EXTENDED_IN_PLACE      = 0;
 const char k_EXTENDED_EXTERNAL_FILE = 1;
+const char k_SHARED_MEMORY_SLOT     = 2;
+const char k_FRAGMENT               = 3;
+const char k_COMPRESSED             = 4;
+const char k_ENCODED_FRAGMENT       = 5;
+const char k_PACKED                 = 6;
+
+// A fragment is the fragment's bytes of the payload followed by the stream ID,
+// the total length, the index, the count, and then the "fragment" or "encoded
+// fragment" byte, each field in the byte order of the machine.
+const bsl::size_t k_FRAGMENT_TRAILER_SIZE =
+    2 * sizeof(bsls::Types::Uint64) + 2 * sizeof(unsigned) + 1;
+
+// A compressed message is the compressed bytes of the payload followed by the
+// length of the payload, in the byte order of the machine, and then the
+// "compressed" byte.
+const bsl::size_t k_COMPRESSED_TRAILER_SIZE = sizeof(bsls::Types::Uint64) + 1;
+
+// A packed message is a sequence of payloads, each preceded by its length as
+// an 'unsigned' in the byte order of the machine, followed by the "packed"
+// byte.
+const bsl::size_t k_PACKED_PREFIX_SIZE = sizeof(unsigned);
+
+// Payloads shorter than this are not worth compressing.
+const bsl::size_t k_MIN_COMPRESSED_PAYLOAD_LENGTH = 64;
+
+// Compressed bytes are kept on the stack when they fit in this many bytes,
+// which is the default maximum message size on Linux.
+const int k_COMPRESSION_SCRATCH_SIZE = 8192;
+
+// Paths of temporary files and handles of shared memory slots are kept on the
+// stack when they fit in this many bytes, which is chosen somewhat arbitrarily
+// as big enough for either.
+const int k_HANDLE_BUFFER_SIZE = 256;
+
+// The low 32 bits of each fragment stream ID come from this counter, and the
+// high 32 bits are the process ID.
+bsls::AtomicUint s_nextFragmentStream(0);
+
+// The codecs of the formats, indexed by 'Format'.
+const Codec k_FORMAT_CODECS[] = {
+    {"raw",
+     &FormatUtil::encodeRaw,
+     &FormatUtil::decodeRaw,
+     &FormatUtil::decodeRawBuffer,
+     &FormatUtil::decodeRawPayload,
+     &FormatUtil::decodeRawBatch},
+    {"extended",
+     &FormatUtil::encodeExtended,
+     &FormatUtil::decodeExtended,
+     &FormatUtil::decodeExtendedBuffer,
+     &FormatUtil::decodeExtendedPayload,
+     &FormatUtil::decodeExtendedBatch},
+    {"shared memory",
+     &FormatUtil::encodeSharedMemory,
+     &FormatUtil::decodeSharedMemory,
+     &FormatUtil::decodeSharedMemoryBuffer,
+     &FormatUtil::decodeSharedMemoryPayload,
+     &FormatUtil::decodeSharedMemoryBatch},
+    {"fragmented",
+     &FormatUtil::encodeFragmented,
+     &FormatUtil::decodeFragmented,
+     &FormatUtil::decodeFragmentedBuffer,
+     &FormatUtil::decodeFragmentedPayload,
+     &FormatUtil::decodeFragmentedBatch},
+    {"compressed",
+     &FormatUtil::encodeCompressed,
+     &FormatUtil::decodeCompressed,
+     &FormatUtil::decodeCompressedBuffer,
+     &FormatUtil::decodeCompressedPayload,
+     &FormatUtil::decodeCompressedBatch},
+    {"tagged",
+     &FormatUtil::encodeTagged,
+     &FormatUtil::decodeTagged,
+     &FormatUtil::decodeTaggedBuffer,
+     &FormatUtil::decodeTaggedPayload,
+     &FormatUtil::decodeTaggedBatch},
+    {"packed",
+     &FormatUtil::encodePacked,
+     &FormatUtil::decodePacked,
+     &FormatUtil::decodePackedBuffer,
+     &FormatUtil::decodePackedPayload,
+     &FormatUtil::decodePackedBatch}};
+
+BSLMF_ASSERT(sizeof k_FORMAT_CODECS / sizeof k_FORMAT_CODECS[0] ==
+             Format::NUM_VALUES);
+
+// The codecs that decode messages ending with each reserved tag, indexed by
+// tag. Unused tags, fragments, which must be reassembled, and packed messages,
+// which must be unpacked, have none.
+const Codec *const k_TAG_CODECS[CodecRegistry::k_MIN_APPLICATION_TAG] = {
+    &k_FORMAT_CODECS[Format::e_EXTENDED],       // k_EXTENDED_IN_PLACE
+    &k_FORMAT_CODECS[Format::e_EXTENDED],       // k_EXTENDED_EXTERNAL_FILE
+    &k_FORMAT_CODECS[Format::e_SHARED_MEMORY],  // k_SHARED_MEMORY_SLOT
+    0,                                          // k_FRAGMENT
+    &k_FORMAT_CODECS[Format::e_COMPRESSED],     // k_COMPRESSED
+    0,                                          // k_ENCODED_FRAGMENT
+    0};                                         // k_PACKED
 
 class EnvHasValue {
     // This class is a unary function-like object closed over an output string.
@@ -194,6 +299,44 @@ int writeToTempFile(const bslstl::StringRef& data, bsl::string *path)
     return 0;
 }
 
+class CloseAndRemoveGuard {
+    // This class closes a file and then deletes it when destroyed, logging a
+    // diagnostic if either fails.
+
+    bsl::FILE  *d_file_p;
+    const char *d_path_p;
+
+  public:
+    CloseAndRemoveGuard(bsl::FILE *file, const char *path)
+    : d_file_p(file)
+    , d_path_p(path)
+    {
+    }
+
+    ~CloseAndRemoveGuard()
+    {
+        BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+        if (bsl::fclose(d_file_p)) {
+            BALL_LOG_WARN << "Unable to close file \"" << d_path_p << '\"'
+                          << BALL_LOG_END;
+        }
+
+        if (bsl::remove(d_path_p)) {
+            BALL_LOG_WARN << "Unable to remove file \"" << d_path_p << '\"'
+                          << BALL_LOG_END;
+        }
+    }
+
+    void setPath(const char *path)
+        // Use the specified 'path' as the name of the file to delete. Note
+        // that 'path' must name the same file as the path originally
+        // specified.
+    {
+        d_path_p = path;
+    }
+};
+
 int readAndRemoveFile(bsl::string *bufferPtr)
     // Read into the specified 'bufferPtr' the contents of the file whose full
     // path is the current value of 'bufferPtr'. Return zero on success or a
@@ -214,30 +357,7 @@ int readAndRemoveFile(bsl::string *bufferPtr)
         return 1;                                                     // RETURN
     }
 
-    struct Closer {
-        bsl::FILE *const  d_file;
-        const char       *d_path;
-        Closer(bsl::FILE *file, const char *path)
-        : d_file(file)
-        , d_path(path)
-        {
-        }
-        ~Closer()
-        {
-            BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
-
-            if (bsl::fclose(d_file)) {
-                BALL_LOG_WARN << "Unable to close file \"" << d_path << '\"'
-                              << BALL_LOG_END;
-            }
-
-            if (bsl::remove(d_path)) {
-                BALL_LOG_WARN << "Unable to remove file \"" << d_path << '\"'
-                              << BALL_LOG_END;
-            }
-        }
-
-    } closer(message, path);
+    CloseAndRemoveGuard closer(message, path);
 
     const bdls::FilesystemUtil::Offset sizeSigned =
         bdls::FilesystemUtil::getFileSize(path);
@@ -259,7 +379,7 @@ int readAndRemoveFile(bsl::string *bufferPtr)
     buffer.insert(bsl::size_t(0), room, char(0));  // Make room before the path
 
     path = buffer.data() + room;  // 'path' shifted right with the insert.
-    closer.d_path = path;
+    closer.setPath(path);
 
     const bsl::size_t countRead = bsl::fread(&buffer[0], 1, room, message);
     if (countRead < size) {
@@ -289,121 +409,1338 @@ int readAndRemoveFile(bsl::string *bufferPtr)
     return 0;                                                         // RETURN
 }
 
-}  // close unnamed namespace
+int appendAndRemoveFile(const char *path, MessageBuffer *output)
+    // Append to the specified 'output' the contents of the file at the
+    // specified 'path', and then delete the file. Return zero on success or a
+    // nonzero value otherwise. Note that the file is deleted even if this
+    // function fails. Also note that, unlike 'readAndRemoveFile', this
+    // function neither moves nor initializes any existing storage.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(path);
+    BSLS_ASSERT(output);
 
-FormatUtil::Encoder FormatUtil::encoder(Format format)
+    bsl::FILE *const message = bsl::fopen(path, "r");
+    if (!message) {
+        BALL_LOG_ERROR << "Unable to open the file \"" << path
+                       << "\" for reading: " << bsl::strerror(errno)
+                       << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    CloseAndRemoveGuard closer(message, path);
+
+    const bdls::FilesystemUtil::Offset sizeSigned =
+        bdls::FilesystemUtil::getFileSize(path);
+    if (sizeSigned < 0) {
+        BALL_LOG_ERROR << "Unable to determine the size the the file \""
+                       << path << '\"' << BALL_LOG_END;
+        return 2;                                                     // RETURN
+    }
+
+    const bsl::size_t size = sizeSigned;
+    const bsl::size_t room = size + 1;  // an extra char, so we can detect if
+                                        // the file grew between determining
+                                        // its size and reading it.
+
+    output->reserve(output->length() + room);
+
+    const bsl::size_t countRead =
+        bsl::fread(output->data() + output->length(), 1, room, message);
+    if (countRead != size) {
+        BALL_LOG_ERROR << "Unable to read the contents of \"" << path
+                       << "\". Expected " << size << " bytes but read "
+                       << countRead << ". Maybe the file was modified."
+                       << BALL_LOG_END;
+        return 3;                                                     // RETURN
+    }
+
+    output->setLength(output->length() + size);
+    return 0;
+}
+
+int parseCompressed(bsls::Types::Uint64      *length,
+                    bslstl::StringRef        *compressed,
+                    const bslstl::StringRef&  message)
+    // Load into the specified 'length' and the specified 'compressed' the
+    // length of the payload and the compressed bytes of the specified
+    // 'message', which ends with the "compressed" byte. Return zero on success
+    // or a nonzero value if 'message' is too short or names a length that
+    // 'compressed' could not decompress into.
 {
-    switch (format) {
-      case Format::e_RAW:
-        return &FormatUtil::encodeRaw;                                // RETURN
-      default:
-        BSLS_ASSERT(format == Format::e_EXTENDED);
-        return &FormatUtil::encodeExtended;                           // RETURN
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(length);
+    BSLS_ASSERT(compressed);
+
+    if (message.length() < k_COMPRESSED_TRAILER_SIZE) {
+        BALL_LOG_ERROR << "A compressed message of " << message.length()
+                       << " bytes is too short for its trailer."
+                       << BALL_LOG_END;
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    const bsl::size_t compressedLength =
+        message.length() - k_COMPRESSED_TRAILER_SIZE;
+    bsl::memcpy(length, message.data() + compressedLength, sizeof *length);
+
+    // Check the length before anyone allocates that much.
+    if (ipcu::LzUtil::minCompressedLength(*length) > compressedLength) {
+        BALL_LOG_ERROR << "A compressed message of " << compressedLength
+                       << " bytes cannot hold a payload of " << *length
+                       << " bytes." << BALL_LOG_END;
+        return makeError(e_DECODER_ERROR);                            // RETURN
     }
+
+    *compressed = bslstl::StringRef(message.data(), compressedLength);
+    return 0;
 }
 
-FormatUtil::Decoder FormatUtil::decoder(Format format)
+int decompress(char                     *output,
+               bsl::size_t               length,
+               const bslstl::StringRef&  compressed)
+    // Decompress the specified 'compressed' bytes into the specified 'length'
+    // bytes at the specified 'output'. Return zero on success or a nonzero
+    // value if 'compressed' is invalid or does not decompress into exactly
+    // 'length' bytes.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    bsl::size_t decompressedLength;
+    if (ipcu::LzUtil::decompress(&decompressedLength,
+                                 output,
+                                 length,
+                                 compressed.data(),
+                                 compressed.length()) ||
+        decompressedLength != length) {
+        BALL_LOG_ERROR << "Unable to decompress " << compressed.length()
+                       << " bytes into a payload of " << length << " bytes."
+                       << BALL_LOG_END;
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    return 0;
+}
+
+bool accepts(Format format, char tag)
+    // Return whether the decoders of the specified 'format' decode messages
+    // ending with the specified 'tag'.
 {
-    switch (format) {
-      case Format::e_RAW:
-        return &FormatUtil::decodeRaw;                                // RETURN
+    switch (tag) {
+      case k_EXTENDED_IN_PLACE:
+        return true;                                                  // RETURN
+      case k_EXTENDED_EXTERNAL_FILE:
+        return format != Format::e_FRAGMENTED;                        // RETURN
+      case k_SHARED_MEMORY_SLOT:
+        return format == Format::e_SHARED_MEMORY ||
+               format == Format::e_TAGGED;                            // RETURN
+      case k_FRAGMENT:
+      case k_ENCODED_FRAGMENT:
+        return format == Format::e_FRAGMENTED ||
+               format == Format::e_TAGGED;                            // RETURN
+      case k_COMPRESSED:
+        return format == Format::e_COMPRESSED ||
+               format == Format::e_TAGGED;                            // RETURN
+      case k_PACKED:
+        return format == Format::e_PACKED;                            // RETURN
       default:
-        BSLS_ASSERT(format == Format::e_EXTENDED);
-        return &FormatUtil::decodeExtended;                           // RETURN
+        return format == Format::e_TAGGED;                            // RETURN
     }
 }
 
-int FormatUtil::encodeRaw(long, bslstl::StringRef *, bsl::string *)
+const Codec *findCodec(const bslstl::StringRef& message)
+    // Return the address of the application's codec that decodes the
+    // specified 'message', according to its last byte, or log a diagnostic
+    // and return zero if there is none. The behavior is undefined if
+    // 'message' is empty.
 {
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(!message.empty());
+
+    const char tag = message[message.length() - 1];
+    if (const Codec *const codec = FormatUtil::tagCodec(tag)) {
+        return codec;                                                 // RETURN
+    }
+
+    BALL_LOG_ERROR << "The final byte of message is 0x" << bsl::hex
+                   << int(tag) << ", under which no codec is registered."
+                   << BALL_LOG_END;
     return 0;
 }
 
-int FormatUtil::decodeRaw(bsl::string *)
+void append(MessageBuffer *output, const bslstl::StringRef& data)
+    // Append the specified 'data' to the specified 'output'. The behavior is
+    // undefined if 'data' refers to memory within 'output'.
+{
+    const bsl::size_t offset = output->length();
+    output->reserve(offset + data.length());
+    bsl::memcpy(output->data() + offset, data.data(), data.length());
+    output->setLength(offset + data.length());
+}
+
+int unpackOnly(bslstl::StringRef *payload, const bslstl::StringRef& message)
+    // Load into the specified 'payload' the only payload of the specified
+    // packed 'message'. Return zero on success, or log a diagnostic and
+    // return a nonzero value if 'message' is malformed or packs more than one
+    // payload.
 {
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(payload);
+    BSLS_ASSERT(FormatUtil::isPacked(message));
+
+    unsigned length = 0;
+    if (message.length() > k_PACKED_PREFIX_SIZE) {
+        bsl::memcpy(&length, message.data(), k_PACKED_PREFIX_SIZE);
+    }
+
+    if (message.length() != k_PACKED_PREFIX_SIZE + length + 1) {
+        BALL_LOG_ERROR << "A packed message of " << message.length()
+                       << " bytes does not hold exactly one payload, and so "
+                          "must be unpacked by a receiver."
+                       << BALL_LOG_END;
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    *payload = bslstl::StringRef(message.data() + k_PACKED_PREFIX_SIZE,
+                                 length);
     return 0;
 }
 
-int FormatUtil::encodeExtended(long               maxMessageSize,
-                               bslstl::StringRef *originalAndOutput,
-                               bsl::string       *messageBuffer)
+                             // =================
+                             // struct BufferTail
+                             // =================
+
+struct BufferTail {
+    // This 'struct' refers to the bytes of a 'MessageBuffer' from an offset
+    // to the end of its contents, so that 'decodeMessage' can decode in place
+    // both a message that is a whole buffer and a message that was copied to
+    // the end of a batch's arena. The bytes are located by offset, since
+    // decoding may move the buffer.
+
+    // DATA
+    MessageBuffer *d_buffer_p;   // buffer whose last bytes are the message
+    bsl::size_t    d_offset;     // offset of the message within the buffer
+    MessageBuffer *d_scratch_p;  // buffer in which an application's codec
+                                 // decodes the message if 'd_offset' is not
+                                 // zero
+
+    // CREATORS
+    explicit BufferTail(MessageBuffer *buffer,
+                        bsl::size_t    offset  = 0,
+                        MessageBuffer *scratch = 0)
+    : d_buffer_p(buffer)
+    , d_offset(offset)
+    , d_scratch_p(scratch)
+    {
+        BSLS_ASSERT(buffer);
+        BSLS_ASSERT(offset <= buffer->length());
+        BSLS_ASSERT(offset == 0 || scratch);
+    }
+};
+
+// The following overloads provide the operations with which 'decodeMessage'
+// decodes a message held in a 'bsl::string', a 'BufferTail', or a 'Payload'.
+
+bslstl::StringRef contentsOf(const bsl::string& message)
+    // Return a reference to the contents of the specified 'message'.
 {
-    BSLS_ASSERT(originalAndOutput);
-    BSLS_ASSERT(messageBuffer);
+    return message;
+}
 
-    bslstl::StringRef& message = *originalAndOutput;
-    bsl::string&       buffer  = *messageBuffer;
+bslstl::StringRef contentsOf(const BufferTail& message)
+{
+    return message.d_buffer_p->stringRef(
+        message.d_offset, message.d_buffer_p->length() - message.d_offset);
+}
 
-    // If the message is shorter than 'maxMessageSize', then just write it
-    // to the 'buffer' along with the trailing "in place" byte (it has to be
-    // _shorter_ than 'maxMessageSize' so that there's at least one byte left
-    // for the "in place" byte).
-    if (long(message.length()) < maxMessageSize) {
-        // If 'message' aliases 'buffer' completely, then we don't have to
-        // copy. Otherwise we do have to copy.
-        if (message.data() != buffer.data() ||
-            message.length() != buffer.size()) {
-            buffer.assign(message);
-        }
+bslstl::StringRef contentsOf(const Payload& message)
+{
+    return message.stringRef();
+}
 
-        buffer += k_EXTENDED_IN_PLACE;
-        message = buffer;
-        return 0;                                                     // RETURN
+bslma::Allocator *allocatorOf(const bsl::string& message)
+    // Return the allocator used by the specified 'message' to supply memory.
+{
+    return message.get_allocator().mechanism();
+}
+
+bslma::Allocator *allocatorOf(const BufferTail& message)
+{
+    return message.d_buffer_p->allocator();
+}
+
+bslma::Allocator *allocatorOf(const Payload& message)
+{
+    return message.allocator();
+}
+
+void keepOnly(bsl::string *message, const bslstl::StringRef& part)
+    // Replace the contents of the specified 'message' with the specified
+    // 'part' of them.
+{
+    const bsl::size_t offset = part.data() - message->data();
+    message->resize(offset + part.length());
+    message->erase(0, offset);
+}
+
+void keepOnly(BufferTail *message, const bslstl::StringRef& part)
+{
+    MessageBuffer& buffer = *message->d_buffer_p;
+    char *const    data   = buffer.data() + message->d_offset;
+    if (part.data() != data) {
+        bsl::memmove(data, part.data(), part.length());
     }
+    buffer.setLength(message->d_offset + part.length());
+}
 
-    // The message is too large. Write it to a temporary file instead, and let
-    // the value enqueued be the path to the file along with the trailing
-    // "external file" byte.
+void keepOnly(Payload *message, const bslstl::StringRef& part)
+{
+    BufferTail tail(&message->buffer());
+    keepOnly(&tail, part);
+}
 
-    // 265 is chosen somewhat arbitrarily as "big enough for a temp path."
-    bdlma::LocalSequentialAllocator<256> pathAllocator(
-                                           buffer.get_allocator().mechanism());
+char *makeRoom(bsl::string *message, bsl::size_t length)
+    // Replace the contents of the specified 'message' with the specified
+    // 'length' bytes having unspecified values, and return the address of the
+    // first of them.
+{
+    message->resize(length);
+    return &(*message)[0];
+}
 
-    bsl::string path(&pathAllocator);
-    if (writeToTempFile(message, &path)) {
-        return makeError(e_ENCODER_ERROR);                            // RETURN
+char *makeRoom(BufferTail *message, bsl::size_t length)
+{
+    MessageBuffer& buffer = *message->d_buffer_p;
+    buffer.setLength(message->d_offset);
+    buffer.reserve(message->d_offset + length);
+    buffer.setLength(message->d_offset + length);
+    return buffer.data() + message->d_offset;
+}
+
+char *makeRoom(Payload *message, bsl::size_t length)
+{
+    BufferTail tail(&message->buffer());
+    return makeRoom(&tail, length);
+}
+
+int loadFile(bsl::string *message, const char *path)
+    // Replace the contents of the specified 'message' with the contents of
+    // the file at the specified 'path', and delete the file. Return zero on
+    // success or a nonzero value otherwise. The behavior is undefined if
+    // 'path' refers into 'message'.
+{
+    message->assign(path);
+    return readAndRemoveFile(message);
+}
+
+int loadFile(BufferTail *message, const char *path)
+{
+    message->d_buffer_p->setLength(message->d_offset);
+    return appendAndRemoveFile(path, message->d_buffer_p);
+}
+
+int loadFile(Payload *message, const char *path)
+{
+    // Map the file rather than copying it.
+    return message->mapAndRemoveFile(path);
+}
+
+int loadSlot(bsl::string *message, const bslstl::StringRef& handle)
+    // Replace the contents of the specified 'message' with the contents of
+    // the shared memory slot having the specified 'handle', releasing the
+    // slot. Return zero on success or a nonzero value otherwise. Note that
+    // 'handle' may refer into 'message', since the pool parses the handle
+    // before modifying 'message'.
+{
+    return SharedMemoryPool::defaultPool().read(message, handle);
+}
+
+int loadSlot(BufferTail *message, const bslstl::StringRef& handle)
+{
+    // Shrinking the buffer does not modify its bytes, so 'handle' remains
+    // valid until the pool has parsed it.
+    message->d_buffer_p->setLength(message->d_offset);
+    return SharedMemoryPool::defaultPool().read(message->d_buffer_p, handle);
+}
+
+int loadSlot(Payload *message, const bslstl::StringRef& handle)
+{
+    BufferTail tail(&message->buffer());
+    return loadSlot(&tail, handle);
+}
+
+int decodeWith(const Codec& codec, bsl::string *message)
+    // Decode the specified 'message' using the specified application's
+    // 'codec'. Return zero on success or a nonzero value otherwise.
+{
+    return codec.d_decoder(message);
+}
+
+int decodeWith(const Codec& codec, BufferTail *message)
+{
+    if (message->d_offset == 0) {
+        return codec.d_bufferDecoder(message->d_buffer_p);            // RETURN
     }
 
-    buffer = path;
-    buffer += k_EXTENDED_EXTERNAL_FILE;
-    message = buffer;
+    // The codec may replace the message with a payload of any length, so
+    // decode it outside of the buffer.
+    MessageBuffer& scratch = *message->d_scratch_p;
+    scratch.clear();
+    append(&scratch, contentsOf(*message));
+    if (const int rc = codec.d_bufferDecoder(&scratch)) {
+        return rc;                                                    // RETURN
+    }
+
+    message->d_buffer_p->setLength(message->d_offset);
+    append(message->d_buffer_p, scratch.stringRef());
     return 0;
 }
 
-int FormatUtil::decodeExtended(bsl::string *originalAndOutput)
+int decodeWith(const Codec& codec, Payload *message)
+{
+    if (!codec.d_payloadDecoder) {
+        return codec.d_bufferDecoder(&message->buffer());             // RETURN
+    }
+
+    return codec.d_payloadDecoder(message);
+}
+
+template <class MESSAGE>
+int decodeMessage(MESSAGE *message, Format format)
+    // Decode in place the specified 'message', accepting the messages that
+    // the decoders of the specified 'format' accept. Return zero on success,
+    // or log a diagnostic and return a nonzero value otherwise. Note that
+    // fragments are not decoded, since they must be reassembled.
 {
     BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
-    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(message);
 
-    bsl::string& message = *originalAndOutput;
-    if (message.empty()) {
-        BALL_LOG_ERROR << "The extended codec cannot decode an empty message."
+    const char *const       codecName = k_FORMAT_CODECS[format].d_name;
+    const bslstl::StringRef contents  = contentsOf(*message);
+    if (contents.empty()) {
+        BALL_LOG_ERROR << "The " << codecName
+                       << " codec cannot decode an empty message."
                        << BALL_LOG_END;
         return makeError(e_DECODER_ERROR);                            // RETURN
     }
 
-    const char lastByte = message.back();
-    if (lastByte == k_EXTENDED_IN_PLACE) {
-        // success. Get rid of the trailing "indicator" byte.
-        message.resize(message.size() - 1);
-        return 0;                                                     // RETURN
+    const char lastByte = contents[contents.length() - 1];
+    if (!accepts(format, lastByte)) {
+        BALL_LOG_ERROR << "The final byte of message is 0x" << bsl::hex
+                       << int(lastByte)
+                       << ", which is not one of the accepted values for the "
+                       << codecName << " codec." << BALL_LOG_END;
+        return makeError(e_DECODER_ERROR);                            // RETURN
     }
-    else if (lastByte == k_EXTENDED_EXTERNAL_FILE) {
-        // Interpret the message as a file path and use the file's contents.
-        // First get rid of the tailing "indicator" byte.
-        message.resize(message.size() - 1);
-        if (readAndRemoveFile(&message)) {
+
+    // The message, except for the trailing "indicator" byte.
+    const bslstl::StringRef body(contents.data(), contents.length() - 1);
+
+    switch (lastByte) {
+      case k_EXTENDED_IN_PLACE: {
+        keepOnly(message, body);
+        return 0;                                                     // RETURN
+      }
+      case k_EXTENDED_EXTERNAL_FILE: {
+        // 'body' is the path to a file whose contents are the payload. Copy
+        // the path out of 'message' first, since the payload replaces it.
+        bdlma::LocalSequentialAllocator<k_HANDLE_BUFFER_SIZE> pathAllocator(
+                                                       allocatorOf(*message));
+        const bsl::string path(body.data(), body.length(), &pathAllocator);
+
+        if (loadFile(message, path.c_str())) {
+            return makeError(e_DECODER_ERROR);                        // RETURN
+        }
+        return 0;                                                     // RETURN
+      }
+      case k_SHARED_MEMORY_SLOT: {
+        // 'body' is the handle of a shared memory slot whose contents are the
+        // payload.
+        if (loadSlot(message, body)) {
             return makeError(e_DECODER_ERROR);                        // RETURN
         }
+        return 0;                                                     // RETURN
+      }
+      case k_COMPRESSED: {
+        bsls::Types::Uint64 length;
+        bslstl::StringRef   input;
+        if (const int rc = parseCompressed(&length, &input, contents)) {
+            return rc;                                                // RETURN
+        }
 
-        // success
+        // Copy the compressed bytes out of 'message' first, since the payload
+        // replaces them.
+        bdlma::LocalSequentialAllocator<k_COMPRESSION_SCRATCH_SIZE>
+                          compressedAllocator(allocatorOf(*message));
+        const bsl::string compressed(
+            input.data(), input.length(), &compressedAllocator);
+
+        return decompress(
+                 makeRoom(message, length), length, compressed);      // RETURN
+      }
+      case k_PACKED: {
+        bslstl::StringRef payload;
+        if (const int rc = unpackOnly(&payload, contents)) {
+            return rc;                                                // RETURN
+        }
+
+        keepOnly(message, payload);
         return 0;                                                     // RETURN
+      }
+      case k_FRAGMENT:
+      case k_ENCODED_FRAGMENT: {
+        BALL_LOG_ERROR << "The " << codecName
+                       << " codec cannot decode a fragment without a "
+                          "reassembler."
+                       << BALL_LOG_END;
+        return makeError(e_DECODER_ERROR);                            // RETURN
+      }
+    }
+
+    // Decode the message using an application's codec.
+    const Codec *const codec = findCodec(contents);
+    if (!codec) {
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    return decodeWith(*codec, message);
+}
+
+int decodeBatch(MessageBuffer                                   *arena,
+                bsl::vector<PosixQueueTypes::MessageDescriptor> *messages,
+                Format                                           format,
+                FragmentReassembler                             *reassembler)
+    // Decode in place each message within the specified 'arena' that is
+    // described by an element of the specified 'messages', accepting the
+    // messages that the decoders of the specified 'format' accept, and
+    // removing from 'messages' each message that cannot be decoded. Add
+    // fragments to the specified 'reassembler', appending to 'arena' each
+    // payload that they complete, and remove from 'messages' those that do
+    // not complete one. If 'reassembler' is zero, fragments cannot be
+    // decoded. Return zero if every message was decoded or a nonzero value
+    // otherwise.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(arena);
+    BSLS_ASSERT(messages);
+
+    typedef PosixQueueTypes::MessageDescriptor Descriptor;
+
+    // Payloads that are reassembled, or decoded by application codecs, are
+    // decoded here and then appended to the arena.
+    MessageBuffer payload(arena->allocator());
+    bool          failed = false;
+
+    // Decode each message, moving the descriptors of those that yield a
+    // payload to the front of 'messages'. The rest are overwritten or erased.
+    bsl::vector<Descriptor>::iterator output = messages->begin();
+    for (bsl::vector<Descriptor>::iterator message = messages->begin();
+         message != messages->end();
+         ++message) {
+        const bslstl::StringRef contents =
+            arena->stringRef(message->d_offset, message->d_length);
+        const char lastByte =
+            contents.empty() ? 0 : contents[contents.length() - 1];
+
+        if (!contents.empty() && lastByte == k_EXTENDED_IN_PLACE) {
+            // Get rid of the trailing "indicator" byte, leaving the payload
+            // where it is.
+            --message->d_length;
+            *output++ = *message;
+            continue;
+        }
+
+        // Any other payload is appended to the arena, and the message's
+        // descriptor modified to refer to it. This may move the arena, but
+        // the descriptors refer to it only by offset.
+        const bsl::size_t offset = arena->length();
+
+        const bool isFragment =
+            lastByte == k_FRAGMENT || lastByte == k_ENCODED_FRAGMENT;
+
+        if (reassembler && isFragment && accepts(format, lastByte)) {
+            FragmentHeader    header;
+            bslstl::StringRef data;
+            if (FormatUtil::decodeFragment(&header, &data, contents)) {
+                BALL_LOG_ERROR << "A fragment of " << contents.length()
+                               << " bytes is too short for its header."
+                               << BALL_LOG_END;
+                failed = true;
+                continue;
+            }
+
+            bool isComplete;
+            if (reassembler->add(&isComplete, &payload, header, data)) {
+                failed = true;
+                continue;
+            }
+
+            if (!isComplete) {
+                // A later fragment will complete the payload.
+                continue;
+            }
+
+            // The payload of an encoded fragment is itself a message.
+            if (header.d_isEncoded &&
+                FormatUtil::decodeTaggedBuffer(&payload)) {
+                failed = true;
+                continue;
+            }
+
+            append(arena, payload.stringRef());
+        }
+        else {
+            // Copy the message to the end of the arena, and decode it there.
+            arena->reserve(offset + message->d_length);
+            bsl::memcpy(arena->data() + offset,
+                        arena->data() + message->d_offset,
+                        message->d_length);
+            arena->setLength(offset + message->d_length);
+
+            BufferTail tail(arena, offset, &payload);
+            if (decodeMessage(&tail, format)) {
+                arena->setLength(offset);
+                failed = true;
+                continue;
+            }
+        }
+
+        message->d_offset = offset;
+        message->d_length = arena->length() - offset;
+        *output++ = *message;
+    }
+
+    messages->erase(output, messages->end());
+    return failed ? makeError(e_DECODER_ERROR) : 0;
+}
+
+}  // close unnamed namespace
+
+const Codec& FormatUtil::formatCodec(Format format)
+{
+    BSLS_ASSERT(unsigned(format) < Format::NUM_VALUES);
+
+    return k_FORMAT_CODECS[format];
+}
+
+const Codec *FormatUtil::tagCodec(unsigned char tag)
+{
+    if (tag < CodecRegistry::k_MIN_APPLICATION_TAG) {
+        return k_TAG_CODECS[tag];                                     // RETURN
+    }
+
+    return CodecRegistry::defaultRegistry().lookup(tag);
+}
+
+FormatUtil::Encoder FormatUtil::encoder(Format format)
+{
+    return formatCodec(format).d_encoder;
+}
+
+FormatUtil::Decoder FormatUtil::decoder(Format format)
+{
+    return formatCodec(format).d_decoder;
+}
+
+FormatUtil::BufferDecoder FormatUtil::bufferDecoder(Format format)
+{
+    return formatCodec(format).d_bufferDecoder;
+}
+
+FormatUtil::PayloadDecoder FormatUtil::payloadDecoder(Format format)
+{
+    return formatCodec(format).d_payloadDecoder;
+}
+
+FormatUtil::BatchDecoder FormatUtil::batchDecoder(Format format)
+{
+    return formatCodec(format).d_batchDecoder;
+}
+
+int FormatUtil::encodeRaw(long, bslstl::StringRef *, bsl::string *)
+{
+    return 0;
+}
+
+int FormatUtil::decodeRaw(bsl::string *)
+{
+    return 0;
+}
+
+int FormatUtil::decodeRawBuffer(MessageBuffer *)
+{
+    return 0;
+}
+
+int FormatUtil::decodeRawPayload(Payload *)
+{
+    return 0;
+}
+
+int FormatUtil::decodeRawBatch(
+                             MessageBuffer                                   *,
+                             bsl::vector<PosixQueueTypes::MessageDescriptor> *)
+{
+    return 0;
+}
+
+int FormatUtil::encodeExtended(long               maxMessageSize,
+                               bslstl::StringRef *originalAndOutput,
+                               bsl::string       *messageBuffer)
+{
+    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(messageBuffer);
+
+    bslstl::StringRef& message = *originalAndOutput;
+    bsl::string&       buffer  = *messageBuffer;
+
+    // If the message is shorter than 'maxMessageSize', then just write it
+    // to the 'buffer' along with the trailing "in place" byte (it has to be
+    // _shorter_ than 'maxMessageSize' so that there's at least one byte left
+    // for the "in place" byte).
+    if (long(message.length()) < maxMessageSize) {
+        // If 'message' aliases 'buffer' completely, then we don't have to
+        // copy. Otherwise we do have to copy.
+        if (message.data() != buffer.data() ||
+            message.length() != buffer.size()) {
+            buffer.assign(message);
+        }
+
+        buffer += k_EXTENDED_IN_PLACE;
+        message = buffer;
+        return 0;                                                     // RETURN
+    }
+
+    // The message is too large. Write it to a temporary file instead, and let
+    // the value enqueued be the path to the file along with the trailing
+    // "external file" byte.
+    bdlma::LocalSequentialAllocator<k_HANDLE_BUFFER_SIZE> pathAllocator(
+                                           buffer.get_allocator().mechanism());
+
+    bsl::string path(&pathAllocator);
+    if (writeToTempFile(message, &path)) {
+        return makeError(e_ENCODER_ERROR);                            // RETURN
+    }
+
+    buffer = path;
+    buffer += k_EXTENDED_EXTERNAL_FILE;
+    message = buffer;
+    return 0;
+}
+
+int FormatUtil::decodeExtended(bsl::string *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_EXTENDED);
+}
+
+int FormatUtil::decodeExtendedBuffer(MessageBuffer *originalAndOutput)
+{
+    BSLS_ASSERT(originalAndOutput);
+
+    BufferTail message(originalAndOutput);
+    return decodeMessage(&message, Format::e_EXTENDED);
+}
+
+int FormatUtil::decodeExtendedPayload(Payload *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_EXTENDED);
+}
+
+int FormatUtil::decodeExtendedBatch(
+                     MessageBuffer                                   *arena,
+                     bsl::vector<PosixQueueTypes::MessageDescriptor> *messages)
+{
+    FragmentReassembler *const noReassembler = 0;
+    return decodeBatch(arena, messages, Format::e_EXTENDED, noReassembler);
+}
+
+int FormatUtil::encodeSharedMemory(long               maxMessageSize,
+                                   bslstl::StringRef *originalAndOutput,
+                                   bsl::string       *messageBuffer)
+{
+    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(messageBuffer);
+
+    bslstl::StringRef& message = *originalAndOutput;
+    bsl::string&       buffer  = *messageBuffer;
+
+    if (long(message.length()) < maxMessageSize) {
+        return encodeExtended(
+            maxMessageSize, originalAndOutput, messageBuffer);        // RETURN
+    }
+
+    // The message is too large to fit in place. Copy it into shared memory,
+    // and let the value enqueued be the handle of the slot along with the
+    // trailing "shared memory" byte. The handle is built outside of 'buffer',
+    // since 'message' might refer into 'buffer'.
+    bdlma::LocalSequentialAllocator<k_HANDLE_BUFFER_SIZE> handleAllocator(
+                                           buffer.get_allocator().mechanism());
+
+    bsl::string handle(&handleAllocator);
+    if (SharedMemoryPool::defaultPool().write(&handle, message) == 0) {
+        if (long(handle.length()) < maxMessageSize) {
+            buffer = handle;
+            buffer += k_SHARED_MEMORY_SLOT;
+            message = buffer;
+            return 0;                                                 // RETURN
+        }
+
+        // The queue's messages are too small even for a handle. Release the
+        // slot without copying the payload back, since 'message' still
+        // refers to it.
+        SharedMemoryPool::defaultPool().release(handle);
+    }
+
+    // Fall back to a temporary file.
+    return encodeExtended(maxMessageSize, originalAndOutput, messageBuffer);
+}
+
+int FormatUtil::decodeSharedMemory(bsl::string *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_SHARED_MEMORY);
+}
+
+int FormatUtil::decodeSharedMemoryBuffer(MessageBuffer *originalAndOutput)
+{
+    BSLS_ASSERT(originalAndOutput);
+
+    BufferTail message(originalAndOutput);
+    return decodeMessage(&message, Format::e_SHARED_MEMORY);
+}
+
+int FormatUtil::decodeSharedMemoryPayload(Payload *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_SHARED_MEMORY);
+}
+
+int FormatUtil::decodeSharedMemoryBatch(
+                     MessageBuffer                                   *arena,
+                     bsl::vector<PosixQueueTypes::MessageDescriptor> *messages)
+{
+    FragmentReassembler *const noReassembler = 0;
+    return decodeBatch(
+        arena, messages, Format::e_SHARED_MEMORY, noReassembler);
+}
+
+int FormatUtil::encodeFragmented(long               maxMessageSize,
+                                 bslstl::StringRef *originalAndOutput,
+                                 bsl::string       *messageBuffer)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(messageBuffer);
+
+    if (long(originalAndOutput->length()) >= maxMessageSize) {
+        BALL_LOG_ERROR << "A payload of " << originalAndOutput->length()
+                       << " bytes does not fit in a message of at most "
+                       << maxMessageSize
+                       << " bytes, and so must be sent as fragments."
+                       << BALL_LOG_END;
+        return makeError(e_ENCODER_ERROR);                            // RETURN
+    }
+
+    return encodeExtended(maxMessageSize, originalAndOutput, messageBuffer);
+}
+
+bsl::size_t FormatUtil::maxFragmentLength(long maxMessageSize)
+{
+    if (maxMessageSize <= long(k_FRAGMENT_TRAILER_SIZE)) {
+        return 0;                                                     // RETURN
+    }
+
+    return maxMessageSize - k_FRAGMENT_TRAILER_SIZE;
+}
+
+bsls::Types::Uint64 FormatUtil::nextFragmentStreamId()
+{
+    const bsls::Types::Uint64 pid = static_cast<unsigned>(getpid());
+    return pid << 32 | s_nextFragmentStream.add(1);
+}
+
+void FormatUtil::encodeFragment(bsl::string              *messageBuffer,
+                                const bslstl::StringRef&  data,
+                                const FragmentHeader&     header)
+{
+    BSLS_ASSERT(messageBuffer);
+
+    bsl::string& buffer = *messageBuffer;
+    buffer.reserve(data.length() + k_FRAGMENT_TRAILER_SIZE);
+    buffer.assign(data.data(), data.length());
+    buffer.append(reinterpret_cast<const char *>(&header.d_streamId),
+                  sizeof header.d_streamId);
+    buffer.append(reinterpret_cast<const char *>(&header.d_totalLength),
+                  sizeof header.d_totalLength);
+    buffer.append(reinterpret_cast<const char *>(&header.d_index),
+                  sizeof header.d_index);
+    buffer.append(reinterpret_cast<const char *>(&header.d_count),
+                  sizeof header.d_count);
+    buffer += header.d_isEncoded ? k_ENCODED_FRAGMENT : k_FRAGMENT;
+}
+
+bool FormatUtil::isFragment(const bslstl::StringRef& message)
+{
+    return message.length() >= k_FRAGMENT_TRAILER_SIZE &&
+           (message[message.length() - 1] == k_FRAGMENT ||
+            message[message.length() - 1] == k_ENCODED_FRAGMENT);
+}
+
+bool FormatUtil::isExternal(const bslstl::StringRef& message)
+{
+    return !message.empty() &&
+           (message[message.length() - 1] == k_EXTENDED_EXTERNAL_FILE ||
+            message[message.length() - 1] == k_SHARED_MEMORY_SLOT);
+}
+
+int FormatUtil::decodeFragment(FragmentHeader           *header,
+                               bslstl::StringRef        *data,
+                               const bslstl::StringRef&  message)
+{
+    BSLS_ASSERT(header);
+    BSLS_ASSERT(data);
+
+    if (!isFragment(message)) {
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    const bsl::size_t length = message.length() - k_FRAGMENT_TRAILER_SIZE;
+    const char       *field  = message.data() + length;
+    bsl::memcpy(&header->d_streamId, field, sizeof header->d_streamId);
+    field += sizeof header->d_streamId;
+    bsl::memcpy(&header->d_totalLength, field, sizeof header->d_totalLength);
+    field += sizeof header->d_totalLength;
+    bsl::memcpy(&header->d_index, field, sizeof header->d_index);
+    field += sizeof header->d_index;
+    bsl::memcpy(&header->d_count, field, sizeof header->d_count);
+    header->d_isEncoded = message[message.length() - 1] == k_ENCODED_FRAGMENT;
+
+    *data = bslstl::StringRef(message.data(), length);
+    return 0;
+}
+
+int FormatUtil::decodeFragmented(bsl::string *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_FRAGMENTED);
+}
+
+int FormatUtil::decodeFragmentedBuffer(MessageBuffer *originalAndOutput)
+{
+    BSLS_ASSERT(originalAndOutput);
+
+    BufferTail message(originalAndOutput);
+    return decodeMessage(&message, Format::e_FRAGMENTED);
+}
+
+int FormatUtil::decodeFragmentedPayload(Payload *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_FRAGMENTED);
+}
+
+int FormatUtil::decodeFragmentedBatch(
+                     MessageBuffer                                   *arena,
+                     bsl::vector<PosixQueueTypes::MessageDescriptor> *messages)
+{
+    FragmentReassembler *const noReassembler = 0;
+    return decodeBatch(arena, messages, Format::e_FRAGMENTED, noReassembler);
+}
+
+int FormatUtil::reassemble(bool                *isComplete,
+                           bsl::string         *originalAndOutput,
+                           FragmentReassembler *reassembler,
+                           Decoder              decoder)
+{
+    BSLS_ASSERT(isComplete);
+    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(reassembler);
+    BSLS_ASSERT(decoder);
+
+    *isComplete = false;
+
+    FragmentHeader    header;
+    bslstl::StringRef data;
+    if (decodeFragment(&header, &data, *originalAndOutput)) {
+        if (const int rc = decoder(originalAndOutput)) {
+            return rc;                                                // RETURN
+        }
+
+        *isComplete = true;
+        return 0;                                                     // RETURN
+    }
+
+    MessageBuffer payload(originalAndOutput->get_allocator().mechanism());
+    if (reassembler->add(isComplete, &payload, header, data)) {
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    if (!*isComplete) {
+        return 0;                                                     // RETURN
+    }
+
+    originalAndOutput->assign(payload.data(), payload.length());
+
+    // The payload of an encoded fragment is itself a message.
+    return header.d_isEncoded ? decodeTagged(originalAndOutput) : 0;
+}
+
+int FormatUtil::reassemble(bool                *isComplete,
+                           MessageBuffer       *originalAndOutput,
+                           FragmentReassembler *reassembler,
+                           BufferDecoder        decoder)
+{
+    BSLS_ASSERT(isComplete);
+    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(reassembler);
+    BSLS_ASSERT(decoder);
+
+    *isComplete = false;
+
+    FragmentHeader    header;
+    bslstl::StringRef data;
+    if (decodeFragment(&header, &data, originalAndOutput->stringRef())) {
+        if (const int rc = decoder(originalAndOutput)) {
+            return rc;                                                // RETURN
+        }
+
+        *isComplete = true;
+        return 0;                                                     // RETURN
+    }
+
+    // The reassembler copies 'data' before it modifies 'originalAndOutput'.
+    if (reassembler->add(isComplete, originalAndOutput, header, data)) {
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    // The payload of an encoded fragment is itself a message.
+    return *isComplete && header.d_isEncoded
+               ? decodeTaggedBuffer(originalAndOutput)
+               : 0;
+}
+
+int FormatUtil::reassemble(bool                *isComplete,
+                           Payload             *originalAndOutput,
+                           FragmentReassembler *reassembler,
+                           PayloadDecoder       decoder)
+{
+    BSLS_ASSERT(isComplete);
+    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(reassembler);
+    BSLS_ASSERT(decoder);
+
+    if (isFragment(originalAndOutput->buffer().stringRef())) {
+        // The decoder is used only for messages that are not fragments.
+        return reassemble(isComplete,
+                          &originalAndOutput->buffer(),
+                          reassembler,
+                          &decodeTaggedBuffer);                       // RETURN
+    }
+
+    *isComplete = false;
+    if (const int rc = decoder(originalAndOutput)) {
+        return rc;                                                    // RETURN
+    }
+
+    *isComplete = true;
+    return 0;
+}
+
+int FormatUtil::reassembleBatch(
+                  MessageBuffer                                   *arena,
+                  bsl::vector<PosixQueueTypes::MessageDescriptor> *messages,
+                  Format                                           format,
+                  FragmentReassembler                             *reassembler)
+{
+    return decodeBatch(arena, messages, format, reassembler);
+}
+
+int FormatUtil::encodeCompressed(long               maxMessageSize,
+                                 bslstl::StringRef *originalAndOutput,
+                                 bsl::string       *messageBuffer)
+{
+    BSLS_ASSERT(originalAndOutput);
+    BSLS_ASSERT(messageBuffer);
+
+    bslstl::StringRef& message = *originalAndOutput;
+    bsl::string&       buffer  = *messageBuffer;
+
+    // Compress the payload only if the result is shorter than the payload in
+    // place would be, and fits in a message. Compression gives up as soon as
+    // it exceeds that, so a payload that does not compress costs little.
+    if (message.length() >= k_MIN_COMPRESSED_PAYLOAD_LENGTH &&
+        maxMessageSize > long(k_COMPRESSED_TRAILER_SIZE)) {
+        const bsl::size_t capacity =
+            bsl::min(message.length(), bsl::size_t(maxMessageSize)) -
+            k_COMPRESSED_TRAILER_SIZE;
+
+        if (ipcu::LzUtil::minCompressedLength(message.length()) <= capacity) {
+            // Compress outside of 'buffer', since 'message' might refer into
+            // 'buffer'.
+            bdlma::LocalSequentialAllocator<k_COMPRESSION_SCRATCH_SIZE>
+                compressedAllocator(buffer.get_allocator().mechanism());
+
+            bsl::string compressed(capacity + k_COMPRESSED_TRAILER_SIZE,
+                                   '\0',
+                                   &compressedAllocator);
+
+            const bsl::size_t compressedLength = ipcu::LzUtil::compress(
+                &compressed[0], capacity, message.data(), message.length());
+            if (compressedLength) {
+                const bsls::Types::Uint64 length = message.length();
+                compressed.resize(compressedLength);
+                compressed.append(reinterpret_cast<const char *>(&length),
+                                  sizeof length);
+                compressed += k_COMPRESSED;
+
+                buffer  = compressed;
+                message = buffer;
+                return 0;                                             // RETURN
+            }
+        }
+    }
+
+    // Send the payload uncompressed, in place or in a temporary file.
+    return encodeExtended(maxMessageSize, originalAndOutput, messageBuffer);
+}
+
+int FormatUtil::decodeCompressed(bsl::string *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_COMPRESSED);
+}
+
+int FormatUtil::decodeCompressedBuffer(MessageBuffer *originalAndOutput)
+{
+    BSLS_ASSERT(originalAndOutput);
+
+    BufferTail message(originalAndOutput);
+    return decodeMessage(&message, Format::e_COMPRESSED);
+}
+
+int FormatUtil::decodeCompressedPayload(Payload *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_COMPRESSED);
+}
+
+int FormatUtil::decodeCompressedBatch(
+                     MessageBuffer                                   *arena,
+                     bsl::vector<PosixQueueTypes::MessageDescriptor> *messages)
+{
+    FragmentReassembler *const noReassembler = 0;
+    return decodeBatch(arena, messages, Format::e_COMPRESSED, noReassembler);
+}
+
+int FormatUtil::encodeTagged(long               maxMessageSize,
+                             bslstl::StringRef *originalAndOutput,
+                             bsl::string       *messageBuffer)
+{
+    return encodeCompressed(maxMessageSize, originalAndOutput, messageBuffer);
+}
+
+int FormatUtil::decodeTagged(bsl::string *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_TAGGED);
+}
+
+int FormatUtil::decodeTaggedBuffer(MessageBuffer *originalAndOutput)
+{
+    BSLS_ASSERT(originalAndOutput);
+
+    BufferTail message(originalAndOutput);
+    return decodeMessage(&message, Format::e_TAGGED);
+}
+
+int FormatUtil::decodeTaggedPayload(Payload *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_TAGGED);
+}
+
+int FormatUtil::decodeTaggedBatch(
+                     MessageBuffer                                   *arena,
+                     bsl::vector<PosixQueueTypes::MessageDescriptor> *messages)
+{
+    FragmentReassembler *const noReassembler = 0;
+    return decodeBatch(arena, messages, Format::e_TAGGED, noReassembler);
+}
+
+int FormatUtil::encodePacked(long               maxMessageSize,
+                             bslstl::StringRef *originalAndOutput,
+                             bsl::string       *messageBuffer)
+{
+    return encodeExtended(maxMessageSize, originalAndOutput, messageBuffer);
+}
+
+bsl::size_t FormatUtil::packedLength(bsl::size_t payloadLength)
+{
+    return k_PACKED_PREFIX_SIZE + payloadLength;
+}
+
+bsl::size_t FormatUtil::maxPackedLength(long maxMessageSize)
+{
+    if (maxMessageSize <= 1) {
+        return 0;                                                     // RETURN
+    }
+
+    return maxMessageSize - 1;
+}
+
+void FormatUtil::pack(bsl::string             *messageBuffer,
+                      const bslstl::StringRef *begin,
+                      const bslstl::StringRef *end)
+{
+    BSLS_ASSERT(messageBuffer);
+    BSLS_ASSERT(begin < end);
+
+    bsl::size_t length = 1;
+    for (const bslstl::StringRef *payload = begin; payload != end; ++payload) {
+        length += packedLength(payload->length());
+    }
+
+    bsl::string& buffer = *messageBuffer;
+    buffer.clear();
+    buffer.reserve(length);
+    for (const bslstl::StringRef *payload = begin; payload != end; ++payload) {
+        const unsigned payloadLength = unsigned(payload->length());
+        buffer.append(reinterpret_cast<const char *>(&payloadLength),
+                      k_PACKED_PREFIX_SIZE);
+        buffer.append(payload->data(), payload->length());
+    }
+    buffer += k_PACKED;
+}
+
+bool FormatUtil::isPacked(const bslstl::StringRef& message)
+{
+    return !message.empty() && message[message.length() - 1] == k_PACKED;
+}
+
+int FormatUtil::unpack(bsl::vector<bslstl::StringRef> *payloads,
+                       const bslstl::StringRef&        message)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(payloads);
+
+    if (!isPacked(message)) {
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    const bsl::size_t numPayloads = payloads->size();
+    const char       *next        = message.data();
+    const char *const end         = message.data() + message.length() - 1;
+    while (next != end) {
+        const bsl::size_t remaining = end - next;
+        unsigned          length    = 0;
+        if (remaining >= k_PACKED_PREFIX_SIZE) {
+            bsl::memcpy(&length, next, k_PACKED_PREFIX_SIZE);
+        }
+
+        if (remaining < k_PACKED_PREFIX_SIZE ||
+            remaining - k_PACKED_PREFIX_SIZE < length) {
+            BALL_LOG_ERROR << "A packed message of " << message.length()
+                           << " bytes is truncated at offset "
+                           << next - message.data() << "." << BALL_LOG_END;
+            payloads->resize(numPayloads);
+            return makeError(e_DECODER_ERROR);                        // RETURN
+        }
+
+        next += k_PACKED_PREFIX_SIZE;
+        payloads->push_back(bslstl::StringRef(next, length));
+        next += length;
+    }
+
+    if (payloads->size() == numPayloads) {
+        BALL_LOG_ERROR << "A packed message holds no payloads."
+                       << BALL_LOG_END;
+        return makeError(e_DECODER_ERROR);                            // RETURN
+    }
+
+    return 0;
+}
+
+int FormatUtil::decodePacked(bsl::string *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_PACKED);
+}
+
+int FormatUtil::decodePackedBuffer(MessageBuffer *originalAndOutput)
+{
+    BSLS_ASSERT(originalAndOutput);
+
+    BufferTail message(originalAndOutput);
+    return decodeMessage(&message, Format::e_PACKED);
+}
+
+int FormatUtil::decodePackedPayload(Payload *originalAndOutput)
+{
+    return decodeMessage(originalAndOutput, Format::e_PACKED);
+}
+
+int FormatUtil::decodePackedBatch(
+                     MessageBuffer                                   *arena,
+                     bsl::vector<PosixQueueTypes::MessageDescriptor> *messages)
+{
+    BSLS_ASSERT(arena);
+    BSLS_ASSERT(messages);
+
+    typedef PosixQueueTypes::MessageDescriptor Descriptor;
+
+    FragmentReassembler *const noReassembler = 0;
+
+    bsl::vector<Descriptor>::const_iterator message = messages->begin();
+    while (message != messages->end() &&
+           !isPacked(arena->stringRef(message->d_offset, message->d_length))) {
+        ++message;
+    }
+    if (message == messages->end()) {
+        // Nothing to unpack.
+        return decodeBatch(
+            arena, messages, Format::e_PACKED, noReassembler);        // RETURN
+    }
+
+    // The payloads of a packed message stay where they are in the arena, and
+    // each gets its own descriptor. Runs of other messages are decoded as the
+    // extended format's batch decoder would, which may append to the arena,
+    // so each packed message is located only after the run before it.
+    bsl::vector<Descriptor>        decoded(arena->allocator());
+    bsl::vector<Descriptor>        run(arena->allocator());
+    bsl::vector<bslstl::StringRef> payloads(arena->allocator());
+    bool                           failed = false;
+
+    decoded.reserve(messages->size());
+    for (message = messages->begin(); message != messages->end(); ++message) {
+        if (!isPacked(
+                arena->stringRef(message->d_offset, message->d_length))) {
+            run.push_back(*message);
+            continue;
+        }
+
+        if (!run.empty()) {
+            if (decodeBatch(arena, &run, Format::e_PACKED, noReassembler)) {
+                failed = true;
+            }
+            decoded.insert(decoded.end(), run.begin(), run.end());
+            run.clear();
+        }
+
+        payloads.clear();
+        if (unpack(&payloads,
+                   arena->stringRef(message->d_offset, message->d_length))) {
+            failed = true;
+            continue;
+        }
+
+        for (bsl::size_t i = 0; i < payloads.size(); ++i) {
+            Descriptor payload;
+            payload.d_offset   = payloads[i].data() - arena->data();
+            payload.d_length   = payloads[i].length();
+            payload.d_priority = message->d_priority;
+            decoded.push_back(payload);
+        }
+    }
+
+    if (!run.empty()) {
+        if (decodeBatch(arena, &run, Format::e_PACKED, noReassembler)) {
+            failed = true;
+        }
+        decoded.insert(decoded.end(), run.begin(), run.end());
     }
 
-    BALL_LOG_ERROR
-        << "The final byte of message is 0x" << bsl::hex << int(lastByte)
-        << ", which is not one of the accepted values for the extended codec."
-        << BALL_LOG_END;
-    return makeError(e_DECODER_ERROR);
+    messages->assign(decoded.begin(), decoded.end());
+    return failed ? makeError(e_DECODER_ERROR) : 0;
 }
 
 const char *FormatUtil::description(int errorCode)
@@ -1,30 +1,57 @@
 #ifndef INCLUDED_IPCMQ_FORMATUTIL
 #define INCLUDED_IPCMQ_FORMATUTIL
 
+#include <ipcmq_codecregistry.h>
 #include <ipcmq_format.h>
+#include <ipcmq_fragmentreassembler.h>
+#include <ipcmq_posixqueue.h>
 
+#include <bsl_cstddef.h>
 #include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bsls_types.h>
 
 namespace BloombergLP {
 namespace ipcmq {
 
+class MessageBuffer;
+class Payload;
+
 struct FormatUtil {
     // This class is a namespace for a set of functions and types used to
     // encode and decode message queue messages according to various supported
     // protocols (formats).
 
     // TYPES
-    typedef int (*Encoder)(long               maxMessageSize,
-                           bslstl::StringRef *originalAndOutput,
-                           bsl::string       *messageBuffer);
-
-    typedef int (*Decoder)(bsl::string *originalAndOutput);
+    typedef Codec::Encoder        Encoder;
+    typedef Codec::Decoder        Decoder;
+    typedef Codec::BufferDecoder  BufferDecoder;
+    typedef Codec::PayloadDecoder PayloadDecoder;
+    typedef Codec::BatchDecoder   BatchDecoder;
 
     // CLASS METHODS
+    static const Codec& formatCodec(Format format);
+        // Return a reference to the codec of the specified 'format'.
+
+    static const Codec *tagCodec(unsigned char tag);
+        // Return the address of the codec that decodes messages ending with
+        // the specified 'tag', or zero if there is none. Tags below
+        // 'CodecRegistry::k_MIN_APPLICATION_TAG' are those of the codecs of
+        // this package, and the rest are looked up in
+        // 'CodecRegistry::defaultRegistry()'. Note that fragments have no
+        // codec, since they must be reassembled.
+
     static Encoder encoder(Format format);
 
     static Decoder decoder(Format format);
 
+    static BufferDecoder bufferDecoder(Format format);
+
+    static PayloadDecoder payloadDecoder(Format format);
+
+    static BatchDecoder batchDecoder(Format format);
+
     static int encodeRaw(long               maxMessageSize,
                          bslstl::StringRef *originalAndOutput,
                          bsl::string       *messageBuffer);
@@ -33,6 +60,17 @@ struct FormatUtil {
     static int decodeRaw(bsl::string *originalAndOutput);
         // Do nothing. Return zero, which indicates success.
 
+    static int decodeRawBuffer(MessageBuffer *originalAndOutput);
+        // Do nothing. Return zero, which indicates success.
+
+    static int decodeRawPayload(Payload *originalAndOutput);
+        // Do nothing. Return zero, which indicates success.
+
+    static int decodeRawBatch(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+        // Do nothing. Return zero, which indicates success.
+
     static int encodeExtended(long               maxMessageSize,
                               bslstl::StringRef *originalAndOutput,
                               bsl::string       *messageBuffer);
@@ -60,6 +98,333 @@ struct FormatUtil {
         // indicates neither of the above, return a nonzero value, which
         // indicates failure.
 
+    static int decodeExtendedBuffer(MessageBuffer *originalAndOutput);
+        // Decode in place the message that is the contents of the specified
+        // 'originalAndOutput', as 'decodeExtended' would. If the message's
+        // payload is in place, shrink 'originalAndOutput' by one byte. If the
+        // payload is in an external file, replace the contents of
+        // 'originalAndOutput' with the contents of the file and delete the
+        // file. Return zero on success or a nonzero value otherwise. Note
+        // that no more than the bytes of the payload are written to
+        // 'originalAndOutput'.
+
+    static int decodeExtendedPayload(Payload *originalAndOutput);
+        // Decode in place the message that is the contents of the buffer of
+        // the specified 'originalAndOutput', as 'decodeExtendedBuffer' would,
+        // except that a payload in an external file is mapped into memory by
+        // 'originalAndOutput' rather than copied. Return zero on success or a
+        // nonzero value otherwise.
+
+    static int decodeExtendedBatch(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+        // Decode in place each message within the specified 'arena' that is
+        // described by an element of the specified 'messages', as
+        // 'decodeExtended' would. If a message's payload is in place, shrink
+        // its descriptor by one byte. If a message's payload is in an external
+        // file, append the file's contents to 'arena', delete the file, and
+        // modify the message's descriptor to refer to the appended contents.
+        // Remove from 'messages' each message that cannot be decoded, logging
+        // a diagnostic. Return zero if every message was decoded or a nonzero
+        // value otherwise.
+
+    static int encodeSharedMemory(long               maxMessageSize,
+                                  bslstl::StringRef *originalAndOutput,
+                                  bsl::string       *messageBuffer);
+        // If the specified 'originalAndOutput' is small enough to fit in place
+        // within a message, then encode it as 'encodeExtended' would.
+        // Otherwise, copy 'originalAndOutput' into a slot of
+        // 'SharedMemoryPool::defaultPool()', assign to the specified
+        // 'messageBuffer' the handle of the slot followed by a byte indicating
+        // that the message is in shared memory, and modify
+        // 'originalAndOutput' to refer to 'messageBuffer'. If
+        // 'originalAndOutput' cannot be copied into shared memory, then
+        // encode it as 'encodeExtended' would, in a temporary file. Return
+        // zero on success or a nonzero value otherwise.
+
+    static int decodeSharedMemory(bsl::string *originalAndOutput);
+        // If the last byte of the specified 'originalAndOutput' indicates
+        // that the message is in shared memory, replace 'originalAndOutput'
+        // with the contents of the shared memory slot whose handle is
+        // 'originalAndOutput' (except for the last byte), releasing the slot.
+        // Otherwise, decode 'originalAndOutput' as 'decodeExtended' would.
+        // Return zero on success or a nonzero value otherwise.
+
+    static int decodeSharedMemoryBuffer(MessageBuffer *originalAndOutput);
+        // Decode in place the message that is the contents of the specified
+        // 'originalAndOutput', as 'decodeSharedMemory' would. Return zero on
+        // success or a nonzero value otherwise.
+
+    static int decodeSharedMemoryPayload(Payload *originalAndOutput);
+        // Decode in place the message that is the contents of the buffer of
+        // the specified 'originalAndOutput', as 'decodeSharedMemoryBuffer'
+        // would, except that a payload in an external file is mapped into
+        // memory by 'originalAndOutput' rather than copied. Return zero on
+        // success or a nonzero value otherwise.
+
+    static int decodeSharedMemoryBatch(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+        // Decode in place each message within the specified 'arena' that is
+        // described by an element of the specified 'messages', as
+        // 'decodeSharedMemory' would, and as 'decodeExtendedBatch' describes.
+        // The contents of a shared memory slot are appended to 'arena'.
+        // Remove from 'messages' each message that cannot be decoded, logging
+        // a diagnostic. Return zero if every message was decoded or a nonzero
+        // value otherwise.
+
+    static int encodeFragmented(long               maxMessageSize,
+                                bslstl::StringRef *originalAndOutput,
+                                bsl::string       *messageBuffer);
+        // If the specified 'originalAndOutput' is small enough to fit in place
+        // within a message, then encode it as 'encodeExtended' would and
+        // return zero. Otherwise, return a nonzero value. Note that a payload
+        // too large to fit in place must instead be split into fragments
+        // using 'maxFragmentLength' and 'encodeFragment', as 'QueueSender'
+        // does.
+
+    static bsl::size_t maxFragmentLength(long maxMessageSize);
+        // Return the maximum number of bytes of a payload that fit in one
+        // fragment encoded within a message no longer than the specified
+        // 'maxMessageSize', or return zero if no bytes fit.
+
+    static bsls::Types::Uint64 nextFragmentStreamId();
+        // Return a stream ID that differs from every other stream ID returned
+        // by this function in any process currently running on this host.
+
+    static void encodeFragment(bsl::string              *messageBuffer,
+                               const bslstl::StringRef&  data,
+                               const FragmentHeader&     header);
+        // Assign to the specified 'messageBuffer' the specified 'data'
+        // followed by the specified 'header' and a byte indicating that the
+        // message is a fragment, and whether the fragmented payload is itself
+        // an encoded message. The behavior is undefined unless 'data' does
+        // not refer to memory within 'messageBuffer'.
+
+    static bool isFragment(const bslstl::StringRef& message);
+        // Return whether the specified 'message' is a fragment encoded by
+        // 'encodeFragment'.
+
+    static bool isExternal(const bslstl::StringRef& message);
+        // Return whether the specified 'message', which is encoded in any
+        // format other than 'Format::e_RAW', refers to a payload stored
+        // outside of the queue, in a file or in shared memory.
+
+    static int decodeFragment(FragmentHeader           *header,
+                              bslstl::StringRef        *data,
+                              const bslstl::StringRef&  message);
+        // Load into the specified 'header' and the specified 'data' the
+        // header and the payload bytes of the fragment that is the specified
+        // 'message'. Return zero on success or a nonzero value if 'message' is
+        // not a fragment.
+
+    static int decodeFragmented(bsl::string *originalAndOutput);
+        // If the last byte of the specified 'originalAndOutput' indicates
+        // that the message is in place, shrink 'originalAndOutput' by one byte
+        // and return zero. Otherwise, return a nonzero value. Note that
+        // fragments must instead be decoded using 'reassemble'.
+
+    static int decodeFragmentedBuffer(MessageBuffer *originalAndOutput);
+        // Decode in place the message that is the contents of the specified
+        // 'originalAndOutput', as 'decodeFragmented' would.
+
+    static int decodeFragmentedPayload(Payload *originalAndOutput);
+        // Decode in place the message that is the contents of the buffer of
+        // the specified 'originalAndOutput', as 'decodeFragmented' would.
+
+    static int decodeFragmentedBatch(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+        // Decode in place each message within the specified 'arena' that is
+        // described by an element of the specified 'messages', as
+        // 'decodeFragmented' would. Remove from 'messages' each message that
+        // cannot be decoded, including fragments, logging a diagnostic. Return
+        // zero if every message was decoded or a nonzero value otherwise.
+
+    static int reassemble(bool                *isComplete,
+                          bsl::string         *originalAndOutput,
+                          FragmentReassembler *reassembler,
+                          Decoder              decoder);
+    static int reassemble(bool                *isComplete,
+                          MessageBuffer       *originalAndOutput,
+                          FragmentReassembler *reassembler,
+                          BufferDecoder        decoder);
+    static int reassemble(bool                *isComplete,
+                          Payload             *originalAndOutput,
+                          FragmentReassembler *reassembler,
+                          PayloadDecoder       decoder);
+        // If the specified 'originalAndOutput' is a fragment, add it to the
+        // specified 'reassembler' and, if that completes its payload, replace
+        // 'originalAndOutput' with the payload, first decoding the payload as
+        // 'decodeTagged' would if the fragments are of an encoded message.
+        // Otherwise, decode 'originalAndOutput' in place using the specified
+        // 'decoder'. Assign through the specified 'isComplete' whether
+        // 'originalAndOutput' is now a whole payload. Return zero on success
+        // or a nonzero value otherwise.
+
+    static int reassembleBatch(
+                 MessageBuffer                                   *arena,
+                 bsl::vector<PosixQueueTypes::MessageDescriptor> *messages,
+                 Format                                           format,
+                 FragmentReassembler                             *reassembler);
+        // Decode in place each message within the specified 'arena' that is
+        // described by an element of the specified 'messages', as the batch
+        // decoder of the specified 'format' would, except that fragments are
+        // added to the specified 'reassembler', as 'reassemble' describes.
+        // Append to 'arena' each payload completed by a fragment, and modify
+        // the fragment's descriptor to refer to it. Remove from 'messages'
+        // each fragment that does not complete a payload, and each message
+        // that cannot be decoded, logging a diagnostic for the latter. If
+        // 'reassembler' is zero, every fragment is a message that cannot be
+        // decoded. Return zero if every message was decoded or a nonzero
+        // value otherwise.
+
+    static int encodeCompressed(long               maxMessageSize,
+                                bslstl::StringRef *originalAndOutput,
+                                bsl::string       *messageBuffer);
+        // If the specified 'originalAndOutput' compresses into fewer bytes
+        // than it would occupy in place, and into few enough to fit within a
+        // message, then assign to the specified 'messageBuffer' the compressed
+        // bytes followed by the length of 'originalAndOutput' and a byte
+        // indicating that the message is compressed, and modify
+        // 'originalAndOutput' to refer to 'messageBuffer'. Otherwise, encode
+        // 'originalAndOutput' uncompressed as 'encodeExtended' would. Return
+        // zero on success or a nonzero value otherwise. Note that payloads
+        // shorter than 64 bytes are not compressed.
+
+    static int decodeCompressed(bsl::string *originalAndOutput);
+        // If the last byte of the specified 'originalAndOutput' indicates
+        // that the message is compressed, replace 'originalAndOutput' with
+        // the decompressed payload. Otherwise, decode 'originalAndOutput' as
+        // 'decodeExtended' would. Return zero on success or a nonzero value
+        // otherwise.
+
+    static int decodeCompressedBuffer(MessageBuffer *originalAndOutput);
+        // Decode in place the message that is the contents of the specified
+        // 'originalAndOutput', as 'decodeCompressed' would. Return zero on
+        // success or a nonzero value otherwise.
+
+    static int decodeCompressedPayload(Payload *originalAndOutput);
+        // Decode in place the message that is the contents of the buffer of
+        // the specified 'originalAndOutput', as 'decodeCompressedBuffer'
+        // would, except that a payload in an external file is mapped into
+        // memory by 'originalAndOutput' rather than copied. Return zero on
+        // success or a nonzero value otherwise.
+
+    static int decodeCompressedBatch(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+        // Decode in place each message within the specified 'arena' that is
+        // described by an element of the specified 'messages', as
+        // 'decodeCompressed' would, and as 'decodeExtendedBatch' describes.
+        // The decompressed payload of a compressed message is appended to
+        // 'arena'. Remove from 'messages' each message that cannot be
+        // decoded, logging a diagnostic. Return zero if every message was
+        // decoded or a nonzero value otherwise.
+
+    static int encodeTagged(long               maxMessageSize,
+                            bslstl::StringRef *originalAndOutput,
+                            bsl::string       *messageBuffer);
+        // Encode the specified 'originalAndOutput' as 'encodeCompressed'
+        // would. Return zero on success or a nonzero value otherwise. Note
+        // that 'QueueSender' encodes the 'Format::e_TAGGED' format
+        // differently: it encodes without regard to 'maxMessageSize', using
+        // any codec, and sends the result as fragments if it does not fit.
+
+    static int decodeTagged(bsl::string *originalAndOutput);
+        // Decode in place the specified 'originalAndOutput' using the decoder
+        // of the codec that 'tagCodec' returns for its last byte. Return zero
+        // on success or a nonzero value if there is no such codec or it fails.
+
+    static int decodeTaggedBuffer(MessageBuffer *originalAndOutput);
+        // Decode in place the message that is the contents of the specified
+        // 'originalAndOutput', as 'decodeTagged' would. Return zero on success
+        // or a nonzero value otherwise.
+
+    static int decodeTaggedPayload(Payload *originalAndOutput);
+        // Decode in place the message that is the contents of the buffer of
+        // the specified 'originalAndOutput', as 'decodeTagged' would, using
+        // the payload decoder of the codec if it has one. Return zero on
+        // success or a nonzero value otherwise.
+
+    static int decodeTaggedBatch(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+        // Decode in place each message within the specified 'arena' that is
+        // described by an element of the specified 'messages', as
+        // 'decodeTagged' would, and as 'decodeExtendedBatch' describes. Remove
+        // from 'messages' each message that cannot be decoded, including
+        // fragments, logging a diagnostic. Return zero if every message was
+        // decoded or a nonzero value otherwise.
+
+    static int encodePacked(long               maxMessageSize,
+                            bslstl::StringRef *originalAndOutput,
+                            bsl::string       *messageBuffer);
+        // Encode the specified 'originalAndOutput' by itself, as
+        // 'encodeExtended' would. Return zero on success or a nonzero value
+        // otherwise. Note that 'QueueSender' packs the payloads of a batch
+        // that fit together into one message using 'pack'.
+
+    static bsl::size_t packedLength(bsl::size_t payloadLength);
+        // Return the number of bytes that a payload of the specified
+        // 'payloadLength' occupies within a packed message.
+
+    static bsl::size_t maxPackedLength(long maxMessageSize);
+        // Return the maximum sum of the 'packedLength' of the payloads packed
+        // into one message no longer than the specified 'maxMessageSize'.
+
+    static void pack(bsl::string             *messageBuffer,
+                     const bslstl::StringRef *begin,
+                     const bslstl::StringRef *end);
+        // Assign to the specified 'messageBuffer' a packed message holding
+        // each payload in the specified range '[begin, end)', in order: each
+        // payload preceded by its length, followed by a byte indicating that
+        // the message is packed. The behavior is undefined unless
+        // 'begin < end', and no payload refers to memory within
+        // 'messageBuffer'.
+
+    static bool isPacked(const bslstl::StringRef& message);
+        // Return whether the specified 'message' was encoded by 'pack'.
+
+    static int unpack(bsl::vector<bslstl::StringRef> *payloads,
+                      const bslstl::StringRef&        message);
+        // Append to the specified 'payloads' a reference to each payload
+        // within the specified packed 'message', in order. Return zero on
+        // success, or a nonzero value, leaving 'payloads' unmodified, if
+        // 'message' is not a packed message of at least one payload.
+
+    static int decodePacked(bsl::string *originalAndOutput);
+        // If the last byte of the specified 'originalAndOutput' indicates that
+        // the message is packed, replace 'originalAndOutput' with its payload.
+        // Otherwise, decode 'originalAndOutput' as 'decodeExtended' would.
+        // Return zero on success or a nonzero value otherwise. Note that a
+        // packed message of more than one payload cannot be decoded in place,
+        // and must instead be unpacked using 'unpack', as 'QueueReceiver'
+        // does.
+
+    static int decodePackedBuffer(MessageBuffer *originalAndOutput);
+        // Decode in place the message that is the contents of the specified
+        // 'originalAndOutput', as 'decodePacked' would. Return zero on success
+        // or a nonzero value otherwise.
+
+    static int decodePackedPayload(Payload *originalAndOutput);
+        // Decode in place the message that is the contents of the buffer of
+        // the specified 'originalAndOutput', as 'decodePackedBuffer' would,
+        // except that a payload in an external file is mapped into memory by
+        // 'originalAndOutput' rather than copied. Return zero on success or a
+        // nonzero value otherwise.
+
+    static int decodePackedBatch(
+                    MessageBuffer                                   *arena,
+                    bsl::vector<PosixQueueTypes::MessageDescriptor> *messages);
+        // Decode in place each message within the specified 'arena' that is
+        // described by an element of the specified 'messages', replacing the
+        // descriptor of each packed message with a descriptor of each of its
+        // payloads, which stay where they are, and decoding the other messages
+        // as 'decodeExtendedBatch' would. Remove from 'messages' each message
+        // that cannot be decoded, logging a diagnostic. Return zero if every
+        // message was decoded or a nonzero value otherwise.
+
     static const char *description(int errorCode);
         // Return a description of the specified 'errorCode'. The behavior is
         // undefined unless 'errorCode' has the same value as the result of
@@ -0,0 +1,263 @@
+
+#include <ipcmq_fragmentreassembler.h>
+#include <ipcmq_messagebuffer.h>
+
+#include <ball_log.h>
+
+#include <bslma_default.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsl_cstring.h>
+#include <bsl_vector.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.FRAGMENTREASSEMBLER";
+
+bool isConsistent(const FragmentHeader& header)
+    // Return whether the specified 'header' describes a fragment that a
+    // sender could have produced: one of the fewest fragments of
+    // 'chunkSize()' bytes that hold the payload, so that none is empty.
+    // Note that this bounds the count of fragments by the payload length.
+{
+    if (header.d_count == 0 || header.d_totalLength == 0 ||
+        header.d_index >= header.d_count) {
+        return false;                                                 // RETURN
+    }
+
+    const bsls::Types::Uint64 chunk = header.chunkSize();
+    return (header.d_totalLength - 1) / chunk + 1 == header.d_count;
+}
+
+bsl::size_t footprint(const FragmentHeader& header)
+    // Return the number of bytes that an incomplete payload having the
+    // specified 'header' occupies: the payload itself, and one bit for each
+    // fragment to record whether it was received.
+{
+    return header.d_totalLength + (header.d_count + 7) / 8;
+}
+
+}  // close unnamed namespace
+
+                     // ==================================
+                     // struct FragmentReassembler::Stream
+                     // ==================================
+
+struct FragmentReassembler::Stream {
+    // This 'struct' is a payload of which some but not all fragments have
+    // been added.
+
+    // DATA
+    MessageBuffer       d_buffer;  // has capacity for the whole payload
+    bsl::vector<bool>   d_received;
+    unsigned            d_numReceived;
+    bsls::Types::Uint64 d_totalLength;
+    bsl::size_t         d_footprint;  // counted against the pending bytes
+    bsls::Types::Uint64 d_sequence;   // for discarding the oldest first
+
+    // CREATORS
+    Stream(const FragmentHeader&  header,
+           bsls::Types::Uint64    sequence,
+           bslma::Allocator      *allocator)
+    : d_buffer(allocator)
+    , d_received(header.d_count, false, allocator)
+    , d_numReceived(0)
+    , d_totalLength(header.d_totalLength)
+    , d_footprint(footprint(header))
+    , d_sequence(sequence)
+    {
+        d_buffer.reserve(header.d_totalLength);
+    }
+};
+
+                         // -------------------------
+                         // class FragmentReassembler
+                         // -------------------------
+
+// CREATORS
+FragmentReassembler::FragmentReassembler(bslma::Allocator *allocator)
+: d_streams(allocator)
+, d_pendingBytes(0)
+, d_maxPendingBytes(k_DEFAULT_MAX_PENDING_BYTES)
+, d_maxPendingStreams(k_DEFAULT_MAX_PENDING_STREAMS)
+, d_nextSequence(0)
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+}
+
+FragmentReassembler::FragmentReassembler(bsl::size_t       maxPendingBytes,
+                                         bsl::size_t       maxPendingStreams,
+                                         bslma::Allocator *allocator)
+: d_streams(allocator)
+, d_pendingBytes(0)
+, d_maxPendingBytes(maxPendingBytes)
+, d_maxPendingStreams(maxPendingStreams)
+, d_nextSequence(0)
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    BSLS_ASSERT(maxPendingStreams > 0);
+}
+
+// MANIPULATORS
+int FragmentReassembler::add(bool                     *isComplete,
+                             MessageBuffer            *payload,
+                             const FragmentHeader&     header,
+                             const bslstl::StringRef&  data)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(isComplete);
+    BSLS_ASSERT(payload);
+
+    *isComplete = false;
+
+    // The header is checked before anything is allocated for its stream,
+    // since a corrupt count would otherwise size the record of fragments
+    // received.
+    if (!isConsistent(header) || data.length() != header.length()) {
+        BALL_LOG_ERROR << "Invalid fragment " << header.d_index << '/'
+                       << header.d_count << " of stream " << header.d_streamId
+                       << " having " << data.length() << " of "
+                       << header.d_totalLength << " bytes." << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    StreamMap::iterator found = d_streams.find(header.d_streamId);
+    if (found == d_streams.end()) {
+        const bsl::size_t bytes = footprint(header);
+        if (bytes > d_maxPendingBytes) {
+            BALL_LOG_ERROR << "Dropping fragment of stream "
+                           << header.d_streamId << ", whose payload of "
+                           << header.d_totalLength
+                           << " bytes exceeds the limit of "
+                           << d_maxPendingBytes << " pending bytes."
+                           << BALL_LOG_END;
+            return 2;                                                 // RETURN
+        }
+
+        evict(1, bytes);
+
+        found = d_streams
+                    .insert(bsl::make_pair(
+                        header.d_streamId,
+                        bsl::allocate_shared<Stream>(d_allocator_p,
+                                                     header,
+                                                     d_nextSequence++,
+                                                     d_allocator_p)))
+                    .first;
+        d_pendingBytes += bytes;
+    }
+
+    Stream& stream = *found->second;
+    if (stream.d_totalLength != header.d_totalLength ||
+        stream.d_received.size() != header.d_count) {
+        BALL_LOG_ERROR << "Fragment " << header.d_index << '/'
+                       << header.d_count << " of stream " << header.d_streamId
+                       << " having " << header.d_totalLength
+                       << " total bytes is inconsistent with earlier "
+                          "fragments."
+                       << BALL_LOG_END;
+        return 3;                                                     // RETURN
+    }
+
+    if (stream.d_received[header.d_index]) {
+        BALL_LOG_ERROR << "Duplicate fragment " << header.d_index << '/'
+                       << header.d_count << " of stream " << header.d_streamId
+                       << BALL_LOG_END;
+        return 4;                                                     // RETURN
+    }
+
+    bsl::memcpy(stream.d_buffer.data() + header.offset(),
+                data.data(),
+                data.length());
+    stream.d_received[header.d_index] = true;
+    if (++stream.d_numReceived < header.d_count) {
+        return 0;                                                     // RETURN
+    }
+
+    // That was the last fragment. Hand over the buffer if possible, and copy
+    // it otherwise.
+    stream.d_buffer.setLength(stream.d_totalLength);
+    if (payload->allocator() == stream.d_buffer.allocator()) {
+        payload->swap(stream.d_buffer);
+    }
+    else {
+        payload->clear();
+        payload->reserve(stream.d_buffer.length());
+        bsl::memcpy(payload->data(),
+                    stream.d_buffer.data(),
+                    stream.d_buffer.length());
+        payload->setLength(stream.d_buffer.length());
+    }
+
+    d_pendingBytes -= stream.d_footprint;
+    d_streams.erase(found);
+
+    *isComplete = true;
+    return 0;
+}
+
+void FragmentReassembler::setLimits(bsl::size_t maxPendingBytes,
+                                    bsl::size_t maxPendingStreams)
+{
+    BSLS_ASSERT(maxPendingStreams > 0);
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    d_maxPendingBytes   = maxPendingBytes;
+    d_maxPendingStreams = maxPendingStreams;
+
+    evict(0, 0);
+}
+
+void FragmentReassembler::evict(bsl::size_t incomingStreams,
+                                bsl::size_t incomingBytes)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    while (!d_streams.empty() &&
+           (d_streams.size() + incomingStreams > d_maxPendingStreams ||
+            d_pendingBytes + incomingBytes > d_maxPendingBytes)) {
+        StreamMap::iterator oldest = d_streams.begin();
+        for (StreamMap::iterator it = d_streams.begin();
+             it != d_streams.end();
+             ++it) {
+            if (it->second->d_sequence < oldest->second->d_sequence) {
+                oldest = it;
+            }
+        }
+
+        BALL_LOG_WARN << "Discarding incomplete stream " << oldest->first
+                      << " having " << oldest->second->d_numReceived << " of "
+                      << oldest->second->d_received.size()
+                      << " fragments, to make room for newer streams."
+                      << BALL_LOG_END;
+
+        d_pendingBytes -= oldest->second->d_footprint;
+        d_streams.erase(oldest);
+    }
+}
+
+// ACCESSORS
+bsl::size_t FragmentReassembler::numPendingStreams() const
+{
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    return d_streams.size();
+}
+
+bsl::size_t FragmentReassembler::numPendingBytes() const
+{
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    return d_pendingBytes;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
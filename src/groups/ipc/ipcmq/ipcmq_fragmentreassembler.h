@@ -0,0 +1,182 @@
+#ifndef INCLUDED_IPCMQ_FRAGMENTREASSEMBLER
+#define INCLUDED_IPCMQ_FRAGMENTREASSEMBLER
+
+#include <bsl_cstddef.h>
+#include <bsl_memory.h>
+#include <bsl_string.h>
+#include <bsl_unordered_map.h>
+
+#include <bslmt_mutex.h>
+
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+class MessageBuffer;
+
+                           // =====================
+                           // struct FragmentHeader
+                           // =====================
+
+struct FragmentHeader {
+    // This 'struct' describes one fragment of a payload that was too large to
+    // send in one message, and so was sent as a sequence of messages
+    // ("fragments"). The fragments of a payload share a stream ID that is
+    // unique among the payloads in flight on a queue, and each fragment other
+    // than the last holds the same number of bytes of the payload, namely
+    // 'chunkSize()'. The payload may itself be an encoded message, which is
+    // decoded once reassembled.
+
+    // DATA
+    bsls::Types::Uint64 d_streamId;
+    bsls::Types::Uint64 d_totalLength;  // length of the whole payload
+    unsigned            d_index;        // of this fragment, from zero
+    unsigned            d_count;        // of fragments in the payload
+    bool                d_isEncoded;    // whether the payload is a message
+
+    // ACCESSORS
+    bsl::size_t chunkSize() const;
+        // Return the number of bytes of the payload in each fragment except
+        // possibly the last, which may have fewer. The behavior is undefined
+        // unless '0 < d_count'.
+
+    bsl::size_t offset() const;
+        // Return the offset within the payload of the first byte of this
+        // fragment.
+
+    bsl::size_t length() const;
+        // Return the number of bytes of the payload in this fragment. The
+        // behavior is undefined unless 'd_index < d_count'.
+};
+
+                         // =========================
+                         // class FragmentReassembler
+                         // =========================
+
+class FragmentReassembler {
+    // This class reassembles payloads from their fragments. Fragments of any
+    // number of payloads may be added in any order, interleaved with one
+    // another, so that several senders can share one queue and several
+    // threads can share one reassembler. The memory used by incomplete
+    // payloads is bounded: when a new payload would exceed either the maximum
+    // number of incomplete payloads or the maximum number of bytes they may
+    // occupy, the least recently started incomplete payloads are discarded
+    // to make room. This class is thread-safe.
+
+  public:
+    // PUBLIC CONSTANTS
+    static const bsl::size_t k_DEFAULT_MAX_PENDING_BYTES = 256 * 1024 * 1024;
+    static const bsl::size_t k_DEFAULT_MAX_PENDING_STREAMS = 64;
+
+  private:
+    // PRIVATE TYPES
+    struct Stream;
+
+    typedef bsl::unordered_map<bsls::Types::Uint64, bsl::shared_ptr<Stream> >
+        StreamMap;  // keyed by stream ID
+
+    // DATA
+    mutable bslmt::Mutex  d_mutex;  // protects all below
+    StreamMap             d_streams;
+    bsl::size_t           d_pendingBytes;
+    bsl::size_t           d_maxPendingBytes;
+    bsl::size_t           d_maxPendingStreams;
+    bsls::Types::Uint64   d_nextSequence;
+    bslma::Allocator     *d_allocator_p;
+
+    FragmentReassembler(const FragmentReassembler&);             // = delete
+    FragmentReassembler& operator=(const FragmentReassembler&);  // = delete
+
+  public:
+    // CREATORS
+    explicit FragmentReassembler(bslma::Allocator *allocator = 0);
+    FragmentReassembler(bsl::size_t       maxPendingBytes,
+                        bsl::size_t       maxPendingStreams,
+                        bslma::Allocator *allocator = 0);
+        // Create a 'FragmentReassembler' having no incomplete payloads.
+        // Optionally specify the 'maxPendingBytes' that incomplete payloads
+        // may occupy and the 'maxPendingStreams' that may be incomplete at
+        // once. If they are not specified, 'k_DEFAULT_MAX_PENDING_BYTES' and
+        // 'k_DEFAULT_MAX_PENDING_STREAMS' are used. Optionally specify an
+        // 'allocator' used to supply memory. The behavior is undefined unless
+        // '0 < maxPendingStreams'.
+
+    // MANIPULATORS
+    int add(bool                     *isComplete,
+            MessageBuffer            *payload,
+            const FragmentHeader&     header,
+            const bslstl::StringRef&  data);
+        // Add the specified 'data', which is the fragment of a payload
+        // described by the specified 'header'. If 'data' is the last missing
+        // fragment of the payload, replace the contents of the specified
+        // 'payload' with the whole payload and assign 'true' through the
+        // specified 'isComplete'. Otherwise, assign 'false' through
+        // 'isComplete' and leave 'payload' unmodified. Return zero on success
+        // or a nonzero value if 'header' does not describe one of the fewest
+        // fragments that hold the payload, or 'data' has a different length,
+        // or if the fragment is inconsistent with the fragments of the same
+        // payload already added, is a duplicate, or belongs to a payload
+        // larger than the maximum pending bytes. Note that 'data' may refer
+        // to memory within 'payload'.
+
+    void setLimits(bsl::size_t maxPendingBytes, bsl::size_t maxPendingStreams);
+        // Set the maximum number of bytes that incomplete payloads may occupy
+        // to the specified 'maxPendingBytes', and the maximum number of
+        // incomplete payloads to the specified 'maxPendingStreams'. Discard
+        // incomplete payloads as necessary to respect the new limits. The
+        // behavior is undefined unless '0 < maxPendingStreams'.
+
+    // ACCESSORS
+    bsl::size_t numPendingStreams() const;
+        // Return the number of payloads of which some but not all fragments
+        // have been added.
+
+    bsl::size_t numPendingBytes() const;
+        // Return the number of bytes that the incomplete payloads occupy,
+        // which is the sum of their lengths and of one bit for each of their
+        // fragments.
+
+  private:
+    // PRIVATE MANIPULATORS
+    void evict(bsl::size_t incomingStreams, bsl::size_t incomingBytes);
+        // Discard the least recently started incomplete payloads until there
+        // is room for the specified 'incomingStreams' more payloads having a
+        // total of the specified 'incomingBytes'. The behavior is undefined
+        // unless 'd_mutex' is locked.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                           // ---------------------
+                           // struct FragmentHeader
+                           // ---------------------
+
+// ACCESSORS
+inline
+bsl::size_t FragmentHeader::chunkSize() const
+{
+    return (d_totalLength + d_count - 1) / d_count;
+}
+
+inline
+bsl::size_t FragmentHeader::offset() const
+{
+    return d_index * chunkSize();
+}
+
+inline
+bsl::size_t FragmentHeader::length() const
+{
+    const bsl::size_t begin = offset();
+    const bsl::size_t chunk = chunkSize();
+    return d_totalLength - begin < chunk ? d_totalLength - begin : chunk;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
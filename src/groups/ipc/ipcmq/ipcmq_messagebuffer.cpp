@@ -0,0 +1,48 @@
+
+#include <ipcmq_messagebuffer.h>
+
+#include <bslma_allocator.h>
+#include <bslma_default.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_cstring.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+
+// CREATORS
+MessageBuffer::MessageBuffer(bslma::Allocator *basicAllocator)
+: d_data_p(0)
+, d_length(0)
+, d_capacity(0)
+, d_allocator_p(bslma::Default::allocator(basicAllocator))
+{
+}
+
+MessageBuffer::~MessageBuffer()
+{
+    d_allocator_p->deallocate(d_data_p);
+}
+
+// MANIPULATORS
+void MessageBuffer::reserve(bsl::size_t capacity)
+{
+    if (capacity <= d_capacity) {
+        return;                                                       // RETURN
+    }
+
+    const bsl::size_t newCapacity = bsl::max(capacity, 2 * d_capacity);
+    char *const       newData     =
+        static_cast<char *>(d_allocator_p->allocate(newCapacity));
+
+    if (d_length) {
+        bsl::memcpy(newData, d_data_p, d_length);
+    }
+
+    d_allocator_p->deallocate(d_data_p);
+    d_data_p   = newData;
+    d_capacity = newCapacity;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
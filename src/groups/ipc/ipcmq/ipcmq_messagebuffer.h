@@ -0,0 +1,186 @@
+#ifndef INCLUDED_IPCMQ_MESSAGEBUFFER
+#define INCLUDED_IPCMQ_MESSAGEBUFFER
+
+#include <bsl_algorithm.h>
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+
+#include <bslma_usesbslmaallocator.h>
+
+#include <bslmf_nestedtraitdeclaration.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+                            // ===================
+                            // class MessageBuffer
+                            // ===================
+
+class MessageBuffer {
+    // This class provides a growable, contiguous region of memory into which
+    // messages are received. Unlike 'bsl::string', growing a 'MessageBuffer'
+    // does not initialize the new storage, so a buffer that is reused for many
+    // messages has only the bytes of the messages themselves written to it.
+    // The first 'length()' bytes of the buffer are its contents; the bytes
+    // between 'length()' and 'capacity()' are uninitialized room for more.
+
+    // DATA
+    char             *d_data_p;
+    bsl::size_t       d_length;
+    bsl::size_t       d_capacity;
+    bslma::Allocator *d_allocator_p;
+
+    MessageBuffer(const MessageBuffer&);             // = delete
+    MessageBuffer& operator=(const MessageBuffer&);  // = delete
+
+  public:
+    // TRAITS
+    BSLMF_NESTED_TRAIT_DECLARATION(MessageBuffer, bslma::UsesBslmaAllocator);
+
+    // CREATORS
+    explicit MessageBuffer(bslma::Allocator *basicAllocator = 0);
+        // Create an empty 'MessageBuffer' having zero capacity. Optionally
+        // specify a 'basicAllocator' used to supply memory. If
+        // 'basicAllocator' is zero, the currently installed default allocator
+        // is used.
+
+    ~MessageBuffer();
+        // Destroy this object and release its memory.
+
+    // MANIPULATORS
+    void reserve(bsl::size_t capacity);
+        // Make the capacity of this buffer at least the specified 'capacity',
+        // preserving its contents. Do not initialize any storage obtained.
+        // Note that capacity grows geometrically, so that a sequence of calls
+        // to 'reserve' with increasing values allocates a logarithmic number
+        // of times.
+
+    void setLength(bsl::size_t length);
+        // Set the length of the contents of this buffer to the specified
+        // 'length'. The behavior is undefined unless
+        // 'length <= capacity()'. Note that if 'length' is greater than the
+        // current length, the contents of the bytes added are whatever was
+        // last written to them.
+
+    void clear();
+        // Set the length of this buffer to zero, keeping its capacity.
+
+    void swap(MessageBuffer& other);
+        // Exchange the contents and capacity of this buffer with those of the
+        // specified 'other' buffer. The behavior is undefined unless both
+        // buffers use the same allocator.
+
+    char *data();
+        // Return a pointer providing modifiable access to the beginning of
+        // this buffer's storage. Note that the pointer is invalidated by any
+        // call to 'reserve' that grows the buffer.
+
+    // ACCESSORS
+    const char *data() const;
+        // Return a pointer providing non-modifiable access to the beginning
+        // of this buffer's storage.
+
+    bsl::size_t length() const;
+        // Return the length of the contents of this buffer.
+
+    bsl::size_t capacity() const;
+        // Return the number of bytes this buffer can hold without allocating.
+
+    bslstl::StringRef stringRef() const;
+        // Return a reference to the contents of this buffer.
+
+    bslstl::StringRef stringRef(bsl::size_t offset, bsl::size_t length) const;
+        // Return a reference to the specified 'length' bytes of the contents
+        // of this buffer beginning at the specified 'offset'. The behavior is
+        // undefined unless 'offset + length <= this->length()'.
+
+    bslma::Allocator *allocator() const;
+        // Return the allocator used by this object to supply memory.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                            // -------------------
+                            // class MessageBuffer
+                            // -------------------
+
+// MANIPULATORS
+inline
+void MessageBuffer::setLength(bsl::size_t length)
+{
+    BSLS_ASSERT(length <= d_capacity);
+
+    d_length = length;
+}
+
+inline
+void MessageBuffer::clear()
+{
+    d_length = 0;
+}
+
+inline
+void MessageBuffer::swap(MessageBuffer& other)
+{
+    BSLS_ASSERT(d_allocator_p == other.d_allocator_p);
+
+    bsl::swap(d_data_p, other.d_data_p);
+    bsl::swap(d_length, other.d_length);
+    bsl::swap(d_capacity, other.d_capacity);
+}
+
+inline
+char *MessageBuffer::data()
+{
+    return d_data_p;
+}
+
+// ACCESSORS
+inline
+const char *MessageBuffer::data() const
+{
+    return d_data_p;
+}
+
+inline
+bsl::size_t MessageBuffer::length() const
+{
+    return d_length;
+}
+
+inline
+bsl::size_t MessageBuffer::capacity() const
+{
+    return d_capacity;
+}
+
+inline
+bslstl::StringRef MessageBuffer::stringRef() const
+{
+    return bslstl::StringRef(d_data_p, d_length);
+}
+
+inline
+bslstl::StringRef MessageBuffer::stringRef(bsl::size_t offset,
+                                           bsl::size_t length) const
+{
+    BSLS_ASSERT(offset + length <= d_length);
+
+    return bslstl::StringRef(d_data_p + offset, length);
+}
+
+inline
+bslma::Allocator *MessageBuffer::allocator() const
+{
+    return d_allocator_p;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
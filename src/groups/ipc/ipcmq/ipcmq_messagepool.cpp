@@ -0,0 +1,78 @@
+
+#include <ipcmq_messagepool.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+
+                             // -----------------
+                             // class MessagePool
+                             // -----------------
+
+// CREATORS
+MessagePool::MessagePool(bslma::Allocator *basicAllocator)
+: d_upstream("ipcmq::MessagePool", basicAllocator)
+, d_multipool(&d_upstream)
+, d_buffers(-1, &d_multipool)
+{
+}
+
+MessagePool::~MessagePool()
+{
+    BSLS_ASSERT(numBuffersInUse() == 0);
+}
+
+// MANIPULATORS
+bsl::string *MessagePool::getBuffer()
+{
+    return d_buffers.getObject();
+}
+
+void MessagePool::releaseBuffer(bsl::string *buffer)
+{
+    BSLS_ASSERT(buffer);
+
+    // The pool clears the buffer, which keeps its capacity.
+    d_buffers.releaseObject(buffer);
+}
+
+// ACCESSORS
+bsls::Types::Int64 MessagePool::numBytesAllocated() const
+{
+    return d_upstream.numBytesTotal();
+}
+
+bsls::Types::Int64 MessagePool::numBytesInUse() const
+{
+    return d_upstream.numBytesInUse();
+}
+
+int MessagePool::numBuffers() const
+{
+    return d_buffers.numObjects();
+}
+
+int MessagePool::numBuffersInUse() const
+{
+    return d_buffers.numObjects() - d_buffers.numAvailableObjects();
+}
+
+                            // -------------------
+                            // class MessageHandle
+                            // -------------------
+
+// MANIPULATORS
+MessageHandle& MessageHandle::operator=(bslmf::MovableRef<MessageHandle> rhs)
+{
+    MessageHandle& other = bslmf::MovableRefUtil::access(rhs);
+    if (&other != this) {
+        reset();
+        swap(other);
+    }
+
+    return *this;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
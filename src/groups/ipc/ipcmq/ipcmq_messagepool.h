@@ -0,0 +1,281 @@
+#ifndef INCLUDED_IPCMQ_MESSAGEPOOL
+#define INCLUDED_IPCMQ_MESSAGEPOOL
+
+#include <bdlcc_objectpool.h>
+
+#include <bdlma_concurrentmultipoolallocator.h>
+#include <bdlma_countingallocator.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_string.h>
+
+#include <bslmf_isbitwisemoveable.h>
+#include <bslmf_movableref.h>
+#include <bslmf_nestedtraitdeclaration.h>
+
+#include <bsls_assert.h>
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+                             // =================
+                             // class MessagePool
+                             // =================
+
+class MessagePool {
+    // This class provides a thread-safe pool of message buffers, so that a
+    // buffer handed to the application and later released is reused for
+    // another message rather than freed. Each buffer is a 'bsl::string' that
+    // keeps its capacity while in the pool. The memory of the buffers, and
+    // of the pool itself, comes from a multipool allocator, which recycles
+    // blocks by size class, so that the block a buffer gives up as it grows
+    // is reused by the next buffer to grow through that size. The multipool
+    // draws on the allocator supplied at construction through a counting
+    // allocator, so 'numBytesAllocated' stops growing once the pool has as
+    // many buffers as are ever in use at once and each has held a message
+    // as large as any received: from then on, buffers cost no allocation.
+
+    // PRIVATE TYPES
+    typedef bdlcc::ObjectPool<bsl::string,
+                              bdlcc::ObjectPoolFunctors::DefaultCreator,
+                              bdlcc::ObjectPoolFunctors::Clear<bsl::string> >
+        BufferPool;
+
+    // DATA
+    bdlma::CountingAllocator            d_upstream;
+    bdlma::ConcurrentMultipoolAllocator d_multipool;
+    BufferPool                          d_buffers;
+
+    MessagePool(const MessagePool&);             // = delete
+    MessagePool& operator=(const MessagePool&);  // = delete
+
+  public:
+    // CREATORS
+    explicit MessagePool(bslma::Allocator *basicAllocator = 0);
+        // Create an empty 'MessagePool'. Optionally specify a
+        // 'basicAllocator' used to supply memory. If 'basicAllocator' is
+        // zero, the currently installed default allocator is used.
+
+    ~MessagePool();
+        // Destroy this object and every buffer in it. The behavior is
+        // undefined unless every buffer obtained from this pool has been
+        // released to it.
+
+    // MANIPULATORS
+    bsl::string *getBuffer();
+        // Return a pointer to an empty buffer, reusing one released to this
+        // pool if there is one, in which case it keeps the capacity it had.
+
+    void releaseBuffer(bsl::string *buffer);
+        // Clear the specified 'buffer' and return it to this pool. The
+        // behavior is undefined unless 'buffer' was obtained from this pool
+        // and has not since been released.
+
+    // ACCESSORS
+    bsls::Types::Int64 numBytesAllocated() const;
+        // Return the number of bytes that this pool has allocated, in total,
+        // from the allocator supplied at construction.
+
+    bsls::Types::Int64 numBytesInUse() const;
+        // Return the number of bytes that this pool holds from the allocator
+        // supplied at construction. Note that memory recycled by this pool is
+        // in use until the pool is destroyed.
+
+    int numBuffers() const;
+        // Return the number of buffers that this pool has created.
+
+    int numBuffersInUse() const;
+        // Return the number of buffers obtained from this pool and not yet
+        // released to it.
+};
+
+                            // ===================
+                            // class MessageHandle
+                            // ===================
+
+class MessageHandle {
+    // This class is a movable handle to a message buffer obtained from a
+    // 'MessagePool'. The handle owns the buffer: moving the handle transfers
+    // the buffer without copying the message, and when a handle that owns a
+    // buffer is destroyed or reset, the buffer returns to its pool. A handle
+    // converts to a 'bsl::string *' to its buffer, so that a function taking
+    // the message as a 'bsl::string *' can be given a handle; such a function
+    // must not keep the pointer beyond the life of the handle. A handle is
+    // not thread-safe, but may be moved to, and released on, any thread.
+
+    // DATA
+    bsl::string *d_buffer_p;  // zero if this handle is empty
+    MessagePool *d_pool_p;
+
+    MessageHandle(const MessageHandle&);             // = delete
+    MessageHandle& operator=(const MessageHandle&);  // = delete
+
+  public:
+    // TRAITS
+    BSLMF_NESTED_TRAIT_DECLARATION(MessageHandle, bslmf::IsBitwiseMoveable);
+
+    // CREATORS
+    MessageHandle();
+        // Create an empty 'MessageHandle'.
+
+    MessageHandle(bsl::string *buffer, MessagePool *pool);
+        // Create a 'MessageHandle' that owns the specified 'buffer', obtained
+        // from the specified 'pool'. The behavior is undefined unless 'buffer'
+        // is not owned by anything else.
+
+    MessageHandle(bslmf::MovableRef<MessageHandle> original);       // IMPLICIT
+        // Create a 'MessageHandle' that owns the buffer of the specified
+        // 'original', if any, leaving 'original' empty.
+
+    ~MessageHandle();
+        // Return the buffer of this handle, if any, to its pool, and destroy
+        // this object.
+
+    // MANIPULATORS
+    MessageHandle& operator=(bslmf::MovableRef<MessageHandle> rhs);
+        // Return the buffer of this handle, if any, to its pool, take the
+        // buffer of the specified 'rhs', if any, leaving 'rhs' empty, and
+        // return a reference providing modifiable access to this object.
+
+    void reset();
+        // Return the buffer of this handle, if any, to its pool, leaving this
+        // handle empty.
+
+    bsl::string *release();
+        // Return the buffer of this handle, or zero if it is empty, leaving
+        // this handle empty without returning the buffer to its pool. The
+        // caller must return the buffer to 'pool()' when done with it.
+
+    void swap(MessageHandle& other);
+        // Exchange the buffer of this handle with that of the specified
+        // 'other' handle.
+
+    // ACCESSORS
+    bsl::string *get() const;
+        // Return the buffer of this handle, or zero if it is empty.
+
+    bsl::string& operator*() const;
+        // Return a reference to the buffer of this handle. The behavior is
+        // undefined if this handle is empty.
+
+    bsl::string *operator->() const;
+        // Return the buffer of this handle. The behavior is undefined if this
+        // handle is empty.
+
+    operator bsl::string *() const;
+        // Return the buffer of this handle, or zero if it is empty.
+
+    MessagePool *pool() const;
+        // Return the pool of the buffer of this handle, or zero if it is
+        // empty.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                            // -------------------
+                            // class MessageHandle
+                            // -------------------
+
+// CREATORS
+inline
+MessageHandle::MessageHandle()
+: d_buffer_p(0)
+, d_pool_p(0)
+{
+}
+
+inline
+MessageHandle::MessageHandle(bsl::string *buffer, MessagePool *pool)
+: d_buffer_p(buffer)
+, d_pool_p(pool)
+{
+    BSLS_ASSERT(buffer);
+    BSLS_ASSERT(pool);
+}
+
+inline
+MessageHandle::MessageHandle(bslmf::MovableRef<MessageHandle> original)
+: d_buffer_p(bslmf::MovableRefUtil::access(original).d_buffer_p)
+, d_pool_p(bslmf::MovableRefUtil::access(original).d_pool_p)
+{
+    MessageHandle& other = bslmf::MovableRefUtil::access(original);
+    other.d_buffer_p     = 0;
+    other.d_pool_p       = 0;
+}
+
+inline
+MessageHandle::~MessageHandle()
+{
+    reset();
+}
+
+// MANIPULATORS
+inline
+void MessageHandle::reset()
+{
+    if (d_buffer_p) {
+        d_pool_p->releaseBuffer(d_buffer_p);
+        d_buffer_p = 0;
+        d_pool_p   = 0;
+    }
+}
+
+inline
+bsl::string *MessageHandle::release()
+{
+    bsl::string *const buffer = d_buffer_p;
+    d_buffer_p = 0;
+    d_pool_p   = 0;
+    return buffer;
+}
+
+inline
+void MessageHandle::swap(MessageHandle& other)
+{
+    bsl::swap(d_buffer_p, other.d_buffer_p);
+    bsl::swap(d_pool_p, other.d_pool_p);
+}
+
+// ACCESSORS
+inline
+bsl::string *MessageHandle::get() const
+{
+    return d_buffer_p;
+}
+
+inline
+bsl::string& MessageHandle::operator*() const
+{
+    BSLS_ASSERT(d_buffer_p);
+
+    return *d_buffer_p;
+}
+
+inline
+bsl::string *MessageHandle::operator->() const
+{
+    BSLS_ASSERT(d_buffer_p);
+
+    return d_buffer_p;
+}
+
+inline
+MessageHandle::operator bsl::string *() const
+{
+    return d_buffer_p;
+}
+
+inline
+MessagePool *MessageHandle::pool() const
+{
+    return d_pool_p;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
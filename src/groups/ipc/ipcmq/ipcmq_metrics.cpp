@@ -0,0 +1,249 @@
+
+#include <ipcmq_metrics.h>
+
+#include <bdlb_bitutil.h>
+
+#include <bslmf_assert.h>
+
+#include <bslmt_threadutil.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+typedef Metrics_Shard Shard;
+
+typedef bsls::AtomicInt64 (Shard::*Buckets)[Shard::k_NUM_BUCKETS];
+    // the buckets of one of the histograms of a shard
+
+int bucketIndex(bsls::Types::Int64 nanoseconds)
+    // Return the index of the bucket counting the specified 'nanoseconds',
+    // which is the same as that of an 'ipcu::Histogram' of precision zero.
+    // Negative times, which a clock adjustment could produce, count as zero.
+{
+    if (nanoseconds < 2) {
+        return nanoseconds < 0 ? 0 : int(nanoseconds);                // RETURN
+    }
+
+    return 64 - bdlb::BitUtil::numLeadingUnsetBits(
+                                        bsls::Types::Uint64(nanoseconds));
+}
+
+bsls::Types::Uint64 bucketLowest(int index)
+    // Return the least value counted by the bucket at the specified 'index'.
+{
+    return index < 2 ? index : bsls::Types::Uint64(1) << (index - 1);
+}
+
+void loadHistogram(ipcu::Histogram *result,
+                   const Shard     *shards,
+                   int              numShards,
+                   Buckets          buckets)
+    // Load into the specified 'result' the sums of the specified 'buckets' of
+    // the specified 'numShards' 'shards'.
+{
+    *result = ipcu::Histogram(0);
+    for (int i = 0; i < Shard::k_NUM_BUCKETS; ++i) {
+        bsls::Types::Int64 count = 0;
+        for (int j = 0; j < numShards; ++j) {
+            count += (shards[j].*buckets)[i].loadRelaxed();
+        }
+        result->record(bucketLowest(i), count);
+    }
+}
+
+}  // close unnamed namespace
+
+                           // ----------------------
+                           // struct MetricsSnapshot
+                           // ----------------------
+
+// CREATORS
+MetricsSnapshot::MetricsSnapshot(bslma::Allocator *basicAllocator)
+: d_numMessages(0)
+, d_numBytes(0)
+, d_numWouldBlock(0)
+, d_numTimeouts(0)
+, d_numErrors(0)
+, d_numExternalPayloads(0)
+, d_numSpinHits(0)
+, d_numSpinMisses(0)
+, d_codingNanoseconds(0, basicAllocator)
+, d_callbackNanoseconds(0, basicAllocator)
+, d_latencyNanoseconds(0, basicAllocator)
+, d_spinNanoseconds(0, basicAllocator)
+{
+}
+
+MetricsSnapshot::MetricsSnapshot(const MetricsSnapshot&  original,
+                                 bslma::Allocator       *basicAllocator)
+: d_numMessages(original.d_numMessages)
+, d_numBytes(original.d_numBytes)
+, d_numWouldBlock(original.d_numWouldBlock)
+, d_numTimeouts(original.d_numTimeouts)
+, d_numErrors(original.d_numErrors)
+, d_numExternalPayloads(original.d_numExternalPayloads)
+, d_numSpinHits(original.d_numSpinHits)
+, d_numSpinMisses(original.d_numSpinMisses)
+, d_codingNanoseconds(original.d_codingNanoseconds, basicAllocator)
+, d_callbackNanoseconds(original.d_callbackNanoseconds, basicAllocator)
+, d_latencyNanoseconds(original.d_latencyNanoseconds, basicAllocator)
+, d_spinNanoseconds(original.d_spinNanoseconds, basicAllocator)
+{
+}
+
+// MANIPULATORS
+void MetricsSnapshot::add(const MetricsSnapshot& other)
+{
+    d_numMessages         += other.d_numMessages;
+    d_numBytes            += other.d_numBytes;
+    d_numWouldBlock       += other.d_numWouldBlock;
+    d_numTimeouts         += other.d_numTimeouts;
+    d_numErrors           += other.d_numErrors;
+    d_numExternalPayloads += other.d_numExternalPayloads;
+    d_numSpinHits         += other.d_numSpinHits;
+    d_numSpinMisses       += other.d_numSpinMisses;
+    d_codingNanoseconds.add(other.d_codingNanoseconds);
+    d_callbackNanoseconds.add(other.d_callbackNanoseconds);
+    d_latencyNanoseconds.add(other.d_latencyNanoseconds);
+    d_spinNanoseconds.add(other.d_spinNanoseconds);
+}
+
+                               // -------------
+                               // class Metrics
+                               // -------------
+
+// CREATORS
+Metrics::Metrics()
+{
+    // 'bsls::AtomicInt64' is initialized to zero.
+}
+
+// MANIPULATORS
+void Metrics::recordMessage(bsl::size_t numBytes)
+{
+    Shard& counters = shard();
+    counters.d_counters[Shard::e_MESSAGES].addRelaxed(1);
+    counters.d_counters[Shard::e_BYTES].addRelaxed(numBytes);
+}
+
+void Metrics::recordWouldBlock()
+{
+    shard().d_counters[Shard::e_WOULD_BLOCK].addRelaxed(1);
+}
+
+void Metrics::recordTimeout()
+{
+    shard().d_counters[Shard::e_TIMEOUTS].addRelaxed(1);
+}
+
+void Metrics::recordError()
+{
+    shard().d_counters[Shard::e_ERRORS].addRelaxed(1);
+}
+
+void Metrics::recordExternalPayload()
+{
+    shard().d_counters[Shard::e_EXTERNAL_PAYLOADS].addRelaxed(1);
+}
+
+void Metrics::recordCodingTime(bsls::Types::Int64 nanoseconds)
+{
+    shard().d_coding[bucketIndex(nanoseconds)].addRelaxed(1);
+}
+
+void Metrics::recordCodingTime(bsls::Types::Int64 nanoseconds,
+                               bsls::Types::Int64 count)
+{
+    BSLS_ASSERT(count >= 0);
+
+    shard().d_coding[bucketIndex(nanoseconds)].addRelaxed(count);
+}
+
+void Metrics::recordCallbackTime(bsls::Types::Int64 nanoseconds)
+{
+    shard().d_callback[bucketIndex(nanoseconds)].addRelaxed(1);
+}
+
+void Metrics::recordLatency(bsls::Types::Int64 nanoseconds)
+{
+    shard().d_latency[bucketIndex(nanoseconds)].addRelaxed(1);
+}
+
+void Metrics::recordSpin(bsls::Types::Int64 nanoseconds, bool isHit)
+{
+    Shard& counters = shard();
+    counters.d_counters[isHit ? Shard::e_SPIN_HITS : Shard::e_SPIN_MISSES]
+        .addRelaxed(1);
+    counters.d_spin[bucketIndex(nanoseconds)].addRelaxed(1);
+}
+
+void Metrics::reset()
+{
+    for (int i = 0; i < k_NUM_SHARDS; ++i) {
+        Shard& counters = d_shards[i];
+        for (int j = 0; j < Shard::k_NUM_COUNTERS; ++j) {
+            counters.d_counters[j].storeRelaxed(0);
+        }
+        for (int j = 0; j < Shard::k_NUM_BUCKETS; ++j) {
+            counters.d_coding[j].storeRelaxed(0);
+            counters.d_callback[j].storeRelaxed(0);
+            counters.d_latency[j].storeRelaxed(0);
+            counters.d_spin[j].storeRelaxed(0);
+        }
+    }
+}
+
+Metrics_Shard& Metrics::shard()
+{
+    // Thread IDs are often addresses, whose low bits are all alike, so they
+    // are mixed by a multiplicative hash, whose high bits select the shard.
+    BSLMF_ASSERT(k_NUM_SHARDS == 8);
+
+    const bsls::Types::Uint64 id = bslmt::ThreadUtil::selfIdAsUint64();
+    return d_shards[(id * 0x9E3779B97F4A7C15ULL) >> 61];
+}
+
+// ACCESSORS
+void Metrics::loadSnapshot(MetricsSnapshot *result) const
+{
+    BSLS_ASSERT(result);
+
+    bsls::Types::Int64 sums[Shard::k_NUM_COUNTERS] = {};
+    for (int i = 0; i < k_NUM_SHARDS; ++i) {
+        for (int j = 0; j < Shard::k_NUM_COUNTERS; ++j) {
+            sums[j] += d_shards[i].d_counters[j].loadRelaxed();
+        }
+    }
+
+    result->d_numMessages         = sums[Shard::e_MESSAGES];
+    result->d_numBytes            = sums[Shard::e_BYTES];
+    result->d_numWouldBlock       = sums[Shard::e_WOULD_BLOCK];
+    result->d_numTimeouts         = sums[Shard::e_TIMEOUTS];
+    result->d_numErrors           = sums[Shard::e_ERRORS];
+    result->d_numExternalPayloads = sums[Shard::e_EXTERNAL_PAYLOADS];
+    result->d_numSpinHits         = sums[Shard::e_SPIN_HITS];
+    result->d_numSpinMisses       = sums[Shard::e_SPIN_MISSES];
+
+    loadHistogram(&result->d_codingNanoseconds,
+                  d_shards,
+                  k_NUM_SHARDS,
+                  &Shard::d_coding);
+    loadHistogram(&result->d_callbackNanoseconds,
+                  d_shards,
+                  k_NUM_SHARDS,
+                  &Shard::d_callback);
+    loadHistogram(&result->d_latencyNanoseconds,
+                  d_shards,
+                  k_NUM_SHARDS,
+                  &Shard::d_latency);
+    loadHistogram(&result->d_spinNanoseconds,
+                  d_shards,
+                  k_NUM_SHARDS,
+                  &Shard::d_spin);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
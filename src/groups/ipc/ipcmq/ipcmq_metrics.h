@@ -0,0 +1,187 @@
+#ifndef INCLUDED_IPCMQ_METRICS
+#define INCLUDED_IPCMQ_METRICS
+
+#include <ipcu_histogram.h>
+
+#include <bslma_usesbslmaallocator.h>
+
+#include <bslmf_nestedtraitdeclaration.h>
+
+#include <bsls_atomic.h>
+#include <bsls_types.h>
+
+#include <bsl_cstddef.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+                           // ======================
+                           // struct MetricsSnapshot
+                           // ======================
+
+struct MetricsSnapshot {
+    // This 'struct' holds the values of the counters of a 'Metrics' object at
+    // one point in time. The histograms have one bucket for each power of
+    // two, so the times they report are accurate to within a factor of two.
+
+    // DATA
+    bsls::Types::Int64 d_numMessages;          // payloads sent or received
+    bsls::Types::Int64 d_numBytes;             // bytes in those payloads
+    bsls::Types::Int64 d_numWouldBlock;        // attempts that found the
+                                               // queue full or empty
+    bsls::Types::Int64 d_numTimeouts;          // attempts that timed out
+    bsls::Types::Int64 d_numErrors;            // other failed attempts
+    bsls::Types::Int64 d_numExternalPayloads;  // payloads stored in a file or
+                                               // in shared memory
+    bsls::Types::Int64 d_numSpinHits;          // payloads received while
+                                               // polling before blocking
+    bsls::Types::Int64 d_numSpinMisses;        // polls that ended without a
+                                               // payload, and then blocked
+    ipcu::Histogram    d_codingNanoseconds;    // time to encode or decode
+                                               // each payload
+    ipcu::Histogram    d_callbackNanoseconds;  // time spent in the callback
+                                               // with each payload
+    ipcu::Histogram    d_latencyNanoseconds;   // time from receiving each
+                                               // payload until its callback
+                                               // returned
+    ipcu::Histogram    d_spinNanoseconds;      // time spent polling before
+                                               // each payload or blocking
+
+    // TRAITS
+    BSLMF_NESTED_TRAIT_DECLARATION(MetricsSnapshot,
+                                   bslma::UsesBslmaAllocator);
+
+    // CREATORS
+    explicit MetricsSnapshot(bslma::Allocator *basicAllocator = 0);
+        // Create a 'MetricsSnapshot' having every count zero. Optionally
+        // specify a 'basicAllocator' used to supply memory.
+
+    MetricsSnapshot(const MetricsSnapshot&  original,
+                    bslma::Allocator       *basicAllocator = 0);
+        // Create a 'MetricsSnapshot' having the same values as the specified
+        // 'original'. Optionally specify a 'basicAllocator' used to supply
+        // memory.
+
+    // MANIPULATORS
+    void add(const MetricsSnapshot& other);
+        // Add every count of the specified 'other' snapshot to this snapshot.
+};
+
+                            // ====================
+                            // struct Metrics_Shard
+                            // ====================
+
+struct Metrics_Shard {
+    // This component-private 'struct' holds the counters of a 'Metrics'
+    // object updated by some of the threads that use it.
+
+    // PUBLIC CONSTANTS
+    enum Counter {
+        e_MESSAGES,
+        e_BYTES,
+        e_WOULD_BLOCK,
+        e_TIMEOUTS,
+        e_ERRORS,
+        e_EXTERNAL_PAYLOADS,
+        e_SPIN_HITS,
+        e_SPIN_MISSES,
+        k_NUM_COUNTERS
+    };
+
+    enum { k_NUM_BUCKETS = 65 };  // zero, and then one per power of two
+
+    // DATA
+    bsls::AtomicInt64 d_counters[k_NUM_COUNTERS];
+    bsls::AtomicInt64 d_coding[k_NUM_BUCKETS];
+    bsls::AtomicInt64 d_callback[k_NUM_BUCKETS];
+    bsls::AtomicInt64 d_latency[k_NUM_BUCKETS];
+    bsls::AtomicInt64 d_spin[k_NUM_BUCKETS];
+    char              d_padding[64];  // keeps shards off each other's cache
+                                      // lines
+};
+
+                               // =============
+                               // class Metrics
+                               // =============
+
+class Metrics {
+    // This class counts the payloads sent or received by a 'QueueSender',
+    // 'QueueReceiver', or 'Consumer', and the attempts that failed, and
+    // records how long each payload took to encode or decode and to process,
+    // so that applications can see what their queues are doing. Counting is
+    // cheap enough to be left enabled always: each thread updates one of
+    // several shards of relaxed atomic counters, chosen by a hash of its
+    // thread ID, so that threads using the same object seldom contend for a
+    // cache line, and each time is recorded by incrementing the bucket for
+    // its power of two. 'loadSnapshot' sums the shards. This class is
+    // thread-safe, though a snapshot taken while other threads record is not
+    // an atomic view of all the counters.
+
+    // PRIVATE CONSTANTS
+    enum { k_NUM_SHARDS = 8 };
+
+    // DATA
+    Metrics_Shard d_shards[k_NUM_SHARDS];
+
+    // NOT IMPLEMENTED
+    Metrics(const Metrics&);             // = delete
+    Metrics& operator=(const Metrics&);  // = delete
+
+  public:
+    // CREATORS
+    Metrics();
+        // Create a 'Metrics' object having every count zero.
+
+    // MANIPULATORS
+    void recordMessage(bsl::size_t numBytes);
+        // Count a payload of the specified 'numBytes' sent or received.
+
+    void recordWouldBlock();
+        // Count an attempt that failed because the queue was full or empty.
+
+    void recordTimeout();
+        // Count an attempt that failed because it timed out.
+
+    void recordError();
+        // Count an attempt that failed for any other reason.
+
+    void recordExternalPayload();
+        // Count a payload that was stored outside of the queue.
+
+    void recordCodingTime(bsls::Types::Int64 nanoseconds);
+    void recordCodingTime(bsls::Types::Int64 nanoseconds,
+                          bsls::Types::Int64 count);
+        // Record that a payload, or each of the optionally specified 'count'
+        // payloads, took the specified 'nanoseconds' to encode or decode.
+
+    void recordCallbackTime(bsls::Types::Int64 nanoseconds);
+        // Record that processing a payload took the specified 'nanoseconds'.
+
+    void recordLatency(bsls::Types::Int64 nanoseconds);
+        // Record that a payload was processed the specified 'nanoseconds'
+        // after it was received.
+
+    void recordSpin(bsls::Types::Int64 nanoseconds, bool isHit);
+        // Record that a thread polled for the specified 'nanoseconds' before
+        // blocking to receive, and that it received a payload if the
+        // specified 'isHit' is 'true', or blocked otherwise.
+
+    void reset();
+        // Set every count to zero.
+
+    // ACCESSORS
+    void loadSnapshot(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the current counts.
+
+  private:
+    // PRIVATE MANIPULATORS
+    Metrics_Shard& shard();
+        // Return a reference providing modifiable access to the shard used by
+        // the calling thread.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
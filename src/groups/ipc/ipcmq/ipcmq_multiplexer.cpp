@@ -0,0 +1,346 @@
+
+#include <ipcmq_multiplexer.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuereceiver.h>
+
+#include <ball_log.h>
+
+#include <bdlf_memfn.h>
+
+#include <bslma_default.h>
+#include <bslma_stdallocator.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsls_assert.h>
+#include <bsls_platform.h>
+#include <bsls_types.h>
+
+#include <errno.h>   // errno, EINTR
+#include <string.h>  // strerror
+#include <unistd.h>  // close, read, write
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+#include <sys/epoll.h>    // epoll_*
+#include <sys/eventfd.h>  // eventfd
+#endif
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.MULTIPLEXER";
+
+// The maximum number of ready queues reported by one call to 'epoll_wait'.
+const int k_MAX_EVENTS = 64;
+
+// The maximum number of messages received from one queue before moving on to
+// the next ready queue. 'epoll' is used in level-triggered mode, so a queue
+// that still has messages is reported again by the next 'epoll_wait', and no
+// one busy queue can starve the others.
+const int k_MAX_MESSAGES_PER_WAKEUP = 16;
+
+}  // close unnamed namespace
+
+                      // ================================
+                      // struct Multiplexer::Registration
+                      // ================================
+
+struct Multiplexer::Registration {
+    // This 'struct' holds everything needed to receive from and dispatch
+    // messages for one registered queue.
+
+    // DATA
+    QueueReceiver   d_receiver;
+    MessageCallback d_callback;
+    bsl::string     d_messageBuffer;
+
+    // CREATORS
+    Registration(PosixQueue             *queue,
+                 Format                  format,
+                 const MessageCallback&  callback,
+                 bslma::Allocator       *allocator)
+    : d_receiver(queue, format)
+    , d_callback(bsl::allocator_arg_t(),
+                 bsl::allocator<MessageCallback>(allocator),
+                 callback)
+    , d_messageBuffer(allocator)
+    {
+    }
+};
+
+                            // -----------------
+                            // class Multiplexer
+                            // -----------------
+
+// CREATORS
+Multiplexer::Multiplexer(bslma::Allocator *allocator)
+: d_epollFd(-1)
+, d_eventFd(-1)
+, d_shuttingDown(false)
+, d_registrations(allocator)
+, d_thread(bslmt::ThreadUtil::invalidHandle())
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+#ifdef BSLS_PLATFORM_OS_LINUX
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    d_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (d_epollFd == -1) {
+        BALL_LOG_ERROR << "Unable to create epoll instance: "
+                       << strerror(errno) << BALL_LOG_END;
+        return;                                                       // RETURN
+    }
+
+    d_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (d_eventFd == -1) {
+        BALL_LOG_ERROR << "Unable to create eventfd: " << strerror(errno)
+                       << BALL_LOG_END;
+        return;                                                       // RETURN
+    }
+
+    epoll_event event = epoll_event();
+    event.events      = EPOLLIN;
+    event.data.fd     = d_eventFd;
+    if (epoll_ctl(d_epollFd, EPOLL_CTL_ADD, d_eventFd, &event) == -1) {
+        BALL_LOG_ERROR << "Unable to add eventfd to epoll set: "
+                       << strerror(errno) << BALL_LOG_END;
+        close(d_eventFd);
+        d_eventFd = -1;
+    }
+#endif
+}
+
+Multiplexer::~Multiplexer()
+{
+    stop();
+
+    if (d_eventFd != -1) {
+        close(d_eventFd);
+    }
+
+    if (d_epollFd != -1) {
+        close(d_epollFd);
+    }
+}
+
+// MANIPULATORS
+int Multiplexer::add(PosixQueue             *queue,
+                     Format                  format,
+                     const MessageCallback&  callback)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(queue);
+
+    const int fd = queue->fileDescriptor();
+    if (!isValid() || fd == -1) {
+        BALL_LOG_ERROR << "Unable to multiplex the message queue "
+                       << queue->name()
+                       << " because it is closed or because message queues "
+                          "cannot be waited on using epoll on this platform."
+                       << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    const bsl::shared_ptr<Registration> registration =
+        bsl::allocate_shared<Registration>(
+            d_allocator_p, queue, format, callback, d_allocator_p);
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (!d_registrations.insert(bsl::make_pair(fd, registration)).second) {
+        BALL_LOG_ERROR << "The message queue " << queue->name()
+                       << " is already registered." << BALL_LOG_END;
+        return 2;                                                     // RETURN
+    }
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    epoll_event event = epoll_event();
+    event.events      = EPOLLIN;
+    event.data.fd     = fd;
+    if (epoll_ctl(d_epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        BALL_LOG_ERROR << "Unable to add the message queue " << queue->name()
+                       << " to the epoll set: " << strerror(errno)
+                       << BALL_LOG_END;
+        d_registrations.erase(fd);
+        return 3;                                                     // RETURN
+    }
+#endif
+
+    return 0;
+}
+
+int Multiplexer::remove(PosixQueue *queue)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(queue);
+
+    const int fd = queue->fileDescriptor();
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (fd == -1 || !d_registrations.erase(fd)) {
+        return 1;                                                     // RETURN
+    }
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    // Note that the 'event' argument is ignored, but must not be null on
+    // kernels older than 2.6.9.
+    epoll_event event = epoll_event();
+    if (epoll_ctl(d_epollFd, EPOLL_CTL_DEL, fd, &event) == -1) {
+        BALL_LOG_WARN << "Unable to remove the message queue " << queue->name()
+                      << " from the epoll set: " << strerror(errno)
+                      << BALL_LOG_END;
+    }
+#endif
+
+    return 0;
+}
+
+int Multiplexer::start()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    if (!isValid() || d_thread != bslmt::ThreadUtil::invalidHandle()) {
+        return 1;                                                     // RETURN
+    }
+
+    d_shuttingDown = false;
+    const int rc   = bslmt::ThreadUtil::create(
+               &d_thread, bdlf::MemFnUtil::memFn(&Multiplexer::run, this));
+    if (rc) {
+        BALL_LOG_ERROR << "Unable to start multiplexer thread. "
+                          "bslmt::ThreadUtil::create returned rc="
+                       << rc << BALL_LOG_END;
+        d_thread = bslmt::ThreadUtil::invalidHandle();
+        return 2;                                                     // RETURN
+    }
+
+    return 0;
+}
+
+void Multiplexer::stop()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    if (d_thread == bslmt::ThreadUtil::invalidHandle()) {
+        // Thread never started. Nothing to join.
+        return;                                                       // RETURN
+    }
+
+    d_shuttingDown = true;
+
+    const bsls::Types::Uint64 one = 1;
+    if (write(d_eventFd, &one, sizeof one) == -1) {
+        BALL_LOG_ERROR << "Unable to signal the multiplexer thread: "
+                       << strerror(errno) << BALL_LOG_END;
+    }
+
+    const int rc = bslmt::ThreadUtil::join(d_thread);
+    if (rc) {
+        BALL_LOG_ERROR << "Unable to join multiplexer thread. "
+                          "bslmt::ThreadUtil::join returned rc="
+                       << rc << BALL_LOG_END;
+    }
+    d_thread = bslmt::ThreadUtil::invalidHandle();
+
+    // Reset the eventfd's counter so that the thread can be restarted. The
+    // eventfd is non-blocking, so 'EAGAIN' means that the counter is already
+    // zero.
+    bsls::Types::Uint64 count;
+    while (read(d_eventFd, &count, sizeof count) == -1) {
+        if (errno != EINTR) {
+            if (errno != EAGAIN) {
+                BALL_LOG_ERROR << "Unable to reset the multiplexer's eventfd: "
+                               << strerror(errno) << BALL_LOG_END;
+            }
+            break;
+        }
+    }
+}
+
+void Multiplexer::run()
+{
+#ifdef BSLS_PLATFORM_OS_LINUX
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    epoll_event events[k_MAX_EVENTS];
+    while (!d_shuttingDown.load()) {
+        const int numReady = epoll_wait(d_epollFd, events, k_MAX_EVENTS, -1);
+        if (numReady == -1) {
+            if (errno != EINTR) {
+                BALL_LOG_ERROR << "epoll_wait failed: " << strerror(errno)
+                               << BALL_LOG_END;
+                return;                                               // RETURN
+            }
+            continue;
+        }
+
+        for (int i = 0; i < numReady && !d_shuttingDown.load(); ++i) {
+            if (events[i].data.fd != d_eventFd) {
+                dispatch(events[i].data.fd);
+            }
+        }
+    }
+#endif
+}
+
+void Multiplexer::dispatch(int fileDescriptor)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    bsl::shared_ptr<Registration> registration;
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+        const RegistrationMap::const_iterator found =
+            d_registrations.find(fileDescriptor);
+        if (found == d_registrations.end()) {
+            // The queue was removed after 'epoll_wait' reported it ready.
+            return;                                                   // RETURN
+        }
+        registration = found->second;
+    }
+
+    // Payloads unpacked from a packed message do not make the queue
+    // readable, so they are all dispatched now, even past the limit.
+    for (int i = 0; i < k_MAX_MESSAGES_PER_WAKEUP ||
+                    registration->d_receiver.hasUnpackedPayloads();
+         ++i) {
+        unsigned  priority;
+        const int rc = registration->d_receiver.tryReceive(
+                                &registration->d_messageBuffer, &priority);
+        if (rc == 0) {
+            registration->d_callback(&registration->d_messageBuffer,
+                                     priority);
+        }
+        else if (rc == int(PosixQueue::Receive::e_EMPTY)) {
+            // Another receiver got there first, or we drained the queue.
+            return;                                                   // RETURN
+        }
+        else {
+            BALL_LOG_ERROR << "Unable to receive message from message queue "
+                           << registration->d_receiver.posixQueue().name()
+                           << ": "
+                           << registration->d_receiver.description(rc)
+                           << BALL_LOG_END;
+            return;                                                   // RETURN
+        }
+    }
+}
+
+// ACCESSORS
+bool Multiplexer::isValid() const
+{
+    return d_epollFd != -1 && d_eventFd != -1;
+}
+
+int Multiplexer::numQueues() const
+{
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    return int(d_registrations.size());
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,126 @@
+#ifndef INCLUDED_IPCMQ_MULTIPLEXER
+#define INCLUDED_IPCMQ_MULTIPLEXER
+
+#include <ipcmq_format.h>
+
+#include <bsl_functional.h>
+#include <bsl_memory.h>
+#include <bsl_string.h>
+#include <bsl_unordered_map.h>
+
+#include <bslmt_mutex.h>
+#include <bslmt_threadutil.h>
+
+#include <bsls_atomic.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+class PosixQueue;
+
+                             // =================
+                             // class Multiplexer
+                             // =================
+
+class Multiplexer {
+    // This class manages a thread that receives messages from any number of
+    // message queues, invoking a callback associated with each queue for
+    // every message received from that queue. The thread waits on all of the
+    // queues at once using 'epoll', and is woken for shutdown using an
+    // 'eventfd', so it consumes no CPU while the queues are idle and stops
+    // without delay. This class is supported only on Linux, where message
+    // queue descriptors are file descriptors. On other platforms, 'add' and
+    // 'start' always fail.
+
+  public:
+    // PUBLIC TYPES
+    typedef bsl::function<void(bsl::string *, unsigned)> MessageCallback;
+
+  private:
+    // PRIVATE TYPES
+    struct Registration;
+
+    typedef bsl::unordered_map<int, bsl::shared_ptr<Registration> >
+        RegistrationMap;  // keyed by file descriptor
+
+    // DATA
+    int                        d_epollFd;
+    int                        d_eventFd;
+    bsls::AtomicInt            d_shuttingDown;
+    mutable bslmt::Mutex       d_mutex;  // protects 'd_registrations'
+    RegistrationMap            d_registrations;
+    bslmt::ThreadUtil::Handle  d_thread;
+    bslma::Allocator          *d_allocator_p;
+
+    Multiplexer(const Multiplexer&);             // = delete
+    Multiplexer& operator=(const Multiplexer&);  // = delete
+
+  public:
+    // CREATORS
+    explicit Multiplexer(bslma::Allocator *allocator = 0);
+        // Create a 'Multiplexer' object having no queues. Optionally specify
+        // an 'allocator' used to supply memory. Note that the thread managed
+        // by this object is not started until 'start' is called.
+
+    ~Multiplexer();
+        // Stop the thread managed by this object, if it is running, and then
+        // destroy this object. Note that the queues registered with this
+        // object are not closed.
+
+    // MANIPULATORS
+    int add(PosixQueue             *queue,
+            Format                  format,
+            const MessageCallback&  callback);
+        // Register the specified 'queue', so that the specified 'callback' is
+        // invoked with every message received from 'queue', decoded according
+        // to the specified 'format', and with the message's priority. Return
+        // zero on success or a nonzero value otherwise. This function may be
+        // called whether or not this object is running, and may be called
+        // from within a callback. The behavior is undefined unless 'queue' is
+        // open for reading, is not already registered with this object, and
+        // remains open until it is removed or this object is destroyed.
+
+    int remove(PosixQueue *queue);
+        // Deregister the specified 'queue', so that no more messages are
+        // received from it by this object. Return zero on success or a
+        // nonzero value if 'queue' is not registered with this object. Note
+        // that when this function is called from a thread other than the
+        // thread managed by this object, a callback invocation for 'queue'
+        // already in progress may still be in progress when this function
+        // returns.
+
+    int start();
+        // Start the thread that receives messages from the registered queues.
+        // Return zero on success or a nonzero value if the thread is already
+        // running or cannot be started.
+
+    void stop();
+        // Wake the thread managed by this object and wait for it to finish.
+        // Do nothing if the thread is not running. The behavior is undefined
+        // if this function is called from within a callback.
+
+    // ACCESSORS
+    bool isValid() const;
+        // Return whether this object was able to acquire the system resources
+        // it needs to wait on queues.
+
+    int numQueues() const;
+        // Return the number of queues currently registered with this object.
+
+  private:
+    // PRIVATE MANIPULATORS
+    void run();
+        // Wait for messages on the registered queues and dispatch them to
+        // their callbacks until 'stop' is called.
+
+    void dispatch(int fileDescriptor);
+        // Receive the messages available on the registered queue having the
+        // specified 'fileDescriptor', up to a limit, and invoke its callback
+        // with each.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -0,0 +1,167 @@
+
+#include <ipcmq_packedbacklog.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsl_cstring.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+
+                            // -------------------
+                            // class PackedBacklog
+                            // -------------------
+
+// CREATORS
+PackedBacklog::PackedBacklog(bslma::Allocator *allocator)
+: d_arena(allocator)
+, d_payloads(allocator)
+, d_next(0)
+, d_numPending(0)
+{
+}
+
+// MANIPULATORS
+void PackedBacklog::push(const bslstl::StringRef *begin,
+                         const bslstl::StringRef *end,
+                         unsigned                 priority)
+{
+    BSLS_ASSERT(begin <= end);
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    for (const bslstl::StringRef *payload = begin; payload != end; ++payload) {
+        PosixQueue::MessageDescriptor descriptor;
+        descriptor.d_offset   = d_arena.length();
+        descriptor.d_length   = payload->length();
+        descriptor.d_priority = priority;
+
+        d_arena.reserve(descriptor.d_offset + descriptor.d_length);
+        bsl::memcpy(d_arena.data() + descriptor.d_offset,
+                    payload->data(),
+                    descriptor.d_length);
+        d_arena.setLength(descriptor.d_offset + descriptor.d_length);
+        d_payloads.push_back(descriptor);
+    }
+
+    d_numPending = int(d_payloads.size() - d_next);
+}
+
+bool PackedBacklog::pop(bsl::string *payload, unsigned *priority)
+{
+    BSLS_ASSERT(payload);
+
+    if (isEmpty()) {
+        return false;                                                 // RETURN
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (d_next == d_payloads.size()) {
+        // Another thread took the last payload.
+        return false;                                                 // RETURN
+    }
+
+    const PosixQueue::MessageDescriptor& descriptor = d_payloads[d_next++];
+    payload->assign(d_arena.data() + descriptor.d_offset,
+                    descriptor.d_length);
+    if (priority) {
+        *priority = descriptor.d_priority;
+    }
+
+    // Once every payload is delivered, start over at the beginning of the
+    // buffer.
+    if (d_next == d_payloads.size()) {
+        d_arena.clear();
+        d_payloads.clear();
+        d_next = 0;
+    }
+    d_numPending = int(d_payloads.size() - d_next);
+
+    return true;
+}
+
+bool PackedBacklog::pop(MessageBuffer *payload, unsigned *priority)
+{
+    BSLS_ASSERT(payload);
+
+    if (isEmpty()) {
+        return false;                                                 // RETURN
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (d_next == d_payloads.size()) {
+        // Another thread took the last payload.
+        return false;                                                 // RETURN
+    }
+
+    const PosixQueue::MessageDescriptor& descriptor = d_payloads[d_next++];
+    payload->reserve(descriptor.d_length);
+    bsl::memcpy(payload->data(),
+                d_arena.data() + descriptor.d_offset,
+                descriptor.d_length);
+    payload->setLength(descriptor.d_length);
+    if (priority) {
+        *priority = descriptor.d_priority;
+    }
+
+    if (d_next == d_payloads.size()) {
+        d_arena.clear();
+        d_payloads.clear();
+        d_next = 0;
+    }
+    d_numPending = int(d_payloads.size() - d_next);
+
+    return true;
+}
+
+bool PackedBacklog::popAll(
+                         MessageBuffer                              *arena,
+                         bsl::vector<PosixQueue::MessageDescriptor> *payloads)
+{
+    BSLS_ASSERT(arena);
+    BSLS_ASSERT(payloads);
+
+    if (isEmpty()) {
+        return false;                                                 // RETURN
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (d_next == d_payloads.size()) {
+        // Another thread took the last payload.
+        return false;                                                 // RETURN
+    }
+
+    // The pending payloads are contiguous at the end of the buffer, so they
+    // are copied at once and their offsets shifted.
+    const bsl::size_t base   = d_payloads[d_next].d_offset;
+    const bsl::size_t length = d_arena.length() - base;
+    arena->reserve(length);
+    bsl::memcpy(arena->data(), d_arena.data() + base, length);
+    arena->setLength(length);
+
+    payloads->assign(d_payloads.begin() + d_next, d_payloads.end());
+    for (bsl::size_t i = 0; i < payloads->size(); ++i) {
+        (*payloads)[i].d_offset -= base;
+    }
+
+    d_arena.clear();
+    d_payloads.clear();
+    d_next       = 0;
+    d_numPending = 0;
+
+    return true;
+}
+
+// ACCESSORS
+bool PackedBacklog::isEmpty() const
+{
+    return d_numPending.load() == 0;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
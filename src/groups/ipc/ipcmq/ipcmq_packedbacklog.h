@@ -0,0 +1,82 @@
+#ifndef INCLUDED_IPCMQ_PACKEDBACKLOG
+#define INCLUDED_IPCMQ_PACKEDBACKLOG
+
+#include <ipcmq_messagebuffer.h>
+#include <ipcmq_posixqueue.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bslmt_mutex.h>
+
+#include <bsls_atomic.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+                            // ===================
+                            // class PackedBacklog
+                            // ===================
+
+class PackedBacklog {
+    // This class holds the payloads of packed messages that were received but
+    // not yet delivered. A receiver that unpacks a message delivers its first
+    // payload and adds the rest to the backlog, from which later receive
+    // operations take them, in order, before receiving another message. The
+    // payloads are copied into one buffer, which keeps its capacity once the
+    // backlog is empty, so that a backlog that is repeatedly filled and
+    // emptied allocates no more memory. This class is thread-safe.
+
+    // DATA
+    mutable bslmt::Mutex                       d_mutex;  // protects all below
+    MessageBuffer                              d_arena;
+    bsl::vector<PosixQueue::MessageDescriptor> d_payloads;
+    bsl::size_t                                d_next;
+        // index within 'd_payloads' of the next payload to deliver
+
+    bsls::AtomicInt                            d_numPending;
+        // so that 'isEmpty' does not lock
+
+    PackedBacklog(const PackedBacklog&);             // = delete
+    PackedBacklog& operator=(const PackedBacklog&);  // = delete
+
+  public:
+    // CREATORS
+    explicit PackedBacklog(bslma::Allocator *allocator = 0);
+        // Create an empty 'PackedBacklog'. Optionally specify an 'allocator'
+        // used to supply memory.
+
+    // MANIPULATORS
+    void push(const bslstl::StringRef *begin,
+              const bslstl::StringRef *end,
+              unsigned                 priority);
+        // Add to the end of this backlog a copy of each payload in the
+        // specified range '[begin, end)', each having the specified
+        // 'priority'.
+
+    bool pop(bsl::string *payload, unsigned *priority);
+    bool pop(MessageBuffer *payload, unsigned *priority);
+        // If this backlog is not empty, remove its first payload, assign it to
+        // the specified 'payload', assign its priority through the specified
+        // 'priority' unless 'priority' is zero, and return 'true'. Otherwise,
+        // return 'false'.
+
+    bool popAll(MessageBuffer                              *arena,
+                bsl::vector<PosixQueue::MessageDescriptor> *payloads);
+        // If this backlog is not empty, remove all of its payloads, assign
+        // them to the specified 'arena', assign to the specified 'payloads' a
+        // descriptor of each within 'arena', in order, and return 'true'.
+        // Otherwise, return 'false'.
+
+    // ACCESSORS
+    bool isEmpty() const;
+        // Return whether this backlog has no payloads. Note that another
+        // thread may change the answer as soon as it is returned.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
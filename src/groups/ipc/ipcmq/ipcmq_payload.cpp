@@ -0,0 +1,112 @@
+
+#include <ipcmq_payload.h>
+
+#include <ball_log.h>
+
+#include <bsl_algorithm.h>
+
+#include <errno.h>     // errno
+#include <fcntl.h>     // open
+#include <string.h>    // strerror
+#include <sys/mman.h>  // mmap, munmap, madvise
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, unlink
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.PAYLOAD";
+
+}  // close unnamed namespace
+
+// CREATORS
+Payload::Payload(bslma::Allocator *basicAllocator)
+: d_buffer(basicAllocator)
+, d_mapping_p(0)
+, d_mappingLength(0)
+{
+}
+
+Payload::~Payload()
+{
+    reset();
+}
+
+// MANIPULATORS
+void Payload::reset()
+{
+    if (d_mapping_p) {
+        munmap(const_cast<char *>(d_mapping_p), d_mappingLength);
+        d_mapping_p     = 0;
+        d_mappingLength = 0;
+    }
+
+    d_buffer.clear();
+}
+
+int Payload::mapAndRemoveFile(const char *path)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(path);
+
+    reset();
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to open the file \"" << path
+                       << "\" for reading: " << strerror(errno)
+                       << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    // Delete the file right away. Its storage remains until it's closed and
+    // unmapped, and nobody else needs to find it by name.
+    if (unlink(path)) {
+        BALL_LOG_WARN << "Unable to remove file \"" << path
+                      << "\": " << strerror(errno) << BALL_LOG_END;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status)) {
+        BALL_LOG_ERROR << "Unable to determine the size of the file \""
+                       << path << "\": " << strerror(errno) << BALL_LOG_END;
+        close(fd);
+        return 2;                                                     // RETURN
+    }
+
+    if (status.st_size == 0) {
+        // success, and there's nothing to map
+        close(fd);
+        return 0;                                                     // RETURN
+    }
+
+    const bsl::size_t size    = status.st_size;
+    void *const       address = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping remains valid after the descriptor is closed.
+    if (address == MAP_FAILED) {
+        BALL_LOG_ERROR << "Unable to map the file \"" << path
+                       << "\" into memory: " << strerror(errno)
+                       << BALL_LOG_END;
+        return 3;                                                     // RETURN
+    }
+
+    // Payloads are usually read from front to back, so ask the kernel to read
+    // ahead aggressively and to drop pages once they've been read. This is
+    // only a hint, so failure doesn't matter.
+    madvise(address, size, MADV_SEQUENTIAL);
+
+    d_mapping_p     = static_cast<const char *>(address);
+    d_mappingLength = size;
+    return 0;
+}
+
+void Payload::swap(Payload& other)
+{
+    d_buffer.swap(other.d_buffer);
+    bsl::swap(d_mapping_p, other.d_mapping_p);
+    bsl::swap(d_mappingLength, other.d_mappingLength);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,160 @@
+#ifndef INCLUDED_IPCMQ_PAYLOAD
+#define INCLUDED_IPCMQ_PAYLOAD
+
+#include <ipcmq_messagebuffer.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+
+#include <bslma_usesbslmaallocator.h>
+
+#include <bslmf_nestedtraitdeclaration.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+                               // =============
+                               // class Payload
+                               // =============
+
+class Payload {
+    // This class provides read-only access to the payload of a received
+    // message, wherever the payload is. A payload that was in the message
+    // itself (or in shared memory) is held in a 'MessageBuffer'. A payload
+    // that was in an external file is instead mapped into memory directly
+    // from the file, so that reading it copies nothing, and pages of the
+    // file are read from the page cache as they are accessed. The file is
+    // deleted as soon as it is mapped, and its storage is reclaimed by the
+    // system once the mapping is released, which happens when this object
+    // is reset, reused, or destroyed.
+
+    // DATA
+    MessageBuffer  d_buffer;
+    const char    *d_mapping_p;      // zero unless a file is mapped
+    bsl::size_t    d_mappingLength;
+
+    Payload(const Payload&);             // = delete
+    Payload& operator=(const Payload&);  // = delete
+
+  public:
+    // TRAITS
+    BSLMF_NESTED_TRAIT_DECLARATION(Payload, bslma::UsesBslmaAllocator);
+
+    // CREATORS
+    explicit Payload(bslma::Allocator *basicAllocator = 0);
+        // Create an empty 'Payload'. Optionally specify a 'basicAllocator'
+        // used to supply memory. If 'basicAllocator' is zero, the currently
+        // installed default allocator is used.
+
+    ~Payload();
+        // Release any mapping held by this object, and destroy this object.
+
+    // MANIPULATORS
+    void reset();
+        // Release any mapping held by this object and make this object empty,
+        // keeping the capacity of its buffer.
+
+    MessageBuffer& buffer();
+        // Return a reference providing modifiable access to the buffer that
+        // holds the contents of this object when no file is mapped. The
+        // behavior is undefined unless 'isMapped()' is 'false'.
+
+    int mapAndRemoveFile(const char *path);
+        // Release any mapping held by this object, map into memory the
+        // contents of the file at the specified 'path', and delete the file.
+        // Make the contents of this object the contents of the file. Return
+        // zero on success or a nonzero value otherwise, in which case this
+        // object is empty. Note that the file is deleted even if this function
+        // fails, unless the file cannot be opened.
+
+    void swap(Payload& other);
+        // Exchange the contents of this object with those of the specified
+        // 'other' object. The behavior is undefined unless both objects use
+        // the same allocator.
+
+    // ACCESSORS
+    const char *data() const;
+        // Return a pointer providing non-modifiable access to the contents of
+        // this object.
+
+    bsl::size_t length() const;
+        // Return the length of the contents of this object.
+
+    bslstl::StringRef stringRef() const;
+        // Return a reference to the contents of this object.
+
+    bool isMapped() const;
+        // Return whether the contents of this object are a file mapped into
+        // memory.
+
+    bslma::Allocator *allocator() const;
+        // Return the allocator used by this object to supply memory.
+};
+
+// FREE FUNCTIONS
+void swap(Payload& a, Payload& b);
+    // Exchange the contents of the specified 'a' and 'b'. The behavior is
+    // undefined unless both objects use the same allocator.
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                               // -------------
+                               // class Payload
+                               // -------------
+
+// MANIPULATORS
+inline
+MessageBuffer& Payload::buffer()
+{
+    BSLS_ASSERT(!d_mapping_p);
+
+    return d_buffer;
+}
+
+// ACCESSORS
+inline
+const char *Payload::data() const
+{
+    return d_mapping_p ? d_mapping_p : d_buffer.data();
+}
+
+inline
+bsl::size_t Payload::length() const
+{
+    return d_mapping_p ? d_mappingLength : d_buffer.length();
+}
+
+inline
+bslstl::StringRef Payload::stringRef() const
+{
+    return bslstl::StringRef(data(), length());
+}
+
+inline
+bool Payload::isMapped() const
+{
+    return d_mapping_p;
+}
+
+inline
+bslma::Allocator *Payload::allocator() const
+{
+    return d_buffer.allocator();
+}
+
+// FREE FUNCTIONS
+inline
+void swap(Payload& a, Payload& b)
+{
+    a.swap(b);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -1,24 +1,18 @@
 
 #include <ipcmq_posixqueue.h>
-#include <ipcu_algoutil.h>
+#include <ipcmq_messagebuffer.h>
+#include <ipcmq_systemlimits.h>
 
 #include <ball_log.h>
 
-#include <bdlb_arrayutil.h>
-
-#include <bdlb_guid.h>
-#include <bdlb_guidutil.h>
-
 #include <bslma_default.h>
 
-#include <bslmt_once.h>
-
 #include <bsls_assert.h>
+#include <bsls_platform.h>
 #include <bsls_timeinterval.h>
 
 #include <errno.h>     // error codes
 #include <fcntl.h>     // file open constants
-#include <limits.h>    // _POSIX_*_MAX
 #include <mqueue.h>    // mq_*
 #include <string.h>    // strerror
 #include <sys/stat.h>  // file mode constants
@@ -113,242 +107,163 @@ Receive::Result convertReceiveError(int errorNumber)
     }
 }
 
-void randomQueueName(bsl::string *outputPtr)
-{
-    BSLS_ASSERT_SAFE(outputPtr);
-    bsl::string& output = *outputPtr;
-
-    output.assign(1, '/');
-    output += bdlb::GuidUtil::guidToString(bdlb::GuidUtil::generate());
-
-    // Shrink, if necessary, to fit minimum POSIX size spec.
-    const bsl::string::size_type sizes[] = {
-        output.size(), _POSIX_PATH_MAX - 1, _POSIX_NAME_MAX - 1};
-    output.resize(*bsl::min_element(sizes, bdlb::ArrayUtil::end(sizes)));
-}
+// pessimistically small fallback value, used until a queue is opened
+const long FALLBACK_MAX_MESSAGE_SIZE = 1024;
 
-void closeAndUnlinkTemporaryQueue(mqd_t queue, const bsl::string& name)
+timespec toTimespec(const bsls::TimeInterval& interval)
 {
-    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
-
-    int rc = mq_close(queue);
-    if (rc == -1) {
-        BALL_LOG_WARN << "Unable to close temporary queue. errno=" << errno
-                      << BALL_LOG_END;
-    }
+    timespec result;
+    result.tv_sec   = interval.seconds();
+    result.tv_nsec  = interval.nanoseconds();
 
-    rc = mq_unlink(name.c_str());
-    if (rc == -1) {
-        BALL_LOG_WARN << "Unable to unlink temporary queue. errno=" << errno
-                      << BALL_LOG_END;
-    }
+    return result;
 }
 
-int temporaryQueue(const mq_attr *inputAttributes, mq_attr *outputAttributes)
-    // Create and then destroy a message queue with a randomly generated name.
-    // If the specified 'inputAttributes' is not zero, specify those attributes
-    // when creating the queue. If the specified 'outputAttributes' is not
-    // zero, query the created queue's attributes and store them in
-    // 'outputAttributes' before destroying the queue. If the generated queue
-    // name is not unique, retry an unspecified number of times with a
-    // different randomly generated name. Return zero on success. If the
-    // maximum number of retries is reached, return the nonzero 'errno'. If the
-    // creation of the queue fails for some other reason, return the nonzero
-    // 'errno'. If 'outputAttributes' is not zero and the querying of the
-    // queue's attributes fails, return the nonzero 'errno'.
-{
-    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
-
-    bsl::string name;
-    mqd_t       queue;
-    const int   k_MAX_ATTEMPTS = 3;
-    for (int attempt = 1; true; ++attempt) {
-        randomQueueName(&name);
-        // The choice of "write only" is arbitrary. What matters is "create
-        // only."
-        const int openFlags   = O_WRONLY | O_CREAT | O_EXCL;
-        const int permissions = 0600;  // user read/write only
-        queue = mq_open(name.c_str(), openFlags, permissions, inputAttributes);
-
-        // error?
-        if (queue == mqd_t(-1)) {
-            switch (errno) {
-              case EEXIST:
-                // The one case we can handle. Maybe our 'name' was not unique,
-                // so try again unless we've already tried too many times.
-                if (attempt != k_MAX_ATTEMPTS) {
-                    break;  // break from switch to re-enter loop
-                }
-              default: {
-                BALL_LOG_TRACE
-                    << "Unable to create a temporary queue with name=" << name
-                    << " got errno=" << errno
-                    << " which corresponds to the system error: "
-                    << systemError(errno) << BALL_LOG_END;
-                return errno;                                         // RETURN
-              }
-            }
-        }
-        else {
-            // success
-            break;  // break from loop so the success code below can execute
-        }
-    }
-
-    // 'queue' now refers to an open message queue. Get its attributes, if
-    // requested. In any case, unlink and close the queue.
-    int rc = 0;
+// A deadline that has always already passed. 'mq_timedsend' and
+// 'mq_timedreceive' return 'ETIMEDOUT' immediately when given this deadline
+// and the operation would otherwise block, which allows a single call to be
+// non-blocking without modifying the 'O_NONBLOCK' flag of the descriptor.
+const timespec k_EXPIRED_DEADLINE = {0, 0};
+
+Receive::Result receiveImp(mqd_t           queue,
+                           char           *buffer,
+                           bsl::size_t     capacity,
+                           bsl::size_t    *length,
+                           unsigned       *priority,
+                           const timespec *deadline)
+    // Receive the next message from the specified 'queue' into the specified
+    // 'buffer' having the specified 'capacity', load its length into the
+    // specified 'length', and, if the specified 'priority' is not zero, load
+    // its priority into 'priority'. Wait for a message until the specified
+    // 'deadline', or indefinitely if 'deadline' is zero. Return zero on
+    // success or a nonzero value otherwise.
+{
+    BSLS_ASSERT_OPT(buffer);
+    BSLS_ASSERT_OPT(length);
+
+    const ssize_t rc =
+        deadline
+            ? mq_timedreceive(queue, buffer, capacity, priority, deadline)
+            : mq_receive(queue, buffer, capacity, priority);
 
-    if (outputAttributes) {
-        rc = mq_getattr(queue, outputAttributes);
-        if (rc == -1) {
-            BALL_LOG_WARN
-                << "Unable to get attributes of temporary queue. Using "
-                   "fallback values. errno="
-                << errno << BALL_LOG_END;
-            BSLS_ASSERT_SAFE(errno);
-            rc = errno;
-        }
+    if (rc == -1) {
+        // A blocking descriptor reports an empty queue as a timeout when
+        // given an expired deadline, while a non-blocking descriptor reports
+        // it as 'EAGAIN'. Either way, the queue is empty.
+        return errno == ETIMEDOUT && deadline == &k_EXPIRED_DEADLINE
+                   ? Receive::e_EMPTY
+                   : convertReceiveError(errno);                      // RETURN
     }
 
-    closeAndUnlinkTemporaryQueue(queue, name);
+    // On success, the returned value is the size of the message received.
+    BSLS_ASSERT_SAFE(rc >= 0);
+    BSLS_ASSERT_OPT(bsl::size_t(rc) <= capacity);
+    *length = rc;
 
-    return rc;
+    return Receive::e_SUCCESS;
 }
 
-// pessimistically small fallback values
-const long FALLBACK_MAX_MESSAGES     = 1;
-const long FALLBACK_MAX_MESSAGE_SIZE = 1024;
+Receive::Result receiveBatchImp(mqd_t                           queue,
+                                long                            maxMessageSize,
+                                MessageBuffer                  *arena,
+                                bsl::vector<MessageDescriptor> *descriptors,
+                                bsl::size_t                     maxMessages,
+                                const timespec                 *firstDeadline,
+                                const timespec                 *deadline)
+    // Receive up to the specified 'maxMessages' messages from the specified
+    // 'queue', whose maximum message size is the specified 'maxMessageSize',
+    // into the specified 'arena', and describe each in the specified
+    // 'descriptors'. Wait for the first message until the specified
+    // 'firstDeadline', or indefinitely if 'firstDeadline' is zero, and for
+    // subsequent messages until the specified 'deadline'. Return zero if at
+    // least one message was received, or a nonzero value otherwise.
+{
+    BSLS_ASSERT(arena);
+    BSLS_ASSERT(descriptors);
+    BSLS_ASSERT(0 < maxMessages);
+    BSLS_ASSERT(deadline);
+
+    arena->clear();
+    descriptors->clear();
+
+    while (descriptors->size() < maxMessages) {
+        const timespec *const wait =
+            descriptors->empty() ? firstDeadline : deadline;
+
+        // 'mq_receive' requires room for a maximum size message, but writes
+        // only the message itself, so the arena grows by only that much.
+        arena->reserve(arena->length() + maxMessageSize);
+
+        char *const   destination = arena->data() + arena->length();
+        unsigned      priority;
+        const ssize_t rc =
+            wait ? mq_timedreceive(
+                       queue, destination, maxMessageSize, &priority, wait)
+                 : mq_receive(queue, destination, maxMessageSize, &priority);
 
-mq_attr systemDefaults()
-    // Return the attributes of a message queue created without specifying any
-    // attributes.
-{
-    static const mq_attr *ptr = 0;
-    BSLMT_ONCE_DO
-    {
-        BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
-
-        static mq_attr fallbackAttributes;
-        fallbackAttributes.mq_maxmsg      = FALLBACK_MAX_MESSAGES;
-        fallbackAttributes.mq_msgsize     = FALLBACK_MAX_MESSAGE_SIZE;
-
-        static mq_attr outputAttributes;
+        if (rc == -1) {
+            const int errorNumber = errno;
+            if (!descriptors->empty()) {
+                // Keep what we have. If the error was anything other than
+                // the queue being empty, the next call will report it.
+                break;
+            }
 
-        const mq_attr *const inputAttributesPtr = 0;  // parameter not used
-        if (temporaryQueue(inputAttributesPtr, &outputAttributes)) {
-            // error
-            ptr = &fallbackAttributes;
+            return errorNumber == ETIMEDOUT && wait == &k_EXPIRED_DEADLINE
+                       ? Receive::e_EMPTY
+                       : convertReceiveError(errorNumber);            // RETURN
         }
-        else {
-            // success
-            ptr = &outputAttributes;
-        }
-
-        BSLS_ASSERT_SAFE(ptr);
-        BALL_LOG_DEBUG << "system default mq_attr calculated to be: mq_maxmsg="
-                       << ptr->mq_maxmsg << " mq_msgsize=" << ptr->mq_msgsize
-                       << BALL_LOG_END;
-    }
-
-    BSLS_ASSERT_SAFE(ptr);
-    return *ptr;
-}
 
-long systemDefaultMaxMessages()
-{
-    return systemDefaults().mq_maxmsg;
-}
-
-long systemDefaultMaxMessageSize()
-{
-    return systemDefaults().mq_msgsize;
-}
-
-bool canCreateQueueWith(long maxMessages, long maxMessageSize)
-    // Return whether a message queue can be created with the specified
-    // 'maxMessages' as its 'mq_msgmax' attribute and with the specified
-    // 'maxMessageSize' as its 'mq_msgsize' attribute.
-{
-    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
-
-    mq_attr inputAttributes;
-    inputAttributes.mq_maxmsg  = maxMessages;
-    inputAttributes.mq_msgsize = maxMessageSize;
-
-    mq_attr *const outputAttributesPtr = 0;  // parameter not used
-    const int      rc = temporaryQueue(&inputAttributes, outputAttributesPtr);
-
-    return rc == 0;
-}
-
-bool canCreateQueueWithMaxMessageSize(long maxMessageSize)
-    // Return whether a message queue can be created with the specified
-    // 'maxMessageSize' as its 'mq_msgsize' attribute when its 'mq_msgmax'
-    // attribute is defaulted.
-{
-    return canCreateQueueWith(systemDefaultMaxMessages(), maxMessageSize);
-}
-
-bool canCreateQueueWithMaxMessages(long maxMessages)
-    // Return whether a message queue can be created with the specified
-    // 'maxMessages' as its 'mq_msgmax' attribute when its 'mq_msgsize'
-    // attribute is defaulted.
-{
-    return canCreateQueueWith(maxMessages, systemDefaultMaxMessageSize());
-}
-
-long systemMaxMaxMessages()
-    // Return the largest value for a queue's 'mq_msgmax' attribute that this
-    // system will allow when the queue's 'mq_msgsize' attribute is defaulted.
-{
-    static const long *ptr = 0;
-    BSLMT_ONCE_DO
-    {
-        BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+        MessageDescriptor descriptor;
+        descriptor.d_offset   = arena->length();
+        descriptor.d_length   = rc;
+        descriptor.d_priority = priority;
+        descriptors->push_back(descriptor);
 
-        static const long value = ipcu::AlgoUtil::findMaxIf(
-                   systemDefaultMaxMessages(), &canCreateQueueWithMaxMessages);
-        ptr = &value;
-
-        BALL_LOG_DEBUG
-            << "system maximum value for mq_msgmax calcualated to be " << value
-            << BALL_LOG_END;
+        arena->setLength(arena->length() + rc);
     }
 
-    BSLS_ASSERT_SAFE(ptr);
-    return *ptr;
+    return Receive::e_SUCCESS;
 }
 
-long systemMaxMaxMessageSize()
-    // Return the largest value for a queue's 'mq_msgsize' attribute that this
-    // system will allow when the queue's 'mq_msgmax' attribute is defaulted.
-{
-    static const long *ptr = 0;
-    BSLMT_ONCE_DO
-    {
-        BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
-
-        static const long value = ipcu::AlgoUtil::findMaxIf(
-             systemDefaultMaxMessageSize(), &canCreateQueueWithMaxMessageSize);
-        ptr = &value;
+Send::Result sendBatchImp(mqd_t                    queue,
+                          const bslstl::StringRef *begin,
+                          const bslstl::StringRef *end,
+                          bsl::size_t             *numSent,
+                          unsigned                 priority,
+                          const timespec          *deadline)
+    // Enqueue onto the specified 'queue' a message for each payload in the
+    // specified range '[begin, end)', each having the specified 'priority',
+    // until one fails, and load into the specified 'numSent' the number of
+    // messages enqueued. Wait for room in the queue until the specified
+    // 'deadline', or indefinitely if 'deadline' is zero. Return zero if every
+    // message was enqueued or a nonzero value otherwise.
+{
+    BSLS_ASSERT(begin <= end);
+    BSLS_ASSERT(numSent);
+
+    *numSent = 0;
+    for (const bslstl::StringRef *payload = begin; payload != end; ++payload) {
+        const int rc =
+            deadline ? mq_timedsend(queue,
+                                    payload->data(),
+                                    payload->length(),
+                                    priority,
+                                    deadline)
+                     : mq_send(queue,
+                               payload->data(),
+                               payload->length(),
+                               priority);
+        if (rc == -1) {
+            return errno == ETIMEDOUT && deadline == &k_EXPIRED_DEADLINE
+                       ? Send::e_FULL
+                       : convertSendError(errno);                     // RETURN
+        }
 
-        BALL_LOG_DEBUG
-            << "system maximum value for mq_msgsize calculated to be " << value
-            << BALL_LOG_END;
+        ++*numSent;
     }
 
-    BSLS_ASSERT_SAFE(ptr);
-    return *ptr;
-}
-
-timespec toTimespec(const bsls::TimeInterval& interval)
-{
-    timespec result;
-    result.tv_sec   = interval.seconds();
-    result.tv_nsec  = interval.nanoseconds();
-
-    return result;
+    return Send::e_SUCCESS;
 }
 
 }  // close unnamed namespace
@@ -442,7 +357,7 @@ Open::Result PosixQueue::open(const bslstl::StringRef& name,
             attrs.mq_maxmsg = attributes.d_maxMessages.the<int>();
         }
         else if (attributes.d_maxMessages.is<Default>()) {
-            attrs.mq_maxmsg = systemDefaultMaxMessages();
+            attrs.mq_maxmsg = defaultMaxMessages();
         }
         else {
             BSLS_ASSERT(attributes.d_maxMessages.is<Max>());
@@ -454,7 +369,7 @@ Open::Result PosixQueue::open(const bslstl::StringRef& name,
             attrs.mq_msgsize = attributes.d_maxMessageSize.the<int>();
         }
         else if (attributes.d_maxMessageSize.is<Default>()) {
-            attrs.mq_msgsize = systemDefaultMaxMessageSize();
+            attrs.mq_msgsize = defaultMaxMessageSize();
         }
         else {
             BSLS_ASSERT(attributes.d_maxMessageSize.is<Max>());
@@ -548,88 +463,228 @@ SetNonBlocking::Result PosixQueue::setNonBlocking(bool nonBlocking)
         return SetNonBlocking::e_CLOSED;                              // RETURN
     }
 
-    mq_attr attributes;
-    BSLS_ASSERT_SAFE(d_handle);
-    if (mq_getattr(d_handle->d_descriptor, &attributes) == -1) {
-        return convertBasicError<SetNonBlocking>(errno);              // RETURN
-    }
-
-    // Set the non-blocking bit to 'nonBlocking'.
-    if (nonBlocking) {
-        attributes.mq_flags |= O_NONBLOCK;
-    }
-    else {
-        attributes.mq_flags &= ~O_NONBLOCK;
-    }
+    // 'mq_setattr' ignores every field but 'mq_flags', and 'O_NONBLOCK' is
+    // the only flag defined for it, so there's no need to first fetch the
+    // current attributes with 'mq_getattr'.
+    mq_attr attributes = mq_attr();
+    attributes.mq_flags = nonBlocking ? O_NONBLOCK : 0;
 
     // Note that the third argument of 'mq_setattr' is a pointer to a 'mq_attr'
     // into which the old attributes can be written. We specify null since we
     // don't care.
+    BSLS_ASSERT_SAFE(d_handle);
     if (mq_setattr(d_handle->d_descriptor, &attributes, 0) == -1) {
         return convertBasicError<SetNonBlocking>(errno);              // RETURN
     }
 
+    d_openState = nonBlocking ? e_NONBLOCKING : e_BLOCKING;
     return SetNonBlocking::e_SUCCESS;
 }
 
 Receive::Result PosixQueue::receive(bsl::string *outputPtr, unsigned *priority)
 {
     BSLS_ASSERT_OPT(outputPtr);
-    BSLS_ASSERT_SAFE(d_handle);
 
     bsl::string& output = *outputPtr;
 
     output.resize(d_maxMessageSize);
     BSLS_ASSERT_OPT(!output.empty());
 
-    const ssize_t rc = mq_receive(
-                  d_handle->d_descriptor, &output[0], output.size(), priority);
-
-    if (rc == -1) {
-        return convertReceiveError(errno);                            // RETURN
-    }
+    bsl::size_t           messageSize = 0;
+    const Receive::Result rc          =
+        receive(&output[0], output.size(), &messageSize, priority);
 
-    // On success, the returned value is the size of the message received.
-    // Resize 'output' so that there aren't any trailing null characters;
-    const ssize_t messageSize = rc;
-    BSLS_ASSERT_OPT(ssize_t(output.size()) >= messageSize);
+    // Resize 'output' so that there aren't any trailing null characters.
     output.resize(messageSize);
 
-    return Receive::e_SUCCESS;
+    return rc;
 }
 
 Receive::Result PosixQueue::receive(bsl::string               *outputPtr,
                                     const bsls::TimeInterval&  deadline,
                                     unsigned                  *priority)
 {
-    // TODO This is a near copy/paste of the other 'receive'.
     BSLS_ASSERT_OPT(outputPtr);
-    BSLS_ASSERT_SAFE(d_handle);
 
     bsl::string& output = *outputPtr;
 
     output.resize(d_maxMessageSize);
     BSLS_ASSERT_OPT(!output.empty());
 
+    bsl::size_t           messageSize = 0;
+    const Receive::Result rc          =
+        receive(&output[0], output.size(), &messageSize, deadline, priority);
+
+    // Resize 'output' so that there aren't any trailing null characters.
+    output.resize(messageSize);
+
+    return rc;
+}
+
+Receive::Result PosixQueue::receive(char        *buffer,
+                                    bsl::size_t  capacity,
+                                    bsl::size_t *length,
+                                    unsigned    *priority)
+{
+    BSLS_ASSERT_OPT(capacity >= bsl::size_t(d_maxMessageSize));
+    BSLS_ASSERT_SAFE(d_handle);
+
+    const timespec *const blockIndefinitely = 0;
+    return receiveImp(d_handle->d_descriptor,
+                      buffer,
+                      capacity,
+                      length,
+                      priority,
+                      blockIndefinitely);
+}
+
+Receive::Result PosixQueue::receive(char                      *buffer,
+                                    bsl::size_t                capacity,
+                                    bsl::size_t               *length,
+                                    const bsls::TimeInterval&  deadline,
+                                    unsigned                  *priority)
+{
+    BSLS_ASSERT_OPT(capacity >= bsl::size_t(d_maxMessageSize));
+    BSLS_ASSERT_SAFE(d_handle);
+
     const timespec absoluteTime = toTimespec(deadline);
-    const ssize_t  rc           = mq_timedreceive(d_handle->d_descriptor,
-                                       &output[0],
-                                       output.size(),
-                                       priority,
-                                       &absoluteTime);
+    return receiveImp(d_handle->d_descriptor,
+                      buffer,
+                      capacity,
+                      length,
+                      priority,
+                      &absoluteTime);
+}
 
-    if (rc == -1) {
-        return convertReceiveError(errno);                            // RETURN
-    }
+Send::Result PosixQueue::sendBatch(const bslstl::StringRef *begin,
+                                   const bslstl::StringRef *end,
+                                   bsl::size_t             *numSent,
+                                   unsigned                 priority)
+{
+    BSLS_ASSERT_SAFE(d_handle);
 
-    // On success, the returned value is the size of the message received.
-    // Resize 'output' so that there aren't any trailing null characters;
-    const ssize_t messageSize = rc;
-    BSLS_ASSERT_OPT(ssize_t(output.size()) >= messageSize);
-    BSLS_ASSERT_SAFE(messageSize >= 0);
+    const timespec *const blockIndefinitely = 0;
+    return sendBatchImp(d_handle->d_descriptor,
+                        begin,
+                        end,
+                        numSent,
+                        priority,
+                        blockIndefinitely);
+}
+
+Send::Result PosixQueue::sendBatch(const bslstl::StringRef   *begin,
+                                   const bslstl::StringRef   *end,
+                                   bsl::size_t               *numSent,
+                                   const bsls::TimeInterval&  deadline,
+                                   unsigned                   priority)
+{
+    BSLS_ASSERT_SAFE(d_handle);
+
+    const timespec absoluteTime = toTimespec(deadline);
+    return sendBatchImp(
+        d_handle->d_descriptor, begin, end, numSent, priority, &absoluteTime);
+}
+
+Send::Result PosixQueue::trySendBatch(const bslstl::StringRef *begin,
+                                      const bslstl::StringRef *end,
+                                      bsl::size_t             *numSent,
+                                      unsigned                 priority)
+{
+    BSLS_ASSERT_SAFE(d_handle);
+
+    return sendBatchImp(d_handle->d_descriptor,
+                        begin,
+                        end,
+                        numSent,
+                        priority,
+                        &k_EXPIRED_DEADLINE);
+}
+
+Receive::Result PosixQueue::tryReceive(bsl::string *outputPtr,
+                                       unsigned    *priority)
+{
+    BSLS_ASSERT_OPT(outputPtr);
+
+    bsl::string& output = *outputPtr;
+
+    output.resize(d_maxMessageSize);
+    BSLS_ASSERT_OPT(!output.empty());
+
+    bsl::size_t           messageSize = 0;
+    const Receive::Result rc          =
+        tryReceive(&output[0], output.size(), &messageSize, priority);
+
+    // Resize 'output' so that there aren't any trailing null characters.
     output.resize(messageSize);
 
-    return Receive::e_SUCCESS;
+    return rc;
+}
+
+Receive::Result PosixQueue::tryReceive(char        *buffer,
+                                       bsl::size_t  capacity,
+                                       bsl::size_t *length,
+                                       unsigned    *priority)
+{
+    BSLS_ASSERT_OPT(capacity >= bsl::size_t(d_maxMessageSize));
+    BSLS_ASSERT_SAFE(d_handle);
+
+    return receiveImp(d_handle->d_descriptor,
+                      buffer,
+                      capacity,
+                      length,
+                      priority,
+                      &k_EXPIRED_DEADLINE);
+}
+
+Receive::Result PosixQueue::receiveBatch(
+                                  MessageBuffer                  *arena,
+                                  bsl::vector<MessageDescriptor> *descriptors,
+                                  bsl::size_t                     maxMessages)
+{
+    BSLS_ASSERT_SAFE(d_handle);
+
+    const timespec *const blockIndefinitely = 0;
+    return receiveBatchImp(d_handle->d_descriptor,
+                           d_maxMessageSize,
+                           arena,
+                           descriptors,
+                           maxMessages,
+                           blockIndefinitely,
+                           &k_EXPIRED_DEADLINE);
+}
+
+Receive::Result PosixQueue::receiveBatch(
+                                  MessageBuffer                  *arena,
+                                  bsl::vector<MessageDescriptor> *descriptors,
+                                  bsl::size_t                     maxMessages,
+                                  const bsls::TimeInterval&       deadline)
+{
+    BSLS_ASSERT_SAFE(d_handle);
+
+    const timespec absoluteTime = toTimespec(deadline);
+    return receiveBatchImp(d_handle->d_descriptor,
+                           d_maxMessageSize,
+                           arena,
+                           descriptors,
+                           maxMessages,
+                           &absoluteTime,
+                           &absoluteTime);
+}
+
+Receive::Result PosixQueue::tryReceiveBatch(
+                                  MessageBuffer                  *arena,
+                                  bsl::vector<MessageDescriptor> *descriptors,
+                                  bsl::size_t                     maxMessages)
+{
+    BSLS_ASSERT_SAFE(d_handle);
+
+    return receiveBatchImp(d_handle->d_descriptor,
+                           d_maxMessageSize,
+                           arena,
+                           descriptors,
+                           maxMessages,
+                           &k_EXPIRED_DEADLINE,
+                           &k_EXPIRED_DEADLINE);
 }
 
 Send::Result PosixQueue::send(const bslstl::StringRef& payload,
@@ -666,6 +721,25 @@ Send::Result PosixQueue::send(const bslstl::StringRef&  payload,
     return Send::e_SUCCESS;
 }
 
+Send::Result PosixQueue::trySend(const bslstl::StringRef& payload,
+                                 unsigned                 priority)
+{
+    BSLS_ASSERT_SAFE(d_handle);
+
+    if (mq_timedsend(d_handle->d_descriptor,
+                     payload.data(),
+                     payload.length(),
+                     priority,
+                     &k_EXPIRED_DEADLINE) == -1) {
+        // As in 'tryReceive', a full queue is reported either as a timeout or
+        // as 'EAGAIN' depending on the mode of the descriptor.
+        return errno == ETIMEDOUT ? Send::e_FULL
+                                  : convertSendError(errno);          // RETURN
+    }
+
+    return Send::e_SUCCESS;
+}
+
 // ACCESSORS
 const bsl::string& PosixQueue::name() const
 {
@@ -697,6 +771,21 @@ long PosixQueue::numCurrentMessages() const
     return attrs.mq_curmsgs;
 }
 
+int PosixQueue::fileDescriptor() const
+{
+    if (d_openState == e_CLOSED) {
+        return -1;                                                    // RETURN
+    }
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    // On Linux, 'mqd_t' is a file descriptor.
+    BSLS_ASSERT_SAFE(d_handle);
+    return d_handle->d_descriptor;
+#else
+    return -1;
+#endif
+}
+
 bslma::Allocator *PosixQueue::allocator() const
 {
     bslma::Allocator *const result = d_name.get_allocator().mechanism();
@@ -734,22 +823,22 @@ Unlink::Result PosixQueue::unlink(const bsl::string& name)
 
 long PosixQueue::maxMaxMessages()
 {
-    return systemMaxMaxMessages();
+    return SystemLimitsUtil::limits().d_maxMaxMessages;
 }
 
 long PosixQueue::maxMaxMessageSize()
 {
-    return systemMaxMaxMessageSize();
+    return SystemLimitsUtil::limits().d_maxMaxMessageSize;
 }
 
 long PosixQueue::defaultMaxMessages()
 {
-    return systemDefaultMaxMessages();
+    return SystemLimitsUtil::limits().d_defaultMaxMessages;
 }
 
 long PosixQueue::defaultMaxMessageSize()
 {
-    return systemDefaultMaxMessageSize();
+    return SystemLimitsUtil::limits().d_defaultMaxMessageSize;
 }
 
 #undef LOG_UNEXPECTED
@@ -5,13 +5,17 @@
 
 #include <bdlb_variant.h>
 
+#include <bsl_cstddef.h>
 #include <bsl_string.h>
+#include <bsl_vector.h>
 
 namespace BloombergLP {
 namespace bslma { class Allocator; }
 namespace bsls { class TimeInterval; }
 namespace ipcmq {
 
+class MessageBuffer;
+
                         // =========================
                         // namespace PosixQueueTypes
                         // =========================
@@ -96,6 +100,16 @@ struct CreateMode {
     CreateMode();  // = delete
 };
 
+struct MessageDescriptor {
+    // This 'struct' describes one of the messages received into a
+    // 'MessageBuffer' by a batch receive operation. The message occupies
+    // 'd_length' bytes of the buffer beginning at 'd_offset'.
+
+    bsl::size_t d_offset;
+    bsl::size_t d_length;
+    unsigned    d_priority;
+};
+
 }  // close component types namespace
 
 class PosixQueue_NativeHandle;  // component-private opaque handle type
@@ -116,6 +130,7 @@ class PosixQueue {
     ALIAS(CreateMode);
     ALIAS(Default);
     ALIAS(Max);
+    ALIAS(MessageDescriptor);
     ALIAS(Open);
     ALIAS(OpenMode);
     ALIAS(Receive);
@@ -173,6 +188,37 @@ class PosixQueue {
         // return 'Send::e_TIMED_OUT' if the queue is still full. Return zero
         // on success or another 'Send::Result' value if an error occurs.
 
+    Send::Result sendBatch(const bslstl::StringRef *begin,
+                           const bslstl::StringRef *end,
+                           bsl::size_t             *numSent,
+                           unsigned                 priority = 0);
+    Send::Result sendBatch(const bslstl::StringRef   *begin,
+                           const bslstl::StringRef   *end,
+                           bsl::size_t               *numSent,
+                           const bsls::TimeInterval&  deadline,
+                           unsigned                   priority = 0);
+        // Enqueue, in order, a message for each payload in the specified
+        // range '[begin, end)', each having the optionally specified
+        // 'priority', and load into the specified 'numSent' the number of
+        // messages enqueued. Optionally specify a 'deadline', which is an
+        // absolute offset from the epoch, after which this function stops
+        // and returns 'Send::e_TIMED_OUT' if the queue is still full. Return
+        // zero if every message was enqueued, or the 'Send::Result' value of
+        // the first message that could not be enqueued, in which case no
+        // subsequent messages are enqueued either.
+
+    Send::Result trySendBatch(const bslstl::StringRef *begin,
+                              const bslstl::StringRef *end,
+                              bsl::size_t             *numSent,
+                              unsigned                 priority = 0);
+        // Enqueue, in order, a message for each payload in the specified
+        // range '[begin, end)', each having the optionally specified
+        // 'priority', until the queue is full, and load into the specified
+        // 'numSent' the number of messages enqueued. Do not block. Return
+        // zero if every message was enqueued, 'Send::e_FULL' if the queue
+        // became full first, or another 'Send::Result' value if an error
+        // occurs.
+
     Receive::Result receive(bsl::string *output, unsigned *priority = 0);
     Receive::Result receive(bsl::string               *output,
                             const bsls::TimeInterval&  deadline,
@@ -185,12 +231,109 @@ class PosixQueue {
         // empty. Return zero on success or another 'Receive::Result' value if
         // an error occurs.
 
+    Receive::Result receive(char        *buffer,
+                            bsl::size_t  capacity,
+                            bsl::size_t *length,
+                            unsigned    *priority = 0);
+    Receive::Result receive(char                      *buffer,
+                            bsl::size_t                capacity,
+                            bsl::size_t               *length,
+                            const bsls::TimeInterval&  deadline,
+                            unsigned                  *priority = 0);
+        // Receive the next available message into the specified 'buffer'
+        // having the specified 'capacity', and load the length of the message
+        // into the specified 'length'. If the optionally specified 'priority'
+        // is not zero, write the priority of the received message through it.
+        // Optionally specify a 'deadline', which is an absolute offset from
+        // the epoch, after which this function will return
+        // 'Receive::e_TIMED_OUT' if the queue is still empty. Return zero on
+        // success or another 'Receive::Result' value if an error occurs. Only
+        // the bytes of the message are written to 'buffer'. The behavior is
+        // undefined unless 'capacity >= maxMessageSize()'.
+
+    Receive::Result receiveBatch(
+                              MessageBuffer                  *arena,
+                              bsl::vector<MessageDescriptor> *descriptors,
+                              bsl::size_t                     maxMessages);
+    Receive::Result receiveBatch(
+                            MessageBuffer                  *arena,
+                            bsl::vector<MessageDescriptor> *descriptors,
+                            bsl::size_t                     maxMessages,
+                            const bsls::TimeInterval&       deadline);
+        // Receive up to the specified 'maxMessages' messages into the
+        // specified 'arena', one after another, and load into the specified
+        // 'descriptors' the offset, length, and priority of each message
+        // received, in the order received. Clear 'arena' and 'descriptors'
+        // first, but keep their capacity, so that a reused 'arena' and
+        // 'descriptors' do not allocate memory once they have grown large
+        // enough. If a 'deadline', which is an absolute offset from the
+        // epoch, is specified, then receive messages until 'maxMessages' have
+        // been received or 'deadline' passes. Otherwise, block until one
+        // message is available and then receive only messages that are
+        // immediately available. Return zero if at least one message was
+        // received, 'Receive::e_TIMED_OUT' if 'deadline' passed before any
+        // message was received, or another 'Receive::Result' value if an
+        // error occurs. If an error occurs after at least one message has
+        // been received, return zero and keep the messages received. The
+        // behavior is undefined unless '0 < maxMessages'.
+
+    Receive::Result tryReceiveBatch(
+                              MessageBuffer                  *arena,
+                              bsl::vector<MessageDescriptor> *descriptors,
+                              bsl::size_t                     maxMessages);
+        // Receive up to the specified 'maxMessages' messages that are
+        // immediately available into the specified 'arena', and load into the
+        // specified 'descriptors' the offset, length, and priority of each, as
+        // described for 'receiveBatch'. Do not block. Return zero if at least
+        // one message was received, 'Receive::e_EMPTY' if the queue is empty,
+        // or another 'Receive::Result' value if an error occurs. The behavior
+        // is undefined unless '0 < maxMessages'.
+
+    Send::Result trySend(const bslstl::StringRef& payload,
+                         unsigned                 priority = 0);
+        // Enqueue a message having the specified 'payload' and the optionally
+        // specified 'priority' if the queue is not full. Do not block,
+        // regardless of whether this object is in non-blocking mode. Return
+        // zero on success, 'Send::e_FULL' if the queue is full, or another
+        // 'Send::Result' value if an error occurs. Note that this function
+        // does not modify the flags of the underlying queue descriptor, and so
+        // may be called concurrently with the blocking 'send' on the same
+        // object.
+
+    Receive::Result tryReceive(bsl::string *output, unsigned *priority = 0);
+        // Assign through the specified 'output' the next available message if
+        // the queue is not empty. If the optionally specified 'priority' is
+        // not zero, write the priority of the received message through it. Do
+        // not block, regardless of whether this object is in non-blocking
+        // mode. Return zero on success, 'Receive::e_EMPTY' if the queue is
+        // empty, or another 'Receive::Result' value if an error occurs. Note
+        // that this function does not modify the flags of the underlying
+        // queue descriptor, and so may be called concurrently with the
+        // blocking 'receive' on the same object.
+
+    Receive::Result tryReceive(char        *buffer,
+                               bsl::size_t  capacity,
+                               bsl::size_t *length,
+                               unsigned    *priority = 0);
+        // Receive the next available message into the specified 'buffer'
+        // having the specified 'capacity' if the queue is not empty, and load
+        // the length of the message into the specified 'length'. If the
+        // optionally specified 'priority' is not zero, write the priority of
+        // the received message through it. Do not block. Return zero on
+        // success, 'Receive::e_EMPTY' if the queue is empty, or another
+        // 'Receive::Result' value if an error occurs. The behavior is
+        // undefined unless 'capacity >= maxMessageSize()'.
+
     SetNonBlocking::Result setNonBlocking(bool nonBlocking);
         // Set whether 'send' and 'receive' return immediately. On success, if
         // the specified 'nonBlocking' is 'true', then calls to 'send' and
         // 'receive' will return immediately, and if the specified
         // 'nonBlocking' is 'false', then calls to 'send' and 'receive' might
-        // block if the queue is full or empty, respectively.
+        // block if the queue is full or empty, respectively. Note that no
+        // system call is made if this object is already in the requested
+        // mode. Also note that 'trySend' and 'tryReceive' do not block
+        // regardless of this setting, and are preferable to toggling the mode
+        // of a queue shared among threads.
 
     // ACCESSORS
     const bsl::string& name() const;
@@ -208,6 +351,14 @@ class PosixQueue {
         // Return the number of messages currently enqueued in this queue.
         // Return zero of this queue is not open or if an error occurs.
 
+    int fileDescriptor() const;
+        // Return the file descriptor underlying this queue, which may be used
+        // with 'poll', 'select', or 'epoll' to wait until the queue can be
+        // read from or written to. Return -1 if this queue is not open, or if
+        // message queue descriptors are not file descriptors on this platform.
+        // Note that, of the platforms supported, only on Linux are message
+        // queue descriptors file descriptors.
+
     bslma::Allocator *allocator() const;
         // Return the allocator that supplies memory for this object.
 
@@ -220,23 +371,25 @@ class PosixQueue {
     static long maxMaxMessages();
         // Return the maximum number of messages that the system will allow to
         // be specified when opening a message queue, assuming that the maximum
-        // message size is defaulted. Note that this value is calculated once
-        // at runtime and then cached.
+        // message size is defaulted. Note that this value is discovered once
+        // at runtime by 'SystemLimitsUtil::limits()' and then cached.
 
     static long maxMaxMessageSize();
         // Return the maximum message size that the system will allow to be
         // specified when opening a message queue, assuming that the maximum
-        // number of messages is defaulted. Note that this value is calculated
-        // once at runtime and then cached.
+        // number of messages is defaulted. Note that this value is discovered
+        // once at runtime by 'SystemLimitsUtil::limits()' and then cached.
 
     static long defaultMaxMessages();
         // Return the maximum number of messages that a default-created queue
-        // can hold before blocking senders. Note that this value is calculated
-        // once at runtime and then cached.
+        // can hold before blocking senders. Note that this value is
+        // discovered once at runtime by 'SystemLimitsUtil::limits()' and then
+        // cached.
 
     static long defaultMaxMessageSize();
         // Return the maximum message size for a default-created queue. Note
-        // that this value is calculated once at runtime and then cached.
+        // that this value is discovered once at runtime by
+        // 'SystemLimitsUtil::limits()' and then cached.
 };
 
 }  // close package namespace
@@ -0,0 +1,439 @@
+
+#include <ipcmq_producer.h>
+
+#include <ball_log.h>
+
+#include <bdlb_bitutil.h>
+
+#include <bdlf_bind.h>
+#include <bdlf_memfn.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bslma_default.h>
+
+#include <bslmt_lockguard.h>
+#include <bslmt_threadattributes.h>
+
+#include <bsls_assert.h>
+#include <bsls_timeinterval.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.PRODUCER";
+
+typedef bsls::AtomicOperations AtomicOps;
+
+}  // close unnamed namespace
+
+                           // ----------------------
+                           // struct ProducerOptions
+                           // ----------------------
+
+// CREATORS
+ProducerOptions::ProducerOptions()
+: d_capacity(1024)
+, d_maxBatchSize(64)
+, d_fullPolicy(e_BLOCK)
+, d_linger()
+{
+}
+
+                               // --------------
+                               // class Producer
+                               // --------------
+
+// CREATORS
+Producer::Producer(const bslstl::StringRef&       name,
+                   Format                         format,
+                   const PosixQueue::Attributes&  attributes,
+                   int                            filePermissions,
+                   bslma::Allocator              *allocator)
+: d_sender(name, format, attributes, filePermissions, allocator)
+, d_options()
+, d_mask(0)
+, d_sequences(allocator)
+, d_payloads(allocator)
+, d_priorities(allocator)
+, d_enqueuePosition(0)
+, d_dequeuePosition(0)
+, d_isDrainerWaiting(false)
+, d_numWaitingSenders(0)
+, d_shuttingDown(false)
+, d_numDropped(0)
+, d_thread(bslmt::ThreadUtil::invalidHandle())
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    start(name);
+}
+
+Producer::Producer(const bslstl::StringRef&       name,
+                   Format                         format,
+                   const Options&                 options,
+                   const PosixQueue::Attributes&  attributes,
+                   int                            filePermissions,
+                   bslma::Allocator              *allocator)
+: d_sender(name, format, attributes, filePermissions, allocator)
+, d_options(options)
+, d_mask(0)
+, d_sequences(allocator)
+, d_payloads(allocator)
+, d_priorities(allocator)
+, d_enqueuePosition(0)
+, d_dequeuePosition(0)
+, d_isDrainerWaiting(false)
+, d_numWaitingSenders(0)
+, d_shuttingDown(false)
+, d_numDropped(0)
+, d_thread(bslmt::ThreadUtil::invalidHandle())
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    start(name);
+}
+
+Producer::~Producer()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    if (d_thread == bslmt::ThreadUtil::invalidHandle()) {
+        // Thread never started. Nothing to join.
+        return;                                                       // RETURN
+    }
+
+    // The sending thread checks for shutdown while holding the mutex, so it
+    // either sees the flag or is waiting when signaled.
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_drainerMutex);
+        d_shuttingDown = true;
+        d_drainerCondition.signal();
+    }
+
+    const int rc = bslmt::ThreadUtil::join(d_thread);
+    if (rc) {
+        BALL_LOG_ERROR << "Unable to join producer thread. "
+                          "bslmt::ThreadUtil::join returned rc="
+                       << rc << BALL_LOG_END;
+    }
+}
+
+// MANIPULATORS
+int Producer::send(const bslstl::StringRef& payload, int priority)
+{
+    const bsls::TimeInterval *const noDeadline = 0;
+    const bool                      blocking   = true;
+    return stage(payload, noDeadline, blocking, priority);
+}
+
+int Producer::send(const bslstl::StringRef&  payload,
+                   const bsls::TimeInterval& relativeTimeout,
+                   int                       priority)
+{
+    const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                        relativeTimeout;
+    const bool               blocking = true;
+    return stage(payload, &deadline, blocking, priority);
+}
+
+int Producer::trySend(const bslstl::StringRef& payload, int priority)
+{
+    const bsls::TimeInterval *const noDeadline = 0;
+    const bool                      blocking   = false;
+    return stage(payload, noDeadline, blocking, priority);
+}
+
+void Producer::resetMetrics()
+{
+    d_sender.resetMetrics();
+    d_numDropped = 0;
+}
+
+void Producer::start(const bslstl::StringRef& name)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(d_options.d_capacity > 0);
+    BSLS_ASSERT(d_options.d_maxBatchSize > 0);
+
+    if (!d_sender.isOpen()) {
+        return;                                                       // RETURN
+    }
+
+    const bsls::Types::Uint64 numSlots = bdlb::BitUtil::roundUpToBinaryPower(
+                                 bsls::Types::Uint64(d_options.d_capacity));
+    d_mask = numSlots - 1;
+
+    // Slot 'i' is first claimed by the sender at enqueue position 'i'.
+    d_sequences.resize(numSlots);
+    for (bsls::Types::Uint64 i = 0; i < numSlots; ++i) {
+        AtomicOps::initUint64(&d_sequences[i], i);
+    }
+    d_payloads.resize(numSlots);
+    d_priorities.resize(numSlots);
+
+    bslmt::ThreadAttributes attributes;
+    ThreadOptionsUtil::loadAttributes(&attributes, d_options.d_threadOptions);
+
+    const int rc = bslmt::ThreadUtil::create(
+        &d_thread,
+        attributes,
+        bdlf::BindUtil::bind(&ThreadOptionsUtil::run,
+                             d_options.d_threadOptions,
+                             bslmt::ThreadUtil::Invokable(
+                                 bdlf::MemFnUtil::memFn(&Producer::drain,
+                                                        this))));
+    if (rc) {
+        BALL_LOG_ERROR << "Unable to start producer thread for the message "
+                          "queue "
+                       << name << ". bslmt::ThreadUtil::create returned rc="
+                       << rc << BALL_LOG_END;
+        d_thread = bslmt::ThreadUtil::invalidHandle();
+    }
+}
+
+int Producer::stage(const bslstl::StringRef&  payload,
+                    const bsls::TimeInterval *deadline,
+                    bool                      blocking,
+                    int                       priority)
+{
+    using namespace PosixQueueTypes;
+
+    if (d_thread == bslmt::ThreadUtil::invalidHandle()) {
+        // Nothing would ever send the payload. Fail as sending to a queue
+        // that is not open for sending does.
+        return Send::e_WRONG_MODE;                                    // RETURN
+    }
+
+    if (tryStage(payload, priority)) {
+        return 0;                                                     // RETURN
+    }
+
+    switch (d_options.d_fullPolicy) {
+      case Options::e_DROP: {
+        d_numDropped.addRelaxed(1);
+        return 0;                                                     // RETURN
+      }
+      case Options::e_REPORT: {
+        return Send::e_FULL;                                          // RETURN
+      }
+      case Options::e_BLOCK: {
+        if (!blocking) {
+            return Send::e_FULL;                                      // RETURN
+        }
+      } break;
+    }
+
+    // Announce this sender before looking again, so that the sending thread,
+    // having returned slots, either sees it or is seen to have returned them.
+    int rc = Send::e_FULL;
+    d_numWaitingSenders.add(1);
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_senderMutex);
+        while (rc == Send::e_FULL) {
+            if (tryStage(payload, priority)) {
+                rc = 0;
+            }
+            else if (!deadline) {
+                d_senderCondition.wait(&d_senderMutex);
+            }
+            else if (d_senderCondition.timedWait(&d_senderMutex, *deadline)) {
+                rc = tryStage(payload, priority) ? 0 : int(Send::e_TIMED_OUT);
+            }
+        }
+    }
+    d_numWaitingSenders.add(-1);
+
+    return rc;
+}
+
+bool Producer::tryStage(const bslstl::StringRef& payload, int priority)
+{
+    bsls::Types::Uint64 position = d_enqueuePosition.loadRelaxed();
+    bsls::Types::Uint64 index;
+    for (;;) {
+        index = position & d_mask;
+        const bsls::Types::Uint64 sequence =
+                                     AtomicOps::getUint64(&d_sequences[index]);
+        const bsls::Types::Int64  lead =
+                                    bsls::Types::Int64(sequence - position);
+        if (lead == 0) {
+            // The slot is free. Claim it.
+            const bsls::Types::Uint64 previous =
+                      d_enqueuePosition.testAndSwap(position, position + 1);
+            if (previous == position) {
+                break;
+            }
+            position = previous;
+        }
+        else if (lead < 0) {
+            // The slot still holds the payload staged one lap ago.
+            return false;                                             // RETURN
+        }
+        else {
+            // Another sender claimed the slot first.
+            position = d_enqueuePosition.loadRelaxed();
+        }
+    }
+
+    d_payloads[index].assign(payload.data(), payload.length());
+    d_priorities[index] = priority;
+
+    // Publish the slot before looking for the sending thread, so that the
+    // sending thread, having announced that it is waiting, either sees the
+    // slot or is seen to be waiting.
+    AtomicOps::setUint64(&d_sequences[index], position + 1);
+    if (d_isDrainerWaiting.load()) {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_drainerMutex);
+        d_drainerCondition.signal();
+    }
+
+    return true;
+}
+
+void Producer::drain()
+{
+    // The payloads of a batch refer to the buffers of their slots, which are
+    // not returned to the senders until the batch has been enqueued.
+    bsl::vector<bslstl::StringRef> batch(d_allocator_p);
+    batch.reserve(d_options.d_maxBatchSize);
+
+    while (const int numReady = waitForPayloads()) {
+        const bsls::Types::Uint64 end = d_dequeuePosition + numReady;
+        while (d_dequeuePosition != end) {
+            // Send a run of payloads having the same priority.
+            const int priority = d_priorities[d_dequeuePosition & d_mask];
+            batch.clear();
+            for (bsls::Types::Uint64 position = d_dequeuePosition;
+                 position != end &&
+                 d_priorities[position & d_mask] == priority;
+                 ++position) {
+                batch.push_back(d_payloads[position & d_mask]);
+            }
+
+            sendRun(batch.data(), batch.data() + batch.size(), priority);
+
+            // Return the slots, each to the sender one lap ahead.
+            for (bsl::size_t i = 0; i < batch.size(); ++i) {
+                AtomicOps::setUint64(&d_sequences[d_dequeuePosition & d_mask],
+                                     d_dequeuePosition + d_mask + 1);
+                ++d_dequeuePosition;
+            }
+
+            if (d_numWaitingSenders.load()) {
+                bslmt::LockGuard<bslmt::Mutex> guard(&d_senderMutex);
+                d_senderCondition.broadcast();
+            }
+        }
+    }
+}
+
+int Producer::waitForPayloads()
+{
+    const bool lingers  = d_options.d_linger > bsls::TimeInterval();
+    int        numReady = numPublished();
+    if (numReady == d_options.d_maxBatchSize || (numReady && !lingers)) {
+        return numReady;                                              // RETURN
+    }
+
+    // Announce that this thread is waiting before looking again, so that a
+    // sender, having published a slot, either sees this thread waiting or is
+    // seen to have published it. The linger begins once there is a payload.
+    bool               isLingering = false;
+    bsls::TimeInterval deadline;
+    d_isDrainerWaiting = true;
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_drainerMutex);
+        for (;;) {
+            numReady = numPublished();
+            if (numReady == d_options.d_maxBatchSize ||
+                (numReady && !lingers) || d_shuttingDown.load()) {
+                break;
+            }
+
+            if (!numReady) {
+                d_drainerCondition.wait(&d_drainerMutex);
+                continue;
+            }
+
+            if (!isLingering) {
+                isLingering = true;
+                deadline    = bdlt::CurrentTime::now() + d_options.d_linger;
+            }
+            if (d_drainerCondition.timedWait(&d_drainerMutex, deadline)) {
+                numReady = numPublished();
+                break;
+            }
+        }
+    }
+    d_isDrainerWaiting = false;
+
+    return numReady;
+}
+
+void Producer::sendRun(const bslstl::StringRef *begin,
+                       const bslstl::StringRef *end,
+                       int                      priority)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    while (begin != end) {
+        bsl::size_t numSent;
+        const int   rc = d_sender.sendBatch(begin, end, &numSent, priority);
+        begin += numSent;
+        if (rc) {
+            BALL_LOG_ERROR << "Unable to send message to message queue: "
+                           << d_sender.description(rc)
+                           << ". The message is dropped." << BALL_LOG_END;
+            ++begin;
+        }
+    }
+}
+
+// ACCESSORS
+void Producer::loadMetrics(MetricsSnapshot *result) const
+{
+    d_sender.loadMetrics(result);
+}
+
+bsls::Types::Int64 Producer::numDropped() const
+{
+    return d_numDropped.loadRelaxed();
+}
+
+bool Producer::isOpen() const
+{
+    return d_sender.isOpen();
+}
+
+IPCU_DEFINE_OPERATOR_BOOL(Producer)
+{
+    IPCU_RETURN_OPERATOR_BOOL(Producer, isOpen());
+}
+
+const PosixQueue& Producer::posixQueue() const
+{
+    return d_sender.posixQueue();
+}
+
+int Producer::numPublished() const
+{
+    int                 numReady = 0;
+    bsls::Types::Uint64 position = d_dequeuePosition;
+    while (numReady < d_options.d_maxBatchSize &&
+           AtomicOps::getUint64(&d_sequences[position & d_mask]) ==
+               position + 1) {
+        ++numReady;
+        ++position;
+    }
+
+    return numReady;
+}
+
+// CLASS METHODS
+const char *Producer::description(int errorCode)
+{
+    return QueueSender::description(errorCode);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
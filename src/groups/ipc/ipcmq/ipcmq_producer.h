@@ -0,0 +1,319 @@
+#ifndef INCLUDED_IPCMQ_PRODUCER
+#define INCLUDED_IPCMQ_PRODUCER
+
+#include <ipcmq_format.h>
+#include <ipcmq_metrics.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuesender.h>
+#include <ipcmq_sender.h>
+#include <ipcmq_threadoptions.h>
+#include <ipcu_operatorbool.h>
+
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bslmt_condition.h>
+#include <bslmt_mutex.h>
+#include <bslmt_threadutil.h>
+
+#include <bsls_atomic.h>
+#include <bsls_atomicoperations.h>
+#include <bsls_timeinterval.h>
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+                           // ======================
+                           // struct ProducerOptions
+                           // ======================
+
+struct ProducerOptions {
+    // This 'struct' describes the staging queue of a 'Producer', what
+    // happens to a payload sent while the staging queue is full, and where
+    // and how its sending thread runs.
+
+    // PUBLIC TYPES
+    enum FullPolicy {
+        e_BLOCK,   // wait for room, as a blocking 'send' on the queue would
+        e_DROP,    // discard the payload and report success
+        e_REPORT   // fail with 'PosixQueue::Send::e_FULL'
+    };
+
+    // DATA
+    int d_capacity;
+        // the number of payloads that can be staged, rounded up to a power of
+        // two
+
+    int d_maxBatchSize;
+        // the maximum number of staged payloads that the sending thread
+        // enqueues onto the message queue at a time
+
+    FullPolicy d_fullPolicy;
+        // what a 'send' does when the staging queue is full. Note that
+        // 'trySend' never blocks, so it fails with 'PosixQueue::Send::e_FULL'
+        // if this is 'e_BLOCK'.
+
+    bsls::TimeInterval d_linger;
+        // how long the sending thread waits, after finding fewer than
+        // 'd_maxBatchSize' staged payloads, for more to be staged before it
+        // enqueues them. A longer linger makes larger batches, which with the
+        // 'Format::e_PACKED' format are packed into fewer messages, at the
+        // cost of latency.
+
+    ThreadOptions d_threadOptions;
+        // the CPUs, NUMA node, scheduling policy, stack size, and name of the
+        // sending thread. Options that are not permitted are logged and
+        // ignored (see 'ThreadOptionsUtil').
+
+    // CREATORS
+    ProducerOptions();
+        // Create a 'ProducerOptions' object describing a staging queue of 1024
+        // payloads sent in batches of at most 64 without lingering, a 'send'
+        // that blocks while the staging queue is full, and a sending thread
+        // that runs as any other.
+};
+
+                               // ==============
+                               // class Producer
+                               // ==============
+
+class Producer : public Sender {
+    // This class implements the 'Sender' protocol by copying each payload
+    // into a bounded, in-process staging queue, from which a dedicated thread
+    // enqueues payloads onto a message queue using a 'QueueSender'. It is the
+    // sending counterpart of 'Consumer': a thread that sends never waits for
+    // the message queue, only for room in the staging queue, and then only if
+    // so configured.
+    //
+    // The staging queue is a ring of slots, each having a sequence number, as
+    // described by Dmitry Vyukov for his bounded MPMC queue. A sending thread
+    // claims a slot by advancing the enqueue position with one compare and
+    // swap, copies the payload into the slot's buffer, and publishes the slot
+    // by storing its sequence number, so sending threads do not lock and
+    // never wait for each other, except to retry a lost compare and swap. The
+    // buffers keep their capacity, so once each has held a payload as large
+    // as any sent, staging allocates no more memory. The sending thread
+    // enqueues the payloads of consecutive published slots having the same
+    // priority as a batch, and then returns the slots to the senders. It
+    // sleeps only when the staging queue is empty, and is woken only by a
+    // sender that finds it asleep.
+    //
+    // A successful 'send' means that the payload was staged, not that it was
+    // enqueued onto the message queue. A payload that the sending thread is
+    // unable to enqueue is logged and dropped. Every payload staged is
+    // enqueued, in order, before the destructor returns, so destroying a
+    // 'Producer' blocks for as long as the message queue stays full.
+
+  public:
+    // PUBLIC TYPES
+    typedef ProducerOptions Options;
+
+  private:
+    // DATA
+    QueueSender                                     d_sender;
+    Options                                         d_options;
+    bsls::Types::Uint64                             d_mask;
+        // one less than the number of slots
+
+    bsl::vector<bsls::AtomicOperations::AtomicTypes::Uint64>
+                                                    d_sequences;
+        // for each slot, the enqueue position that may claim it, or one more
+        // than the position that published it
+
+    bsl::vector<bsl::string>                        d_payloads;
+    bsl::vector<int>                                d_priorities;
+
+    char                                            d_padding0[64];
+    bsls::AtomicUint64                              d_enqueuePosition;
+    char                                            d_padding1[64];
+    bsls::Types::Uint64                             d_dequeuePosition;
+        // used only by the sending thread
+
+    bsls::AtomicInt                                 d_isDrainerWaiting;
+    bslmt::Mutex                                    d_drainerMutex;
+    bslmt::Condition                                d_drainerCondition;
+        // signaled when a slot is published or shutdown begins
+
+    bsls::AtomicInt                                 d_numWaitingSenders;
+    bslmt::Mutex                                    d_senderMutex;
+    bslmt::Condition                                d_senderCondition;
+        // signaled when slots are returned to the senders
+
+    bsls::AtomicInt                                 d_shuttingDown;
+    bsls::AtomicInt64                               d_numDropped;
+    bslmt::ThreadUtil::Handle                       d_thread;
+    bslma::Allocator                               *d_allocator_p;
+
+    Producer(const Producer&);             // = delete
+    Producer& operator=(const Producer&);  // = delete
+
+  public:
+    // CREATORS
+    Producer(
+        const bslstl::StringRef&       name,
+        Format                         format,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+    Producer(
+        const bslstl::StringRef&       name,
+        Format                         format,
+        const Options&                 options,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+        // Create a 'Producer' object that sends to the message queue with the
+        // specified 'name' in the specified 'format'. Optionally specify
+        // 'options' describing the staging queue. Optionally specify
+        // 'attributes' and 'filePermissions', which will be used when
+        // creating the queue if the queue does not already exist. If the
+        // queue is opened, this object starts its sending thread immediately.
+        // The behavior is undefined unless '0 < options.d_capacity' and
+        // '0 < options.d_maxBatchSize'.
+
+    ~Producer();
+        // Wait for the sending thread to enqueue every payload staged, stop
+        // it, and then destroy this object. The behavior is undefined if any
+        // other thread is sending using this object.
+
+    // MANIPULATORS
+    int send(const bslstl::StringRef& payload);                // override
+    int send(const bslstl::StringRef& payload, int priority);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout,
+             int                       priority);  // override
+        // Stage for sending to the queue represented by this object a message
+        // consisting of the specified 'payload' and having the optionally
+        // specified 'priority'. If the staging queue is full, then do as the
+        // full policy of this object says; if that is to block, block for no
+        // longer than the optionally specified 'relativeTimeout', relative to
+        // the beginning of the invocation of this function. Return zero if
+        // the payload is staged or dropped by policy, or a nonzero value
+        // otherwise. If the sending thread could not be started, return
+        // 'PosixQueueTypes::Send::e_WRONG_MODE', as sending to a message
+        // queue that is not open for sending does.
+
+    int trySend(const bslstl::StringRef& payload);                // override
+    int trySend(const bslstl::StringRef& payload, int priority);  // override
+        // Stage for sending to the queue represented by this object a message
+        // consisting of the specified 'payload' and having the optionally
+        // specified 'priority'. Do not block. Return zero if the payload is
+        // staged or dropped by policy, or a nonzero value otherwise. If the
+        // sending thread could not be started, return
+        // 'PosixQueueTypes::Send::e_WRONG_MODE'.
+
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero.
+
+    // ACCESSORS
+    void loadMetrics(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the payloads enqueued onto the
+        // message queue by the sending thread, the attempts that failed, and
+        // the time taken to encode each payload. Note that the payloads
+        // dropped because the staging queue was full are not included; see
+        // 'numDropped'.
+
+    bsls::Types::Int64 numDropped() const;
+        // Return the number of payloads dropped because the staging queue was
+        // full.
+
+    bool isOpen() const;
+        // Return whether this object represents an open message queue.
+
+    IPCU_DECLARE_OPERATOR_BOOL(Producer);
+        // Return 'isOpen()'.
+
+    const PosixQueue& posixQueue() const;
+        // Return a reference providing non-modifiable access to the
+        // 'PosixQueue' instance used to implement this object.
+
+    // CLASS METHODS
+    static const char *description(int errorCode);
+        // Return a pointer to a null terminated string that describes the
+        // specified 'errorCode'. The behavior is undefined unless 'errorCode'
+        // has the same value as the result of a previous invocation of one of
+        // the methods of an instance of this class.
+
+  private:
+    // PRIVATE MANIPULATORS
+    void start(const bslstl::StringRef& name);
+        // Allocate the staging queue and start the sending thread for the
+        // message queue having the specified 'name'.
+
+    int stage(const bslstl::StringRef&  payload,
+              const bsls::TimeInterval *deadline,
+              bool                      blocking,
+              int                       priority);
+        // Stage the specified 'payload' having the specified 'priority'. If
+        // the staging queue is full, do as the full policy says, but do not
+        // block if the specified 'blocking' is 'false', and otherwise block
+        // until the specified 'deadline', or indefinitely if 'deadline' is
+        // zero. Return zero if 'payload' is staged or dropped,
+        // 'PosixQueueTypes::Send::e_WRONG_MODE' if the sending thread is not
+        // running, or another nonzero value otherwise.
+
+    bool tryStage(const bslstl::StringRef& payload, int priority);
+        // Stage the specified 'payload' having the specified 'priority' if
+        // there is a free slot, and wake the sending thread if it is waiting.
+        // Return whether 'payload' was staged.
+
+    void drain();
+        // Enqueue staged payloads onto the message queue until shutdown
+        // begins and every staged payload is enqueued.
+
+    int waitForPayloads();
+        // Return the number of consecutive published slots at the dequeue
+        // position, but no more than the maximum batch size. Block until
+        // there is at least one, or until shutdown begins, in which case
+        // return zero if there are none. Once there is at least one, block
+        // for up to the linger of this object until there are the maximum
+        // batch size or shutdown begins.
+
+    void sendRun(const bslstl::StringRef *begin,
+                 const bslstl::StringRef *end,
+                 int                      priority);
+        // Enqueue onto the message queue a message for each payload in the
+        // specified range '[begin, end)', each having the specified
+        // 'priority'. Log and drop each payload that cannot be enqueued.
+
+    // PRIVATE ACCESSORS
+    int numPublished() const;
+        // Return the number of consecutive published slots at the dequeue
+        // position, but no more than the maximum batch size.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                               // --------------
+                               // class Producer
+                               // --------------
+
+inline
+int Producer::send(const bslstl::StringRef& payload)
+{
+    return send(payload, 0);
+}
+
+inline
+int Producer::send(const bslstl::StringRef&  payload,
+                   const bsls::TimeInterval& relativeTimeout)
+{
+    return send(payload, relativeTimeout, 0);
+}
+
+inline
+int Producer::trySend(const bslstl::StringRef& payload)
+{
+    return trySend(payload, 0);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -88,6 +88,53 @@ int Queue::trySend(const bslstl::StringRef& payload, int priority)
     return d_sender.trySend(payload, priority);
 }
 
+int Queue::sendBatch(const bslstl::StringRef *begin,
+                     const bslstl::StringRef *end,
+                     bsl::size_t             *numSent)
+{
+    return d_sender.sendBatch(begin, end, numSent);
+}
+
+int Queue::sendBatch(const bslstl::StringRef *begin,
+                     const bslstl::StringRef *end,
+                     bsl::size_t             *numSent,
+                     int                      priority)
+{
+    return d_sender.sendBatch(begin, end, numSent, priority);
+}
+
+int Queue::sendBatch(const bslstl::StringRef   *begin,
+                     const bslstl::StringRef   *end,
+                     bsl::size_t               *numSent,
+                     const bsls::TimeInterval&  relativeTimeout)
+{
+    return d_sender.sendBatch(begin, end, numSent, relativeTimeout);
+}
+
+int Queue::sendBatch(const bslstl::StringRef   *begin,
+                     const bslstl::StringRef   *end,
+                     bsl::size_t               *numSent,
+                     const bsls::TimeInterval&  relativeTimeout,
+                     int                        priority)
+{
+    return d_sender.sendBatch(begin, end, numSent, relativeTimeout, priority);
+}
+
+int Queue::trySendBatch(const bslstl::StringRef *begin,
+                        const bslstl::StringRef *end,
+                        bsl::size_t             *numSent)
+{
+    return d_sender.trySendBatch(begin, end, numSent);
+}
+
+int Queue::trySendBatch(const bslstl::StringRef *begin,
+                        const bslstl::StringRef *end,
+                        bsl::size_t             *numSent,
+                        int                      priority)
+{
+    return d_sender.trySendBatch(begin, end, numSent, priority);
+}
+
 int Queue::unlink()
 {
     using namespace PosixQueueTypes;
@@ -95,7 +142,20 @@ int Queue::unlink()
     return PosixQueue::unlink(d_queue.name());
 }
 
+void Queue::resetMetrics()
+{
+    d_sender.resetMetrics();
+    d_receiver.resetMetrics();
+}
+
 // ACCESSORS
+void Queue::loadMetrics(MetricsSnapshot *sent,
+                        MetricsSnapshot *received) const
+{
+    d_sender.loadMetrics(sent);
+    d_receiver.loadMetrics(received);
+}
+
 PosixQueue::Open::Result Queue::openResult() const
 {
     return d_openResult;
@@ -6,6 +6,7 @@
 #include <ipcmq_queuereceiver.h>
 #include <ipcmq_queuesender.h>
 
+#include <bsl_cstddef.h>
 #include <bsl_string.h>
 
 namespace BloombergLP {
@@ -91,12 +92,60 @@ class Queue : public Sender, public Receiver {
         // successfully sent or a nonzero value otherwise. If an error occurs,
         // 'errorDescription' will return a description of the error.
 
+    int sendBatch(const bslstl::StringRef *begin,
+                  const bslstl::StringRef *end,
+                  bsl::size_t             *numSent);
+    int sendBatch(const bslstl::StringRef *begin,
+                  const bslstl::StringRef *end,
+                  bsl::size_t             *numSent,
+                  int                      priority);
+    int sendBatch(const bslstl::StringRef   *begin,
+                  const bslstl::StringRef   *end,
+                  bsl::size_t               *numSent,
+                  const bsls::TimeInterval&  relativeTimeout);
+    int sendBatch(const bslstl::StringRef   *begin,
+                  const bslstl::StringRef   *end,
+                  bsl::size_t               *numSent,
+                  const bsls::TimeInterval&  relativeTimeout,
+                  int                        priority);
+        // Enqueue onto the queue represented by this object, in order, a
+        // message for each payload in the specified range '[begin, end)',
+        // each having the optionally specified 'priority', and load into the
+        // specified 'numSent' the number of messages enqueued. Block for no
+        // longer than the optionally specified 'relativeTimeout', relative to
+        // the beginning of the invocation of this function, for the whole
+        // batch. Return zero if every message was sent, or the nonzero result
+        // of the first message that could not be sent, in which case none of
+        // the subsequent messages are sent either.
+
+    int trySendBatch(const bslstl::StringRef *begin,
+                     const bslstl::StringRef *end,
+                     bsl::size_t             *numSent);
+    int trySendBatch(const bslstl::StringRef *begin,
+                     const bslstl::StringRef *end,
+                     bsl::size_t             *numSent,
+                     int                      priority);
+        // Enqueue onto the queue represented by this object, in order, a
+        // message for each payload in the specified range '[begin, end)',
+        // each having the optionally specified 'priority', until the queue is
+        // full, and load into the specified 'numSent' the number of messages
+        // enqueued. Do not block. Return zero if every message was sent, or
+        // the nonzero result of the first message that could not be sent.
+
     int unlink();
         // Mark for deletion the message queue opened by this object. Return
         // zero on success or a nonzero value otherwise. If an error occurs,
         // 'errorDescription' will return a description of the error.
 
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero.
+
     // ACCESSORS
+    void loadMetrics(MetricsSnapshot *sent, MetricsSnapshot *received) const;
+        // Load into the specified 'sent' the metrics of the messages sent by
+        // this object, and into the specified 'received' the metrics of the
+        // messages received by this object.
+
     PosixQueue::Open::Result openResult() const;
         // Return the result returned when this queue was opened.
 
@@ -1,14 +1,168 @@
 
 #include <ipcmq_queuereceiver.h>
+#include <ipcmq_fragmentreassembler.h>
+#include <ipcmq_messagebuffer.h>
+#include <ipcmq_packedbacklog.h>
+#include <ipcmq_payload.h>
 #include <ipcu_algoutil.h>
 
+#include <bdlma_localsequentialallocator.h>
+
 #include <bdlt_currenttime.h>
 
+#include <bslma_default.h>
+
 #include <bsls_assert.h>
 #include <bsls_timeinterval.h>
+#include <bsls_timeutil.h>
+#include <bsls_types.h>
+
+#include <bsl_cstring.h>
+#include <bsl_vector.h>
 
 namespace BloombergLP {
 namespace ipcmq {
+namespace {
+
+bslstl::StringRef contents(const bsl::string& payload)
+    // Return the bytes of the specified 'payload'.
+{
+    return payload;
+}
+
+bslstl::StringRef contents(const MessageBuffer& payload)
+    // Return the bytes of the specified 'payload'.
+{
+    return payload.stringRef();
+}
+
+bslstl::StringRef contents(const Payload& payload)
+    // Return the bytes of the specified 'payload'.
+{
+    return payload.stringRef();
+}
+
+PosixQueueTypes::Receive::Result receiveMessage(
+                                      PosixQueue               *queue,
+                                      bsl::string              *message,
+                                      const bsls::TimeInterval *deadline,
+                                      bool                      block,
+                                      unsigned                 *priority)
+    // Receive into the specified 'message' the next message from the
+    // specified 'queue', and assign through the specified 'priority' its
+    // priority. If the specified 'block' is 'false', do not block. Otherwise,
+    // block until the specified 'deadline', or indefinitely if 'deadline' is
+    // zero. Return zero on success or a nonzero value otherwise.
+{
+    if (!block) {
+        return queue->tryReceive(message, priority);                  // RETURN
+    }
+    else if (deadline) {
+        return queue->receive(message, *deadline, priority);          // RETURN
+    }
+
+    return queue->receive(message, priority);
+}
+
+PosixQueueTypes::Receive::Result receiveMessage(
+                                      PosixQueue               *queue,
+                                      MessageBuffer            *message,
+                                      const bsls::TimeInterval *deadline,
+                                      bool                      block,
+                                      unsigned                 *priority)
+    // Receive into the specified 'message' the next message from the
+    // specified 'queue', as the 'bsl::string' overload does.
+{
+    using namespace PosixQueueTypes;
+
+    message->reserve(queue->maxMessageSize());
+
+    bsl::size_t     length = 0;
+    Receive::Result rc;
+    if (!block) {
+        rc = queue->tryReceive(
+            message->data(), message->capacity(), &length, priority);
+    }
+    else if (deadline) {
+        rc = queue->receive(message->data(),
+                            message->capacity(),
+                            &length,
+                            *deadline,
+                            priority);
+    }
+    else {
+        rc = queue->receive(
+            message->data(), message->capacity(), &length, priority);
+    }
+
+    message->setLength(rc ? 0 : length);
+    return rc;
+}
+
+PosixQueueTypes::Receive::Result receiveMessage(
+                                      PosixQueue               *queue,
+                                      Payload                  *message,
+                                      const bsls::TimeInterval *deadline,
+                                      bool                      block,
+                                      unsigned                 *priority)
+    // Receive into the buffer of the specified 'message' the next message
+    // from the specified 'queue', as the 'bsl::string' overload does.
+{
+    return receiveMessage(
+        queue, &message->buffer(), deadline, block, priority);
+}
+
+bool popBacklog(PackedBacklog *backlog,
+                bsl::string   *payload,
+                unsigned      *priority)
+    // Move the first payload of the specified 'backlog', if any, into the
+    // specified 'payload', and assign through the specified 'priority' its
+    // priority. Return whether a payload was moved.
+{
+    return backlog->pop(payload, priority);
+}
+
+bool popBacklog(PackedBacklog *backlog,
+                MessageBuffer *payload,
+                unsigned      *priority)
+    // Move the first payload of the specified 'backlog', if any, into the
+    // specified 'payload', as the 'bsl::string' overload does.
+{
+    return backlog->pop(payload, priority);
+}
+
+bool popBacklog(PackedBacklog *backlog, Payload *payload, unsigned *priority)
+    // Move the first payload of the specified 'backlog', if any, into the
+    // buffer of the specified 'payload', as the 'bsl::string' overload does.
+{
+    return backlog->pop(&payload->buffer(), priority);
+}
+
+void keepOnly(bsl::string *payload, const bslstl::StringRef& part)
+    // Make the contents of the specified 'payload' the specified 'part' of
+    // them.
+{
+    const bsl::size_t offset = part.data() - payload->data();
+    payload->erase(offset + part.length());
+    payload->erase(0, offset);
+}
+
+void keepOnly(MessageBuffer *payload, const bslstl::StringRef& part)
+    // Make the contents of the specified 'payload' the specified 'part' of
+    // them.
+{
+    bsl::memmove(payload->data(), part.data(), part.length());
+    payload->setLength(part.length());
+}
+
+void keepOnly(Payload *payload, const bslstl::StringRef& part)
+    // Make the contents of the buffer of the specified 'payload' the
+    // specified 'part' of them.
+{
+    keepOnly(&payload->buffer(), part);
+}
+
+}  // close unnamed namespace
 
 // CREATORS
 QueueReceiver::QueueReceiver(const bslstl::StringRef&       name,
@@ -18,9 +172,24 @@ QueueReceiver::QueueReceiver(const bslstl::StringRef&       name,
                              bslma::Allocator              *allocator)
 : d_queue(allocator)
 , d_decoder(FormatUtil::decoder(format))
+, d_bufferDecoder(FormatUtil::bufferDecoder(format))
+, d_payloadDecoder(FormatUtil::payloadDecoder(format))
+, d_batchDecoder(FormatUtil::batchDecoder(format))
+, d_format(format)
 {
     d_queue.createInPlace<PosixQueue>(allocator);
 
+    if (format == Format::e_FRAGMENTED || format == Format::e_TAGGED) {
+        allocator = bslma::Default::allocator(allocator);
+        d_reassembler_mp.load(new (*allocator) FragmentReassembler(allocator),
+                              allocator);
+    }
+    else if (format == Format::e_PACKED) {
+        allocator = bslma::Default::allocator(allocator);
+        d_backlog_mp.load(new (*allocator) PackedBacklog(allocator),
+                          allocator);
+    }
+
     using namespace PosixQueueTypes;
     const CreateMode createMode(permissions ? OpenOrCreate(permissions)
                                             : OpenOrCreate());
@@ -30,8 +199,23 @@ QueueReceiver::QueueReceiver(const bslstl::StringRef&       name,
 QueueReceiver::QueueReceiver(PosixQueue *queue, Format format)
 : d_queue(queue)
 , d_decoder(FormatUtil::decoder(format))
+, d_bufferDecoder(FormatUtil::bufferDecoder(format))
+, d_payloadDecoder(FormatUtil::payloadDecoder(format))
+, d_batchDecoder(FormatUtil::batchDecoder(format))
+, d_format(format)
 {
     BSLS_ASSERT(queue);
+
+    if (format == Format::e_FRAGMENTED || format == Format::e_TAGGED) {
+        bslma::Allocator *const allocator = bslma::Default::allocator();
+        d_reassembler_mp.load(new (*allocator) FragmentReassembler(allocator),
+                              allocator);
+    }
+    else if (format == Format::e_PACKED) {
+        bslma::Allocator *const allocator = bslma::Default::allocator();
+        d_backlog_mp.load(new (*allocator) PackedBacklog(allocator),
+                          allocator);
+    }
 }
 
 // MANIPULATORS
@@ -61,13 +245,23 @@ int QueueReceiver::receive(bsl::string *payload, unsigned *priority)
         return rc;                                                    // RETURN
     }
 
+    if (d_reassembler_mp) {
+        const bool block = true;
+        return receiveFragments(payload, 0, block, priority);         // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bool block = true;
+        return receivePacked(payload, 0, block, priority);            // RETURN
+    }
+
     // Receive a message from the queue.
     if (const Receive::Result rc = posixQueue().receive(payload, priority)) {
-        return rc;                                                    // RETURN
+        return recordFailure(rc);                                     // RETURN
     }
 
     // Decode the message in place.
-    return d_decoder(payload);
+    return decode(payload, d_decoder);
 }
 
 int QueueReceiver::receive(bsl::string               *payload,
@@ -82,14 +276,29 @@ int QueueReceiver::receive(bsl::string               *payload,
         return rc;                                                    // RETURN
     }
 
+    if (d_reassembler_mp) {
+        // The timeout applies to the fragments as a whole.
+        const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                            relativeTimeout;
+        const bool               block    = true;
+        return receiveFragments(payload, &deadline, block, priority); // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                            relativeTimeout;
+        const bool               block    = true;
+        return receivePacked(payload, &deadline, block, priority);    // RETURN
+    }
+
     // Receive a message from the queue.
     if (const Receive::Result rc = posixQueue().receive(
             payload, bdlt::CurrentTime::now() + relativeTimeout, priority)) {
-        return rc;                                                    // RETURN
+        return recordFailure(rc);                                     // RETURN
     }
 
     // Decode the message in place.
-    return d_decoder(payload);
+    return decode(payload, d_decoder);
 }
 
 int QueueReceiver::tryReceive(bsl::string *payload, unsigned *priority)
@@ -97,18 +306,377 @@ int QueueReceiver::tryReceive(bsl::string *payload, unsigned *priority)
     using namespace PosixQueueTypes;
     BSLS_ASSERT(payload);
 
-    // 'tryReceive' is non-blocking
-    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(true)) {
+    if (d_reassembler_mp) {
+        const bool block = false;
+        return receiveFragments(payload, 0, block, priority);         // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bool block = false;
+        return receivePacked(payload, 0, block, priority);            // RETURN
+    }
+
+    // 'tryReceive' is non-blocking. Note that 'PosixQueue::tryReceive' does
+    // not change the mode of the queue, so there's no need to
+    // 'setNonBlocking'.
+    if (const Receive::Result rc =
+            posixQueue().tryReceive(payload, priority)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+
+    // Decode the message in place.
+    return decode(payload, d_decoder);
+}
+
+int QueueReceiver::receive(MessageBuffer *payload)
+{
+    return receive(payload, 0);
+}
+
+int QueueReceiver::receive(MessageBuffer             *payload,
+                           const bsls::TimeInterval&  relativeTimeout)
+{
+    return receive(payload, relativeTimeout, 0);
+}
+
+int QueueReceiver::tryReceive(MessageBuffer *payload)
+{
+    return tryReceive(payload, 0);
+}
+
+int QueueReceiver::receive(MessageBuffer *payload, unsigned *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    // This 'receive' is blocking (and without a timeout)
+    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(false)) {
         return rc;                                                    // RETURN
     }
 
-    // Receive a message from the queue.
-    if (const Receive::Result rc = posixQueue().receive(payload, priority)) {
+    if (d_reassembler_mp) {
+        const bool block = true;
+        return receiveFragments(payload, 0, block, priority);         // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bool block = true;
+        return receivePacked(payload, 0, block, priority);            // RETURN
+    }
+
+    // Receive a message from the queue directly into 'payload'. 'reserve'
+    // allocates only the first time, or if the queue's message size grew.
+    payload->reserve(posixQueue().maxMessageSize());
+
+    bsl::size_t length = 0;
+    if (const Receive::Result rc = posixQueue().receive(
+            payload->data(), payload->capacity(), &length, priority)) {
+        payload->clear();
+        return recordFailure(rc);                                     // RETURN
+    }
+    payload->setLength(length);
+
+    // Decode the message in place.
+    return decode(payload, d_bufferDecoder);
+}
+
+int QueueReceiver::receive(MessageBuffer             *payload,
+                           const bsls::TimeInterval&  relativeTimeout,
+                           unsigned                  *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    // This 'receive' is blocking (though with a timeout)
+    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(false)) {
         return rc;                                                    // RETURN
     }
 
+    if (d_reassembler_mp) {
+        // The timeout applies to the fragments as a whole.
+        const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                            relativeTimeout;
+        const bool               block    = true;
+        return receiveFragments(payload, &deadline, block, priority); // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                            relativeTimeout;
+        const bool               block    = true;
+        return receivePacked(payload, &deadline, block, priority);    // RETURN
+    }
+
+    payload->reserve(posixQueue().maxMessageSize());
+
+    bsl::size_t length = 0;
+    if (const Receive::Result rc = posixQueue().receive(
+            payload->data(),
+            payload->capacity(),
+            &length,
+            bdlt::CurrentTime::now() + relativeTimeout,
+            priority)) {
+        payload->clear();
+        return recordFailure(rc);                                     // RETURN
+    }
+    payload->setLength(length);
+
     // Decode the message in place.
-    return d_decoder(payload);
+    return decode(payload, d_bufferDecoder);
+}
+
+int QueueReceiver::tryReceive(MessageBuffer *payload, unsigned *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    if (d_reassembler_mp) {
+        const bool block = false;
+        return receiveFragments(payload, 0, block, priority);         // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bool block = false;
+        return receivePacked(payload, 0, block, priority);            // RETURN
+    }
+
+    payload->reserve(posixQueue().maxMessageSize());
+
+    bsl::size_t length = 0;
+    if (const Receive::Result rc = posixQueue().tryReceive(
+            payload->data(), payload->capacity(), &length, priority)) {
+        payload->clear();
+        return recordFailure(rc);                                     // RETURN
+    }
+    payload->setLength(length);
+
+    // Decode the message in place.
+    return decode(payload, d_bufferDecoder);
+}
+
+int QueueReceiver::receive(Payload *payload)
+{
+    return receive(payload, 0);
+}
+
+int QueueReceiver::receive(Payload                   *payload,
+                           const bsls::TimeInterval&  relativeTimeout)
+{
+    return receive(payload, relativeTimeout, 0);
+}
+
+int QueueReceiver::tryReceive(Payload *payload)
+{
+    return tryReceive(payload, 0);
+}
+
+int QueueReceiver::receive(Payload *payload, unsigned *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    // Release any file mapped by the previous message.
+    payload->reset();
+
+    // This 'receive' is blocking (and without a timeout)
+    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(false)) {
+        return rc;                                                    // RETURN
+    }
+
+    if (d_reassembler_mp) {
+        const bool block = true;
+        return receiveFragments(payload, 0, block, priority);         // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bool block = true;
+        return receivePacked(payload, 0, block, priority);            // RETURN
+    }
+
+    MessageBuffer& buffer = payload->buffer();
+    buffer.reserve(posixQueue().maxMessageSize());
+
+    bsl::size_t length = 0;
+    if (const Receive::Result rc = posixQueue().receive(
+            buffer.data(), buffer.capacity(), &length, priority)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+    buffer.setLength(length);
+
+    // Decode the message in place, or map the file that it refers to.
+    return decode(payload, d_payloadDecoder);
+}
+
+int QueueReceiver::receive(Payload                   *payload,
+                           const bsls::TimeInterval&  relativeTimeout,
+                           unsigned                  *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    // Release any file mapped by the previous message.
+    payload->reset();
+
+    // This 'receive' is blocking (though with a timeout)
+    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(false)) {
+        return rc;                                                    // RETURN
+    }
+
+    if (d_reassembler_mp) {
+        // The timeout applies to the fragments as a whole.
+        const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                            relativeTimeout;
+        const bool               block    = true;
+        return receiveFragments(payload, &deadline, block, priority); // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                            relativeTimeout;
+        const bool               block    = true;
+        return receivePacked(payload, &deadline, block, priority);    // RETURN
+    }
+
+    MessageBuffer& buffer = payload->buffer();
+    buffer.reserve(posixQueue().maxMessageSize());
+
+    bsl::size_t length = 0;
+    if (const Receive::Result rc = posixQueue().receive(
+            buffer.data(),
+            buffer.capacity(),
+            &length,
+            bdlt::CurrentTime::now() + relativeTimeout,
+            priority)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+    buffer.setLength(length);
+
+    // Decode the message in place, or map the file that it refers to.
+    return decode(payload, d_payloadDecoder);
+}
+
+int QueueReceiver::tryReceive(Payload *payload, unsigned *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    // Release any file mapped by the previous message.
+    payload->reset();
+
+    if (d_reassembler_mp) {
+        const bool block = false;
+        return receiveFragments(payload, 0, block, priority);         // RETURN
+    }
+
+    if (d_backlog_mp) {
+        const bool block = false;
+        return receivePacked(payload, 0, block, priority);            // RETURN
+    }
+
+    MessageBuffer& buffer = payload->buffer();
+    buffer.reserve(posixQueue().maxMessageSize());
+
+    bsl::size_t length = 0;
+    if (const Receive::Result rc = posixQueue().tryReceive(
+            buffer.data(), buffer.capacity(), &length, priority)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+    buffer.setLength(length);
+
+    // Decode the message in place, or map the file that it refers to.
+    return decode(payload, d_payloadDecoder);
+}
+
+int QueueReceiver::receiveBatch(
+                       MessageBuffer                              *arena,
+                       bsl::vector<PosixQueue::MessageDescriptor> *payloads,
+                       bsl::size_t                                 maxMessages)
+{
+    using namespace PosixQueueTypes;
+
+    // This 'receiveBatch' is blocking (and without a timeout)
+    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(false)) {
+        return rc;                                                    // RETURN
+    }
+
+    // Payloads left over from a packed message are delivered before any
+    // other message is received.
+    if (hasUnpackedPayloads() && 0 == receiveBacklog(arena, payloads)) {
+        return 0;                                                     // RETURN
+    }
+
+    if (const Receive::Result rc =
+            posixQueue().receiveBatch(arena, payloads, maxMessages)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+
+    return decodeBatch(arena, payloads);
+}
+
+int QueueReceiver::receiveBatch(
+                   MessageBuffer                              *arena,
+                   bsl::vector<PosixQueue::MessageDescriptor> *payloads,
+                   bsl::size_t                                 maxMessages,
+                   const bsls::TimeInterval&                   relativeTimeout)
+{
+    using namespace PosixQueueTypes;
+
+    // This 'receiveBatch' is blocking (though with a timeout)
+    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(false)) {
+        return rc;                                                    // RETURN
+    }
+
+    // Payloads left over from a packed message are delivered before any
+    // other message is received.
+    if (hasUnpackedPayloads() && 0 == receiveBacklog(arena, payloads)) {
+        return 0;                                                     // RETURN
+    }
+
+    if (const Receive::Result rc = posixQueue().receiveBatch(
+            arena,
+            payloads,
+            maxMessages,
+            bdlt::CurrentTime::now() + relativeTimeout)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+
+    return decodeBatch(arena, payloads);
+}
+
+int QueueReceiver::tryReceiveBatch(
+                       MessageBuffer                              *arena,
+                       bsl::vector<PosixQueue::MessageDescriptor> *payloads,
+                       bsl::size_t                                 maxMessages)
+{
+    using namespace PosixQueueTypes;
+
+    // Payloads left over from a packed message are delivered before any
+    // other message is received.
+    if (hasUnpackedPayloads() && 0 == receiveBacklog(arena, payloads)) {
+        return 0;                                                     // RETURN
+    }
+
+    if (const Receive::Result rc =
+            posixQueue().tryReceiveBatch(arena, payloads, maxMessages)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+
+    return decodeBatch(arena, payloads);
+}
+
+void QueueReceiver::setFragmentLimits(bsl::size_t maxPendingBytes,
+                                      bsl::size_t maxPendingStreams)
+{
+    BSLS_ASSERT(maxPendingStreams > 0);
+
+    if (d_reassembler_mp) {
+        d_reassembler_mp->setLimits(maxPendingBytes, maxPendingStreams);
+    }
+}
+
+void QueueReceiver::resetMetrics()
+{
+    d_metrics.reset();
 }
 
 int QueueReceiver::unlink()
@@ -122,12 +690,243 @@ PosixQueue& QueueReceiver::posixQueue()
         static_cast<const QueueReceiver&>(*this).posixQueue());
 }
 
+template <typename PAYLOAD>
+int QueueReceiver::receiveFragments(PAYLOAD                  *payload,
+                                    const bsls::TimeInterval *deadline,
+                                    bool                      block,
+                                    unsigned                 *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(d_reassembler_mp);
+
+    // The time spent reassembling and decoding each fragment counts toward
+    // the time to decode the payload.
+    bsls::Types::Int64 decodeTime = 0;
+
+    for (;;) {
+        if (const Receive::Result rc = receiveMessage(
+                &posixQueue(), payload, deadline, block, priority)) {
+            return recordFailure(rc);                                 // RETURN
+        }
+
+        if (FormatUtil::isExternal(contents(*payload))) {
+            d_metrics.recordExternalPayload();
+        }
+
+        const bsls::Types::Int64 start = bsls::TimeUtil::getTimer();
+        bool                     isComplete;
+        const int                rc    = reassemble(&isComplete, payload);
+        decodeTime += bsls::TimeUtil::getTimer() - start;
+        if (rc) {
+            return recordFailure(rc);                                 // RETURN
+        }
+
+        if (isComplete) {
+            d_metrics.recordCodingTime(decodeTime);
+            d_metrics.recordMessage(contents(*payload).length());
+            return 0;                                                 // RETURN
+        }
+    }
+}
+
+template <typename PAYLOAD>
+int QueueReceiver::receivePacked(PAYLOAD                  *payload,
+                                 const bsls::TimeInterval *deadline,
+                                 bool                      block,
+                                 unsigned                 *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(d_backlog_mp);
+
+    // Payloads left over from a packed message are delivered before any
+    // other message is received.
+    if (popBacklog(d_backlog_mp.get(), payload, priority)) {
+        d_metrics.recordMessage(contents(*payload).length());
+        return 0;                                                     // RETURN
+    }
+
+    unsigned messagePriority = 0;
+    if (const Receive::Result rc = receiveMessage(
+            &posixQueue(), payload, deadline, block, &messagePriority)) {
+        return recordFailure(rc);                                     // RETURN
+    }
+    if (priority) {
+        *priority = messagePriority;
+    }
+
+    if (!FormatUtil::isPacked(contents(*payload))) {
+        return decodeMessage(payload);                                // RETURN
+    }
+
+    // The payloads after the first refer to 'payload', so they are copied
+    // into the backlog before 'payload' is shortened to the first. The time
+    // to unpack the message is divided evenly among its payloads.
+    bdlma::LocalSequentialAllocator<64 * sizeof(bslstl::StringRef)> arena;
+    bsl::vector<bslstl::StringRef> payloads(&arena);
+
+    const bsls::Types::Int64 start = bsls::TimeUtil::getTimer();
+    if (const int rc = FormatUtil::unpack(&payloads, contents(*payload))) {
+        return recordFailure(rc);                                     // RETURN
+    }
+    d_backlog_mp->push(payloads.data() + 1,
+                       payloads.data() + payloads.size(),
+                       messagePriority);
+    keepOnly(payload, payloads.front());
+
+    const bsls::Types::Int64 numPayloads = payloads.size();
+    d_metrics.recordCodingTime(
+        (bsls::TimeUtil::getTimer() - start) / numPayloads, numPayloads);
+    d_metrics.recordMessage(contents(*payload).length());
+    return 0;
+}
+
+template <typename PAYLOAD, typename DECODER>
+int QueueReceiver::decode(PAYLOAD *payload, DECODER decoder)
+{
+    if (d_format != Format::e_RAW &&
+        FormatUtil::isExternal(contents(*payload))) {
+        d_metrics.recordExternalPayload();
+    }
+
+    const bsls::Types::Int64 start = bsls::TimeUtil::getTimer();
+    const int                rc    = decoder(payload);
+    d_metrics.recordCodingTime(bsls::TimeUtil::getTimer() - start);
+    if (rc) {
+        return recordFailure(rc);                                     // RETURN
+    }
+
+    d_metrics.recordMessage(contents(*payload).length());
+    return 0;
+}
+
+int QueueReceiver::receiveBacklog(
+                         MessageBuffer                              *arena,
+                         bsl::vector<PosixQueue::MessageDescriptor> *payloads)
+{
+    if (!d_backlog_mp || !d_backlog_mp->popAll(arena, payloads)) {
+        return PosixQueueTypes::Receive::e_EMPTY;                     // RETURN
+    }
+
+    for (bsl::size_t i = 0; i < payloads->size(); ++i) {
+        d_metrics.recordMessage((*payloads)[i].d_length);
+    }
+
+    return 0;
+}
+
+int QueueReceiver::decodeMessage(bsl::string *payload)
+{
+    return decode(payload, d_decoder);
+}
+
+int QueueReceiver::decodeMessage(MessageBuffer *payload)
+{
+    return decode(payload, d_bufferDecoder);
+}
+
+int QueueReceiver::decodeMessage(Payload *payload)
+{
+    return decode(payload, d_payloadDecoder);
+}
+
+int QueueReceiver::reassemble(bool *isComplete, bsl::string *payload)
+{
+    return FormatUtil::reassemble(
+        isComplete, payload, d_reassembler_mp.get(), d_decoder);
+}
+
+int QueueReceiver::reassemble(bool *isComplete, MessageBuffer *payload)
+{
+    return FormatUtil::reassemble(
+        isComplete, payload, d_reassembler_mp.get(), d_bufferDecoder);
+}
+
+int QueueReceiver::reassemble(bool *isComplete, Payload *payload)
+{
+    return FormatUtil::reassemble(
+        isComplete, payload, d_reassembler_mp.get(), d_payloadDecoder);
+}
+
+int QueueReceiver::decodeBatch(
+                         MessageBuffer                              *arena,
+                         bsl::vector<PosixQueue::MessageDescriptor> *payloads)
+{
+    if (d_format != Format::e_RAW) {
+        for (bsl::size_t i = 0; i < payloads->size(); ++i) {
+            const PosixQueue::MessageDescriptor& message = (*payloads)[i];
+            if (FormatUtil::isExternal(
+                    arena->stringRef(message.d_offset, message.d_length))) {
+                d_metrics.recordExternalPayload();
+            }
+        }
+    }
+
+    // The decoder is invoked once for the whole batch. It drops (and logs)
+    // any message that it cannot decode, so the batch is a success if any
+    // message remains.
+    const bsl::size_t        numMessages = payloads->size();
+    const bsls::Types::Int64 start       = bsls::TimeUtil::getTimer();
+    const int                rc          =
+        d_reassembler_mp
+            ? FormatUtil::reassembleBatch(
+                  arena, payloads, d_format, d_reassembler_mp.get())
+            : d_batchDecoder(arena, payloads);
+    const bsls::Types::Int64 decodeTime  =
+                                       bsls::TimeUtil::getTimer() - start;
+
+    // The time to decode the batch is divided evenly among its payloads.
+    // Messages dropped by the decoder count as errors, except for fragments
+    // of payloads that are not yet complete.
+    const bsls::Types::Int64 numDecoded = payloads->size();
+    if (numDecoded) {
+        d_metrics.recordCodingTime(decodeTime / numDecoded, numDecoded);
+    }
+    for (bsl::size_t i = 0; i < payloads->size(); ++i) {
+        d_metrics.recordMessage((*payloads)[i].d_length);
+    }
+    if (!d_reassembler_mp) {
+        for (bsl::size_t i = payloads->size(); i < numMessages; ++i) {
+            d_metrics.recordError();
+        }
+    }
+
+    return payloads->empty() ? recordFailure(rc) : 0;
+}
+
+int QueueReceiver::recordFailure(int rc)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(rc);
+
+    if (rc == Receive::e_EMPTY) {
+        d_metrics.recordWouldBlock();
+    }
+    else if (rc == Receive::e_TIMED_OUT) {
+        d_metrics.recordTimeout();
+    }
+    else {
+        d_metrics.recordError();
+    }
+
+    return rc;
+}
+
 // ACCESSORS
+void QueueReceiver::loadMetrics(MetricsSnapshot *result) const
+{
+    d_metrics.loadSnapshot(result);
+}
+
 bool QueueReceiver::isOpen() const
 {
     return posixQueue().isOpen();
 }
 
+bool QueueReceiver::hasUnpackedPayloads() const
+{
+    return d_backlog_mp && !d_backlog_mp->isEmpty();
+}
+
 IPCU_DEFINE_OPERATOR_BOOL(QueueReceiver)
 {
     IPCU_RETURN_OPERATOR_BOOL(QueueReceiver, isOpen());
@@ -3,31 +3,57 @@
 
 #include <ipcmq_format.h>
 #include <ipcmq_formatutil.h>
+#include <ipcmq_metrics.h>
 #include <ipcu_operatorbool.h>
 #include <ipcmq_posixqueue.h>
 #include <ipcmq_receiver.h>
 
 #include <bdlb_variant.h>
 
+#include <bslma_managedptr.h>
+
+#include <bsl_cstddef.h>
 #include <bsl_string.h>
+#include <bsl_vector.h>
 
 namespace BloombergLP {
 namespace bslma { class Allocator; }
 namespace bsls { class TimeInterval; }
 namespace ipcmq {
 
+class FragmentReassembler;
+class MessageBuffer;
+class PackedBacklog;
+class Payload;
+
                             // ===================
                             // class QueueReceiver
                             // ===================
 
 class QueueReceiver : public Receiver {
     // This class implements the 'Receiver' protocol using a 'PosixQueue'
-    // object.
+    // object. If the 'Format::e_FRAGMENTED' or 'Format::e_TAGGED' format is
+    // used, then each receive operation receives messages until it has a
+    // whole payload, reassembling payloads that were sent as fragments.
+    // Fragments from any number of senders may be interleaved, and several
+    // threads may receive using the same object. However, a payload can be
+    // reassembled only if all of its fragments are received by the same
+    // 'QueueReceiver'. If the 'Format::e_PACKED' format is used, then each
+    // packed message is unpacked: its first payload is delivered, and the
+    // rest are delivered, in order, by the next receive operations, before
+    // any other message is received.
 
     // DATA
     bdlb::Variant2<PosixQueue, PosixQueue *> d_queue;
     FormatUtil::Decoder                      d_decoder;
+    FormatUtil::BufferDecoder                d_bufferDecoder;
+    FormatUtil::PayloadDecoder               d_payloadDecoder;
+    FormatUtil::BatchDecoder                 d_batchDecoder;
+    Format                                   d_format;
+    bslma::ManagedPtr<FragmentReassembler>   d_reassembler_mp;  // may be 0
+    bslma::ManagedPtr<PackedBacklog>         d_backlog_mp;      // may be 0
     PosixQueue::Open::Result                 d_openResult;
+    Metrics                                  d_metrics;
 
   public:
     // CREATORS
@@ -74,11 +100,128 @@ class QueueReceiver : public Receiver {
         // message received. Do not block. Return zero if a message is
         // successfully received or a nonzero value otherwise.
 
+    int receive(MessageBuffer *payload);
+    int receive(MessageBuffer *payload, unsigned *priority);
+    int receive(MessageBuffer             *payload,
+                const bsls::TimeInterval&  relativeTimeout);
+    int receive(MessageBuffer             *payload,
+                const bsls::TimeInterval&  relativeTimeout,
+                unsigned                  *priority);
+        // Load into the specified 'payload' the content of the next available
+        // message on the queue represented by this object. Assign through the
+        // optionally specified 'priority' the priority of the message
+        // received. Block for no longer than the optionally specified
+        // 'relativeTimeout', relative to the beginning of the invocation of
+        // this function. Return zero if a message is successfully received or
+        // a nonzero value otherwise. Note that, unlike the 'bsl::string'
+        // overloads, these functions never initialize the storage of
+        // 'payload', so reusing one 'MessageBuffer' for many messages writes
+        // only the bytes of the messages received.
+
+    int tryReceive(MessageBuffer *payload);
+    int tryReceive(MessageBuffer *payload, unsigned *priority);
+        // Load into the specified 'payload' the content of the next available
+        // message on the queue represented by this object. Assign through the
+        // optionally specified 'priority' the priority of the message
+        // received. Do not block. Return zero if a message is successfully
+        // received or a nonzero value otherwise.
+
+    int receive(Payload *payload);
+    int receive(Payload *payload, unsigned *priority);
+    int receive(Payload                   *payload,
+                const bsls::TimeInterval&  relativeTimeout);
+    int receive(Payload                   *payload,
+                const bsls::TimeInterval&  relativeTimeout,
+                unsigned                  *priority);
+        // Load into the specified 'payload' the content of the next available
+        // message on the queue represented by this object, releasing whatever
+        // 'payload' held before. Assign through the optionally specified
+        // 'priority' the priority of the message received. Block for no
+        // longer than the optionally specified 'relativeTimeout', relative to
+        // the beginning of the invocation of this function. Return zero if a
+        // message is successfully received or a nonzero value otherwise. Note
+        // that a payload in an external file is mapped into memory rather
+        // than copied, so that receiving a large payload neither allocates
+        // nor reads the file up front.
+
+    int tryReceive(Payload *payload);
+    int tryReceive(Payload *payload, unsigned *priority);
+        // Load into the specified 'payload' the content of the next available
+        // message on the queue represented by this object, releasing whatever
+        // 'payload' held before. Assign through the optionally specified
+        // 'priority' the priority of the message received. Do not block.
+        // Return zero if a message is successfully received or a nonzero
+        // value otherwise.
+
+    int receiveBatch(
+                  MessageBuffer                              *arena,
+                  bsl::vector<PosixQueue::MessageDescriptor> *payloads,
+                  bsl::size_t                                 maxMessages);
+    int receiveBatch(
+                  MessageBuffer                              *arena,
+                  bsl::vector<PosixQueue::MessageDescriptor> *payloads,
+                  bsl::size_t                                 maxMessages,
+                  const bsls::TimeInterval&                   relativeTimeout);
+        // Receive up to the specified 'maxMessages' messages from the queue
+        // represented by this object into the specified 'arena', decode them,
+        // and load into the specified 'payloads' the offset within 'arena',
+        // length, and priority of each decoded payload, in the order received.
+        // If a 'relativeTimeout' is specified, receive messages until
+        // 'maxMessages' have been received or 'relativeTimeout' has elapsed
+        // since the beginning of the invocation of this function. Otherwise,
+        // block until one message is available and then receive only messages
+        // that are immediately available. Return zero if at least one payload
+        // was received and decoded, or a nonzero value otherwise. Messages
+        // that cannot be decoded are omitted from 'payloads'. Note that
+        // 'arena' and 'payloads' are cleared first but keep their capacity, so
+        // reusing them avoids allocating memory for each batch. Also note
+        // that with the 'Format::e_FRAGMENTED' and 'Format::e_TAGGED'
+        // formats, fragments that do not complete a payload are omitted from
+        // 'payloads' without failing the batch, and that with the
+        // 'Format::e_PACKED' format, each payload of a packed message is
+        // described separately, so that 'payloads' may describe more than
+        // 'maxMessages' payloads. The behavior is undefined unless
+        // '0 < maxMessages'.
+
+    int tryReceiveBatch(
+                  MessageBuffer                              *arena,
+                  bsl::vector<PosixQueue::MessageDescriptor> *payloads,
+                  bsl::size_t                                 maxMessages);
+        // Receive up to the specified 'maxMessages' messages that are
+        // immediately available on the queue represented by this object into
+        // the specified 'arena', decode them, and describe each decoded
+        // payload in the specified 'payloads', as described for
+        // 'receiveBatch'. Do not block. Return zero if at least one payload
+        // was received and decoded, or a nonzero value otherwise. The behavior
+        // is undefined unless '0 < maxMessages'.
+
+    void setFragmentLimits(bsl::size_t maxPendingBytes,
+                           bsl::size_t maxPendingStreams);
+        // If this object uses the 'Format::e_FRAGMENTED' or
+        // 'Format::e_TAGGED' format, set the maximum number of bytes that
+        // incompletely received payloads may occupy to the specified
+        // 'maxPendingBytes', and the maximum number of incompletely received
+        // payloads to the specified 'maxPendingStreams'. Otherwise, do
+        // nothing. When the fragments of a new payload would exceed either
+        // limit, the least recently started incomplete payloads are
+        // discarded. The behavior is undefined unless
+        // '0 < maxPendingStreams'.
+
     int unlink();
         // Mark for deletion the message queue opened by this object. Return
         // zero on success or a nonzero value otherwise.
 
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero.
+
     // ACCESSORS
+    void loadMetrics(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the payloads received by this
+        // object, the attempts that failed, and the time taken to decode each
+        // payload. Note that a payload received as fragments counts once, and
+        // that a nonblocking attempt that finds the queue empty counts as an
+        // attempt that would block.
+
     PosixQueue::Open::Result openResult() const;
         // Return the result of having opened this queue. The behavior is
         // undefined unless this object owns its 'PosixQueue'.
@@ -86,6 +229,13 @@ class QueueReceiver : public Receiver {
     bool isOpen() const;
         // Return whether this object represents an open message queue.
 
+    bool hasUnpackedPayloads() const;
+        // Return whether payloads unpacked from a packed message are waiting
+        // to be delivered by the next receive operation. Note that the
+        // queue's file descriptor does not become readable for such
+        // payloads, so a caller that waits for the descriptor should first
+        // receive until this function returns 'false'.
+
     IPCU_DECLARE_OPERATOR_BOOL(QueueReceiver);
         // Return 'isOpen()'.
 
@@ -105,6 +255,73 @@ class QueueReceiver : public Receiver {
     PosixQueue& posixQueue();
         // Return a reference providing modifiable access to the 'PosixQueue'
         // instance used to implement this object.
+
+    template <typename PAYLOAD>
+    int receiveFragments(PAYLOAD                  *payload,
+                         const bsls::TimeInterval *deadline,
+                         bool                      block,
+                         unsigned                 *priority);
+        // Receive messages into the specified 'payload' until they complete a
+        // payload, and assign through the specified 'priority' the priority
+        // of the last. If the specified 'block' is 'false', do not block.
+        // Otherwise, block until the specified 'deadline', or indefinitely if
+        // 'deadline' is zero. Return zero if a payload is completed or a
+        // nonzero value otherwise. Note that fragments received before a
+        // failure are kept, so that a later call can complete their payload.
+        // The behavior is undefined unless this object has a reassembler.
+
+    template <typename PAYLOAD>
+    int receivePacked(PAYLOAD                  *payload,
+                      const bsls::TimeInterval *deadline,
+                      bool                      block,
+                      unsigned                 *priority);
+        // Load into the specified 'payload' the next payload left over from a
+        // packed message, or otherwise receive a message into 'payload' and
+        // decode it, unpacking it if it is packed. Assign through the
+        // specified 'priority' the priority of the message. If the specified
+        // 'block' is 'false', do not block. Otherwise, block until the
+        // specified 'deadline', or indefinitely if 'deadline' is zero. Return
+        // zero if a payload is loaded or a nonzero value otherwise. The
+        // behavior is undefined unless this object has a backlog.
+
+    int receiveBacklog(MessageBuffer                              *arena,
+                       bsl::vector<PosixQueue::MessageDescriptor> *payloads);
+        // Load into the specified 'arena' every payload left over from
+        // packed messages, and into the specified 'payloads' a descriptor of
+        // each. Return zero if any payload is loaded, or
+        // 'PosixQueue::Receive::e_EMPTY' otherwise.
+
+    int decodeMessage(bsl::string *payload);
+    int decodeMessage(MessageBuffer *payload);
+    int decodeMessage(Payload *payload);
+        // Decode in place the message in the specified 'payload' using the
+        // decoder of this object for its type, and count it in the metrics of
+        // this object. Return zero on success or a nonzero value otherwise.
+
+    int reassemble(bool *isComplete, bsl::string *payload);
+    int reassemble(bool *isComplete, MessageBuffer *payload);
+    int reassemble(bool *isComplete, Payload *payload);
+        // Decode the message in the specified 'payload', adding it to the
+        // reassembler if it is a fragment, and assign through the specified
+        // 'isComplete' whether 'payload' now holds a whole payload. Return
+        // zero on success or a nonzero value otherwise. The behavior is
+        // undefined unless this object has a reassembler.
+
+    template <typename PAYLOAD, typename DECODER>
+    int decode(PAYLOAD *payload, DECODER decoder);
+        // Decode in place the message received into the specified 'payload'
+        // using the specified 'decoder', and count it in the metrics of this
+        // object. Return zero on success or a nonzero value otherwise.
+
+    int decodeBatch(MessageBuffer                              *arena,
+                    bsl::vector<PosixQueue::MessageDescriptor> *payloads);
+        // Decode in place the messages within the specified 'arena' described
+        // by the specified 'payloads'. Return zero if at least one message
+        // was decoded, or a nonzero value otherwise.
+
+    int recordFailure(int rc);
+        // Count in the metrics of this object the specified nonzero result
+        // 'rc' of a failed attempt to receive, and return 'rc'.
 };
 
 }  // close package namespace
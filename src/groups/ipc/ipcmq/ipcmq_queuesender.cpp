@@ -1,11 +1,17 @@
 
 #include <ipcmq_queuesender.h>
+#include <ipcmq_fragmentreassembler.h>
 #include <ipcu_algoutil.h>
 
 #include <bdlma_localsequentialallocator.h>
 
 #include <bdlt_currenttime.h>
 
+#include <bsls_timeutil.h>
+#include <bsls_types.h>
+
+#include <bsl_climits.h>
+
 namespace BloombergLP {
 namespace ipcmq {
 namespace {
@@ -25,6 +31,10 @@ QueueSender::QueueSender(const bslstl::StringRef&       name,
                          bslma::Allocator              *messageAllocator)
 : d_queue(allocator)
 , d_encoder(FormatUtil::encoder(format))
+, d_isRaw(format == Format::e_RAW)
+, d_isFragmented(format == Format::e_FRAGMENTED)
+, d_isTagged(format == Format::e_TAGGED)
+, d_isPacked(format == Format::e_PACKED)
 , d_messageAllocator(messageAllocator)
 {
     d_queue.createInPlace<PosixQueue>(allocator);
@@ -42,6 +52,10 @@ QueueSender::QueueSender(PosixQueue       *queue,
                          bslma::Allocator *messageAllocator)
 : d_queue(queue)
 , d_encoder(FormatUtil::encoder(format))
+, d_isRaw(format == Format::e_RAW)
+, d_isFragmented(format == Format::e_FRAGMENTED)
+, d_isTagged(format == Format::e_TAGGED)
+, d_isPacked(format == Format::e_PACKED)
 , d_messageAllocator(messageAllocator)
 {
     BSLS_ASSERT(queue);
@@ -57,15 +71,12 @@ int QueueSender::send(const bslstl::StringRef& payload, int priority)
         return rc;                                                    // RETURN
     }
 
-    bslstl::StringRef encodedMessage = payload;
-    LocalAllocator    allocator(d_messageAllocator);
-    bsl::string       messageBuffer(&allocator);
-    if (const int rc = d_encoder(
-            posixQueue().maxMessageSize(), &encodedMessage, &messageBuffer)) {
-        return rc;                                                    // RETURN
-    }
-
-    return posixQueue().send(encodedMessage, priority);
+    LocalAllocator                  allocator(d_messageAllocator);
+    bsl::string                     messageBuffer(&allocator);
+    const bsls::TimeInterval *const noDeadline = 0;
+    const bool                      blocking   = true;
+    return sendPayload(
+        payload, &messageBuffer, noDeadline, blocking, priority);
 }
 
 int QueueSender::send(const bslstl::StringRef&  payload,
@@ -79,36 +90,74 @@ int QueueSender::send(const bslstl::StringRef&  payload,
         return rc;                                                    // RETURN
     }
 
-    bslstl::StringRef encodedMessage = payload;
-    LocalAllocator    allocator(d_messageAllocator);
-    bsl::string       messageBuffer(&allocator);
-    if (const int rc = d_encoder(
-            posixQueue().maxMessageSize(), &encodedMessage, &messageBuffer)) {
-        return rc;                                                    // RETURN
-    }
-
-    return posixQueue().send(
-        encodedMessage, bdlt::CurrentTime::now() + relativeTimeout, priority);
+    // If the payload is sent as fragments, the timeout applies to the
+    // fragments as a whole.
+    const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                        relativeTimeout;
+    LocalAllocator           allocator(d_messageAllocator);
+    bsl::string              messageBuffer(&allocator);
+    const bool               blocking = true;
+    return sendPayload(payload, &messageBuffer, &deadline, blocking, priority);
 }
 
 int QueueSender::trySend(const bslstl::StringRef& payload, int priority)
 {
-    using namespace PosixQueueTypes;
+    // 'trySend' does not block. Note that 'PosixQueue::trySend' does not
+    // change the mode of the queue, so there's no need to 'setNonBlocking'.
+    LocalAllocator                  allocator(d_messageAllocator);
+    bsl::string                     messageBuffer(&allocator);
+    const bsls::TimeInterval *const noDeadline = 0;
+    const bool                      blocking   = false;
+    return sendPayload(
+        payload, &messageBuffer, noDeadline, blocking, priority);
+}
 
-    // 'trySend' does not block.
-    if (const SetNonBlocking::Result rc = posixQueue().setNonBlocking(true)) {
-        return rc;                                                    // RETURN
+int QueueSender::sendBatch(const bslstl::StringRef *begin,
+                           const bslstl::StringRef *end,
+                           bsl::size_t             *numSent,
+                           int                      priority)
+{
+    const bsls::TimeInterval *const noDeadline = 0;
+    const bool                      blocking   = true;
+    return sendBatchImp(begin, end, numSent, noDeadline, blocking, priority);
+}
+
+int QueueSender::sendBatch(const bslstl::StringRef   *begin,
+                           const bslstl::StringRef   *end,
+                           bsl::size_t               *numSent,
+                           const bsls::TimeInterval&  relativeTimeout,
+                           int                        priority)
+{
+    // The timeout applies to the batch as a whole.
+    const bsls::TimeInterval deadline = bdlt::CurrentTime::now() +
+                                        relativeTimeout;
+    const bool               blocking = true;
+    return sendBatchImp(begin, end, numSent, &deadline, blocking, priority);
+}
+
+int QueueSender::trySendBatch(const bslstl::StringRef *begin,
+                              const bslstl::StringRef *end,
+                              bsl::size_t             *numSent,
+                              int                      priority)
+{
+    const bsls::TimeInterval *const noDeadline = 0;
+    const bool                      blocking   = false;
+    return sendBatchImp(begin, end, numSent, noDeadline, blocking, priority);
+}
+
+int QueueSender::setCodec(unsigned char tag)
+{
+    if (!d_isTagged) {
+        return 1;                                                     // RETURN
     }
 
-    bslstl::StringRef encodedMessage = payload;
-    LocalAllocator    allocator(d_messageAllocator);
-    bsl::string       messageBuffer(&allocator);
-    if (const int rc = d_encoder(
-            posixQueue().maxMessageSize(), &encodedMessage, &messageBuffer)) {
-        return rc;                                                    // RETURN
+    const Codec *const codec = FormatUtil::tagCodec(tag);
+    if (!codec || !codec->d_encoder) {
+        return 2;                                                     // RETURN
     }
 
-    return posixQueue().send(encodedMessage, priority);
+    d_encoder = codec->d_encoder;
+    return 0;
 }
 
 int QueueSender::unlink()
@@ -116,13 +165,258 @@ int QueueSender::unlink()
     return PosixQueue::unlink(posixQueue().name());
 }
 
+void QueueSender::resetMetrics()
+{
+    d_metrics.reset();
+}
+
 PosixQueue& QueueSender::posixQueue()
 {
     return const_cast<PosixQueue&>(
         static_cast<const QueueSender&>(*this).posixQueue());
 }
 
+int QueueSender::sendBatchImp(const bslstl::StringRef  *begin,
+                              const bslstl::StringRef  *end,
+                              bsl::size_t              *numSent,
+                              const bsls::TimeInterval *deadline,
+                              bool                      blocking,
+                              int                       priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(begin <= end);
+    BSLS_ASSERT(numSent);
+
+    *numSent = 0;
+
+    // Set the mode once for the whole batch. 'trySend' doesn't need a mode.
+    if (blocking) {
+        if (const SetNonBlocking::Result rc =
+                posixQueue().setNonBlocking(false)) {
+            return rc;                                                // RETURN
+        }
+    }
+
+    // Every payload is encoded into the same buffer, which retains its
+    // capacity from one payload to the next.
+    LocalAllocator allocator(d_messageAllocator);
+    bsl::string    messageBuffer(&allocator);
+
+    // A packed sender packs as many consecutive payloads as fit into each
+    // message. A payload that does not fit with the next is sent by itself.
+    const bsl::size_t maxPackedLength =
+        d_isPacked ? FormatUtil::maxPackedLength(posixQueue().maxMessageSize())
+                   : 0;
+
+    const bslstl::StringRef *payload = begin;
+    while (payload != end) {
+        const bslstl::StringRef *packEnd      = payload;
+        bsl::size_t              packedLength = 0;
+        while (packEnd != end &&
+               packedLength + FormatUtil::packedLength(packEnd->length()) <=
+                   maxPackedLength) {
+            packedLength += FormatUtil::packedLength(packEnd->length());
+            ++packEnd;
+        }
+
+        messageBuffer.clear();
+        if (packEnd - payload > 1) {
+            if (const int rc = sendPack(payload,
+                                        packEnd,
+                                        &messageBuffer,
+                                        deadline,
+                                        blocking,
+                                        priority)) {
+                return rc;                                            // RETURN
+            }
+
+            *numSent += packEnd - payload;
+            payload   = packEnd;
+        }
+        else {
+            if (const int rc = sendPayload(
+                    *payload, &messageBuffer, deadline, blocking, priority)) {
+                return rc;                                            // RETURN
+            }
+
+            ++*numSent;
+            ++payload;
+        }
+    }
+
+    return 0;
+}
+
+int QueueSender::sendPayload(const bslstl::StringRef&  payload,
+                             bsl::string              *messageBuffer,
+                             const bsls::TimeInterval *deadline,
+                             bool                      blocking,
+                             int                       priority)
+{
+    BSLS_ASSERT(messageBuffer);
+
+    const long        maxMessageSize = posixQueue().maxMessageSize();
+    const bsl::size_t numBytes       = payload.length();
+    if (d_isFragmented && long(numBytes) >= maxMessageSize) {
+        const bool isEncoded = false;
+        return recordResult(
+            sendFragments(payload, isEncoded, deadline, blocking, priority),
+            numBytes);                                                // RETURN
+    }
+
+    // A tagged message is encoded without regard to the maximum message size,
+    // and then fragmented if it does not fit, so that the encoder never
+    // resorts to a file and the fragments are not copied again.
+    const bsls::Types::Int64 encodeStart    = bsls::TimeUtil::getTimer();
+    bslstl::StringRef        encodedMessage = payload;
+    if (const int rc = d_encoder(d_isTagged ? LONG_MAX : maxMessageSize,
+                                 &encodedMessage,
+                                 messageBuffer)) {
+        return recordResult(rc, numBytes);                            // RETURN
+    }
+    d_metrics.recordCodingTime(bsls::TimeUtil::getTimer() - encodeStart);
+
+    if (!d_isRaw && FormatUtil::isExternal(encodedMessage)) {
+        d_metrics.recordExternalPayload();
+    }
+
+    if (d_isTagged && long(encodedMessage.length()) > maxMessageSize) {
+        const bool isEncoded = true;
+        return recordResult(sendFragments(encodedMessage,
+                                          isEncoded,
+                                          deadline,
+                                          blocking,
+                                          priority),
+                            numBytes);                                // RETURN
+    }
+
+    return recordResult(
+        sendMessage(encodedMessage, deadline, blocking, priority), numBytes);
+}
+
+int QueueSender::sendMessage(const bslstl::StringRef&  message,
+                             const bsls::TimeInterval *deadline,
+                             bool                      blocking,
+                             int                       priority)
+{
+    if (!blocking) {
+        return posixQueue().trySend(message, priority);               // RETURN
+    }
+
+    if (deadline) {
+        return posixQueue().send(message, *deadline, priority);       // RETURN
+    }
+
+    return posixQueue().send(message, priority);
+}
+
+int QueueSender::sendFragments(const bslstl::StringRef&  payload,
+                               bool                      isEncoded,
+                               const bsls::TimeInterval *deadline,
+                               bool                      blocking,
+                               int                       priority)
+{
+    using namespace PosixQueueTypes;
+
+    const long        maxMessageSize = posixQueue().maxMessageSize();
+    const bsl::size_t maxLength      =
+        FormatUtil::maxFragmentLength(maxMessageSize);
+    if (maxLength == 0) {
+        // Messages are too small even for a fragment, so let the fragmented
+        // encoder report the error.
+        bslstl::StringRef encodedMessage = payload;
+        bsl::string       messageBuffer;
+        const int         rc = FormatUtil::encodeFragmented(
+            maxMessageSize, &encodedMessage, &messageBuffer);
+        BSLS_ASSERT(rc);
+        return rc;                                                    // RETURN
+    }
+
+    // Spread the payload evenly over the fewest fragments that can hold it,
+    // so that the receiver can deduce each fragment's offset from the header.
+    const bsl::size_t count = (payload.length() + maxLength - 1) / maxLength;
+    BSLS_ASSERT(count == unsigned(count));
+
+    FragmentHeader header;
+    header.d_streamId    = FormatUtil::nextFragmentStreamId();
+    header.d_totalLength = payload.length();
+    header.d_count       = unsigned(count);
+    header.d_isEncoded   = isEncoded;
+
+    // Every fragment is encoded into the same buffer.
+    LocalAllocator allocator(d_messageAllocator);
+    bsl::string    messageBuffer(&allocator);
+
+    for (header.d_index = 0; header.d_index < header.d_count;
+         ++header.d_index) {
+        FormatUtil::encodeFragment(
+            &messageBuffer,
+            payload.substr(header.offset(), header.length()),
+            header);
+
+        if (const int rc =
+                sendMessage(messageBuffer, deadline, blocking, priority)) {
+            return rc;                                                // RETURN
+        }
+    }
+
+    return 0;
+}
+
+int QueueSender::sendPack(const bslstl::StringRef  *begin,
+                          const bslstl::StringRef  *end,
+                          bsl::string              *messageBuffer,
+                          const bsls::TimeInterval *deadline,
+                          bool                      blocking,
+                          int                       priority)
+{
+    BSLS_ASSERT(begin < end);
+    BSLS_ASSERT(messageBuffer);
+
+    // The time to pack the message is divided evenly among its payloads.
+    const bsls::Types::Int64 numPayloads = end - begin;
+    const bsls::Types::Int64 packStart   = bsls::TimeUtil::getTimer();
+    FormatUtil::pack(messageBuffer, begin, end);
+    d_metrics.recordCodingTime(
+        (bsls::TimeUtil::getTimer() - packStart) / numPayloads, numPayloads);
+
+    // Whether the message is enqueued or not, the result is counted once for
+    // each payload, so that the metrics count payloads however they are
+    // packed.
+    const int rc = sendMessage(*messageBuffer, deadline, blocking, priority);
+    for (const bslstl::StringRef *payload = begin; payload != end; ++payload) {
+        recordResult(rc, payload->length());
+    }
+
+    return rc;
+}
+
+int QueueSender::recordResult(int rc, bsl::size_t numBytes)
+{
+    using namespace PosixQueueTypes;
+
+    if (rc == 0) {
+        d_metrics.recordMessage(numBytes);
+    }
+    else if (rc == Send::e_FULL) {
+        d_metrics.recordWouldBlock();
+    }
+    else if (rc == Send::e_TIMED_OUT) {
+        d_metrics.recordTimeout();
+    }
+    else {
+        d_metrics.recordError();
+    }
+
+    return rc;
+}
+
 // ACCESSORS
+void QueueSender::loadMetrics(MetricsSnapshot *result) const
+{
+    d_metrics.loadSnapshot(result);
+}
+
 PosixQueue::Open::Result QueueSender::openResult() const
 {
     BSLS_ASSERT(d_queue.is<PosixQueue>());
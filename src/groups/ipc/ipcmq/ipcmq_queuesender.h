@@ -3,12 +3,14 @@
 
 #include <ipcmq_format.h>
 #include <ipcmq_formatutil.h>
+#include <ipcmq_metrics.h>
 #include <ipcu_operatorbool.h>
 #include <ipcmq_posixqueue.h>
 #include <ipcmq_sender.h>
 
 #include <bdlb_variant.h>
 
+#include <bsl_cstddef.h>
 #include <bsl_string.h>
 
 namespace BloombergLP {
@@ -25,8 +27,13 @@ class QueueSender : public Sender {
     // DATA
     bdlb::Variant2<PosixQueue, PosixQueue *>  d_queue;
     FormatUtil::Encoder                       d_encoder;
+    bool                                      d_isRaw;
+    bool                                      d_isFragmented;
+    bool                                      d_isTagged;
+    bool                                      d_isPacked;
     bslma::Allocator                         *d_messageAllocator;
     PosixQueue::Open::Result                  d_openResult;
+    Metrics                                   d_metrics;
 
   public:
     // CREATORS
@@ -63,20 +70,98 @@ class QueueSender : public Sender {
         // specified 'priority'. Block for no longer than the optionally
         // specified 'relativeTimeout', relative to the beginning of the
         // invocation of this function. Return zero if the message is
-        // successfully sent or a nonzero value otherwise.
+        // successfully sent or a nonzero value otherwise. If this object uses
+        // the 'Format::e_FRAGMENTED' format and 'payload' does not fit in one
+        // message, then the payload is sent as a sequence of messages, and
+        // 'relativeTimeout' applies to the sequence as a whole. The same is
+        // true of the 'Format::e_TAGGED' format if the encoded payload does
+        // not fit in one message. Note that such a send can fail part way,
+        // for example when 'relativeTimeout' passes, in which case the
+        // fragments already enqueued are delivered but never completed: the
+        // receiver holds them, counting against its limits on pending bytes
+        // and pending streams, until it evicts them. Retrying sends the
+        // whole payload again, as a new sequence.
 
     int trySend(const bslstl::StringRef& payload);                // override
     int trySend(const bslstl::StringRef& payload, int priority);  // override
         // Enqueue onto the queue represented by this object a message
         // consisting of the specified 'payload' and having the optionally
         // specified 'priority'. Do not block. Return zero if the message is
-        // successfully sent or a nonzero value otherwise.
+        // successfully sent or a nonzero value otherwise. Note that a payload
+        // sent as a sequence of messages, as described for 'send', fails
+        // part way if the queue fills before its last message is enqueued,
+        // leaving the messages already enqueued for the receiver to hold
+        // until it evicts them, so a payload that needs many messages is
+        // better sent with 'send' and a timeout.
+
+    int sendBatch(const bslstl::StringRef *begin,
+                  const bslstl::StringRef *end,
+                  bsl::size_t             *numSent);
+    int sendBatch(const bslstl::StringRef *begin,
+                  const bslstl::StringRef *end,
+                  bsl::size_t             *numSent,
+                  int                      priority);
+    int sendBatch(const bslstl::StringRef   *begin,
+                  const bslstl::StringRef   *end,
+                  bsl::size_t               *numSent,
+                  const bsls::TimeInterval&  relativeTimeout);
+    int sendBatch(const bslstl::StringRef   *begin,
+                  const bslstl::StringRef   *end,
+                  bsl::size_t               *numSent,
+                  const bsls::TimeInterval&  relativeTimeout,
+                  int                        priority);
+        // Enqueue onto the queue represented by this object, in order, a
+        // message for each payload in the specified range '[begin, end)',
+        // each having the optionally specified 'priority', and load into the
+        // specified 'numSent' the number of messages enqueued. Block for no
+        // longer than the optionally specified 'relativeTimeout', relative to
+        // the beginning of the invocation of this function, for the whole
+        // batch. Return zero if every message was sent, or the nonzero result
+        // of the first message that could not be sent, in which case none of
+        // the subsequent messages are sent either. Note that every payload is
+        // encoded using the same buffer, so sending a batch allocates no more
+        // memory than sending one message. Also note that if this object uses
+        // the 'Format::e_PACKED' format, consecutive payloads are packed into
+        // as few messages as they fit in, and a payload counts as sent only
+        // once its message is sent.
+
+    int trySendBatch(const bslstl::StringRef *begin,
+                     const bslstl::StringRef *end,
+                     bsl::size_t             *numSent);
+    int trySendBatch(const bslstl::StringRef *begin,
+                     const bslstl::StringRef *end,
+                     bsl::size_t             *numSent,
+                     int                      priority);
+        // Enqueue onto the queue represented by this object, in order, a
+        // message for each payload in the specified range '[begin, end)',
+        // each having the optionally specified 'priority', until the queue is
+        // full, and load into the specified 'numSent' the number of messages
+        // enqueued. Do not block. Return zero if every message was sent, or
+        // the nonzero result of the first message that could not be sent.
+
+    int setCodec(unsigned char tag);
+        // Encode subsequent payloads using the encoder of the codec that
+        // decodes messages ending with the specified 'tag', which may be
+        // registered with 'CodecRegistry::defaultRegistry()'. Return zero on
+        // success, or a nonzero value if this object does not use the
+        // 'Format::e_TAGGED' format or no such codec has an encoder. The
+        // behavior is undefined if another thread is sending using this
+        // object concurrently. Note that until this function is called, a
+        // tagged sender compresses.
 
     int unlink();
         // Mark for deletion the message queue opened by this object. Return
         // zero on success or a nonzero value otherwise.
 
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero.
+
     // ACCESSORS
+    void loadMetrics(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the payloads sent by this object,
+        // the attempts that failed, and the time taken to encode each
+        // payload. Note that a payload sent as fragments counts once.
+
     PosixQueue::Open::Result openResult() const;
         // Return the result of having opened this queue. The behavior is
         // undefined unless this object owns its 'PosixQueue'.
@@ -103,6 +188,76 @@ class QueueSender : public Sender {
     PosixQueue& posixQueue();
         // Return a reference providing modifiable access to the 'PosixQueue'
         // instance used to implement this object.
+
+    int sendBatchImp(const bslstl::StringRef  *begin,
+                     const bslstl::StringRef  *end,
+                     bsl::size_t              *numSent,
+                     const bsls::TimeInterval *deadline,
+                     bool                      blocking,
+                     int                       priority);
+        // Encode and enqueue, in order, a message for each payload in the
+        // specified range '[begin, end)', each having the specified
+        // 'priority', until one fails, and load into the specified 'numSent'
+        // the number of messages enqueued. If the specified 'blocking' is
+        // 'false', do not block. Otherwise, block until the specified
+        // 'deadline', or indefinitely if 'deadline' is zero. Return zero if
+        // every message was enqueued or a nonzero value otherwise.
+
+    int sendPayload(const bslstl::StringRef&  payload,
+                    bsl::string              *messageBuffer,
+                    const bsls::TimeInterval *deadline,
+                    bool                      blocking,
+                    int                       priority);
+        // Encode the specified 'payload' using the specified 'messageBuffer'
+        // as needed, and enqueue the resulting message, or its fragments,
+        // having the specified 'priority'. If the specified 'blocking' is
+        // 'false', do not block. Otherwise, block until the specified
+        // 'deadline', or indefinitely if 'deadline' is zero. Return zero if
+        // the payload was enqueued or a nonzero value otherwise.
+
+    int sendMessage(const bslstl::StringRef&  message,
+                    const bsls::TimeInterval *deadline,
+                    bool                      blocking,
+                    int                       priority);
+        // Enqueue the specified encoded 'message' having the specified
+        // 'priority'. If the specified 'blocking' is 'false', do not block.
+        // Otherwise, block until the specified 'deadline', or indefinitely if
+        // 'deadline' is zero. Return zero on success or a nonzero value
+        // otherwise.
+
+    int sendFragments(const bslstl::StringRef&  payload,
+                      bool                      isEncoded,
+                      const bsls::TimeInterval *deadline,
+                      bool                      blocking,
+                      int                       priority);
+        // Enqueue, in order, the fragments of the specified 'payload', each
+        // having the specified 'priority', until one fails. If the specified
+        // 'isEncoded' is 'true', then 'payload' is itself an encoded message,
+        // which the receiver decodes once it is reassembled. If the specified
+        // 'blocking' is 'false', do not block. Otherwise, block until the
+        // specified 'deadline', or indefinitely if 'deadline' is zero. Return
+        // zero if every fragment was enqueued or a nonzero value otherwise.
+        // Note that if a fragment cannot be enqueued, the fragments already
+        // enqueued are eventually discarded by the receiver.
+
+    int sendPack(const bslstl::StringRef  *begin,
+                 const bslstl::StringRef  *end,
+                 bsl::string              *messageBuffer,
+                 const bsls::TimeInterval *deadline,
+                 bool                      blocking,
+                 int                       priority);
+        // Pack each payload in the specified range '[begin, end)' into one
+        // message, using the specified 'messageBuffer', and enqueue it having
+        // the specified 'priority'. If the specified 'blocking' is 'false',
+        // do not block. Otherwise, block until the specified 'deadline', or
+        // indefinitely if 'deadline' is zero. Count the result in the
+        // metrics of this object once for each payload. Return zero on
+        // success or a nonzero value otherwise. The behavior is undefined
+        // unless 'begin < end' and the payloads fit in one message.
+
+    int recordResult(int rc, bsl::size_t numBytes);
+        // Count in the metrics of this object the specified result 'rc' of
+        // sending a payload of the specified 'numBytes', and return 'rc'.
 };
 
 // ============================================================================
@@ -132,6 +287,31 @@ int QueueSender::trySend(const bslstl::StringRef& payload)
     return trySend(payload, 0);
 }
 
+inline
+int QueueSender::sendBatch(const bslstl::StringRef *begin,
+                           const bslstl::StringRef *end,
+                           bsl::size_t             *numSent)
+{
+    return sendBatch(begin, end, numSent, 0);
+}
+
+inline
+int QueueSender::sendBatch(const bslstl::StringRef   *begin,
+                           const bslstl::StringRef   *end,
+                           bsl::size_t               *numSent,
+                           const bsls::TimeInterval&  relativeTimeout)
+{
+    return sendBatch(begin, end, numSent, relativeTimeout, 0);
+}
+
+inline
+int QueueSender::trySendBatch(const bslstl::StringRef *begin,
+                              const bslstl::StringRef *end,
+                              bsl::size_t             *numSent)
+{
+    return trySendBatch(begin, end, numSent, 0);
+}
+
 }  // close package namespace
 }  // close enterprise namespace
 
@@ -0,0 +1,564 @@
+
+#include <ipcmq_sharedmemorypool.h>
+#include <ipcmq_messagebuffer.h>
+
+#include <ball_log.h>
+
+#include <bslma_default.h>
+
+#include <bslmt_lockguard.h>
+#include <bslmt_once.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_cstring.h>
+#include <bsl_sstream.h>
+
+#include <bsls_assert.h>
+#include <bsls_atomicoperations.h>
+#include <bsls_types.h>
+
+#include <errno.h>     // errno, EEXIST
+#include <fcntl.h>     // O_* constants
+#include <string.h>    // strerror
+#include <sys/mman.h>  // shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, ftruncate, getpid, sysconf
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.SHAREDMEMORYPOOL";
+
+typedef bsls::AtomicOperations           Atomics;
+typedef Atomics::AtomicTypes::Int        AtomicInt;
+typedef bsls::Types::Uint64              Uint64;
+
+// "ipcmqshm" in ASCII, marking the beginning of a segment created by this
+// component, followed by a version number in the last byte.
+const Uint64 k_MAGIC = 0x69706d7173686d01ULL;
+
+// Slots are powers of two in size, from '1 << k_MIN_SLOT_SHIFT' bytes through
+// 'SharedMemoryPool::k_MAX_PAYLOAD_SIZE' bytes.
+const int k_MIN_SLOT_SHIFT = 12;
+const int k_MAX_SLOT_SHIFT = 26;
+const int k_NUM_SIZE_CLASSES = k_MAX_SLOT_SHIFT - k_MIN_SLOT_SHIFT + 1;
+
+// Each segment has room for at least this many bytes of slots. Segments are
+// created using 'ftruncate', so the operating system supplies memory for
+// their pages only as they are written.
+const Uint64 k_MIN_SEGMENT_SLOTS_BYTES = 16 * 1024 * 1024;
+
+// The number of times to try to create a segment whose name is not already
+// taken (for instance, by a segment left behind by a crashed process that had
+// the same process ID).
+const int k_MAX_CREATE_ATTEMPTS = 8;
+
+// A slot is 'e_READING' while a receiver copies its payload out, between
+// claiming it from 'e_IN_USE' and releasing it to 'e_FREE'.
+enum SlotState { e_FREE = 0, e_IN_USE = 1, e_READING = 2 };
+
+struct SegmentHeader {
+    // This 'struct' is the beginning of every segment. It is followed by
+    // 'd_numSlots' objects of type 'AtomicInt', which are the states of the
+    // slots, and then, at 'd_slotsOffset' bytes from the beginning of the
+    // segment, by the slots themselves. Since a segment may be shared by
+    // processes built from different code, every member has a fixed size.
+
+    Uint64    d_magic;
+    Uint64    d_slotSize;
+    Uint64    d_numSlots;
+    Uint64    d_slotsOffset;
+    AtomicInt d_numInUse;
+    AtomicInt d_detached;  // nonzero once the creating process is done
+};
+
+// A handle is the name of the segment, a null character, the index of the
+// slot, and the length of the payload in the slot, each of the last two in
+// the byte order of the machine.
+const bsl::size_t k_HANDLE_SUFFIX_SIZE = 1 + 2 * sizeof(Uint64);
+
+int sizeClassOf(bsl::size_t size)
+    // Return the index of the smallest size class whose slots can hold the
+    // specified 'size' bytes. The behavior is undefined unless
+    // 'size <= SharedMemoryPool::k_MAX_PAYLOAD_SIZE'.
+{
+    int shift = k_MIN_SLOT_SHIFT;
+    while ((bsl::size_t(1) << shift) < size) {
+        ++shift;
+    }
+
+    BSLS_ASSERT(shift <= k_MAX_SLOT_SHIFT);
+    return shift - k_MIN_SLOT_SHIFT;
+}
+
+AtomicInt *slotStates(SegmentHeader *header)
+{
+    return reinterpret_cast<AtomicInt *>(header + 1);
+}
+
+bsl::string systemError(int errorNumber)
+{
+    return strerror(errorNumber);
+}
+
+void unlinkSegment(const bsl::string& name)
+    // Delete the shared memory segment having the specified 'name'. It is not
+    // an error if the segment has already been deleted.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    if (shm_unlink(name.c_str()) == -1 && errno != ENOENT) {
+        BALL_LOG_WARN << "Unable to delete shared memory segment " << name
+                      << ": " << systemError(errno) << BALL_LOG_END;
+    }
+}
+
+void storeBytes(bsl::string *output, const char *data, bsl::size_t length)
+    // Assign to the specified 'output' the specified 'length' bytes beginning
+    // at the specified 'data'.
+{
+    output->assign(data, length);
+}
+
+void storeBytes(MessageBuffer *output, const char *data, bsl::size_t length)
+    // Append to the specified 'output' the specified 'length' bytes beginning
+    // at the specified 'data'.
+{
+    output->reserve(output->length() + length);
+    bsl::memcpy(output->data() + output->length(), data, length);
+    output->setLength(output->length() + length);
+}
+
+}  // close unnamed namespace
+
+                      // ================================
+                      // struct SharedMemoryPool::Segment
+                      // ================================
+
+struct SharedMemoryPool::Segment {
+    // This 'struct' is a segment mapped into the memory of this process.
+
+    // DATA
+    bsl::string    d_name;
+    char          *d_address_p;
+    bsl::size_t    d_size;
+    bool           d_isOwn;     // whether this process created the segment
+    Uint64         d_nextSlot;  // where to start looking for a free slot
+
+    // CREATORS
+    Segment(const bsl::string& name,
+            char              *address,
+            bsl::size_t        size,
+            bool               isOwn,
+            bslma::Allocator  *allocator)
+    : d_name(name, allocator)
+    , d_address_p(address)
+    , d_size(size)
+    , d_isOwn(isOwn)
+    , d_nextSlot(0)
+    {
+    }
+
+    ~Segment()
+    {
+        munmap(d_address_p, d_size);
+    }
+
+    // ACCESSORS
+    SegmentHeader *header() const
+    {
+        return reinterpret_cast<SegmentHeader *>(d_address_p);
+    }
+
+    char *slot(Uint64 index) const
+    {
+        return d_address_p + header()->d_slotsOffset +
+               index * header()->d_slotSize;
+    }
+};
+
+                           // ----------------------
+                           // class SharedMemoryPool
+                           // ----------------------
+
+// CLASS METHODS
+SharedMemoryPool& SharedMemoryPool::defaultPool()
+{
+    static SharedMemoryPool *ptr = 0;
+    BSLMT_ONCE_DO
+    {
+        static SharedMemoryPool pool(bslma::Default::globalAllocator());
+        ptr = &pool;
+    }
+
+    BSLS_ASSERT_SAFE(ptr);
+    return *ptr;
+}
+
+// CREATORS
+SharedMemoryPool::SharedMemoryPool(bslma::Allocator *allocator)
+: d_segments(allocator)
+, d_ownSegments(k_NUM_SIZE_CLASSES, allocator)
+, d_namePrefix(allocator)
+, d_permissions(0600)  // user read/write only
+, d_nextSegmentId(0)
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    bsl::ostringstream prefix;
+    prefix << "/ipcmq-shm-" << getpid() << '-' << static_cast<void *>(this)
+           << '-';
+    d_namePrefix = prefix.str();
+}
+
+SharedMemoryPool::SharedMemoryPool(int               permissions,
+                                   bslma::Allocator *allocator)
+: d_segments(allocator)
+, d_ownSegments(k_NUM_SIZE_CLASSES, allocator)
+, d_namePrefix(allocator)
+, d_permissions(permissions)
+, d_nextSegmentId(0)
+, d_allocator_p(bslma::Default::allocator(allocator))
+{
+    bsl::ostringstream prefix;
+    prefix << "/ipcmq-shm-" << getpid() << '-' << static_cast<void *>(this)
+           << '-';
+    d_namePrefix = prefix.str();
+}
+
+SharedMemoryPool::~SharedMemoryPool()
+{
+    for (SegmentMap::const_iterator it = d_segments.begin();
+         it != d_segments.end();
+         ++it) {
+        const Segment& segment = *it->second;
+        if (!segment.d_isOwn) {
+            continue;
+        }
+
+        // Mark the segment detached, and then delete it if no slots are in
+        // use. Otherwise, whoever releases the last slot deletes it. Since
+        // both this process and the releasing process first write and then
+        // read (in the opposite order), at least one of them sees both
+        // writes.
+        SegmentHeader *const header = segment.header();
+        Atomics::setInt(&header->d_detached, 1);
+        if (Atomics::getInt(&header->d_numInUse) == 0) {
+            unlinkSegment(segment.d_name);
+        }
+    }
+
+    // 'd_segments' unmaps every segment when it is destroyed.
+}
+
+// MANIPULATORS
+int SharedMemoryPool::write(bsl::string              *handle,
+                            const bslstl::StringRef&  payload)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(handle);
+
+    if (payload.length() > k_MAX_PAYLOAD_SIZE) {
+        return 1;                                                     // RETURN
+    }
+
+    const int sizeClass = sizeClassOf(payload.length());
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    // Look for a free slot in the existing segments of the size class, and
+    // create a new segment if there is none.
+    Segment *segment = 0;
+    Uint64   slot    = 0;
+    const bsl::vector<Segment *>& segments = d_ownSegments[sizeClass];
+    for (bsl::size_t i = 0; i < segments.size() && !segment; ++i) {
+        Segment&             candidate = *segments[i];
+        SegmentHeader *const header    = candidate.header();
+        AtomicInt *const     states    = slotStates(header);
+        for (Uint64 j = 0; j < header->d_numSlots; ++j) {
+            const Uint64 index =
+                (candidate.d_nextSlot + j) % header->d_numSlots;
+            if (Atomics::testAndSwapInt(&states[index], e_FREE, e_IN_USE) ==
+                e_FREE) {
+                segment              = &candidate;
+                slot                 = index;
+                candidate.d_nextSlot = index + 1;
+                break;
+            }
+        }
+    }
+
+    if (!segment) {
+        segment = createSegment(sizeClass);
+        if (!segment) {
+            return 2;                                                 // RETURN
+        }
+
+        slot                = 0;
+        segment->d_nextSlot = 1;
+        Atomics::setInt(&slotStates(segment->header())[slot], e_IN_USE);
+    }
+
+    Atomics::addInt(&segment->header()->d_numInUse, 1);
+
+    bsl::memcpy(segment->slot(slot), payload.data(), payload.length());
+
+    const Uint64 length = payload.length();
+    handle->append(segment->d_name);
+    handle->push_back('\0');
+    handle->append(reinterpret_cast<const char *>(&slot), sizeof slot);
+    handle->append(reinterpret_cast<const char *>(&length), sizeof length);
+
+    return 0;
+}
+
+int SharedMemoryPool::read(bsl::string              *payload,
+                           const bslstl::StringRef&  handle)
+{
+    BSLS_ASSERT(payload);
+
+    return readImp(payload, handle);
+}
+
+int SharedMemoryPool::read(MessageBuffer            *payload,
+                           const bslstl::StringRef&  handle)
+{
+    BSLS_ASSERT(payload);
+
+    return readImp(payload, handle);
+}
+
+int SharedMemoryPool::release(const bslstl::StringRef& handle)
+{
+    bsl::string *const noPayload = 0;
+    return readImp(noPayload, handle);
+}
+
+SharedMemoryPool::Segment *SharedMemoryPool::createSegment(int sizeClass)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    const Uint64 slotSize = Uint64(1) << (k_MIN_SLOT_SHIFT + sizeClass);
+    const Uint64 numSlots =
+        bsl::max(k_MIN_SEGMENT_SLOTS_BYTES, slotSize) / slotSize;
+
+    // The slots begin on a page boundary, after the header and slot states.
+    const Uint64 pageSize    = sysconf(_SC_PAGESIZE);
+    const Uint64 headerSize  = sizeof(SegmentHeader) +
+                               numSlots * sizeof(AtomicInt);
+    const Uint64 slotsOffset = (headerSize + pageSize - 1) / pageSize *
+                               pageSize;
+    const Uint64 size        = slotsOffset + numSlots * slotSize;
+
+    bsl::string name(d_allocator_p);
+    int         fd = -1;
+    for (int attempt = 1; fd == -1 && attempt <= k_MAX_CREATE_ATTEMPTS;
+         ++attempt) {
+        bsl::ostringstream stream;
+        stream << d_namePrefix << d_nextSegmentId++;
+        name = stream.str();
+
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, d_permissions);
+        if (fd == -1 && errno != EEXIST) {
+            break;
+        }
+    }
+
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to create shared memory segment " << name
+                       << ": " << systemError(errno) << BALL_LOG_END;
+        return 0;                                                     // RETURN
+    }
+
+    if (ftruncate(fd, size) == -1) {
+        BALL_LOG_ERROR << "Unable to size shared memory segment " << name
+                       << " to " << size << " bytes: " << systemError(errno)
+                       << BALL_LOG_END;
+        close(fd);
+        unlinkSegment(name);
+        return 0;                                                     // RETURN
+    }
+
+    void *const address =
+        mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping remains valid after the descriptor is closed.
+    if (address == MAP_FAILED) {
+        BALL_LOG_ERROR << "Unable to map shared memory segment " << name
+                       << ": " << systemError(errno) << BALL_LOG_END;
+        unlinkSegment(name);
+        return 0;                                                     // RETURN
+    }
+
+    // The segment is zero-filled, so every slot is initially 'e_FREE'.
+    SegmentHeader *const header = static_cast<SegmentHeader *>(address);
+    header->d_slotSize          = slotSize;
+    header->d_numSlots          = numSlots;
+    header->d_slotsOffset       = slotsOffset;
+    Atomics::initInt(&header->d_numInUse, 0);
+    Atomics::initInt(&header->d_detached, 0);
+    header->d_magic = k_MAGIC;
+
+    const bool                     isOwn = true;
+    const bsl::shared_ptr<Segment> segment =
+        bsl::allocate_shared<Segment>(d_allocator_p,
+                                      name,
+                                      static_cast<char *>(address),
+                                      size,
+                                      isOwn,
+                                      d_allocator_p);
+
+    d_segments[name] = segment;
+    d_ownSegments[sizeClass].push_back(segment.get());
+
+    BALL_LOG_DEBUG << "Created shared memory segment " << name << " having "
+                   << numSlots << " slots of " << slotSize << " bytes"
+                   << BALL_LOG_END;
+
+    return segment.get();
+}
+
+bsl::shared_ptr<SharedMemoryPool::Segment> SharedMemoryPool::findSegment(
+                                                       const bsl::string& name)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    const SegmentMap::const_iterator found = d_segments.find(name);
+    if (found != d_segments.end()) {
+        return found->second;                                         // RETURN
+    }
+
+    // This is another process's segment, and we haven't seen it before.
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to open shared memory segment " << name
+                       << ": " << systemError(errno) << BALL_LOG_END;
+        return bsl::shared_ptr<Segment>();                            // RETURN
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) == -1 ||
+        Uint64(status.st_size) < sizeof(SegmentHeader)) {
+        BALL_LOG_ERROR << "Shared memory segment " << name
+                       << " is not a segment of a SharedMemoryPool."
+                       << BALL_LOG_END;
+        close(fd);
+        return bsl::shared_ptr<Segment>();                            // RETURN
+    }
+
+    const bsl::size_t size    = status.st_size;
+    void *const       address =
+        mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        BALL_LOG_ERROR << "Unable to map shared memory segment " << name
+                       << ": " << systemError(errno) << BALL_LOG_END;
+        return bsl::shared_ptr<Segment>();                            // RETURN
+    }
+
+    const bool                     isOwn = false;
+    const bsl::shared_ptr<Segment> segment =
+        bsl::allocate_shared<Segment>(d_allocator_p,
+                                      name,
+                                      static_cast<char *>(address),
+                                      size,
+                                      isOwn,
+                                      d_allocator_p);
+
+    const SegmentHeader& header = *segment->header();
+    if (header.d_magic != k_MAGIC ||
+        header.d_slotsOffset + header.d_numSlots * header.d_slotSize > size) {
+        BALL_LOG_ERROR << "Shared memory segment " << name
+                       << " is not a segment of a SharedMemoryPool."
+                       << BALL_LOG_END;
+        return bsl::shared_ptr<Segment>();                            // RETURN
+    }
+
+    // Before caching another segment, unmap any cached segments of other
+    // processes that have since been deleted, so that their memory can be
+    // reclaimed by the system.
+    for (SegmentMap::iterator it = d_segments.begin();
+         it != d_segments.end();) {
+        const SegmentHeader& other = *it->second->header();
+        if (!it->second->d_isOwn && Atomics::getInt(&other.d_detached) &&
+            Atomics::getInt(&other.d_numInUse) == 0) {
+            it = d_segments.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    d_segments[name] = segment;
+    return segment;
+}
+
+template <typename OUTPUT>
+int SharedMemoryPool::readImp(OUTPUT                   *payload,
+                              const bslstl::StringRef&  handle)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    // Parse the handle before modifying 'payload', which 'handle' might refer
+    // into.
+    if (handle.length() <= k_HANDLE_SUFFIX_SIZE ||
+        handle[handle.length() - k_HANDLE_SUFFIX_SIZE] != '\0') {
+        BALL_LOG_ERROR << "Invalid shared memory handle." << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    const char *const suffix =
+        handle.data() + handle.length() - k_HANDLE_SUFFIX_SIZE + 1;
+    Uint64 slot;
+    Uint64 length;
+    bsl::memcpy(&slot, suffix, sizeof slot);
+    bsl::memcpy(&length, suffix + sizeof slot, sizeof length);
+
+    const bsl::string name(handle.data(),
+                           handle.length() - k_HANDLE_SUFFIX_SIZE,
+                           d_allocator_p);
+
+    bsl::shared_ptr<Segment> segment;
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+        segment = findSegment(name);
+    }
+
+    if (!segment) {
+        return 2;                                                     // RETURN
+    }
+
+    // Claim the slot before reading it, so that of two readers given the
+    // same handle, only one copies the payload out and releases the slot.
+    // Writers claim only free slots, so the slot is not reused until it is
+    // released.
+    SegmentHeader *const header = segment->header();
+    if (slot >= header->d_numSlots || length > header->d_slotSize ||
+        Atomics::testAndSwapInt(
+            &slotStates(header)[slot], e_IN_USE, e_READING) != e_IN_USE) {
+        BALL_LOG_ERROR << "Shared memory handle refers to slot " << slot
+                       << " of segment " << name << " having length " << length
+                       << ", which is not in use." << BALL_LOG_END;
+        return 3;                                                     // RETURN
+    }
+
+    if (payload) {
+        storeBytes(payload, segment->slot(slot), length);
+    }
+
+    // Release the slot. If this was the last slot in use in a segment whose
+    // creator is done with it, delete the segment. See the note in
+    // '~SharedMemoryPool'.
+    Atomics::setInt(&slotStates(header)[slot], e_FREE);
+    if (Atomics::addIntNv(&header->d_numInUse, -1) == 0 &&
+        Atomics::getInt(&header->d_detached)) {
+        unlinkSegment(name);
+
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+        d_segments.erase(name);
+    }
+
+    return 0;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,146 @@
+#ifndef INCLUDED_IPCMQ_SHAREDMEMORYPOOL
+#define INCLUDED_IPCMQ_SHAREDMEMORYPOOL
+
+#include <bsl_cstddef.h>
+#include <bsl_memory.h>
+#include <bsl_string.h>
+#include <bsl_unordered_map.h>
+#include <bsl_vector.h>
+
+#include <bslmt_mutex.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcmq {
+
+class MessageBuffer;
+
+                           // ======================
+                           // class SharedMemoryPool
+                           // ======================
+
+class SharedMemoryPool {
+    // This class provides slots of POSIX shared memory into which a sending
+    // process copies message payloads that are too large to fit in a message,
+    // so that a receiving process can copy them out again without involving a
+    // file system. The sender writes a payload into a slot and sends a small
+    // "handle" naming the slot in place of the payload. The receiver uses the
+    // handle to read the payload, which releases the slot for reuse by the
+    // sender.
+    //
+    // Slots come in power-of-two sizes from 4 KiB to 64 MiB. The slots of
+    // each size are carved out of shared memory segments that this object
+    // creates on demand. The segments are named after the process that
+    // created them, and each records in its own memory which of its slots
+    // are in use, so that no communication other than the handle is needed
+    // between sender and receiver. When a 'SharedMemoryPool' is destroyed,
+    // its segments are deleted, except that a segment having slots whose
+    // handles have not yet been read is deleted by the process that reads the
+    // last of them. Note that a handle that is never read (for example, if
+    // the receiving process crashes) keeps its segment in existence.
+    //
+    // The same object also serves as a cache of the segments of other
+    // processes that this process has read payloads from, so that a segment is
+    // mapped into memory at most once. This class is thread-safe.
+
+  public:
+    // PUBLIC CONSTANTS
+    static const bsl::size_t k_MAX_PAYLOAD_SIZE = 64 * 1024 * 1024;
+
+  private:
+    // PRIVATE TYPES
+    struct Segment;
+
+    typedef bsl::unordered_map<bsl::string, bsl::shared_ptr<Segment> >
+        SegmentMap;  // keyed by name
+
+    // DATA
+    mutable bslmt::Mutex                  d_mutex;  // protects all below
+    SegmentMap                            d_segments;
+    bsl::vector<bsl::vector<Segment *> >  d_ownSegments;  // by size class
+    bsl::string                           d_namePrefix;
+    int                                   d_permissions;
+    int                                   d_nextSegmentId;
+    bslma::Allocator                     *d_allocator_p;
+
+    SharedMemoryPool(const SharedMemoryPool&);             // = delete
+    SharedMemoryPool& operator=(const SharedMemoryPool&);  // = delete
+
+  public:
+    // CLASS METHODS
+    static SharedMemoryPool& defaultPool();
+        // Return a reference to the process-wide pool used by the
+        // 'Format::e_SHARED_MEMORY' codec. The pool is created the first time
+        // this function is called, and destroyed when the process exits.
+
+    // CREATORS
+    explicit SharedMemoryPool(bslma::Allocator *allocator = 0);
+    explicit SharedMemoryPool(int               permissions,
+                              bslma::Allocator *allocator = 0);
+        // Create a 'SharedMemoryPool' having no segments. Optionally specify
+        // the 'permissions' with which segments are created. If
+        // 'permissions' is not specified, only the current user can read and
+        // write them. Optionally specify an 'allocator' used to supply
+        // memory. Note that a receiving process must be able to write to a
+        // segment in order to release its slots.
+
+    ~SharedMemoryPool();
+        // Unmap every segment from the memory of this process and delete
+        // those created by this object, deferring the deletion of any that
+        // have slots in use until the last of them is released.
+
+    // MANIPULATORS
+    int write(bsl::string *handle, const bslstl::StringRef& payload);
+        // Copy the specified 'payload' into a free slot and append to the
+        // specified 'handle' a sequence of bytes by which another process can
+        // read 'payload' from the slot. Return zero on success or a nonzero
+        // value if 'payload' is larger than 'k_MAX_PAYLOAD_SIZE' or a slot
+        // cannot be obtained.
+
+    int read(bsl::string *payload, const bslstl::StringRef& handle);
+        // Assign to the specified 'payload' the contents of the slot
+        // referred to by the specified 'handle', and release the slot. Return
+        // zero on success or a nonzero value otherwise. The behavior is
+        // undefined unless 'handle' was produced by 'write' and has not
+        // already been read. Note that 'handle' may refer to memory within
+        // 'payload'.
+
+    int read(MessageBuffer *payload, const bslstl::StringRef& handle);
+        // Append to the specified 'payload' the contents of the slot referred
+        // to by the specified 'handle', and release the slot. Return zero on
+        // success or a nonzero value otherwise. The behavior is undefined
+        // unless 'handle' was produced by 'write' and has not already been
+        // read. Note that 'handle' may refer to memory within 'payload'.
+
+    int release(const bslstl::StringRef& handle);
+        // Release the slot referred to by the specified 'handle' without
+        // reading its contents, as a sender does with a payload it wrote but
+        // will not send. Return zero on success or a nonzero value otherwise.
+        // The behavior is undefined unless 'handle' was produced by 'write'
+        // and has not already been read or released.
+
+  private:
+    // PRIVATE MANIPULATORS
+    Segment *createSegment(int sizeClass);
+        // Create, map, and return a new segment for slots of the specified
+        // 'sizeClass', or return zero if an error occurs. The behavior is
+        // undefined unless 'd_mutex' is locked.
+
+    bsl::shared_ptr<Segment> findSegment(const bsl::string& name);
+        // Return the segment having the specified 'name', mapping it if
+        // necessary, or return an empty pointer if an error occurs. The
+        // behavior is undefined unless 'd_mutex' is locked. Note that the
+        // segment remains mapped for as long as the returned pointer refers
+        // to it, even if it is meanwhile removed from this object.
+
+    template <typename OUTPUT>
+    int readImp(OUTPUT *payload, const bslstl::StringRef& handle);
+        // Load into the specified 'payload' the contents of the slot referred
+        // to by the specified 'handle', unless 'payload' is zero, and release
+        // the slot. Return zero on success or a nonzero value otherwise.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
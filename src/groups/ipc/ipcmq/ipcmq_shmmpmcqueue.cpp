@@ -0,0 +1,669 @@
+
+#include <ipcmq_shmmpmcqueue.h>
+#include <ipcmq_posixqueueerrors.h>
+#include <ipcmq_waitutil.h>
+
+#include <ball_log.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bslmf_assert.h>
+
+#include <bslmt_threadutil.h>
+
+#include <bsls_assert.h>
+#include <bsls_atomicoperations.h>
+#include <bsls_timeinterval.h>
+
+#include <bsl_cstring.h>
+
+#include <errno.h>     // errno, EEXIST, ENOENT, EPERM
+#include <fcntl.h>     // O_* constants
+#include <signal.h>    // kill
+#include <string.h>    // strerror
+#include <sys/mman.h>  // shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, ftruncate, getpid
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.SHMMPMCQUEUE";
+
+typedef bsls::AtomicOperations       Atomics;
+typedef Atomics::AtomicTypes::Int    AtomicInt;
+typedef Atomics::AtomicTypes::Int64  AtomicInt64;
+typedef Atomics::AtomicTypes::Uint64 AtomicUint64;
+typedef bsls::Types::Int64           Int64;
+typedef bsls::Types::Uint64          Uint64;
+typedef bsls::Types::Uint32          Uint32;
+
+// "ipcmqmp" in ASCII, marking the beginning of a segment created by this
+// component, followed by a version number in the last byte.
+const Uint64 k_MAGIC = 0x6970636d716d7001ULL;
+
+const Uint64 k_CACHE_LINE_SIZE = 64;
+
+// The slots begin on the page after the header.
+const Uint64 k_HEADER_SIZE = 4096;
+
+// With fewer than two slots, a slot free to be written at one position
+// could not be told apart from a slot holding the message of the position
+// before.
+const Uint64 k_MIN_NUM_SLOTS = 2;
+
+// A thread that finds the queue full or empty checks again this many times
+// before it parks.
+const int k_SPIN_COUNT = 4000;
+
+// A parked thread wakes this often to check for slots held by dead
+// processes.
+const int k_RECOVERY_INTERVAL_MILLISECONDS = 100;
+
+// A process that opens a segment that another process is still creating
+// checks again this many times, this many microseconds apart, for it to be
+// initialized.
+const int k_MAX_OPEN_ATTEMPTS       = 1000;
+const int k_OPEN_RETRY_MICROSECONDS = 1000;
+
+// The owner of a slot is the process ID of the claimant times two, plus
+// this if the claimant is reading.
+const int k_READING = 1;
+
+struct SegmentHeader {
+    // This 'struct' is the beginning of every segment. The members written by
+    // senders and those written by receivers are in separate cache lines.
+    // Since a segment may be shared by processes built from different code,
+    // every member has a fixed size.
+
+    // written once, by the creator, except for 'd_numAbandoned'
+    AtomicUint64 d_magic;
+    Uint64       d_numSlots;
+    Uint64       d_slotSize;
+    Uint64       d_maxMessageSize;
+    AtomicInt64  d_numAbandoned;
+    char         d_padding0[k_CACHE_LINE_SIZE - 5 * sizeof(Uint64)];
+
+    // written by senders
+    AtomicUint64 d_enqueuePosition;     // of the next message to write
+    AtomicInt    d_messageCount;        // futex word for parked receivers
+    AtomicInt    d_numSendersParked;
+    char         d_padding1[k_CACHE_LINE_SIZE - sizeof(Uint64) -
+                            2 * sizeof(int)];
+
+    // written by receivers
+    AtomicUint64 d_dequeuePosition;     // of the next message to read
+    AtomicInt    d_roomCount;           // futex word for parked senders
+    AtomicInt    d_numReceiversParked;
+};
+
+BSLMF_ASSERT(sizeof(SegmentHeader) <= k_HEADER_SIZE);
+
+struct SlotHeader {
+    // This 'struct' precedes the payload in every slot. The sequence number
+    // of the slot for position 'p' is 'p' when the slot is free to be
+    // written, and 'p + 1' when it holds the message written at 'p'. Reading
+    // the message makes the slot free to be written at 'p + numSlots'.
+
+    AtomicUint64 d_sequence;
+    AtomicInt    d_owner;     // of the claimant (see 'k_READING'), or zero
+    Uint32       d_length;    // of the payload, or 'k_ABANDONED'
+    int          d_priority;
+    Uint32       d_padding;
+};
+
+BSLMF_ASSERT(sizeof(SlotHeader) == 24);
+
+// A slot having this length holds no message, since the process writing it
+// died. Receivers skip it.
+const Uint32 k_ABANDONED = 0xFFFFFFFF;
+
+SegmentHeader *segmentHeader(char *base)
+{
+    return reinterpret_cast<SegmentHeader *>(base);
+}
+
+SlotHeader *slotAt(char *base, Uint64 position)
+    // Return the slot for the specified 'position' in the segment at the
+    // specified 'base'.
+{
+    const SegmentHeader& header = *segmentHeader(base);
+    return reinterpret_cast<SlotHeader *>(
+        base + k_HEADER_SIZE +
+        (position & (header.d_numSlots - 1)) * header.d_slotSize);
+}
+
+char *payloadOf(SlotHeader *slot)
+{
+    return reinterpret_cast<char *>(slot + 1);
+}
+
+bool claim(SlotHeader *slot, Uint64 sequence, int owner)
+    // Store the specified 'owner' into the specified 'slot' if the slot is
+    // not claimed and its sequence number is the specified 'sequence'.
+    // Return 'true' if the slot is claimed, or 'false' otherwise. Note that
+    // the sequence number is checked after the slot is claimed, since it may
+    // have been advanced by the previous owner just before.
+{
+    if (Atomics::testAndSwapInt(&slot->d_owner, 0, owner) != 0) {
+        return false;                                                 // RETURN
+    }
+
+    if (Atomics::getUint64Acquire(&slot->d_sequence) != sequence) {
+        Atomics::setIntRelease(&slot->d_owner, 0);
+        return false;                                                 // RETURN
+    }
+
+    return true;
+}
+
+void notify(AtomicInt *count, AtomicInt *numParked)
+    // If the specified 'numParked' is not zero, increment the specified
+    // 'count' and wake the threads parked on it. The caller must have made
+    // its progress visible using a sequentially consistent store, so that
+    // either this thread sees a parked thread, or the parked thread sees the
+    // progress before it parks.
+{
+    if (Atomics::getInt(numParked)) {
+        Atomics::addInt(count, 1);
+        WaitUtil::wake(count);
+    }
+}
+
+bool isAlive(int pid)
+    // Return whether the process having the specified 'pid' exists.
+{
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+}  // close unnamed namespace
+
+                             // ------------------
+                             // class ShmMpmcQueue
+                             // ------------------
+
+// CREATORS
+ShmMpmcQueue::ShmMpmcQueue(const bslstl::StringRef&  name,
+                           bsl::size_t               numSlots,
+                           bsl::size_t               maxMessageSize,
+                           int                       filePermissions,
+                           bslma::Allocator         *allocator)
+: d_base_p(0)
+, d_mappingLength(0)
+, d_numSlots(0)
+, d_slotSize(0)
+, d_maxMessageSize(0)
+, d_owner(getpid() * 2)
+, d_name(name, allocator)
+{
+    open(numSlots, maxMessageSize, filePermissions);
+}
+
+ShmMpmcQueue::~ShmMpmcQueue()
+{
+    if (d_base_p) {
+        munmap(d_base_p, d_mappingLength);
+    }
+}
+
+// MANIPULATORS
+int ShmMpmcQueue::receive(bsl::string               *payload,
+                          const bsls::TimeInterval&  relativeTimeout)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return receiveImp(payload, &deadline, true, 0);
+}
+
+int ShmMpmcQueue::receive(bsl::string               *payload,
+                          const bsls::TimeInterval&  relativeTimeout,
+                          unsigned                  *priority)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return receiveImp(payload, &deadline, true, priority);
+}
+
+int ShmMpmcQueue::send(const bslstl::StringRef&  payload,
+                       const bsls::TimeInterval& relativeTimeout)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return sendImp(payload, &deadline, true, 0);
+}
+
+int ShmMpmcQueue::send(const bslstl::StringRef&  payload,
+                       const bsls::TimeInterval& relativeTimeout,
+                       int                       priority)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return sendImp(payload, &deadline, true, priority);
+}
+
+int ShmMpmcQueue::unlink()
+{
+    return unlink(d_name);
+}
+
+int ShmMpmcQueue::open(bsl::size_t numSlots,
+                       bsl::size_t maxMessageSize,
+                       int         filePermissions)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    Uint64 slotCount = k_MIN_NUM_SLOTS;
+    while (slotCount < numSlots) {
+        slotCount *= 2;
+    }
+    const Uint64 slotSize = (sizeof(SlotHeader) + maxMessageSize +
+                             k_CACHE_LINE_SIZE - 1) &
+                            ~(k_CACHE_LINE_SIZE - 1);
+
+    bool isCreator = true;
+    int  fd        = shm_open(d_name.c_str(),
+                              O_RDWR | O_CREAT | O_EXCL,
+                              filePermissions ? filePermissions : 0600);
+    if (fd == -1 && errno == EEXIST) {
+        isCreator = false;
+        fd        = shm_open(d_name.c_str(), O_RDWR, 0);
+    }
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to open shared memory queue " << d_name
+                       << ": " << strerror(errno) << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    Uint64 size = k_HEADER_SIZE + slotCount * slotSize;
+    if (isCreator) {
+        if (ftruncate(fd, size) == -1) {
+            BALL_LOG_ERROR << "Unable to resize shared memory queue "
+                           << d_name << " to " << size
+                           << " bytes: " << strerror(errno) << BALL_LOG_END;
+            close(fd);
+            shm_unlink(d_name.c_str());
+            return 2;                                                 // RETURN
+        }
+    }
+    else {
+        // The creator may not have resized the segment yet.
+        struct stat status;
+        int         attempt = 0;
+        while (fstat(fd, &status) == 0 && status.st_size == 0 &&
+               ++attempt < k_MAX_OPEN_ATTEMPTS) {
+            bslmt::ThreadUtil::microSleep(k_OPEN_RETRY_MICROSECONDS);
+        }
+        if (Uint64(status.st_size) <= k_HEADER_SIZE) {
+            BALL_LOG_ERROR << "The shared memory segment " << d_name
+                           << " is not a queue." << BALL_LOG_END;
+            close(fd);
+            return 3;                                                 // RETURN
+        }
+        size = status.st_size;
+    }
+
+    void *const address =
+        mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping remains valid after the descriptor is closed.
+    if (address == MAP_FAILED) {
+        BALL_LOG_ERROR << "Unable to map shared memory queue " << d_name
+                       << " into memory: " << strerror(errno)
+                       << BALL_LOG_END;
+        if (isCreator) {
+            shm_unlink(d_name.c_str());
+        }
+        return 4;                                                     // RETURN
+    }
+
+    char *const          base   = static_cast<char *>(address);
+    SegmentHeader *const header = segmentHeader(base);
+    if (isCreator) {
+        // The segment is zeroed when it is resized, but each slot must
+        // begin free to be written at its own index. The magic number is
+        // written last.
+        header->d_numSlots       = slotCount;
+        header->d_slotSize       = slotSize;
+        header->d_maxMessageSize = maxMessageSize;
+        for (Uint64 i = 0; i < slotCount; ++i) {
+            Atomics::setUint64Relaxed(&slotAt(base, i)->d_sequence, i);
+        }
+        Atomics::setUint64Release(&header->d_magic, k_MAGIC);
+    }
+    else {
+        int attempt = 0;
+        while (Atomics::getUint64Acquire(&header->d_magic) != k_MAGIC &&
+               ++attempt < k_MAX_OPEN_ATTEMPTS) {
+            bslmt::ThreadUtil::microSleep(k_OPEN_RETRY_MICROSECONDS);
+        }
+        if (Atomics::getUint64Acquire(&header->d_magic) != k_MAGIC ||
+            header->d_numSlots < k_MIN_NUM_SLOTS ||
+            header->d_slotSize <
+                sizeof(SlotHeader) + header->d_maxMessageSize ||
+            size != k_HEADER_SIZE + header->d_numSlots * header->d_slotSize) {
+            BALL_LOG_ERROR << "The shared memory segment " << d_name
+                           << " is not a queue." << BALL_LOG_END;
+            munmap(address, size);
+            return 3;                                                 // RETURN
+        }
+    }
+
+    d_base_p         = base;
+    d_mappingLength  = size;
+    d_numSlots       = header->d_numSlots;
+    d_slotSize       = header->d_slotSize;
+    d_maxMessageSize = header->d_maxMessageSize;
+    return 0;
+}
+
+int ShmMpmcQueue::sendImp(const bslstl::StringRef&  payload,
+                          const bsls::TimeInterval *deadline,
+                          bool                      blocking,
+                          int                       priority)
+{
+    using namespace PosixQueueTypes;
+
+    if (!d_base_p) {
+        return Send::e_UNKNOWN;                                       // RETURN
+    }
+
+    if (payload.length() > d_maxMessageSize) {
+        return Send::e_MESSAGE_TOO_LARGE;                             // RETURN
+    }
+
+    SegmentHeader& header = *segmentHeader(d_base_p);
+
+    int spin = 0;
+    for (;;) {
+        const Uint64 position =
+                        Atomics::getUint64Acquire(&header.d_enqueuePosition);
+        SlotHeader *const slot       = slotAt(d_base_p, position);
+        const Int64       difference =
+                Int64(Atomics::getUint64Acquire(&slot->d_sequence) - position);
+
+        if (difference == 0 && claim(slot, position, d_owner)) {
+            // Only the owner of the slot advances past it, so this succeeds
+            // unless the owner is a process that died and was recovered.
+            Atomics::testAndSwapUint64(
+                &header.d_enqueuePosition, position, position + 1);
+
+            slot->d_length   = Uint32(payload.length());
+            slot->d_priority = priority;
+            bsl::memcpy(payloadOf(slot), payload.data(), payload.length());
+
+            Atomics::setUint64(&slot->d_sequence, position + 1);
+            Atomics::setIntRelease(&slot->d_owner, 0);
+            notify(&header.d_messageCount, &header.d_numReceiversParked);
+            return 0;                                                 // RETURN
+        }
+
+        if (difference > 0) {
+            // Another sender advanced past the slot after it was read.
+            continue;
+        }
+
+        // Either the queue is full, or another thread holds the slot, and is
+        // about to advance past it unless its process died.
+        const bool isFull = difference < 0;
+        if (isFull && !blocking) {
+            if (recover(position)) {
+                continue;
+            }
+            return Send::e_FULL;                                      // RETURN
+        }
+
+        if (spin < k_SPIN_COUNT) {
+            ++spin;
+            WaitUtil::pause();
+            continue;
+        }
+
+        if (recover(position)) {
+            continue;
+        }
+
+        if (!isFull) {
+            bslmt::ThreadUtil::yield();
+        }
+        else if (park(true, position, deadline)) {
+            return Send::e_TIMED_OUT;                                 // RETURN
+        }
+    }
+}
+
+int ShmMpmcQueue::receiveImp(bsl::string              *payload,
+                             const bsls::TimeInterval *deadline,
+                             bool                      blocking,
+                             unsigned                 *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    if (!d_base_p) {
+        return Receive::e_UNKNOWN;                                    // RETURN
+    }
+
+    SegmentHeader& header = *segmentHeader(d_base_p);
+
+    int spin = 0;
+    for (;;) {
+        const Uint64 position =
+                        Atomics::getUint64Acquire(&header.d_dequeuePosition);
+        SlotHeader *const slot       = slotAt(d_base_p, position);
+        const Int64       difference =
+            Int64(Atomics::getUint64Acquire(&slot->d_sequence) - position - 1);
+
+        if (difference == 0 &&
+            claim(slot, position + 1, d_owner + k_READING)) {
+            Atomics::testAndSwapUint64(
+                &header.d_dequeuePosition, position, position + 1);
+
+            const Uint32 length = slot->d_length;
+            if (length != k_ABANDONED) {
+                payload->assign(payloadOf(slot), length);
+                if (priority) {
+                    *priority = slot->d_priority;
+                }
+            }
+
+            Atomics::setUint64(&slot->d_sequence, position + d_numSlots);
+            Atomics::setIntRelease(&slot->d_owner, 0);
+            notify(&header.d_roomCount, &header.d_numSendersParked);
+
+            if (length != k_ABANDONED) {
+                return 0;                                             // RETURN
+            }
+            continue;
+        }
+
+        if (difference > 0) {
+            // Another receiver advanced past the slot after it was read.
+            continue;
+        }
+
+        // As in 'sendImp', but the other way around.
+        const bool isEmpty = difference < 0;
+        if (isEmpty && !blocking) {
+            if (recover(position)) {
+                continue;
+            }
+            return Receive::e_EMPTY;                                  // RETURN
+        }
+
+        if (spin < k_SPIN_COUNT) {
+            ++spin;
+            WaitUtil::pause();
+            continue;
+        }
+
+        if (recover(position)) {
+            continue;
+        }
+
+        if (!isEmpty) {
+            bslmt::ThreadUtil::yield();
+        }
+        else if (park(false, position, deadline)) {
+            return Receive::e_TIMED_OUT;                              // RETURN
+        }
+    }
+}
+
+bool ShmMpmcQueue::recover(Uint64 position)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    SegmentHeader&    header = *segmentHeader(d_base_p);
+    SlotHeader *const slot   = slotAt(d_base_p, position);
+
+    const int owner = Atomics::getInt(&slot->d_owner);
+    if (owner == 0 || isAlive(owner / 2)) {
+        return false;                                                 // RETURN
+    }
+
+    // The slot is taken over in the role of the dead owner, so that if this
+    // process dies too, the next to recover the slot does the same.
+    const int reading = owner & k_READING;
+    if (Atomics::testAndSwapInt(&slot->d_owner, owner, d_owner + reading) !=
+                                                                      owner) {
+        return false;                                                 // RETURN
+    }
+
+    // Since there are at least two slots, the sequence number tells whether
+    // the slot is free to be written at 'sequence', or holds the message
+    // written at 'sequence - 1'.
+    const Uint64 sequence = Atomics::getUint64Acquire(&slot->d_sequence);
+    const bool   isFree   = ((sequence ^ position) & (d_numSlots - 1)) == 0;
+
+    if (!reading && isFree) {
+        // The owner died writing. Its message is published as abandoned, and
+        // the position is advanced past it if the owner died before doing
+        // so.
+        slot->d_length = k_ABANDONED;
+        Atomics::setUint64(&slot->d_sequence, sequence + 1);
+        Atomics::testAndSwapUint64(
+            &header.d_enqueuePosition, sequence, sequence + 1);
+    }
+    else if (reading && !isFree &&
+             Atomics::getUint64(&header.d_dequeuePosition) > sequence - 1) {
+        // The owner died reading, after advancing past the slot, so the
+        // message may have been partly delivered, and is discarded.
+        Atomics::setUint64(&slot->d_sequence, sequence - 1 + d_numSlots);
+    }
+
+    // Otherwise, the owner died after it finished, or before it advanced
+    // past the slot, which then remains as it was.
+    Atomics::setIntRelease(&slot->d_owner, 0);
+    Atomics::addInt64(&header.d_numAbandoned, 1);
+
+    notify(&header.d_messageCount, &header.d_numReceiversParked);
+    notify(&header.d_roomCount, &header.d_numSendersParked);
+
+    BALL_LOG_WARN << "Recovered a slot of shared memory queue " << d_name
+                  << " from process " << owner / 2
+                  << ", which no longer exists." << BALL_LOG_END;
+    return true;
+}
+
+int ShmMpmcQueue::park(bool                      sender,
+                       Uint64                    position,
+                       const bsls::TimeInterval *deadline)
+{
+    SegmentHeader& header = *segmentHeader(d_base_p);
+
+    AtomicInt *const    count      = sender ? &header.d_roomCount
+                                            : &header.d_messageCount;
+    AtomicInt *const    numParked  = sender ? &header.d_numSendersParked
+                                            : &header.d_numReceiversParked;
+    AtomicUint64 *const next       = sender ? &header.d_enqueuePosition
+                                            : &header.d_dequeuePosition;
+    const Uint64        ready      = sender ? position : position + 1;
+
+    bsls::TimeInterval wakeTime = bdlt::CurrentTime::now();
+    wakeTime.addMilliseconds(k_RECOVERY_INTERVAL_MILLISECONDS);
+    const bool isDeadline = deadline && *deadline <= wakeTime;
+    if (isDeadline) {
+        wakeTime = *deadline;
+    }
+
+    // The queue is checked again after announcing that this thread is
+    // parked, so that progress made before the announcement is not missed.
+    const int value = Atomics::getInt(count);
+    Atomics::addInt(numParked, 1);
+
+    int rc = 0;
+    if (Atomics::getUint64(next) == position &&
+        Atomics::getUint64(&slotAt(d_base_p, position)->d_sequence) != ready) {
+        rc = WaitUtil::wait(count, value, &wakeTime);
+    }
+
+    Atomics::addInt(numParked, -1);
+    return rc && isDeadline;
+}
+
+// ACCESSORS
+bool ShmMpmcQueue::isOpen() const
+{
+    return d_base_p != 0;
+}
+
+IPCU_DEFINE_OPERATOR_BOOL(ShmMpmcQueue)
+{
+    IPCU_RETURN_OPERATOR_BOOL(ShmMpmcQueue, isOpen());
+}
+
+bsl::size_t ShmMpmcQueue::maxMessageSize() const
+{
+    return d_maxMessageSize;
+}
+
+const bsl::string& ShmMpmcQueue::name() const
+{
+    return d_name;
+}
+
+bsls::Types::Int64 ShmMpmcQueue::numAbandoned() const
+{
+    if (!d_base_p) {
+        return 0;                                                     // RETURN
+    }
+
+    return Atomics::getInt64(&segmentHeader(d_base_p)->d_numAbandoned);
+}
+
+bsl::size_t ShmMpmcQueue::numSlots() const
+{
+    return d_numSlots;
+}
+
+// CLASS METHODS
+const char *ShmMpmcQueue::description(int errorCode)
+{
+    return ipcmq::description(errorCode);
+}
+
+int ShmMpmcQueue::unlink(const bslstl::StringRef& name)
+{
+    using namespace PosixQueueTypes;
+
+    const bsl::string path(name);
+    if (shm_unlink(path.c_str()) == 0) {
+        return 0;                                                     // RETURN
+    }
+
+    switch (errno) {
+      case EACCES:
+        return Unlink::e_PERMISSION_DENIED;                           // RETURN
+      case ENAMETOOLONG:
+        return Unlink::e_NAME_TOO_LONG;                               // RETURN
+      case ENOENT:
+        return Unlink::e_DOES_NOT_EXIST;                              // RETURN
+      case EINVAL:
+        return Unlink::e_INVALID_PARAMETER;                           // RETURN
+      default:
+        return Unlink::e_UNKNOWN;                                     // RETURN
+    }
+}
+
+}  // close package namespace
+}  // close enterprise namespace
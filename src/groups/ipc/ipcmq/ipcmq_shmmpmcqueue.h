@@ -0,0 +1,285 @@
+#ifndef INCLUDED_IPCMQ_SHMMPMCQUEUE
+#define INCLUDED_IPCMQ_SHMMPMCQUEUE
+
+#include <ipcmq_receiver.h>
+#include <ipcmq_sender.h>
+#include <ipcu_operatorbool.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace bsls { class TimeInterval; }
+namespace ipcmq {
+
+                             // ==================
+                             // class ShmMpmcQueue
+                             // ==================
+
+class ShmMpmcQueue : public Sender, public Receiver {
+    // This class implements both the 'Sender' and 'Receiver' protocols using
+    // a bounded array of fixed size slots in a POSIX shared memory segment,
+    // so that any number of threads in any number of processes may send and
+    // receive concurrently without a lock and without a system call. Each
+    // slot has a sequence number that tells whether it is free to be
+    // written, or holds a message ready to be read, for a given position in
+    // the queue. A sender claims the slot at the position past the last
+    // message written when its sequence number says that it is free,
+    // advances that position, writes its message, and then advances the
+    // sequence number; a receiver does the same at the position of the first
+    // message not read.
+    //
+    // A slot is claimed by storing into it the process ID of the claimant, so
+    // that a process that dies holding a slot does not stop the queue. A
+    // thread that finds the queue full or empty because of a slot held by a
+    // process that no longer exists takes the slot over and completes the
+    // operation on the dead process's behalf: a message that was being
+    // written is marked abandoned and is skipped by receivers, a message
+    // that was being read is discarded, and a message that was written but
+    // not yet read is left to be received. Either way, 'numAbandoned' counts
+    // the slot. Note that a process ID reused by a new process is taken for
+    // the old one, so such a slot is not recovered until the new process
+    // exits, and that since an object records the ID of the process that
+    // opened it, a child process must open its own object rather than use
+    // one opened before 'fork'.
+    //
+    // A thread that finds the queue full, when sending, or empty, when
+    // receiving, spins for a while and then parks on a futex until another
+    // thread makes progress, as described by 'WaitUtil', waking regularly to
+    // check for slots held by dead processes. Messages are received in the
+    // order that their slots were claimed; their priorities are delivered
+    // but do not affect the order.
+
+  public:
+    // PUBLIC CONSTANTS
+    enum {
+        k_DEFAULT_NUM_SLOTS        = 1024,
+        k_DEFAULT_MAX_MESSAGE_SIZE = 8192
+    };
+
+  private:
+    // DATA
+    char                *d_base_p;          // zero unless a segment is mapped
+    bsl::size_t          d_mappingLength;
+    bsls::Types::Uint64  d_numSlots;        // a power of two
+    bsls::Types::Uint64  d_slotSize;        // including its header
+    bsl::size_t          d_maxMessageSize;
+    int                  d_owner;           // stored into claimed slots
+    bsl::string          d_name;
+
+    ShmMpmcQueue(const ShmMpmcQueue&);             // = delete
+    ShmMpmcQueue& operator=(const ShmMpmcQueue&);  // = delete
+
+  public:
+    // CREATORS
+    explicit ShmMpmcQueue(
+        const bslstl::StringRef& name,
+        bsl::size_t              numSlots        = k_DEFAULT_NUM_SLOTS,
+        bsl::size_t              maxMessageSize  = k_DEFAULT_MAX_MESSAGE_SIZE,
+        int                      filePermissions = 0,
+        bslma::Allocator        *allocator       = 0);
+        // Open the shared memory queue having the specified 'name', which
+        // begins with a slash, for sending and receiving. If the queue does
+        // not already exist, create it having the optionally specified
+        // 'numSlots', rounded up to a power of two, each holding a message of
+        // at most the optionally specified 'maxMessageSize' bytes, and the
+        // optionally specified 'filePermissions'. Note that 'numSlots' and
+        // 'maxMessageSize' are ignored if the queue exists. On success,
+        // 'isOpen' will subsequently return 'true'.
+
+    ~ShmMpmcQueue();
+        // Unmap the segment of this object and destroy this object. Note
+        // that the segment remains until it is unlinked.
+
+    // MANIPULATORS
+    int receive(bsl::string *payload);                      // override
+    int receive(bsl::string *payload, unsigned *priority);  // override
+    int receive(bsl::string               *payload,
+                const bsls::TimeInterval&  relativeTimeout);  // override
+    int receive(bsl::string               *payload,
+                const bsls::TimeInterval&  relativeTimeout,
+                unsigned                  *priority);  // override
+        // Assign through the specified 'payload' the content of the next
+        // message in the queue represented by this object. Assign through the
+        // optionally specified 'priority' the priority of the message
+        // received. Block for no longer than the optionally specified
+        // 'relativeTimeout', relative to the beginning of the invocation of
+        // this function. Return zero if a message is successfully received or
+        // a nonzero value otherwise.
+
+    int tryReceive(bsl::string *payload);                      // override
+    int tryReceive(bsl::string *payload, unsigned *priority);  // override
+        // Assign through the specified 'payload' the content of the next
+        // message in the queue represented by this object. Assign through the
+        // optionally specified 'priority' the priority of the message
+        // received. Do not block. Return zero if a message is successfully
+        // received or a nonzero value otherwise.
+
+    int send(const bslstl::StringRef& payload);                // override
+    int send(const bslstl::StringRef& payload, int priority);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout,
+             int                       priority);  // override
+        // Write into the queue represented by this object a message
+        // consisting of the specified 'payload' and having the optionally
+        // specified 'priority'. Block for no longer than the optionally
+        // specified 'relativeTimeout', relative to the beginning of the
+        // invocation of this function. Return zero if the message is
+        // successfully sent or a nonzero value otherwise.
+
+    int trySend(const bslstl::StringRef& payload);                // override
+    int trySend(const bslstl::StringRef& payload, int priority);  // override
+        // Write into the queue represented by this object a message
+        // consisting of the specified 'payload' and having the optionally
+        // specified 'priority'. Do not block. Return zero if the message is
+        // successfully sent or a nonzero value otherwise.
+
+    int unlink();
+        // Mark for deletion the shared memory segment opened by this object.
+        // Return zero on success or a nonzero value otherwise.
+
+    // ACCESSORS
+    bool isOpen() const;
+        // Return whether this object represents an open queue.
+
+    IPCU_DECLARE_OPERATOR_BOOL(ShmMpmcQueue);
+        // Return 'isOpen()'.
+
+    bsl::size_t maxMessageSize() const;
+        // Return the maximum number of bytes in the payload of a message.
+
+    const bsl::string& name() const;
+        // Return the name of the shared memory segment of this object.
+
+    bsls::Types::Int64 numAbandoned() const;
+        // Return the number of slots that have been recovered from processes
+        // that died while holding them, by any process, since the queue was
+        // created.
+
+    bsl::size_t numSlots() const;
+        // Return the number of messages that the queue can hold.
+
+    // CLASS METHODS
+    static const char *description(int errorCode);
+        // Return a pointer to a null terminated string that describes the
+        // specified 'errorCode'. The behavior is undefined unless 'errorCode'
+        // has the same value as the result of a previous invocation of one of
+        // the methods of an instance of this class.
+
+    static int unlink(const bslstl::StringRef& name);
+        // Mark for deletion the shared memory segment having the specified
+        // 'name'. Return zero on success or a nonzero value otherwise.
+
+  private:
+    // PRIVATE MANIPULATORS
+    int open(bsl::size_t numSlots,
+             bsl::size_t maxMessageSize,
+             int         filePermissions);
+        // Open or create the segment of this object, creating it with the
+        // specified 'numSlots' of the specified 'maxMessageSize' and the
+        // specified 'filePermissions'. Return zero on success or a nonzero
+        // value otherwise.
+
+    int sendImp(const bslstl::StringRef&  payload,
+                const bsls::TimeInterval *deadline,
+                bool                      blocking,
+                int                       priority);
+        // Write into the queue a message consisting of the specified
+        // 'payload' and having the specified 'priority'. If the specified
+        // 'blocking' is 'false', do not block. Otherwise, block until the
+        // specified 'deadline', or indefinitely if 'deadline' is zero. Return
+        // zero on success or a nonzero value otherwise.
+
+    int receiveImp(bsl::string              *payload,
+                   const bsls::TimeInterval *deadline,
+                   bool                      blocking,
+                   unsigned                 *priority);
+        // Read from the queue the next message, and load its payload into
+        // the specified 'payload' and, unless it is zero, its priority into
+        // the specified 'priority'. If the specified 'blocking' is 'false',
+        // do not block. Otherwise, block until the specified 'deadline', or
+        // indefinitely if 'deadline' is zero. Return zero on success or a
+        // nonzero value otherwise.
+
+    bool recover(bsls::Types::Uint64 index);
+        // Take over the slot at the specified 'index' if it is held by a
+        // process that no longer exists, and complete the operation of that
+        // process as described in the class documentation. Return 'true' if
+        // the slot was recovered, or 'false' otherwise.
+
+    int park(bool                      sender,
+             bsls::Types::Uint64       position,
+             const bsls::TimeInterval *deadline);
+        // Block the calling thread until another thread makes progress at the
+        // specified 'position', which is the position of the next message to
+        // write if the specified 'sender' is 'true', or to read otherwise, or
+        // until the specified 'deadline', if it is not zero, or until it is
+        // time to check again for dead processes. Return zero unless
+        // 'deadline' passed, in which case return a nonzero value.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                             // ------------------
+                             // class ShmMpmcQueue
+                             // ------------------
+
+inline
+int ShmMpmcQueue::receive(bsl::string *payload)
+{
+    return receiveImp(payload, 0, true, 0);
+}
+
+inline
+int ShmMpmcQueue::receive(bsl::string *payload, unsigned *priority)
+{
+    return receiveImp(payload, 0, true, priority);
+}
+
+inline
+int ShmMpmcQueue::tryReceive(bsl::string *payload)
+{
+    return receiveImp(payload, 0, false, 0);
+}
+
+inline
+int ShmMpmcQueue::tryReceive(bsl::string *payload, unsigned *priority)
+{
+    return receiveImp(payload, 0, false, priority);
+}
+
+inline
+int ShmMpmcQueue::send(const bslstl::StringRef& payload)
+{
+    return sendImp(payload, 0, true, 0);
+}
+
+inline
+int ShmMpmcQueue::send(const bslstl::StringRef& payload, int priority)
+{
+    return sendImp(payload, 0, true, priority);
+}
+
+inline
+int ShmMpmcQueue::trySend(const bslstl::StringRef& payload)
+{
+    return sendImp(payload, 0, false, 0);
+}
+
+inline
+int ShmMpmcQueue::trySend(const bslstl::StringRef& payload, int priority)
+{
+    return sendImp(payload, 0, false, priority);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -0,0 +1,527 @@
+
+#include <ipcmq_shmringqueue.h>
+#include <ipcmq_posixqueueerrors.h>
+#include <ipcmq_waitutil.h>
+
+#include <ball_log.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bslmf_assert.h>
+
+#include <bslmt_threadutil.h>
+
+#include <bsls_assert.h>
+#include <bsls_atomicoperations.h>
+#include <bsls_timeinterval.h>
+
+#include <bsl_cstring.h>
+
+#include <errno.h>     // errno, EEXIST, ENOENT
+#include <fcntl.h>     // O_* constants
+#include <string.h>    // strerror
+#include <sys/mman.h>  // shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, ftruncate
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.SHMRINGQUEUE";
+
+typedef bsls::AtomicOperations       Atomics;
+typedef Atomics::AtomicTypes::Int    AtomicInt;
+typedef Atomics::AtomicTypes::Uint64 AtomicUint64;
+typedef bsls::Types::Uint64          Uint64;
+typedef bsls::Types::Uint32          Uint32;
+
+// "ipcmqrng" in ASCII, marking the beginning of a segment created by this
+// component, followed by a version number in the last byte.
+const Uint64 k_MAGIC = 0x6970636d71726e01ULL;
+
+const bsl::size_t k_CACHE_LINE_SIZE = 64;
+
+// The ring begins on the page after the header.
+const Uint64 k_HEADER_SIZE = 4096;
+
+const Uint64 k_MIN_CAPACITY = 4096;
+
+// A thread that finds the ring full or empty checks again this many times
+// before it parks.
+const int k_SPIN_COUNT = 4000;
+
+// A process that opens a segment that another process is still creating
+// checks again this many times, this many microseconds apart, for it to be
+// initialized.
+const int k_MAX_OPEN_ATTEMPTS       = 1000;
+const int k_OPEN_RETRY_MICROSECONDS = 1000;
+
+struct SegmentHeader {
+    // This 'struct' is the beginning of every segment. The members written by
+    // the sender and those written by the receiver are in separate cache
+    // lines, so that neither side's writes evict the other's reads. Since a
+    // segment may be shared by processes built from different code, every
+    // member has a fixed size.
+
+    // written once, by the creator
+    AtomicUint64 d_magic;
+    Uint64       d_capacity;
+    char         d_padding0[k_CACHE_LINE_SIZE - 2 * sizeof(Uint64)];
+
+    // written by the sender
+    AtomicUint64 d_tail;            // index past the last message written
+    AtomicInt    d_messageCount;    // futex word for a parked receiver
+    AtomicInt    d_senderIsParked;
+    char         d_padding1[k_CACHE_LINE_SIZE - sizeof(Uint64) -
+                            2 * sizeof(int)];
+
+    // written by the receiver
+    AtomicUint64 d_head;            // index of the first message not read
+    AtomicInt    d_roomCount;       // futex word for a parked sender
+    AtomicInt    d_receiverIsParked;
+};
+
+BSLMF_ASSERT(sizeof(SegmentHeader) <= k_HEADER_SIZE);
+
+struct MessageHeader {
+    // This 'struct' precedes the payload of every message in the ring.
+
+    Uint32 d_length;    // of the payload, or 'k_SKIP'
+    int    d_priority;
+};
+
+BSLMF_ASSERT(sizeof(MessageHeader) == 8);
+
+// A message header having this length marks the end of the messages before
+// the end of the ring. The next message is at the beginning of the ring.
+const Uint32 k_SKIP = 0xFFFFFFFF;
+
+Uint64 messageSize(Uint64 payloadLength)
+    // Return the number of bytes occupied by a message having a payload of
+    // the specified 'payloadLength', which is a multiple of eight.
+{
+    return (sizeof(MessageHeader) + payloadLength + 7) & ~Uint64(7);
+}
+
+SegmentHeader *segmentHeader(char *base)
+{
+    return reinterpret_cast<SegmentHeader *>(base);
+}
+
+void publish(AtomicUint64 *index,
+             Uint64        value,
+             AtomicInt    *count,
+             AtomicInt    *otherIsParked)
+    // Store the specified 'value' into the specified 'index', and if the
+    // specified 'otherIsParked' is set, increment the specified 'count' and
+    // wake the other side. Storing the index is sequentially consistent, so
+    // that either this thread sees that the other side is parked, or the
+    // other side sees the new index before it parks.
+{
+    Atomics::setUint64(index, value);
+    if (Atomics::getInt(otherIsParked)) {
+        Atomics::addInt(count, 1);
+        WaitUtil::wake(count);
+    }
+}
+
+}  // close unnamed namespace
+
+                             // ------------------
+                             // class ShmRingQueue
+                             // ------------------
+
+// CREATORS
+ShmRingQueue::ShmRingQueue(const bslstl::StringRef&  name,
+                           bsl::size_t               capacity,
+                           int                       filePermissions,
+                           bslma::Allocator         *allocator)
+: d_base_p(0)
+, d_mappingLength(0)
+, d_capacity(0)
+, d_cachedHead(0)
+, d_cachedTail(0)
+, d_name(name, allocator)
+{
+    open(capacity, filePermissions);
+}
+
+ShmRingQueue::~ShmRingQueue()
+{
+    if (d_base_p) {
+        munmap(d_base_p, d_mappingLength);
+    }
+}
+
+// MANIPULATORS
+int ShmRingQueue::receive(bsl::string               *payload,
+                          const bsls::TimeInterval&  relativeTimeout)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return receiveImp(payload, &deadline, true, 0);
+}
+
+int ShmRingQueue::receive(bsl::string               *payload,
+                          const bsls::TimeInterval&  relativeTimeout,
+                          unsigned                  *priority)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return receiveImp(payload, &deadline, true, priority);
+}
+
+int ShmRingQueue::send(const bslstl::StringRef&  payload,
+                       const bsls::TimeInterval& relativeTimeout)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return sendImp(payload, &deadline, true, 0);
+}
+
+int ShmRingQueue::send(const bslstl::StringRef&  payload,
+                       const bsls::TimeInterval& relativeTimeout,
+                       int                       priority)
+{
+    const bsls::TimeInterval deadline =
+                                   bdlt::CurrentTime::now() + relativeTimeout;
+    return sendImp(payload, &deadline, true, priority);
+}
+
+int ShmRingQueue::unlink()
+{
+    using namespace PosixQueueTypes;
+
+    if (shm_unlink(d_name.c_str()) == 0) {
+        return 0;                                                     // RETURN
+    }
+
+    switch (errno) {
+      case EACCES:
+        return Unlink::e_PERMISSION_DENIED;                           // RETURN
+      case ENAMETOOLONG:
+        return Unlink::e_NAME_TOO_LONG;                               // RETURN
+      case ENOENT:
+        return Unlink::e_DOES_NOT_EXIST;                              // RETURN
+      case EINVAL:
+        return Unlink::e_INVALID_PARAMETER;                           // RETURN
+      default:
+        return Unlink::e_UNKNOWN;                                     // RETURN
+    }
+}
+
+int ShmRingQueue::open(bsl::size_t capacity, int filePermissions)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    Uint64 ringSize = k_MIN_CAPACITY;
+    while (ringSize < capacity) {
+        ringSize *= 2;
+    }
+
+    bool isCreator = true;
+    int  fd        = shm_open(d_name.c_str(),
+                              O_RDWR | O_CREAT | O_EXCL,
+                              filePermissions ? filePermissions : 0600);
+    if (fd == -1 && errno == EEXIST) {
+        isCreator = false;
+        fd        = shm_open(d_name.c_str(), O_RDWR, 0);
+    }
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to open shared memory ring " << d_name
+                       << ": " << strerror(errno) << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    Uint64 size = k_HEADER_SIZE + ringSize;
+    if (isCreator) {
+        if (ftruncate(fd, size) == -1) {
+            BALL_LOG_ERROR << "Unable to resize shared memory ring " << d_name
+                           << " to " << size
+                           << " bytes: " << strerror(errno) << BALL_LOG_END;
+            close(fd);
+            shm_unlink(d_name.c_str());
+            return 2;                                                 // RETURN
+        }
+    }
+    else {
+        // The creator may not have resized the segment yet.
+        struct stat status;
+        int         attempt = 0;
+        while (fstat(fd, &status) == 0 && status.st_size == 0 &&
+               ++attempt < k_MAX_OPEN_ATTEMPTS) {
+            bslmt::ThreadUtil::microSleep(k_OPEN_RETRY_MICROSECONDS);
+        }
+        if (Uint64(status.st_size) <= k_HEADER_SIZE) {
+            BALL_LOG_ERROR << "The shared memory segment " << d_name
+                           << " is not a ring." << BALL_LOG_END;
+            close(fd);
+            return 3;                                                 // RETURN
+        }
+        size = status.st_size;
+    }
+
+    void *const address =
+        mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping remains valid after the descriptor is closed.
+    if (address == MAP_FAILED) {
+        BALL_LOG_ERROR << "Unable to map shared memory ring " << d_name
+                       << " into memory: " << strerror(errno)
+                       << BALL_LOG_END;
+        if (isCreator) {
+            shm_unlink(d_name.c_str());
+        }
+        return 4;                                                     // RETURN
+    }
+
+    char *const          base   = static_cast<char *>(address);
+    SegmentHeader *const header = segmentHeader(base);
+    if (isCreator) {
+        // The segment is zeroed when it is resized, so only the capacity and
+        // the magic number need to be written, the latter last.
+        header->d_capacity = ringSize;
+        Atomics::setUint64Release(&header->d_magic, k_MAGIC);
+    }
+    else {
+        int attempt = 0;
+        while (Atomics::getUint64Acquire(&header->d_magic) != k_MAGIC &&
+               ++attempt < k_MAX_OPEN_ATTEMPTS) {
+            bslmt::ThreadUtil::microSleep(k_OPEN_RETRY_MICROSECONDS);
+        }
+        if (Atomics::getUint64Acquire(&header->d_magic) != k_MAGIC ||
+            header->d_capacity != size - k_HEADER_SIZE) {
+            BALL_LOG_ERROR << "The shared memory segment " << d_name
+                           << " is not a ring." << BALL_LOG_END;
+            munmap(address, size);
+            return 3;                                                 // RETURN
+        }
+    }
+
+    d_base_p        = base;
+    d_mappingLength = size;
+    d_capacity      = header->d_capacity;
+    d_cachedHead    = Atomics::getUint64Acquire(&header->d_head);
+    d_cachedTail    = Atomics::getUint64Acquire(&header->d_tail);
+    return 0;
+}
+
+int ShmRingQueue::sendImp(const bslstl::StringRef&  payload,
+                          const bsls::TimeInterval *deadline,
+                          bool                      blocking,
+                          int                       priority)
+{
+    using namespace PosixQueueTypes;
+
+    if (!d_base_p) {
+        return Send::e_UNKNOWN;                                       // RETURN
+    }
+
+    const Uint64 size = messageSize(payload.length());
+    if (size > d_capacity || payload.length() >= k_SKIP) {
+        return Send::e_MESSAGE_TOO_LARGE;                             // RETURN
+    }
+
+    SegmentHeader& header = *segmentHeader(d_base_p);
+    char *const    ring   = d_base_p + k_HEADER_SIZE;
+
+    // Only this thread writes the tail.
+    Uint64 tail = Atomics::getUint64Relaxed(&header.d_tail);
+    for (;;) {
+        const Uint64 offset     = tail & (d_capacity - 1);
+        const Uint64 contiguous = d_capacity - offset;
+        const Uint64 needed     = size <= contiguous ? size : contiguous;
+        if (const int rc = waitForRoom(tail, needed, deadline, blocking)) {
+            return rc;                                                // RETURN
+        }
+
+        if (size <= contiguous) {
+            break;
+        }
+
+        // Skip to the beginning of the ring, and publish the skip on its own,
+        // so that the receiver makes room at the beginning.
+        const MessageHeader skip = { k_SKIP, 0 };
+        bsl::memcpy(ring + offset, &skip, sizeof skip);
+        tail += contiguous;
+        publish(&header.d_tail,
+                tail,
+                &header.d_messageCount,
+                &header.d_receiverIsParked);
+    }
+
+    const Uint64        offset  = tail & (d_capacity - 1);
+    const MessageHeader message = { Uint32(payload.length()), priority };
+    bsl::memcpy(ring + offset, &message, sizeof message);
+    bsl::memcpy(
+        ring + offset + sizeof message, payload.data(), payload.length());
+
+    publish(&header.d_tail,
+            tail + size,
+            &header.d_messageCount,
+            &header.d_receiverIsParked);
+    return 0;
+}
+
+int ShmRingQueue::receiveImp(bsl::string              *payload,
+                             const bsls::TimeInterval *deadline,
+                             bool                      blocking,
+                             unsigned                 *priority)
+{
+    using namespace PosixQueueTypes;
+    BSLS_ASSERT(payload);
+
+    if (!d_base_p) {
+        return Receive::e_UNKNOWN;                                    // RETURN
+    }
+
+    SegmentHeader& header = *segmentHeader(d_base_p);
+    const char    *ring   = d_base_p + k_HEADER_SIZE;
+
+    // Only this thread writes the head.
+    Uint64 head = Atomics::getUint64Relaxed(&header.d_head);
+    for (;;) {
+        if (const int rc = waitForMessage(head, deadline, blocking)) {
+            return rc;                                                // RETURN
+        }
+
+        const Uint64  offset = head & (d_capacity - 1);
+        MessageHeader message;
+        bsl::memcpy(&message, ring + offset, sizeof message);
+        if (message.d_length != k_SKIP) {
+            payload->assign(ring + offset + sizeof message, message.d_length);
+            if (priority) {
+                *priority = message.d_priority;
+            }
+            head += messageSize(message.d_length);
+            break;
+        }
+
+        // The sender may be waiting for the room at the beginning.
+        head += d_capacity - offset;
+        publish(&header.d_head,
+                head,
+                &header.d_roomCount,
+                &header.d_senderIsParked);
+    }
+
+    publish(
+        &header.d_head, head, &header.d_roomCount, &header.d_senderIsParked);
+    return 0;
+}
+
+int ShmRingQueue::waitForRoom(Uint64                    tail,
+                              Uint64                    size,
+                              const bsls::TimeInterval *deadline,
+                              bool                      blocking)
+{
+    using namespace PosixQueueTypes;
+
+    // The head seen last is checked first, so that the receiver's cache line
+    // is read only when the ring seems full.
+    if (tail + size - d_cachedHead <= d_capacity) {
+        return 0;                                                     // RETURN
+    }
+
+    SegmentHeader& header = *segmentHeader(d_base_p);
+    for (int spin = 0; spin < k_SPIN_COUNT; ++spin) {
+        d_cachedHead = Atomics::getUint64Acquire(&header.d_head);
+        if (tail + size - d_cachedHead <= d_capacity) {
+            return 0;                                                 // RETURN
+        }
+        if (!blocking) {
+            return Send::e_FULL;                                      // RETURN
+        }
+        WaitUtil::pause();
+    }
+
+    for (;;) {
+        const int count = Atomics::getInt(&header.d_roomCount);
+        Atomics::setInt(&header.d_senderIsParked, 1);
+        d_cachedHead = Atomics::getUint64(&header.d_head);
+        if (tail + size - d_cachedHead <= d_capacity) {
+            break;
+        }
+
+        if (WaitUtil::wait(&header.d_roomCount, count, deadline)) {
+            Atomics::setInt(&header.d_senderIsParked, 0);
+            return Send::e_TIMED_OUT;                                 // RETURN
+        }
+    }
+
+    Atomics::setInt(&header.d_senderIsParked, 0);
+    return 0;
+}
+
+int ShmRingQueue::waitForMessage(Uint64                    head,
+                                 const bsls::TimeInterval *deadline,
+                                 bool                      blocking)
+{
+    using namespace PosixQueueTypes;
+
+    // As in 'waitForRoom', but the other way around. Note that the tail seen
+    // last may be older than the head, if this object has not received
+    // before.
+    if (head < d_cachedTail) {
+        return 0;                                                     // RETURN
+    }
+
+    SegmentHeader& header = *segmentHeader(d_base_p);
+    for (int spin = 0; spin < k_SPIN_COUNT; ++spin) {
+        d_cachedTail = Atomics::getUint64Acquire(&header.d_tail);
+        if (head < d_cachedTail) {
+            return 0;                                                 // RETURN
+        }
+        if (!blocking) {
+            return Receive::e_EMPTY;                                  // RETURN
+        }
+        WaitUtil::pause();
+    }
+
+    for (;;) {
+        const int count = Atomics::getInt(&header.d_messageCount);
+        Atomics::setInt(&header.d_receiverIsParked, 1);
+        d_cachedTail = Atomics::getUint64(&header.d_tail);
+        if (head < d_cachedTail) {
+            break;
+        }
+
+        if (WaitUtil::wait(&header.d_messageCount, count, deadline)) {
+            Atomics::setInt(&header.d_receiverIsParked, 0);
+            return Receive::e_TIMED_OUT;                              // RETURN
+        }
+    }
+
+    Atomics::setInt(&header.d_receiverIsParked, 0);
+    return 0;
+}
+
+// ACCESSORS
+bsl::size_t ShmRingQueue::capacity() const
+{
+    return d_capacity;
+}
+
+bool ShmRingQueue::isOpen() const
+{
+    return d_base_p != 0;
+}
+
+IPCU_DEFINE_OPERATOR_BOOL(ShmRingQueue)
+{
+    IPCU_RETURN_OPERATOR_BOOL(ShmRingQueue, isOpen());
+}
+
+const bsl::string& ShmRingQueue::name() const
+{
+    return d_name;
+}
+
+// CLASS METHODS
+const char *ShmRingQueue::description(int errorCode)
+{
+    return ipcmq::description(errorCode);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,257 @@
+#ifndef INCLUDED_IPCMQ_SHMRINGQUEUE
+#define INCLUDED_IPCMQ_SHMRINGQUEUE
+
+#include <ipcmq_receiver.h>
+#include <ipcmq_sender.h>
+#include <ipcu_operatorbool.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace bsls { class TimeInterval; }
+namespace ipcmq {
+
+                             // ==================
+                             // class ShmRingQueue
+                             // ==================
+
+class ShmRingQueue : public Sender, public Receiver {
+    // This class implements both the 'Sender' and 'Receiver' protocols using
+    // a ring of messages in a POSIX shared memory segment, rather than a
+    // message queue, so that a message is handed from one process to another
+    // without a system call and with one copy on each side. The segment has
+    // a header holding the index past the last message written and the index
+    // of the first message not yet read, each in its own cache line, followed
+    // by the ring, each message of which is its length and priority followed
+    // by its payload, padded to a multiple of eight bytes. A message that
+    // does not fit between the end of the last message and the end of the
+    // ring is instead written at the beginning, after a marker telling the
+    // reader to skip to the beginning.
+    //
+    // A thread that finds the ring full, when sending, or empty, when
+    // receiving, spins for a while and then parks on a futex until the other
+    // side makes progress, as described by 'WaitUtil'. Each side wakes the
+    // other only if the other has announced that it is parked, so that
+    // neither side makes a system call while the other keeps up.
+    //
+    // The ring has a single producer and a single consumer: at any time, at
+    // most one thread, in any process, may be sending, and at most one
+    // thread, in any process, may be receiving. Messages are received in the
+    // order sent; their priorities are delivered but do not affect the order.
+
+  public:
+    // PUBLIC CONSTANTS
+    enum { k_DEFAULT_CAPACITY = 1024 * 1024 };
+
+  private:
+    // DATA
+    char                *d_base_p;       // zero unless a segment is mapped
+    bsl::size_t          d_mappingLength;
+    bsls::Types::Uint64  d_capacity;     // of the ring, a power of two
+    bsls::Types::Uint64  d_cachedHead;   // read index last seen by sender
+    bsls::Types::Uint64  d_cachedTail;   // write index last seen by receiver
+    bsl::string          d_name;
+
+    ShmRingQueue(const ShmRingQueue&);             // = delete
+    ShmRingQueue& operator=(const ShmRingQueue&);  // = delete
+
+  public:
+    // CREATORS
+    explicit ShmRingQueue(
+        const bslstl::StringRef&  name,
+        bsl::size_t               capacity        = k_DEFAULT_CAPACITY,
+        int                       filePermissions = 0,
+        bslma::Allocator         *allocator       = 0);
+        // Open the shared memory ring having the specified 'name', which
+        // begins with a slash, for sending and receiving. If the ring does
+        // not already exist, create it having room for the optionally
+        // specified 'capacity' bytes of messages, rounded up to a power of
+        // two, and the optionally specified 'filePermissions'. Note that each
+        // message occupies eight bytes more than its payload, rounded up to a
+        // multiple of eight, and that 'capacity' is ignored if the ring
+        // exists. On success, 'isOpen' will subsequently return 'true'.
+
+    ~ShmRingQueue();
+        // Unmap the segment of this object and destroy this object. Note
+        // that the segment remains until it is unlinked.
+
+    // MANIPULATORS
+    int receive(bsl::string *payload);                      // override
+    int receive(bsl::string *payload, unsigned *priority);  // override
+    int receive(bsl::string               *payload,
+                const bsls::TimeInterval&  relativeTimeout);  // override
+    int receive(bsl::string               *payload,
+                const bsls::TimeInterval&  relativeTimeout,
+                unsigned                  *priority);  // override
+        // Assign through the specified 'payload' the content of the next
+        // message in the ring represented by this object. Assign through the
+        // optionally specified 'priority' the priority of the message
+        // received. Block for no longer than the optionally specified
+        // 'relativeTimeout', relative to the beginning of the invocation of
+        // this function. Return zero if a message is successfully received or
+        // a nonzero value otherwise.
+
+    int tryReceive(bsl::string *payload);                      // override
+    int tryReceive(bsl::string *payload, unsigned *priority);  // override
+        // Assign through the specified 'payload' the content of the next
+        // message in the ring represented by this object. Assign through the
+        // optionally specified 'priority' the priority of the message
+        // received. Do not block. Return zero if a message is successfully
+        // received or a nonzero value otherwise.
+
+    int send(const bslstl::StringRef& payload);                // override
+    int send(const bslstl::StringRef& payload, int priority);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout,
+             int                       priority);  // override
+        // Write into the ring represented by this object a message consisting
+        // of the specified 'payload' and having the optionally specified
+        // 'priority'. Block for no longer than the optionally specified
+        // 'relativeTimeout', relative to the beginning of the invocation of
+        // this function. Return zero if the message is successfully sent or a
+        // nonzero value otherwise.
+
+    int trySend(const bslstl::StringRef& payload);                // override
+    int trySend(const bslstl::StringRef& payload, int priority);  // override
+        // Write into the ring represented by this object a message consisting
+        // of the specified 'payload' and having the optionally specified
+        // 'priority'. Do not block. Return zero if the message is successfully
+        // sent or a nonzero value otherwise.
+
+    int unlink();
+        // Mark for deletion the shared memory segment opened by this object.
+        // Return zero on success or a nonzero value otherwise.
+
+    // ACCESSORS
+    bsl::size_t capacity() const;
+        // Return the number of bytes of messages that the ring can hold.
+
+    bool isOpen() const;
+        // Return whether this object represents an open ring.
+
+    IPCU_DECLARE_OPERATOR_BOOL(ShmRingQueue);
+        // Return 'isOpen()'.
+
+    const bsl::string& name() const;
+        // Return the name of the shared memory segment of this object.
+
+    // CLASS METHODS
+    static const char *description(int errorCode);
+        // Return a pointer to a null terminated string that describes the
+        // specified 'errorCode'. The behavior is undefined unless 'errorCode'
+        // has the same value as the result of a previous invocation of one of
+        // the methods of an instance of this class.
+
+  private:
+    // PRIVATE MANIPULATORS
+    int open(bsl::size_t capacity, int filePermissions);
+        // Open or create the segment of this object, creating it with room
+        // for the specified 'capacity' bytes of messages and the specified
+        // 'filePermissions'. Return zero on success or a nonzero value
+        // otherwise.
+
+    int sendImp(const bslstl::StringRef&  payload,
+                const bsls::TimeInterval *deadline,
+                bool                      blocking,
+                int                       priority);
+        // Write into the ring a message consisting of the specified 'payload'
+        // and having the specified 'priority'. If the specified 'blocking' is
+        // 'false', do not block. Otherwise, block until the specified
+        // 'deadline', or indefinitely if 'deadline' is zero. Return zero on
+        // success or a nonzero value otherwise.
+
+    int receiveImp(bsl::string              *payload,
+                   const bsls::TimeInterval *deadline,
+                   bool                      blocking,
+                   unsigned                 *priority);
+        // Read from the ring the next message, and load its payload into the
+        // specified 'payload' and, unless it is zero, its priority into the
+        // specified 'priority'. If the specified 'blocking' is 'false', do
+        // not block. Otherwise, block until the specified 'deadline', or
+        // indefinitely if 'deadline' is zero. Return zero on success or a
+        // nonzero value otherwise.
+
+    int waitForRoom(bsls::Types::Uint64       tail,
+                    bsls::Types::Uint64       size,
+                    const bsls::TimeInterval *deadline,
+                    bool                      blocking);
+        // Wait until the ring has room for the specified 'size' bytes at the
+        // specified 'tail', the index past the last message written, as
+        // described by 'sendImp' for the specified 'deadline' and 'blocking'.
+        // Return zero once there is room, or a nonzero value otherwise.
+
+    int waitForMessage(bsls::Types::Uint64       head,
+                       const bsls::TimeInterval *deadline,
+                       bool                      blocking);
+        // Wait until the ring has a message at the specified 'head', the
+        // index of the first message not yet read, as described by
+        // 'receiveImp' for the specified 'deadline' and 'blocking'. Return
+        // zero once there is a message, or a nonzero value otherwise.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                             // ------------------
+                             // class ShmRingQueue
+                             // ------------------
+
+inline
+int ShmRingQueue::receive(bsl::string *payload)
+{
+    return receiveImp(payload, 0, true, 0);
+}
+
+inline
+int ShmRingQueue::receive(bsl::string *payload, unsigned *priority)
+{
+    return receiveImp(payload, 0, true, priority);
+}
+
+inline
+int ShmRingQueue::tryReceive(bsl::string *payload)
+{
+    return receiveImp(payload, 0, false, 0);
+}
+
+inline
+int ShmRingQueue::tryReceive(bsl::string *payload, unsigned *priority)
+{
+    return receiveImp(payload, 0, false, priority);
+}
+
+inline
+int ShmRingQueue::send(const bslstl::StringRef& payload)
+{
+    return sendImp(payload, 0, true, 0);
+}
+
+inline
+int ShmRingQueue::send(const bslstl::StringRef& payload, int priority)
+{
+    return sendImp(payload, 0, true, priority);
+}
+
+inline
+int ShmRingQueue::trySend(const bslstl::StringRef& payload)
+{
+    return sendImp(payload, 0, false, 0);
+}
+
+inline
+int ShmRingQueue::trySend(const bslstl::StringRef& payload, int priority)
+{
+    return sendImp(payload, 0, false, priority);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
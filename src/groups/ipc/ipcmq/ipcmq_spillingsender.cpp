@@ -0,0 +1,272 @@
+
+#include <ipcmq_spillingsender.h>
+
+#include <ball_log.h>
+
+#include <bdlf_memfn.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsls_assert.h>
+#include <bsls_timeinterval.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.SPILLINGSENDER";
+
+// While the queue is full, the replaying thread tries again at least once
+// every 100 milliseconds, so that it notices shutdown.
+const bsls::TimeInterval k_RETRY_INTERVAL(0, 100 * 1000 * 1000);
+
+}  // close unnamed namespace
+
+                        // ----------------------------
+                        // struct SpillingSenderOptions
+                        // ----------------------------
+
+// CREATORS
+SpillingSenderOptions::SpillingSenderOptions()
+: d_journalCapacity(64 * 1024 * 1024)
+{
+}
+
+                            // -------------------
+                            // struct SpillMetrics
+                            // -------------------
+
+// CREATORS
+SpillMetrics::SpillMetrics()
+: d_depth(0)
+, d_numBytes(0)
+, d_maxDepth(0)
+, d_numSpilled(0)
+, d_numReplayed(0)
+, d_numRejected(0)
+{
+}
+
+                            // --------------------
+                            // class SpillingSender
+                            // --------------------
+
+// CREATORS
+SpillingSender::SpillingSender(const bslstl::StringRef&       name,
+                               Format                         format,
+                               const bslstl::StringRef&       journalPath,
+                               const PosixQueue::Attributes&  attributes,
+                               int                            filePermissions,
+                               bslma::Allocator              *allocator)
+: d_sender(name, format, attributes, filePermissions, allocator)
+, d_shuttingDown(false)
+, d_maxDepth(0)
+, d_numSpilled(0)
+, d_numReplayed(0)
+, d_numRejected(0)
+, d_thread(bslmt::ThreadUtil::invalidHandle())
+{
+    start(journalPath, Options(), allocator);
+}
+
+SpillingSender::SpillingSender(const bslstl::StringRef&       name,
+                               Format                         format,
+                               const bslstl::StringRef&       journalPath,
+                               const Options&                 options,
+                               const PosixQueue::Attributes&  attributes,
+                               int                            filePermissions,
+                               bslma::Allocator              *allocator)
+: d_sender(name, format, attributes, filePermissions, allocator)
+, d_shuttingDown(false)
+, d_maxDepth(0)
+, d_numSpilled(0)
+, d_numReplayed(0)
+, d_numRejected(0)
+, d_thread(bslmt::ThreadUtil::invalidHandle())
+{
+    start(journalPath, options, allocator);
+}
+
+SpillingSender::~SpillingSender()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    if (d_thread == bslmt::ThreadUtil::invalidHandle()) {
+        // Thread never started. Nothing to join.
+        return;                                                       // RETURN
+    }
+
+    // The replaying thread checks for shutdown while holding the mutex, so it
+    // either sees the flag or is waiting when signaled.
+    {
+        bslmt::LockGuard<bslmt::Mutex> guard(&d_replayMutex);
+        d_shuttingDown = true;
+        d_replayCondition.signal();
+    }
+
+    const int rc = bslmt::ThreadUtil::join(d_thread);
+    if (rc) {
+        BALL_LOG_ERROR << "Unable to join replaying thread. "
+                          "bslmt::ThreadUtil::join returned rc="
+                       << rc << BALL_LOG_END;
+    }
+}
+
+// MANIPULATORS
+void SpillingSender::resetMetrics()
+{
+    d_sender.resetMetrics();
+    d_maxDepth    = d_journal.numMessages();
+    d_numSpilled  = 0;
+    d_numReplayed = 0;
+    d_numRejected = 0;
+}
+
+void SpillingSender::start(const bslstl::StringRef&  journalPath,
+                           const Options&            options,
+                           bslma::Allocator         *allocator)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    if (!d_sender.isOpen()) {
+        return;                                                       // RETURN
+    }
+
+    // A sender without a journal still works, though it cannot spill.
+    const bsl::string path(journalPath, allocator);
+    if (d_journal.open(path, options.d_journalCapacity)) {
+        return;                                                       // RETURN
+    }
+
+    const int rc = bslmt::ThreadUtil::create(
+            &d_thread, bdlf::MemFnUtil::memFn(&SpillingSender::replay, this));
+    if (rc) {
+        BALL_LOG_ERROR << "Unable to start replaying thread for the spill "
+                          "journal "
+                       << path << ". bslmt::ThreadUtil::create returned rc="
+                       << rc << BALL_LOG_END;
+        d_thread = bslmt::ThreadUtil::invalidHandle();
+    }
+}
+
+int SpillingSender::sendOrSpill(const bslstl::StringRef& payload,
+                                int                      priority)
+{
+    using namespace PosixQueueTypes;
+
+    // A spilled payload is removed from the journal only once it's enqueued,
+    // so an empty journal means that every payload spilled before this one
+    // is already in the queue.
+    if (d_journal.numMessages() == 0) {
+        const int rc = d_sender.trySend(payload, priority);
+        if (rc != Send::e_FULL) {
+            return rc;                                                // RETURN
+        }
+    }
+
+    if (d_thread == bslmt::ThreadUtil::invalidHandle() ||
+        !d_journal.append(payload, priority)) {
+        d_numRejected.addRelaxed(1);
+        return Send::e_FULL;                                          // RETURN
+    }
+    d_numSpilled.addRelaxed(1);
+
+    const bsls::Types::Int64 depth    = d_journal.numMessages();
+    bsls::Types::Int64       maxDepth = d_maxDepth.loadRelaxed();
+    while (depth > maxDepth) {
+        const bsls::Types::Int64 previous =
+                                      d_maxDepth.testAndSwap(maxDepth, depth);
+        if (previous == maxDepth) {
+            break;
+        }
+        maxDepth = previous;
+    }
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_replayMutex);
+    d_replayCondition.signal();
+    return 0;
+}
+
+void SpillingSender::replay()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    using namespace PosixQueueTypes;
+
+    for (;;) {
+        {
+            bslmt::LockGuard<bslmt::Mutex> guard(&d_replayMutex);
+            while (d_journal.numMessages() == 0 && !d_shuttingDown.load()) {
+                d_replayCondition.wait(&d_replayMutex);
+            }
+            if (d_journal.numMessages() == 0) {
+                // shutting down, and nothing left to enqueue
+                return;                                               // RETURN
+            }
+        }
+
+        // The payload stays in the journal until it's enqueued, so that
+        // senders keep spilling behind it.
+        bslstl::StringRef payload;
+        int               priority;
+        d_journal.front(&payload, &priority);
+
+        const int rc = d_sender.send(payload, k_RETRY_INTERVAL, priority);
+        if (rc == Send::e_TIMED_OUT) {
+            // The queue is still full.
+            continue;
+        }
+        if (rc) {
+            BALL_LOG_ERROR << "Unable to send spilled message to message "
+                              "queue: "
+                           << d_sender.description(rc)
+                           << ". The message is dropped." << BALL_LOG_END;
+        }
+        else {
+            d_numReplayed.addRelaxed(1);
+        }
+
+        d_journal.popFront();
+    }
+}
+
+// ACCESSORS
+void SpillingSender::loadMetrics(MetricsSnapshot *result) const
+{
+    d_sender.loadMetrics(result);
+}
+
+void SpillingSender::loadSpillMetrics(SpillMetrics *result) const
+{
+    BSLS_ASSERT(result);
+
+    result->d_depth       = d_journal.numMessages();
+    result->d_numBytes    = d_journal.numBytes();
+    result->d_maxDepth    = d_maxDepth.loadRelaxed();
+    result->d_numSpilled  = d_numSpilled.loadRelaxed();
+    result->d_numReplayed = d_numReplayed.loadRelaxed();
+    result->d_numRejected = d_numRejected.loadRelaxed();
+}
+
+bool SpillingSender::isOpen() const
+{
+    return d_sender.isOpen();
+}
+
+IPCU_DEFINE_OPERATOR_BOOL(SpillingSender)
+{
+    IPCU_RETURN_OPERATOR_BOOL(SpillingSender, isOpen());
+}
+
+const PosixQueue& SpillingSender::posixQueue() const
+{
+    return d_sender.posixQueue();
+}
+
+// CLASS METHODS
+const char *SpillingSender::description(int errorCode)
+{
+    return QueueSender::description(errorCode);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
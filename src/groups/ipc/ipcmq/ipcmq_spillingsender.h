@@ -0,0 +1,273 @@
+#ifndef INCLUDED_IPCMQ_SPILLINGSENDER
+#define INCLUDED_IPCMQ_SPILLINGSENDER
+
+#include <ipcmq_format.h>
+#include <ipcmq_metrics.h>
+#include <ipcmq_posixqueue.h>
+#include <ipcmq_queuesender.h>
+#include <ipcmq_sender.h>
+#include <ipcmq_spilljournal.h>
+#include <ipcu_operatorbool.h>
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+
+#include <bslmt_condition.h>
+#include <bslmt_mutex.h>
+#include <bslmt_threadutil.h>
+
+#include <bsls_atomic.h>
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace bsls { class TimeInterval; }
+namespace ipcmq {
+
+                        // ============================
+                        // struct SpillingSenderOptions
+                        // ============================
+
+struct SpillingSenderOptions {
+    // This 'struct' describes the spill journal of a 'SpillingSender'.
+
+    // DATA
+    bsl::size_t d_journalCapacity;
+        // the number of bytes in the spill journal, which bounds the payloads
+        // that can be spilled at once, including an eight byte header for
+        // each, rounded up to a multiple of eight
+
+    // CREATORS
+    SpillingSenderOptions();
+        // Create a 'SpillingSenderOptions' object describing a spill journal
+        // of 64 mebibytes.
+};
+
+                            // ===================
+                            // struct SpillMetrics
+                            // ===================
+
+struct SpillMetrics {
+    // This 'struct' holds the values of the counters of the spill journal of
+    // a 'SpillingSender' at one point in time.
+
+    // DATA
+    bsls::Types::Int64 d_depth;        // payloads spilled and not yet
+                                       // enqueued
+    bsls::Types::Int64 d_numBytes;     // bytes in those payloads
+    bsls::Types::Int64 d_maxDepth;     // the greatest depth so far
+    bsls::Types::Int64 d_numSpilled;   // payloads ever spilled
+    bsls::Types::Int64 d_numReplayed;  // spilled payloads since enqueued
+    bsls::Types::Int64 d_numRejected;  // payloads refused because the
+                                       // journal was full
+
+    // CREATORS
+    SpillMetrics();
+        // Create a 'SpillMetrics' object having every count zero.
+};
+
+                            // ====================
+                            // class SpillingSender
+                            // ====================
+
+class SpillingSender : public Sender {
+    // This class implements the 'Sender' protocol using a 'QueueSender', but
+    // never blocks: a payload that finds the message queue full is instead
+    // appended to a spill journal, a file mapped into memory, from which a
+    // dedicated thread enqueues it, in order, once the queue has room. While
+    // any payload is in the journal, every payload sent is appended to the
+    // journal as well, so that payloads are enqueued in the order sent.
+    // Bursts larger than the queue are thus absorbed without blocking the
+    // sending threads and without losing payloads, up to the capacity of the
+    // journal, and the journal occupies no memory that the system cannot
+    // page out.
+    //
+    // A successful 'send' means that the payload was enqueued or spilled. A
+    // spilled payload that the replaying thread is unable to enqueue for any
+    // reason but a full queue is logged and dropped. Every payload spilled is
+    // enqueued before the destructor returns, so destroying a
+    // 'SpillingSender' blocks for as long as the message queue stays full.
+    //
+    // Note that spilling only rides out a full queue: it is not durable. The
+    // journal file is removed as soon as it is created, so the payloads
+    // spilled and not yet enqueued are lost if the process crashes, and a
+    // new 'SpillingSender' starts with an empty journal. Use a
+    // 'DurableSender' for payloads that must survive a crash.
+
+  public:
+    // PUBLIC TYPES
+    typedef SpillingSenderOptions Options;
+
+  private:
+    // DATA
+    QueueSender               d_sender;
+    SpillJournal              d_journal;
+    bslmt::Mutex              d_replayMutex;
+    bslmt::Condition          d_replayCondition;
+        // signaled when a payload is spilled or shutdown begins
+
+    bsls::AtomicInt           d_shuttingDown;
+    bsls::AtomicInt64         d_maxDepth;
+    bsls::AtomicInt64         d_numSpilled;
+    bsls::AtomicInt64         d_numReplayed;
+    bsls::AtomicInt64         d_numRejected;
+    bslmt::ThreadUtil::Handle d_thread;
+
+    SpillingSender(const SpillingSender&);             // = delete
+    SpillingSender& operator=(const SpillingSender&);  // = delete
+
+  public:
+    // CREATORS
+    SpillingSender(
+        const bslstl::StringRef&       name,
+        Format                         format,
+        const bslstl::StringRef&       journalPath,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+    SpillingSender(
+        const bslstl::StringRef&       name,
+        Format                         format,
+        const bslstl::StringRef&       journalPath,
+        const Options&                 options,
+        const PosixQueue::Attributes&  attributes = PosixQueue::Attributes(),
+        int                            filePermissions = 0,
+        bslma::Allocator              *allocator       = 0);
+        // Create a 'SpillingSender' object that sends to the message queue
+        // with the specified 'name' in the specified 'format', spilling to a
+        // journal created at the specified 'journalPath'. The journal file is
+        // removed as soon as it is created, so the path need only be unique
+        // for a moment; it should be on a file system backed by storage
+        // rather than memory. Optionally specify 'options' describing the
+        // journal. Optionally specify 'attributes' and 'filePermissions',
+        // which will be used when creating the queue if the queue does not
+        // already exist. If the queue is opened, this object starts its
+        // replaying thread immediately. If the journal cannot be created, it
+        // is logged, and a payload that finds the queue full fails instead.
+
+    ~SpillingSender();
+        // Wait for the replaying thread to enqueue every payload spilled,
+        // stop it, and then destroy this object. The behavior is undefined if
+        // any other thread is sending using this object.
+
+    // MANIPULATORS
+    int send(const bslstl::StringRef& payload);                // override
+    int send(const bslstl::StringRef& payload, int priority);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout);  // override
+    int send(const bslstl::StringRef&  payload,
+             const bsls::TimeInterval& relativeTimeout,
+             int                       priority);  // override
+    int trySend(const bslstl::StringRef& payload);                // override
+    int trySend(const bslstl::StringRef& payload, int priority);  // override
+        // Enqueue onto the queue represented by this object a message
+        // consisting of the specified 'payload' and having the optionally
+        // specified 'priority', or spill it if the queue is full or other
+        // payloads are spilled. Do not block, so ignore the optionally
+        // specified 'relativeTimeout'. Return zero if the payload is enqueued
+        // or spilled, or a nonzero value otherwise.
+
+    void resetMetrics();
+        // Set every count in the metrics of this object to zero, except for
+        // the depth of the journal and the bytes in it.
+
+    // ACCESSORS
+    void loadMetrics(MetricsSnapshot *result) const;
+        // Load into the specified 'result' the payloads enqueued onto the
+        // message queue, whether directly or from the journal, the attempts
+        // that failed, and the time taken to encode each payload. Note that
+        // an attempt that finds the queue full, after which the payload is
+        // spilled, counts as an attempt that would block.
+
+    void loadSpillMetrics(SpillMetrics *result) const;
+        // Load into the specified 'result' the current depth of the journal
+        // and the counts of payloads spilled, replayed, and refused.
+
+    bool isOpen() const;
+        // Return whether this object represents an open message queue.
+
+    IPCU_DECLARE_OPERATOR_BOOL(SpillingSender);
+        // Return 'isOpen()'.
+
+    const PosixQueue& posixQueue() const;
+        // Return a reference providing non-modifiable access to the
+        // 'PosixQueue' instance used to implement this object.
+
+    // CLASS METHODS
+    static const char *description(int errorCode);
+        // Return a pointer to a null terminated string that describes the
+        // specified 'errorCode'. The behavior is undefined unless 'errorCode'
+        // has the same value as the result of a previous invocation of one of
+        // the methods of an instance of this class.
+
+  private:
+    // PRIVATE MANIPULATORS
+    void start(const bslstl::StringRef& journalPath,
+               const Options&           options,
+               bslma::Allocator        *allocator);
+        // Create the journal at the specified 'journalPath' as described by
+        // the specified 'options', and start the replaying thread, using the
+        // specified 'allocator' to supply memory.
+
+    int sendOrSpill(const bslstl::StringRef& payload, int priority);
+        // Enqueue the specified 'payload' having the specified 'priority' if
+        // nothing is spilled and the queue has room, and otherwise spill it.
+        // Return zero if 'payload' is enqueued or spilled, or a nonzero value
+        // otherwise.
+
+    void replay();
+        // Enqueue spilled payloads onto the message queue until shutdown
+        // begins and the journal is empty.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                            // --------------------
+                            // class SpillingSender
+                            // --------------------
+
+inline
+int SpillingSender::send(const bslstl::StringRef& payload)
+{
+    return sendOrSpill(payload, 0);
+}
+
+inline
+int SpillingSender::send(const bslstl::StringRef& payload, int priority)
+{
+    return sendOrSpill(payload, priority);
+}
+
+inline
+int SpillingSender::send(const bslstl::StringRef&  payload,
+                         const bsls::TimeInterval&)
+{
+    return sendOrSpill(payload, 0);
+}
+
+inline
+int SpillingSender::send(const bslstl::StringRef&  payload,
+                         const bsls::TimeInterval&,
+                         int                       priority)
+{
+    return sendOrSpill(payload, priority);
+}
+
+inline
+int SpillingSender::trySend(const bslstl::StringRef& payload)
+{
+    return sendOrSpill(payload, 0);
+}
+
+inline
+int SpillingSender::trySend(const bslstl::StringRef& payload, int priority)
+{
+    return sendOrSpill(payload, priority);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -0,0 +1,244 @@
+
+#include <ipcmq_spilljournal.h>
+
+#include <ball_log.h>
+
+#include <bslmf_assert.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsls_assert.h>
+
+#include <bsl_cstring.h>
+
+#include <errno.h>     // errno
+#include <fcntl.h>     // open
+#include <string.h>    // strerror
+#include <sys/mman.h>  // mmap, munmap
+#include <unistd.h>    // close, ftruncate, unlink
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.SPILLJOURNAL";
+
+struct Header {
+    // This 'struct' is the layout of the header preceding each message in the
+    // file.
+
+    bsls::Types::Uint32 d_length;    // of the payload, or 'k_SKIP'
+    int                 d_priority;
+};
+
+BSLMF_ASSERT(sizeof(Header) == 8);
+
+// A header having this length marks the end of the messages before the end
+// of the file. The next message is at the beginning of the file.
+const bsls::Types::Uint32 k_SKIP = 0xFFFFFFFF;
+
+bsl::size_t recordSize(bsl::size_t payloadLength)
+    // Return the number of bytes occupied by a message having a payload of
+    // the specified 'payloadLength', which is a multiple of eight.
+{
+    return (sizeof(Header) + payloadLength + 7) & ~bsl::size_t(7);
+}
+
+}  // close unnamed namespace
+
+                             // ------------------
+                             // class SpillJournal
+                             // ------------------
+
+// CREATORS
+SpillJournal::SpillJournal()
+: d_base_p(0)
+, d_capacity(0)
+, d_readOffset(0)
+, d_writeOffset(0)
+, d_usedBytes(0)
+, d_numMessages(0)
+, d_numBytes(0)
+{
+}
+
+SpillJournal::~SpillJournal()
+{
+    if (d_base_p) {
+        munmap(d_base_p, d_capacity);
+    }
+}
+
+// MANIPULATORS
+int SpillJournal::open(const bsl::string& path, bsl::size_t capacity)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(!d_base_p);
+
+    capacity &= ~bsl::size_t(7);
+
+    const int fd = ::open(
+        path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to create the spill journal \"" << path
+                       << "\": " << strerror(errno) << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    // Delete the file right away. Its storage remains until it's unmapped,
+    // and nobody else needs to find it by name.
+    if (unlink(path.c_str())) {
+        BALL_LOG_WARN << "Unable to remove file \"" << path
+                      << "\": " << strerror(errno) << BALL_LOG_END;
+    }
+
+    if (ftruncate(fd, capacity)) {
+        BALL_LOG_ERROR << "Unable to extend the spill journal \"" << path
+                       << "\" to " << capacity
+                       << " bytes: " << strerror(errno) << BALL_LOG_END;
+        close(fd);
+        return 2;                                                     // RETURN
+    }
+
+    void *const address =
+        mmap(0, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping remains valid after the descriptor is closed.
+    if (address == MAP_FAILED) {
+        BALL_LOG_ERROR << "Unable to map the spill journal \"" << path
+                       << "\" into memory: " << strerror(errno)
+                       << BALL_LOG_END;
+        return 3;                                                     // RETURN
+    }
+
+    d_base_p   = static_cast<char *>(address);
+    d_capacity = capacity;
+    return 0;
+}
+
+bool SpillJournal::append(const bslstl::StringRef& payload, int priority)
+{
+    const bsl::size_t size = recordSize(payload.length());
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (!d_base_p || size > d_capacity) {
+        return false;                                                 // RETURN
+    }
+
+    // When the journal is empty, both offsets are zero. Otherwise, if the
+    // messages do not wrap around the end of the file, there is room after
+    // the last message and before the first. If they do, there is room only
+    // between the last message and the first.
+    bsl::size_t offset;
+    if (d_usedBytes == 0) {
+        offset = 0;
+    }
+    else if (d_writeOffset > d_readOffset) {
+        const bsl::size_t tail = d_capacity - d_writeOffset;
+        if (size <= tail) {
+            offset = d_writeOffset;
+        }
+        else if (size <= d_readOffset) {
+            if (tail) {
+                Header skip = { k_SKIP, 0 };
+                bsl::memcpy(d_base_p + d_writeOffset, &skip, sizeof skip);
+            }
+            d_usedBytes += tail;
+            offset       = 0;
+        }
+        else {
+            return false;                                             // RETURN
+        }
+    }
+    else if (size <= d_readOffset - d_writeOffset) {
+        offset = d_writeOffset;
+    }
+    else {
+        return false;                                                 // RETURN
+    }
+
+    Header header = { bsls::Types::Uint32(payload.length()), priority };
+    bsl::memcpy(d_base_p + offset, &header, sizeof header);
+    bsl::memcpy(
+        d_base_p + offset + sizeof header, payload.data(), payload.length());
+
+    d_writeOffset  = offset + size;
+    d_usedBytes   += size;
+    d_numBytes.addRelaxed(payload.length());
+    d_numMessages.add(1);
+
+    return true;
+}
+
+bool SpillJournal::front(bslstl::StringRef *payload, int *priority)
+{
+    BSLS_ASSERT(payload);
+    BSLS_ASSERT(priority);
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    if (d_usedBytes == 0) {
+        return false;                                                 // RETURN
+    }
+
+    Header header;
+    bsl::memcpy(&header, d_base_p + d_readOffset, sizeof header);
+    if (header.d_length == k_SKIP) {
+        d_usedBytes  -= d_capacity - d_readOffset;
+        d_readOffset  = 0;
+        bsl::memcpy(&header, d_base_p, sizeof header);
+    }
+
+    payload->assign(d_base_p + d_readOffset + sizeof header, header.d_length);
+    *priority = header.d_priority;
+    return true;
+}
+
+void SpillJournal::popFront()
+{
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+    BSLS_ASSERT(d_usedBytes);
+
+    Header header;
+    bsl::memcpy(&header, d_base_p + d_readOffset, sizeof header);
+    BSLS_ASSERT(header.d_length != k_SKIP);
+
+    const bsl::size_t size = recordSize(header.d_length);
+    d_readOffset += size;
+    d_usedBytes  -= size;
+    if (d_readOffset == d_capacity) {
+        d_readOffset = 0;
+    }
+    if (d_usedBytes == 0) {
+        // Start over at the beginning of the file.
+        d_readOffset  = 0;
+        d_writeOffset = 0;
+    }
+
+    d_numBytes.addRelaxed(-bsls::Types::Int64(header.d_length));
+    d_numMessages.add(-1);
+}
+
+// ACCESSORS
+bool SpillJournal::isOpen() const
+{
+    return d_base_p != 0;
+}
+
+bsl::size_t SpillJournal::capacity() const
+{
+    return d_capacity;
+}
+
+bsls::Types::Int64 SpillJournal::numMessages() const
+{
+    return d_numMessages.load();
+}
+
+bsls::Types::Int64 SpillJournal::numBytes() const
+{
+    return d_numBytes.loadRelaxed();
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,98 @@
+#ifndef INCLUDED_IPCMQ_SPILLJOURNAL
+#define INCLUDED_IPCMQ_SPILLJOURNAL
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+
+#include <bslmt_mutex.h>
+
+#include <bsls_atomic.h>
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+
+                             // ==================
+                             // class SpillJournal
+                             // ==================
+
+class SpillJournal {
+    // This class is a bounded, first-in first-out journal of messages, each a
+    // payload and a priority, kept in a ring within a memory-mapped file, so
+    // that messages that do not fit in a message queue can be set aside
+    // without holding them in the heap. Each message is appended as a header
+    // holding its length and priority, followed by its payload, padded to a
+    // multiple of eight bytes. A message that does not fit between the end of
+    // the last message and the end of the file is instead appended at the
+    // beginning of the file, after a marker telling the reader to skip to
+    // the beginning. The file is removed as soon as it is mapped, so its
+    // storage is reclaimed when this object is destroyed, even if the
+    // process is not shut down cleanly.
+    //
+    // Any number of threads may append concurrently, but only one thread at
+    // a time may read and remove messages. A message returned by 'front'
+    // remains valid until it is removed, since appending never overwrites a
+    // message that has not been removed.
+
+    // DATA
+    bslmt::Mutex      d_mutex;        // protects the offsets
+    char             *d_base_p;       // zero unless a file is mapped
+    bsl::size_t       d_capacity;     // bytes mapped
+    bsl::size_t       d_readOffset;   // of the first message
+    bsl::size_t       d_writeOffset;  // past the last message
+    bsl::size_t       d_usedBytes;    // including headers and padding
+    bsls::AtomicInt64 d_numMessages;
+    bsls::AtomicInt64 d_numBytes;     // in payloads
+
+    SpillJournal(const SpillJournal&);             // = delete
+    SpillJournal& operator=(const SpillJournal&);  // = delete
+
+  public:
+    // CREATORS
+    SpillJournal();
+        // Create a 'SpillJournal' object that is not open.
+
+    ~SpillJournal();
+        // Unmap the file of this object, if any, and destroy this object.
+
+    // MANIPULATORS
+    int open(const bsl::string& path, bsl::size_t capacity);
+        // Create a file at the specified 'path' of the specified 'capacity'
+        // (rounded down to a multiple of eight bytes), map it into memory, and
+        // remove it. Return zero on success or a nonzero value otherwise. The
+        // behavior is undefined unless this object is not open.
+
+    bool append(const bslstl::StringRef& payload, int priority);
+        // Append to this journal a message consisting of the specified
+        // 'payload' and 'priority'. Return 'true' on success, or 'false' if
+        // there is not room for the message or this object is not open.
+
+    bool front(bslstl::StringRef *payload, int *priority);
+        // If this journal is not empty, load into the specified 'payload' a
+        // reference to the payload of its first message, assign through the
+        // specified 'priority' the message's priority, and return 'true'.
+        // Otherwise, return 'false'.
+
+    void popFront();
+        // Remove the first message of this journal. The behavior is undefined
+        // unless 'front' most recently returned 'true' for the calling thread.
+
+    // ACCESSORS
+    bool isOpen() const;
+        // Return whether this object has a mapped file.
+
+    bsl::size_t capacity() const;
+        // Return the number of bytes available to messages and their headers.
+
+    bsls::Types::Int64 numMessages() const;
+        // Return the number of messages in this journal.
+
+    bsls::Types::Int64 numBytes() const;
+        // Return the number of bytes in the payloads of the messages in this
+        // journal.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
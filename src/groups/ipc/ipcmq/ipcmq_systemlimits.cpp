@@ -0,0 +1,632 @@
+
+#include <ipcmq_systemlimits.h>
+#include <ipcu_algoutil.h>
+
+#include <ball_log.h>
+
+#include <bdlb_arrayutil.h>
+#include <bdlb_guid.h>
+#include <bdlb_guidutil.h>
+
+#include <bslmt_once.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_cstdio.h>
+#include <bsl_cstdlib.h>
+#include <bsl_fstream.h>
+#include <bsl_ios.h>
+#include <bsl_ostream.h>
+#include <bsl_sstream.h>
+
+#include <bsls_assert.h>
+#include <bsls_systemtime.h>
+#include <bsls_types.h>
+
+#include <errno.h>         // errno
+#include <fcntl.h>         // file open constants
+#include <limits.h>        // _POSIX_*_MAX
+#include <mqueue.h>        // mq_*
+#include <string.h>        // strerror
+#include <sys/resource.h>  // getrlimit
+#include <sys/stat.h>      // file mode constants
+#include <time.h>          // clock_gettime
+#include <unistd.h>        // getpid, geteuid
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.SYSTEMLIMITS";
+
+// pessimistically small fallback values
+const long k_FALLBACK_MAX_MESSAGES     = 1;
+const long k_FALLBACK_MAX_MESSAGE_SIZE = 1024;
+
+// The limits that Linux (3.5 and later) enforces even on processes having the
+// 'CAP_SYS_RESOURCE' capability. See 'mq_overview(7)'.
+const long k_HARD_MAX_MESSAGES     = 65536;
+const long k_HARD_MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+
+// Linux charges each message slot of a queue against 'RLIMIT_MSGQUEUE' at its
+// maximum size plus the size of some kernel bookkeeping: a 'struct msg_msg'
+// pointer and, for up to one node per priority, a 'struct
+// posix_msg_tree_node'. This is a generous upper bound on the bookkeeping, so
+// that the limits calculated from it are ones that can actually be created.
+const long k_PER_MESSAGE_OVERHEAD = 96;
+
+// The bit of the effective capability set reported in '/proc/self/status'
+// that corresponds to 'CAP_SYS_RESOURCE'.
+const int k_CAP_SYS_RESOURCE = 24;
+
+const char k_PROC_DIRECTORY[] = "/proc/sys/fs/mqueue/";
+
+const char k_CACHE_HEADER[] = "ipcmq-limits-v2";
+
+// The boot time calculated by 'bootTime' moves when the real-time clock is
+// adjusted, so boot times this many seconds apart are taken to be the same
+// boot. A larger adjustment only makes a process probe again.
+const bsls::Types::Int64 k_BOOT_TIME_TOLERANCE = 2;
+
+bsl::string systemError(int errorNumber)
+    // Return the system-dependent description of the specified 'errorNumber'.
+{
+    return strerror(errorNumber);
+}
+
+template <typename VALUE>
+int readValue(const bsl::string& path, VALUE *output)
+    // Load into the specified 'output' the first whitespace-delimited value in
+    // the file at the specified 'path'. Return zero on success or a nonzero
+    // value otherwise.
+{
+    BSLS_ASSERT(output);
+
+    bsl::ifstream in(path.c_str());
+    if (!(in >> *output)) {
+        return 1;                                                     // RETURN
+    }
+
+    return 0;
+}
+
+int readProcValue(const char *name, long *output)
+    // Load into the specified 'output' the value of the mqueue sysctl having
+    // the specified 'name'. Return zero on success or a nonzero value
+    // otherwise.
+{
+    return readValue(bsl::string(k_PROC_DIRECTORY) + name, output);
+}
+
+bool hasSysResourceCapability()
+    // Return whether the current process has the 'CAP_SYS_RESOURCE'
+    // capability, which permits it to exceed the per-queue limits in
+    // '/proc/sys/fs/mqueue'. Return 'false' if this cannot be determined.
+{
+    bsl::ifstream in("/proc/self/status");
+    bsl::string   line;
+    while (bsl::getline(in, line)) {
+        const char prefix[] = "CapEff:";
+        if (line.compare(0, sizeof prefix - 1, prefix) == 0) {
+            bsl::istringstream  fields(line.substr(sizeof prefix - 1));
+            unsigned long long  capabilities;
+            if (!(fields >> bsl::hex >> capabilities)) {
+                return false;                                         // RETURN
+            }
+            return (capabilities >> k_CAP_SYS_RESOURCE) & 1;          // RETURN
+        }
+    }
+
+    return false;
+}
+
+int bootTime(bsls::Types::Int64 *output)
+    // Load into the specified 'output' the time at which the system booted,
+    // in seconds since the epoch. Return zero on success or a nonzero value
+    // if the system does not count the time since boot. Note that the time
+    // is calculated from the system clocks rather than read from '/proc', so
+    // that it is available where '/proc' is not, which is where the cache is
+    // used.
+{
+    BSLS_ASSERT(output);
+
+#ifdef CLOCK_BOOTTIME
+    timespec now;
+    timespec sinceBoot;
+    if (clock_gettime(CLOCK_REALTIME, &now) == 0 &&
+        clock_gettime(CLOCK_BOOTTIME, &sinceBoot) == 0) {
+        *output = bsls::Types::Int64(now.tv_sec) - sinceBoot.tv_sec;
+        return 0;                                                     // RETURN
+    }
+#endif
+
+    return 1;
+}
+
+long maxBytes()
+    // Return the soft 'RLIMIT_MSGQUEUE' of the current process, or -1 if
+    // there is no such limit.
+{
+#ifdef RLIMIT_MSGQUEUE
+    rlimit limit;
+    if (getrlimit(RLIMIT_MSGQUEUE, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY) {
+        return long(limit.rlim_cur);                                  // RETURN
+    }
+#endif
+
+    return -1;
+}
+
+long boundMaxMessages(long limit, long bytes, long maxMessageSize)
+    // Return the lesser of the specified 'limit' and the largest 'mq_maxmsg'
+    // for which a queue having the specified 'maxMessageSize' fits within the
+    // specified 'bytes', but not less than one. If 'bytes' is negative,
+    // return 'limit'.
+{
+    if (bytes < 0) {
+        return limit;                                                 // RETURN
+    }
+
+    const long bound = bytes / (maxMessageSize + k_PER_MESSAGE_OVERHEAD);
+    return bsl::max(bsl::min(limit, bound), 1L);
+}
+
+long boundMaxMessageSize(long limit, long bytes, long maxMessages)
+    // Return the lesser of the specified 'limit' and the largest 'mq_msgsize'
+    // for which a queue having the specified 'maxMessages' fits within the
+    // specified 'bytes', but not less than one. If 'bytes' is negative,
+    // return 'limit'.
+{
+    if (bytes < 0) {
+        return limit;                                                 // RETURN
+    }
+
+    const long bound = bytes / maxMessages - k_PER_MESSAGE_OVERHEAD;
+    return bsl::max(bsl::min(limit, bound), 1L);
+}
+
+void randomQueueName(bsl::string *outputPtr)
+{
+    BSLS_ASSERT_SAFE(outputPtr);
+    bsl::string& output = *outputPtr;
+
+    output.assign(1, '/');
+    output += bdlb::GuidUtil::guidToString(bdlb::GuidUtil::generate());
+
+    // Shrink, if necessary, to fit minimum POSIX size spec.
+    const bsl::string::size_type sizes[] = {
+        output.size(), _POSIX_PATH_MAX - 1, _POSIX_NAME_MAX - 1};
+    output.resize(*bsl::min_element(sizes, bdlb::ArrayUtil::end(sizes)));
+}
+
+void closeAndUnlinkTemporaryQueue(mqd_t queue, const bsl::string& name)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    int rc = mq_close(queue);
+    if (rc == -1) {
+        BALL_LOG_WARN << "Unable to close temporary queue. errno=" << errno
+                      << BALL_LOG_END;
+    }
+
+    rc = mq_unlink(name.c_str());
+    if (rc == -1) {
+        BALL_LOG_WARN << "Unable to unlink temporary queue. errno=" << errno
+                      << BALL_LOG_END;
+    }
+}
+
+int temporaryQueue(const mq_attr *inputAttributes, mq_attr *outputAttributes)
+    // Create and then destroy a message queue with a randomly generated name.
+    // If the specified 'inputAttributes' is not zero, specify those attributes
+    // when creating the queue. If the specified 'outputAttributes' is not
+    // zero, query the created queue's attributes and store them in
+    // 'outputAttributes' before destroying the queue. If the generated queue
+    // name is not unique, retry an unspecified number of times with a
+    // different randomly generated name. Return zero on success. If the
+    // maximum number of retries is reached, return the nonzero 'errno'. If the
+    // creation of the queue fails for some other reason, return the nonzero
+    // 'errno'. If 'outputAttributes' is not zero and the querying of the
+    // queue's attributes fails, return the nonzero 'errno'.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    bsl::string name;
+    mqd_t       queue;
+    const int   k_MAX_ATTEMPTS = 3;
+    for (int attempt = 1; true; ++attempt) {
+        randomQueueName(&name);
+        // The choice of "write only" is arbitrary. What matters is "create
+        // only."
+        const int openFlags   = O_WRONLY | O_CREAT | O_EXCL;
+        const int permissions = 0600;  // user read/write only
+        queue = mq_open(name.c_str(), openFlags, permissions, inputAttributes);
+
+        // error?
+        if (queue == mqd_t(-1)) {
+            switch (errno) {
+              case EEXIST:
+                // The one case we can handle. Maybe our 'name' was not unique,
+                // so try again unless we've already tried too many times.
+                if (attempt != k_MAX_ATTEMPTS) {
+                    break;  // break from switch to re-enter loop
+                }
+              default: {
+                BALL_LOG_TRACE
+                    << "Unable to create a temporary queue with name=" << name
+                    << " got errno=" << errno
+                    << " which corresponds to the system error: "
+                    << systemError(errno) << BALL_LOG_END;
+                return errno;                                         // RETURN
+              }
+            }
+        }
+        else {
+            // success
+            break;  // break from loop so the success code below can execute
+        }
+    }
+
+    // 'queue' now refers to an open message queue. Get its attributes, if
+    // requested. In any case, unlink and close the queue.
+    int rc = 0;
+
+    if (outputAttributes) {
+        rc = mq_getattr(queue, outputAttributes);
+        if (rc == -1) {
+            BALL_LOG_WARN
+                << "Unable to get attributes of temporary queue. Using "
+                   "fallback values. errno="
+                << errno << BALL_LOG_END;
+            BSLS_ASSERT_SAFE(errno);
+            rc = errno;
+        }
+    }
+
+    closeAndUnlinkTemporaryQueue(queue, name);
+
+    return rc;
+}
+
+bool canCreateQueueWith(long maxMessages, long maxMessageSize)
+    // Return whether a message queue can be created with the specified
+    // 'maxMessages' as its 'mq_msgmax' attribute and with the specified
+    // 'maxMessageSize' as its 'mq_msgsize' attribute.
+{
+    mq_attr inputAttributes;
+    inputAttributes.mq_maxmsg  = maxMessages;
+    inputAttributes.mq_msgsize = maxMessageSize;
+
+    mq_attr *const outputAttributesPtr = 0;  // parameter not used
+    const int      rc = temporaryQueue(&inputAttributes, outputAttributesPtr);
+
+    return rc == 0;
+}
+
+class CanCreateQueueWithMaxMessages {
+    // This class is a unary predicate that returns whether a message queue can
+    // be created with a specified 'mq_maxmsg' attribute and the 'mq_msgsize'
+    // bound at construction.
+
+    long d_maxMessageSize;
+
+  public:
+    explicit CanCreateQueueWithMaxMessages(long maxMessageSize)
+    : d_maxMessageSize(maxMessageSize)
+    {
+    }
+
+    bool operator()(long maxMessages) const
+    {
+        return canCreateQueueWith(maxMessages, d_maxMessageSize);
+    }
+};
+
+class CanCreateQueueWithMaxMessageSize {
+    // This class is a unary predicate that returns whether a message queue can
+    // be created with a specified 'mq_msgsize' attribute and the 'mq_maxmsg'
+    // bound at construction.
+
+    long d_maxMessages;
+
+  public:
+    explicit CanCreateQueueWithMaxMessageSize(long maxMessages)
+    : d_maxMessages(maxMessages)
+    {
+    }
+
+    bool operator()(long maxMessageSize) const
+    {
+        return canCreateQueueWith(d_maxMessages, maxMessageSize);
+    }
+};
+
+template <typename VALUE>
+int readField(bsl::istream& in, const char *expectedKey, VALUE *output)
+    // Read from the specified 'in' a key followed by a value, and load the
+    // value into the specified 'output'. Return zero on success or a nonzero
+    // value if reading fails or the key is not the specified 'expectedKey'.
+{
+    BSLS_ASSERT(expectedKey);
+    BSLS_ASSERT(output);
+
+    bsl::string key;
+    if (!(in >> key) || key != expectedKey || !(in >> *output)) {
+        return 1;                                                     // RETURN
+    }
+
+    return 0;
+}
+
+}  // close unnamed namespace
+
+                            // -------------------
+                            // struct SystemLimits
+                            // -------------------
+
+// CREATORS
+SystemLimits::SystemLimits()
+: d_maxMaxMessages(k_FALLBACK_MAX_MESSAGES)
+, d_maxMaxMessageSize(k_FALLBACK_MAX_MESSAGE_SIZE)
+, d_defaultMaxMessages(k_FALLBACK_MAX_MESSAGES)
+, d_defaultMaxMessageSize(k_FALLBACK_MAX_MESSAGE_SIZE)
+, d_maxQueues(-1)
+, d_maxBytes(-1)
+, d_source(SystemLimitsSource::e_FALLBACK)
+, d_discoveryDuration()
+{
+}
+
+bsl::ostream& operator<<(bsl::ostream& stream, const SystemLimits& limits)
+{
+    return stream << "[ maxMaxMessages = " << limits.d_maxMaxMessages
+                  << " maxMaxMessageSize = " << limits.d_maxMaxMessageSize
+                  << " defaultMaxMessages = " << limits.d_defaultMaxMessages
+                  << " defaultMaxMessageSize = "
+                  << limits.d_defaultMaxMessageSize
+                  << " maxQueues = " << limits.d_maxQueues
+                  << " maxBytes = " << limits.d_maxBytes
+                  << " source = " << limits.d_source
+                  << " discoveryMicroseconds = "
+                  << limits.d_discoveryDuration.totalMicroseconds() << " ]";
+}
+
+                          // -----------------------
+                          // struct SystemLimitsUtil
+                          // -----------------------
+
+// CLASS DATA
+const char SystemLimitsUtil::k_CACHE_PATH_VARIABLE[] =
+    "IPCMQ_LIMITS_CACHE_PATH";
+
+// CLASS METHODS
+const SystemLimits& SystemLimitsUtil::limits()
+{
+    static const SystemLimits *ptr = 0;
+    BSLMT_ONCE_DO
+    {
+        BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+        static SystemLimits value;
+        discover(&value);
+        ptr = &value;
+
+        BALL_LOG_DEBUG << "message queue system limits discovered: " << value
+                       << BALL_LOG_END;
+    }
+
+    BSLS_ASSERT_SAFE(ptr);
+    return *ptr;
+}
+
+void SystemLimitsUtil::discover(SystemLimits *output)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(output);
+
+    const bsls::TimeInterval start = bsls::SystemTime::nowMonotonicClock();
+    const char *const        cachePath = bsl::getenv(k_CACHE_PATH_VARIABLE);
+
+    SystemLimits limits;
+    if (readProc(&limits) == 0) {
+        limits.d_source = SystemLimitsSource::e_PROC;
+    }
+    else {
+        // Start over from fallback values, since 'readProc' might have
+        // modified 'limits' before failing.
+        limits = SystemLimits();
+
+        if (cachePath && readCache(&limits, cachePath) == 0) {
+            limits.d_source = SystemLimitsSource::e_CACHE;
+        }
+        else if (probe(&limits) == 0) {
+            limits.d_source = SystemLimitsSource::e_PROBE;
+            if (cachePath && writeCache(limits, cachePath)) {
+                BALL_LOG_WARN << "Unable to write message queue limits to "
+                                 "the cache file \""
+                              << cachePath << '\"' << BALL_LOG_END;
+            }
+        }
+        // Otherwise, 'probe' has left fallback values in 'limits'.
+    }
+
+    limits.d_discoveryDuration =
+        bsls::SystemTime::nowMonotonicClock() - start;
+    *output = limits;
+}
+
+int SystemLimitsUtil::readProc(SystemLimits *output)
+{
+    BSLS_ASSERT(output);
+
+    long maxMessages;
+    long maxMessageSize;
+    if (readProcValue("msg_max", &maxMessages) ||
+        readProcValue("msgsize_max", &maxMessageSize)) {
+        return 1;                                                     // RETURN
+    }
+
+    // 'msg_default' and 'msgsize_default' were added in Linux 3.5. Before
+    // then, the defaults were the lesser of the maximum and a constant.
+    long defaultMaxMessages;
+    if (readProcValue("msg_default", &defaultMaxMessages)) {
+        defaultMaxMessages = bsl::min(maxMessages, 10L);
+    }
+
+    long defaultMaxMessageSize;
+    if (readProcValue("msgsize_default", &defaultMaxMessageSize)) {
+        defaultMaxMessageSize = bsl::min(maxMessageSize, 8192L);
+    }
+
+    if (readProcValue("queues_max", &output->d_maxQueues)) {
+        output->d_maxQueues = -1;
+    }
+
+    // A privileged process may exceed 'msg_max' and 'msgsize_max', but not
+    // the kernel's hard limits.
+    if (hasSysResourceCapability()) {
+        maxMessages    = k_HARD_MAX_MESSAGES;
+        maxMessageSize = k_HARD_MAX_MESSAGE_SIZE;
+    }
+
+    // Every process is subject to 'RLIMIT_MSGQUEUE', which bounds the total
+    // size of the queues created by its user. Note that queues that the user
+    // has already created count against the same limit, so the maxima
+    // calculated here are the best case.
+    output->d_maxBytes              = maxBytes();
+    output->d_defaultMaxMessages    = defaultMaxMessages;
+    output->d_defaultMaxMessageSize = defaultMaxMessageSize;
+    output->d_maxMaxMessages        = boundMaxMessages(
+        maxMessages, output->d_maxBytes, defaultMaxMessageSize);
+    output->d_maxMaxMessageSize     = boundMaxMessageSize(
+        maxMessageSize, output->d_maxBytes, defaultMaxMessages);
+
+    return 0;
+}
+
+int SystemLimitsUtil::probe(SystemLimits *output)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(output);
+
+    *output = SystemLimits();
+
+    mq_attr              defaults;
+    const mq_attr *const inputAttributesPtr = 0;  // parameter not used
+    if (temporaryQueue(inputAttributesPtr, &defaults)) {
+        BALL_LOG_WARN << "Unable to create a temporary message queue to "
+                         "discover system limits. Using fallback values."
+                      << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    output->d_defaultMaxMessages    = defaults.mq_maxmsg;
+    output->d_defaultMaxMessageSize = defaults.mq_msgsize;
+    output->d_maxBytes              = maxBytes();
+
+    output->d_maxMaxMessages = ipcu::AlgoUtil::findMaxIf(
+        output->d_defaultMaxMessages,
+        CanCreateQueueWithMaxMessages(output->d_defaultMaxMessageSize));
+
+    output->d_maxMaxMessageSize = ipcu::AlgoUtil::findMaxIf(
+        output->d_defaultMaxMessageSize,
+        CanCreateQueueWithMaxMessageSize(output->d_defaultMaxMessages));
+
+    return 0;
+}
+
+int SystemLimitsUtil::readCache(SystemLimits *output, const bsl::string& path)
+{
+    BSLS_ASSERT(output);
+
+    bsls::Types::Int64 booted;
+    if (bootTime(&booted)) {
+        // Without a way to tell one boot from another, a cache file might
+        // describe a different system configuration.
+        return 1;                                                     // RETURN
+    }
+
+    bsl::ifstream in(path.c_str());
+    bsl::string   header;
+    if (!(in >> header) || header != k_CACHE_HEADER) {
+        return 2;                                                     // RETURN
+    }
+
+    bsls::Types::Int64 cachedBootTime;
+    unsigned           cachedUserId;
+    long               cachedMaxBytes;
+    SystemLimits       limits;
+    if (readField(in, "bootTime", &cachedBootTime) ||
+        readField(in, "userId", &cachedUserId) ||
+        readField(in, "maxBytes", &cachedMaxBytes) ||
+        readField(in, "maxMaxMessages", &limits.d_maxMaxMessages) ||
+        readField(in, "maxMaxMessageSize", &limits.d_maxMaxMessageSize) ||
+        readField(in, "defaultMaxMessages", &limits.d_defaultMaxMessages) ||
+        readField(
+            in, "defaultMaxMessageSize", &limits.d_defaultMaxMessageSize) ||
+        readField(in, "maxQueues", &limits.d_maxQueues)) {
+        return 3;                                                     // RETURN
+    }
+
+    // The limits depend on the boot (the sysctls might have changed), the
+    // user (which determines privileges), and the user's 'RLIMIT_MSGQUEUE'.
+    const bsls::Types::Int64 bootTimeDifference = cachedBootTime - booted;
+    if (bootTimeDifference > k_BOOT_TIME_TOLERANCE ||
+        bootTimeDifference < -k_BOOT_TIME_TOLERANCE ||
+        cachedUserId != unsigned(geteuid()) || cachedMaxBytes != maxBytes()) {
+        return 4;                                                     // RETURN
+    }
+
+    limits.d_maxBytes = cachedMaxBytes;
+    *output           = limits;
+    return 0;
+}
+
+int SystemLimitsUtil::writeCache(const SystemLimits& limits,
+                                 const bsl::string&  path)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    bsls::Types::Int64 booted;
+    if (bootTime(&booted)) {
+        return 1;                                                     // RETURN
+    }
+
+    // Write to a file specific to this process and then rename it, so that
+    // other processes never read a partially written cache file.
+    bsl::ostringstream temporaryPath;
+    temporaryPath << path << '.' << getpid() << ".tmp";
+
+    {
+        bsl::ofstream out(temporaryPath.str().c_str());
+        out << k_CACHE_HEADER << '\n'
+            << "bootTime " << booted << '\n'
+            << "userId " << unsigned(geteuid()) << '\n'
+            << "maxBytes " << limits.d_maxBytes << '\n'
+            << "maxMaxMessages " << limits.d_maxMaxMessages << '\n'
+            << "maxMaxMessageSize " << limits.d_maxMaxMessageSize << '\n'
+            << "defaultMaxMessages " << limits.d_defaultMaxMessages << '\n'
+            << "defaultMaxMessageSize " << limits.d_defaultMaxMessageSize
+            << '\n'
+            << "maxQueues " << limits.d_maxQueues << '\n';
+
+        out.close();
+        if (!out) {
+            bsl::remove(temporaryPath.str().c_str());
+            return 2;                                                 // RETURN
+        }
+    }
+
+    if (bsl::rename(temporaryPath.str().c_str(), path.c_str())) {
+        BALL_LOG_WARN << "Unable to rename \"" << temporaryPath.str()
+                      << "\" to \"" << path << "\": " << systemError(errno)
+                      << BALL_LOG_END;
+        bsl::remove(temporaryPath.str().c_str());
+        return 3;                                                     // RETURN
+    }
+
+    return 0;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
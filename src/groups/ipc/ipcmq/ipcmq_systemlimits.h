@@ -0,0 +1,139 @@
+#ifndef INCLUDED_IPCMQ_SYSTEMLIMITS
+#define INCLUDED_IPCMQ_SYSTEMLIMITS
+
+#include <ipcu_enum.h>
+
+#include <bsl_iosfwd.h>
+#include <bsl_string.h>
+
+#include <bsls_timeinterval.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+
+                          // ========================
+                          // class SystemLimitsSource
+                          // ========================
+
+IPCU_DEFINE_ENUM(SystemLimitsSource, PROC, CACHE, PROBE, FALLBACK);
+    // 'PROC' means that the limits were read from '/proc/sys/fs/mqueue',
+    // 'CACHE' means that they were read from a cache file written earlier
+    // during the same boot, 'PROBE' means that they were found by creating
+    // temporary message queues, and 'FALLBACK' means that none of those
+    // worked, and pessimistically small values are used instead.
+
+                            // ===================
+                            // struct SystemLimits
+                            // ===================
+
+struct SystemLimits {
+    // This 'struct' describes the limits that the system places on the
+    // attributes of message queues created by the current process, and how
+    // those limits were discovered.
+
+    // DATA
+    long               d_maxMaxMessages;
+        // the largest 'mq_maxmsg' allowed when 'mq_msgsize' is defaulted
+
+    long               d_maxMaxMessageSize;
+        // the largest 'mq_msgsize' allowed when 'mq_maxmsg' is defaulted
+
+    long               d_defaultMaxMessages;
+        // the 'mq_maxmsg' of a queue created without attributes
+
+    long               d_defaultMaxMessageSize;
+        // the 'mq_msgsize' of a queue created without attributes
+
+    long               d_maxQueues;
+        // the system-wide limit on the number of queues, or -1 if unknown
+
+    long               d_maxBytes;
+        // the 'RLIMIT_MSGQUEUE' of this process, or -1 if there is none
+
+    SystemLimitsSource d_source;
+        // where the limits came from
+
+    bsls::TimeInterval d_discoveryDuration;
+        // how long it took to discover the limits
+
+    // CREATORS
+    SystemLimits();
+        // Create a 'SystemLimits' object having pessimistically small
+        // fallback values and a source of 'SystemLimitsSource::e_FALLBACK'.
+};
+
+bsl::ostream& operator<<(bsl::ostream& stream, const SystemLimits& limits);
+    // Print the specified 'limits' to the specified 'stream' on a single line.
+    // Return 'stream'.
+
+                          // =======================
+                          // struct SystemLimitsUtil
+                          // =======================
+
+struct SystemLimitsUtil {
+    // This 'struct' provides a namespace for functions that discover the
+    // limits that the system places on the attributes of message queues.
+    //
+    // On Linux, the limits are read from the files in '/proc/sys/fs/mqueue'
+    // and from 'getrlimit(RLIMIT_MSGQUEUE)', which takes a handful of system
+    // calls and creates no queues. Where those are not available, the limits
+    // are instead found by creating (and destroying) temporary queues having
+    // different attributes, which can take dozens of 'mq_open' and
+    // 'mq_unlink' calls. The results of probing can be saved in a cache file
+    // that is valid until the system reboots, so that other processes started
+    // during the same boot need not probe again. The cache file is used only
+    // if the environment variable named by 'k_CACHE_PATH_VARIABLE' is set to
+    // its path, and only on systems having a clock that counts the time since
+    // boot (Linux), from which the time of the boot is calculated without
+    // reading '/proc'.
+
+    // CLASS DATA
+    static const char k_CACHE_PATH_VARIABLE[];
+        // "IPCMQ_LIMITS_CACHE_PATH"
+
+    // CLASS METHODS
+    static const SystemLimits& limits();
+        // Return the limits of the current system, discovering them the first
+        // time this function is called. This function is thread-safe.
+
+    static void discover(SystemLimits *output);
+        // Load into the specified 'output' the limits of the current system,
+        // trying in order: '/proc', the cache file (if one is configured),
+        // probing (saving the results to the cache file, if one is
+        // configured), and fallback values. Record the source of the limits
+        // and the time taken to discover them in 'output'. Note that unlike
+        // 'limits', this function does all of the work every time it's
+        // called.
+
+    static int readProc(SystemLimits *output);
+        // Load into the specified 'output' the limits read from
+        // '/proc/sys/fs/mqueue' and from 'RLIMIT_MSGQUEUE'. Return zero on
+        // success or a nonzero value if the limits are not available this
+        // way, in which case 'output' might still have been modified. Note
+        // that a process having the 'CAP_SYS_RESOURCE' capability is
+        // permitted to exceed the per-queue limits in '/proc', up to the
+        // kernel's hard limits, and that this is reflected in 'output'.
+
+    static int probe(SystemLimits *output);
+        // Load into the specified 'output' the limits found by creating and
+        // destroying temporary message queues. Return zero on success or a
+        // nonzero value if a temporary queue could not be created at all, in
+        // which case 'output' holds fallback values.
+
+    static int readCache(SystemLimits *output, const bsl::string& path);
+        // Load into the specified 'output' the limits stored in the cache
+        // file at the specified 'path'. Return zero on success or a nonzero
+        // value if the file cannot be read or was written by a process having
+        // a different user or 'RLIMIT_MSGQUEUE', or during a different boot of
+        // the system.
+
+    static int writeCache(const SystemLimits& limits, const bsl::string& path);
+        // Store the specified 'limits' in a cache file at the specified
+        // 'path', replacing any existing file atomically. Return zero on
+        // success or a nonzero value otherwise.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
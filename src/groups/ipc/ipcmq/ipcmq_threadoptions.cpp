@@ -0,0 +1,310 @@
+
+#include <ipcmq_threadoptions.h>
+
+#include <ball_log.h>
+
+#include <bslmt_threadattributes.h>
+
+#include <bsls_assert.h>
+#include <bsls_platform.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_climits.h>
+#include <bsl_cstdlib.h>
+#include <bsl_fstream.h>
+#include <bsl_sstream.h>
+
+#include <string.h>  // strerror
+
+#ifdef BSLS_PLATFORM_OS_UNIX
+#include <pthread.h>  // pthread_self, pthread_setschedparam
+#include <sched.h>    // sched_param, SCHED_FIFO
+#endif
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+#include <errno.h>             // errno
+#include <linux/mempolicy.h>   // MPOL_PREFERRED
+#include <sys/syscall.h>       // SYS_set_mempolicy
+#include <unistd.h>            // syscall
+#endif
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.THREADOPTIONS";
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+// A memory policy names nodes by a mask of this many bits.
+const int k_MAX_NUMA_NODES = 1024;
+#endif
+
+bsl::string describeCpus(const bsl::vector<int>& cpus)
+    // Return the specified 'cpus' as a comma separated list.
+{
+    bsl::ostringstream stream;
+    for (bsl::size_t i = 0; i < cpus.size(); ++i) {
+        stream << (i ? "," : "") << cpus[i];
+    }
+    return stream.str();
+}
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+int parseCpuList(bsl::vector<int> *result, const bsl::string& list)
+    // Append to the specified 'result' the CPUs in the specified 'list',
+    // which is formatted as Linux formats the CPUs of a NUMA node, e.g.
+    // "0-3,8-11". Return zero on success or a nonzero value otherwise.
+{
+    const char *current = list.c_str();
+    while (*current && *current != '\n') {
+        char       *end;
+        const long  first = bsl::strtol(current, &end, 10);
+        if (end == current) {
+            return -1;                                                // RETURN
+        }
+        current = end;
+
+        long last = first;
+        if (*current == '-') {
+            last = bsl::strtol(++current, &end, 10);
+            if (end == current) {
+                return -1;                                            // RETURN
+            }
+            current = end;
+        }
+
+        for (long cpu = first; cpu <= last; ++cpu) {
+            result->push_back(int(cpu));
+        }
+
+        if (*current == ',') {
+            ++current;
+        }
+    }
+
+    return result->empty();
+}
+#endif
+
+int loadNodeCpus(bsl::vector<int> *result, int node)
+    // Load into the specified 'result' the CPUs of the specified NUMA 'node'.
+    // Return zero on success or a nonzero value otherwise.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    bsl::ostringstream path;
+    path << "/sys/devices/system/node/node" << node << "/cpulist";
+
+    bsl::ifstream file(path.str().c_str());
+    bsl::string   list;
+    if (!bsl::getline(file, list) || parseCpuList(result, list)) {
+        BALL_LOG_WARN << "Unable to find the CPUs of NUMA node " << node
+                      << " in " << path.str()
+                      << ", so the thread may run on any CPU."
+                      << BALL_LOG_END;
+        return -1;                                                    // RETURN
+    }
+
+    return 0;
+#else
+    (void)result;
+    BALL_LOG_WARN << "NUMA placement is not supported on this platform, so "
+                     "the thread may run on any CPU rather than those of "
+                     "node "
+                  << node << '.' << BALL_LOG_END;
+    return -1;
+#endif
+}
+
+int setAffinity(const bsl::vector<int>& cpus)
+    // Restrict the calling thread to the specified 'cpus'. Return zero on
+    // success or a nonzero value otherwise. Log a warning on failure.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(!cpus.empty());
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (bsl::size_t i = 0; i < cpus.size(); ++i) {
+        if (0 <= cpus[i] && cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+
+    // A thread ID of zero is the calling thread.
+    if (sched_setaffinity(0, sizeof set, &set)) {
+        BALL_LOG_WARN << "Unable to restrict the thread to CPUs "
+                      << describeCpus(cpus)
+                      << ", so it may run on any CPU: " << strerror(errno)
+                      << BALL_LOG_END;
+        return -1;                                                    // RETURN
+    }
+
+    return 0;
+#else
+    BALL_LOG_WARN << "CPU affinity is not supported on this platform, so "
+                     "the thread may run on any CPU rather than "
+                  << describeCpus(cpus) << '.' << BALL_LOG_END;
+    return -1;
+#endif
+}
+
+int preferNode(int node)
+    // Make the specified NUMA 'node' the one on which the calling thread
+    // allocates memory whenever the node has memory free. Return zero on
+    // success or a nonzero value otherwise. Log a warning on failure.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    const int     bitsPerWord = int(sizeof(unsigned long) * CHAR_BIT);
+    unsigned long mask[k_MAX_NUMA_NODES / bitsPerWord] = {};
+
+    int rc = -1;
+    if (node < k_MAX_NUMA_NODES) {
+        mask[node / bitsPerWord] = 1UL << (node % bitsPerWord);
+
+        // The kernel reads one bit fewer than it is told to. The policy
+        // applies to pages first touched from now on; those of memory
+        // already touched stay where they are.
+        rc = int(syscall(SYS_set_mempolicy,
+                         MPOL_PREFERRED,
+                         mask,
+                         (unsigned long)(k_MAX_NUMA_NODES + 1)));
+    }
+    else {
+        errno = EINVAL;
+    }
+
+    if (rc) {
+        BALL_LOG_WARN << "Unable to prefer NUMA node " << node
+                      << " for the memory of the thread, so it allocates "
+                         "memory on any node: "
+                      << strerror(errno) << BALL_LOG_END;
+    }
+    return rc;
+#else
+    BALL_LOG_WARN << "NUMA placement is not supported on this platform, so "
+                     "the thread allocates memory on any node rather than "
+                     "node "
+                  << node << '.' << BALL_LOG_END;
+    return -1;
+#endif
+}
+
+int setFifoPriority(int priority)
+    // Run the calling thread under the 'SCHED_FIFO' policy at the specified
+    // 'priority', clamped to the range of the policy. Return zero on success
+    // or a nonzero value otherwise. Log a warning on failure.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+#ifdef BSLS_PLATFORM_OS_UNIX
+    const int minPriority = sched_get_priority_min(SCHED_FIFO);
+    const int maxPriority = sched_get_priority_max(SCHED_FIFO);
+
+    sched_param parameters;
+    parameters.sched_priority = bsl::min(bsl::max(priority, minPriority),
+                                         maxPriority);
+
+    // Unlike most, this function returns the error rather than setting
+    // 'errno'. Without 'CAP_SYS_NICE' or an 'RLIMIT_RTPRIO' limit at least
+    // this high, it fails with 'EPERM'.
+    const int rc = pthread_setschedparam(pthread_self(),
+                                         SCHED_FIFO,
+                                         &parameters);
+    if (rc) {
+        BALL_LOG_WARN << "Unable to run the thread under SCHED_FIFO at "
+                         "priority "
+                      << parameters.sched_priority
+                      << ", so it runs under the default policy: "
+                      << strerror(rc) << BALL_LOG_END;
+    }
+    return rc;
+#else
+    BALL_LOG_WARN << "SCHED_FIFO is not supported on this platform, so the "
+                     "thread runs under the default policy rather than at "
+                     "priority "
+                  << priority << '.' << BALL_LOG_END;
+    return -1;
+#endif
+}
+
+}  // close unnamed namespace
+
+                            // --------------------
+                            // struct ThreadOptions
+                            // --------------------
+
+// CREATORS
+ThreadOptions::ThreadOptions()
+: d_cpus()
+, d_numaNode(-1)
+, d_fifoPriority(0)
+, d_stackSize(0)
+, d_name()
+{
+}
+
+// ACCESSORS
+bool ThreadOptions::hasPlacement() const
+{
+    return !d_cpus.empty() || d_numaNode >= 0 || d_fifoPriority > 0;
+}
+
+                          // ------------------------
+                          // struct ThreadOptionsUtil
+                          // ------------------------
+
+// CLASS METHODS
+void ThreadOptionsUtil::loadAttributes(bslmt::ThreadAttributes *result,
+                                       const ThreadOptions&     options)
+{
+    BSLS_ASSERT(result);
+
+    if (options.d_stackSize > 0) {
+        result->setStackSize(options.d_stackSize);
+    }
+    if (!options.d_name.empty()) {
+        result->setThreadName(options.d_name);
+    }
+}
+
+int ThreadOptionsUtil::applyToSelf(const ThreadOptions& options)
+{
+    int numFailed = 0;
+
+    // Each option is applied on its own, so that one that fails does not
+    // keep the others from being applied.
+    bsl::vector<int> cpus(options.d_cpus);
+    if (cpus.empty() && options.d_numaNode >= 0 &&
+        loadNodeCpus(&cpus, options.d_numaNode)) {
+        ++numFailed;
+    }
+    if (!cpus.empty() && setAffinity(cpus)) {
+        ++numFailed;
+    }
+
+    if (options.d_numaNode >= 0 && preferNode(options.d_numaNode)) {
+        ++numFailed;
+    }
+
+    if (options.d_fifoPriority > 0 &&
+        setFifoPriority(options.d_fifoPriority)) {
+        ++numFailed;
+    }
+
+    return numFailed;
+}
+
+void ThreadOptionsUtil::run(const ThreadOptions&                options,
+                            const bslmt::ThreadUtil::Invokable& function)
+{
+    applyToSelf(options);
+    function();
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,97 @@
+#ifndef INCLUDED_IPCMQ_THREADOPTIONS
+#define INCLUDED_IPCMQ_THREADOPTIONS
+
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bslmt_threadutil.h>
+
+namespace BloombergLP {
+namespace bslmt { class ThreadAttributes; }
+namespace ipcmq {
+
+                            // ====================
+                            // struct ThreadOptions
+                            // ====================
+
+struct ThreadOptions {
+    // This 'struct' describes where and how a thread created by a 'Consumer'
+    // or a 'Producer' runs. By default, a thread runs as any other: on any
+    // CPU, allocating memory on any NUMA node, under the default scheduling
+    // policy, with the default stack size and no name.
+
+    // DATA
+    bsl::vector<int> d_cpus;
+        // the CPUs on which the thread may run, or empty for the CPUs of
+        // 'd_numaNode' if it is not negative, or for any CPU otherwise
+
+    int d_numaNode;
+        // the NUMA node on which the thread preferably allocates memory, such
+        // as its message buffers, or negative for any node. Unless 'd_cpus'
+        // is not empty, the thread also runs only on the CPUs of this node.
+
+    int d_fifoPriority;
+        // if positive, the real-time priority with which the thread runs
+        // under the 'SCHED_FIFO' policy, clamped to the range the system
+        // allows, or zero for the default policy. A real-time thread runs
+        // until it blocks, ahead of every thread of the default policy on its
+        // CPU, so a thread that polls should not be given one.
+
+    int d_stackSize;
+        // the size of the stack of the thread in bytes, or zero for the
+        // default
+
+    bsl::string d_name;
+        // the name of the thread, as seen by debuggers and by 'top', or empty
+        // for the name of the process. Linux truncates names to 15 bytes.
+
+    // CREATORS
+    ThreadOptions();
+        // Create a 'ThreadOptions' object describing a thread that runs as
+        // any other.
+
+    // ACCESSORS
+    bool hasPlacement() const;
+        // Return whether these options constrain where or under which policy
+        // a thread runs, which only the thread itself can apply.
+};
+
+                          // ========================
+                          // struct ThreadOptionsUtil
+                          // ========================
+
+struct ThreadOptionsUtil {
+    // This class is a namespace for functions that apply 'ThreadOptions' to
+    // a thread. The stack size and the name are attributes of the thread
+    // given when it is created. The CPUs, the NUMA node, and the scheduling
+    // policy are applied by the thread to itself once it runs, each on its
+    // own, so that one that is not permitted, such as a real-time priority
+    // without 'CAP_SYS_NICE', or not supported, such as NUMA placement on a
+    // platform other than Linux, is logged as a warning and the thread runs
+    // without it. A thread is never refused for its options.
+
+    // CLASS METHODS
+    static void loadAttributes(bslmt::ThreadAttributes *result,
+                               const ThreadOptions&     options);
+        // Load into the specified 'result' the stack size and the name
+        // described by the specified 'options', leaving the other attributes
+        // of 'result' as they are.
+
+    static int applyToSelf(const ThreadOptions& options);
+        // Restrict the calling thread to the CPUs, prefer for its memory the
+        // NUMA node, and give it the scheduling policy described by the
+        // specified 'options'. Log a warning for each that cannot be applied.
+        // Return the number of those that could not be applied, which is zero
+        // if all of them were.
+
+    static void run(const ThreadOptions&                options,
+                    const bslmt::ThreadUtil::Invokable& function);
+        // Apply the specified 'options' to the calling thread as
+        // 'applyToSelf' does, and then invoke the specified 'function'. This
+        // is meant to be bound to the function of a new thread.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
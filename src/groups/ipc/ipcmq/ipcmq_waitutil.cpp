@@ -0,0 +1,109 @@
+
+#include <ipcmq_waitutil.h>
+
+#include <bdlt_currenttime.h>
+
+#include <bslmt_threadutil.h>
+
+#include <bsls_assert.h>
+#include <bsls_platform.h>
+#include <bsls_timeinterval.h>
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+#include <errno.h>        // errno, ETIMEDOUT
+#include <linux/futex.h>  // FUTEX_WAIT, FUTEX_WAKE
+#include <sys/syscall.h>  // SYS_futex
+#include <time.h>         // timespec
+#include <unistd.h>       // syscall
+#endif
+
+#include <bsl_climits.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+#ifndef BSLS_PLATFORM_OS_LINUX
+// Without a futex, a parked thread checks again this often.
+const int k_POLL_MICROSECONDS = 100;
+#endif
+
+}  // close unnamed namespace
+
+                              // ---------------
+                              // struct WaitUtil
+                              // ---------------
+
+// CLASS METHODS
+void WaitUtil::pause()
+{
+#if defined(BSLS_PLATFORM_CMP_GNU) || defined(BSLS_PLATFORM_CMP_CLANG)
+#if defined(BSLS_PLATFORM_CPU_X86) || defined(BSLS_PLATFORM_CPU_X86_64)
+    __asm__ __volatile__("pause" ::: "memory");
+#elif defined(BSLS_PLATFORM_CPU_ARM)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+#endif
+}
+
+int WaitUtil::wait(AtomicInt                *word,
+                   int                       expected,
+                   const bsls::TimeInterval *deadline)
+{
+    BSLS_ASSERT(word);
+
+    bsls::TimeInterval remaining;
+    if (deadline) {
+        remaining = *deadline - bdlt::CurrentTime::now();
+        if (remaining <= bsls::TimeInterval()) {
+            return 1;                                                 // RETURN
+        }
+    }
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    // The futex is not private, since the word may be shared with other
+    // processes. The kernel checks the value of the word and parks the thread
+    // atomically with respect to 'wake'.
+    timespec timeout;
+    timeout.tv_sec  = remaining.seconds();
+    timeout.tv_nsec = remaining.nanoseconds();
+    if (syscall(SYS_futex,
+                reinterpret_cast<int *>(word),
+                FUTEX_WAIT,
+                expected,
+                deadline ? &timeout : 0,
+                0,
+                0) == -1 &&
+        errno == ETIMEDOUT) {
+        return 1;                                                     // RETURN
+    }
+#else
+    (void)expected;
+    bslmt::ThreadUtil::microSleep(k_POLL_MICROSECONDS);
+    if (deadline && bdlt::CurrentTime::now() >= *deadline) {
+        return 1;                                                     // RETURN
+    }
+#endif
+
+    return 0;
+}
+
+void WaitUtil::wake(AtomicInt *word)
+{
+    BSLS_ASSERT(word);
+
+#ifdef BSLS_PLATFORM_OS_LINUX
+    syscall(SYS_futex,
+            reinterpret_cast<int *>(word),
+            FUTEX_WAKE,
+            INT_MAX,
+            0,
+            0,
+            0);
+#else
+    (void)word;
+#endif
+}
+
+}  // close package namespace
+}  // close enterprise namespace
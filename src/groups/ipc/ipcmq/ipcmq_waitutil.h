@@ -0,0 +1,54 @@
+#ifndef INCLUDED_IPCMQ_WAITUTIL
+#define INCLUDED_IPCMQ_WAITUTIL
+
+#include <bsls_atomicoperations.h>
+
+namespace BloombergLP {
+namespace bsls { class TimeInterval; }
+namespace ipcmq {
+
+                              // ===============
+                              // struct WaitUtil
+                              // ===============
+
+struct WaitUtil {
+    // This class is a namespace for functions that let a thread wait for a
+    // word of memory shared between processes to change, first by spinning
+    // using 'pause' and then by parking using 'wait'. On Linux, parking uses
+    // a futex, which the kernel keys on the physical page, so the word may be
+    // mapped at different addresses in different processes. Elsewhere,
+    // parking sleeps briefly instead, and waking does nothing.
+    //
+    // The waiting thread reads the word, checks its condition, and then waits
+    // for the word to differ from what it read. The waking thread changes the
+    // word, typically by incrementing it, and then wakes the waiters, so that
+    // a change made between the check and the wait is not missed.
+
+    // TYPES
+    typedef bsls::AtomicOperations::AtomicTypes::Int AtomicInt;
+
+    // CLASS METHODS
+    static void pause();
+        // Hint to the processor that the calling thread is spinning, so that
+        // it yields resources to a sibling hardware thread and does not
+        // speculate past the spin when it ends.
+
+    static int wait(AtomicInt                *word,
+                    int                       expected,
+                    const bsls::TimeInterval *deadline);
+        // Block the calling thread until it is woken by 'wake' for the
+        // specified 'word', or until the value of 'word' is not the specified
+        // 'expected' value, or until the optionally specified 'deadline', an
+        // absolute time since the epoch, passes. If 'deadline' is zero, do
+        // not time out. Return zero unless 'deadline' passed, in which case
+        // return a nonzero value. Note that this function may return early
+        // for no reason, so the caller must check its condition again.
+
+    static void wake(AtomicInt *word);
+        // Wake every thread waiting in 'wait' for the specified 'word'.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -0,0 +1,597 @@
+
+#include <ipcmq_writeaheadlog.h>
+
+#include <ball_log.h>
+
+#include <bdlde_crc32c.h>
+
+#include <bslmf_assert.h>
+
+#include <bslmt_lockguard.h>
+
+#include <bsls_assert.h>
+#include <bsls_atomicoperations.h>
+
+#include <bsl_cstring.h>
+
+#include <errno.h>      // errno
+#include <fcntl.h>      // open
+#include <string.h>     // strerror
+#include <sys/file.h>   // flock
+#include <sys/mman.h>   // mmap, munmap
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // close, fdatasync, ftruncate
+
+namespace BloombergLP {
+namespace ipcmq {
+namespace {
+
+const char k_LOG_CATEGORY[] = "IPCMQ.WRITEAHEADLOG";
+
+typedef bsls::AtomicOperations    Atomics;
+typedef Atomics::AtomicTypes::Int AtomicInt;
+typedef bsls::Types::Uint64       Uint64;
+typedef bsls::Types::Uint32       Uint32;
+
+// "ipcmqwa" in ASCII, marking the beginning of a log created by this
+// component, followed by a version number in the last byte.
+const Uint64 k_MAGIC = 0x6970636d71776101ULL;
+
+// The header occupies the first page, so that the records are page aligned.
+const Uint64 k_HEADER_SIZE = 4096;
+
+struct LogHeader {
+    // This 'struct' is the beginning of every log. Since a log may be shared
+    // by processes built from different code, every member has a fixed size.
+    // Only the writing process modifies the header.
+
+    Uint64 d_magic;
+    Uint64 d_capacity;      // bytes of records following the header
+    Uint64 d_head;          // offset of the oldest record
+    Uint64 d_tail;          // offset past the newest record
+    Uint64 d_usedBytes;     // including skipped bytes at the end
+    Uint64 d_nextSequence;
+};
+
+BSLMF_ASSERT(sizeof(LogHeader) <= k_HEADER_SIZE);
+
+enum RecordState { e_EMPTY = 0, e_PENDING = 1, e_CONSUMED = 2, e_SKIP = 3 };
+
+struct RecordHeader {
+    // This 'struct' precedes the payload of every record.
+
+    AtomicInt d_state;     // 'RecordState'
+    Uint32    d_length;    // of the payload
+    Uint64    d_sequence;
+    int       d_priority;
+    Uint32    d_checksum;  // of the above, but the state, and the payload
+};
+
+BSLMF_ASSERT(sizeof(RecordHeader) == 24);
+
+Uint64 recordSize(Uint64 payloadLength)
+    // Return the number of bytes occupied by a record having a payload of the
+    // specified 'payloadLength', which is a multiple of eight.
+{
+    return (sizeof(RecordHeader) + payloadLength + 7) & ~Uint64(7);
+}
+
+Uint32 checksum(const RecordHeader& record, const char *payload)
+    // Return the checksum of the specified 'record' having the specified
+    // 'payload'.
+{
+    unsigned int crc = bdlde::Crc32c::calculate(&record.d_length,
+                                                sizeof record.d_length);
+    crc = bdlde::Crc32c::calculate(
+        &record.d_sequence, sizeof record.d_sequence, crc);
+    crc = bdlde::Crc32c::calculate(
+        &record.d_priority, sizeof record.d_priority, crc);
+    return bdlde::Crc32c::calculate(payload, record.d_length, crc);
+}
+
+LogHeader *logHeader(char *base)
+{
+    return reinterpret_cast<LogHeader *>(base);
+}
+
+RecordHeader *recordAt(char *base, Uint64 offset)
+{
+    return reinterpret_cast<RecordHeader *>(base + k_HEADER_SIZE + offset);
+}
+
+bool isSkip(char *base, Uint64 offset)
+    // Return whether the records resume at the beginning of the ring after
+    // the specified 'offset' in the log at the specified 'base', either
+    // because a skip record is there or because there is no room for one.
+{
+    const Uint64 capacity = logHeader(base)->d_capacity;
+    return capacity - offset < sizeof(RecordHeader) ||
+           Atomics::getInt(&recordAt(base, offset)->d_state) == e_SKIP;
+}
+
+char *mapLog(int fd, Uint64 size, const bsl::string& path)
+    // Map into memory the specified 'size' bytes of the file having the
+    // specified 'fd' and 'path'. Return the address of the mapping, or zero
+    // if an error occurs, which is logged.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    void *const address =
+        mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        BALL_LOG_ERROR << "Unable to map the write-ahead log \"" << path
+                       << "\" into memory: " << strerror(errno)
+                       << BALL_LOG_END;
+        return 0;                                                     // RETURN
+    }
+
+    return static_cast<char *>(address);
+}
+
+bool isValid(char *base, Uint64 size)
+    // Return whether the specified 'size' bytes at the specified 'base' are
+    // a log.
+{
+    if (size < k_HEADER_SIZE) {
+        return false;                                                 // RETURN
+    }
+
+    const LogHeader& log = *logHeader(base);
+    return log.d_magic == k_MAGIC &&
+           log.d_capacity == size - k_HEADER_SIZE &&
+           log.d_capacity % 8 == 0 && log.d_head <= log.d_capacity &&
+           log.d_tail <= log.d_capacity && log.d_usedBytes <= log.d_capacity;
+}
+
+void recover(char *base, const bsl::string& path)
+    // Remove from the log at the specified 'base', whose file has the
+    // specified 'path', every record beginning with the first that is not
+    // intact, as may happen if the system crashed before the pages of the
+    // record reached storage. Log what is removed.
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+
+    LogHeader& log       = *logHeader(base);
+    Uint64     offset    = log.d_head;
+    Uint64     remaining = log.d_usedBytes;
+    while (remaining) {
+        const Uint64 tail = log.d_capacity - offset;
+        if (isSkip(base, offset)) {
+            if (tail > remaining) {
+                break;
+            }
+            remaining -= tail;
+            offset     = 0;
+            continue;
+        }
+
+        const RecordHeader& record = *recordAt(base, offset);
+        const int           state  = Atomics::getInt(&record.d_state);
+        const Uint64        size   = recordSize(record.d_length);
+        if (size > remaining || size > tail ||
+            (state != e_PENDING && state != e_CONSUMED) ||
+            (state == e_PENDING &&
+             record.d_checksum !=
+                 checksum(record,
+                          reinterpret_cast<const char *>(&record + 1)))) {
+            break;
+        }
+
+        remaining -= size;
+        offset     = offset + size == log.d_capacity ? 0 : offset + size;
+    }
+
+    if (remaining) {
+        BALL_LOG_WARN << "Discarding " << remaining
+                      << " bytes of records that are not intact at the end "
+                         "of the write-ahead log \""
+                      << path << "\"" << BALL_LOG_END;
+        log.d_tail       = offset;
+        log.d_usedBytes -= remaining;
+    }
+
+    if (log.d_usedBytes == 0) {
+        log.d_head = 0;
+        log.d_tail = 0;
+    }
+}
+
+}  // close unnamed namespace
+
+                            // -------------------
+                            // class WriteAheadLog
+                            // -------------------
+
+// CLASS METHODS
+void WriteAheadLog::encode(char *buffer, const Location& location)
+{
+    BSLS_ASSERT(buffer);
+
+    bsl::memcpy(buffer, &location.d_offset, sizeof location.d_offset);
+    bsl::memcpy(buffer + sizeof location.d_offset,
+                &location.d_sequence,
+                sizeof location.d_sequence);
+}
+
+int WriteAheadLog::decode(Location                 *location,
+                          const bslstl::StringRef&  encoded)
+{
+    BSLS_ASSERT(location);
+
+    if (encoded.length() != k_ENCODED_LOCATION_SIZE) {
+        return 1;                                                     // RETURN
+    }
+
+    bsl::memcpy(&location->d_offset, encoded.data(), sizeof(Uint64));
+    bsl::memcpy(&location->d_sequence,
+                encoded.data() + sizeof(Uint64),
+                sizeof(Uint64));
+    return 0;
+}
+
+// CREATORS
+WriteAheadLog::WriteAheadLog()
+: d_base_p(0)
+, d_mappingLength(0)
+, d_fd(-1)
+, d_lastSequence(0)
+{
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    if (d_base_p) {
+        munmap(d_base_p, d_mappingLength);
+    }
+
+    if (d_fd != -1) {
+        close(d_fd);  // which releases the lock
+    }
+}
+
+// MANIPULATORS
+int WriteAheadLog::openForWriting(const bsl::string& path,
+                                  bsl::size_t        capacity,
+                                  int                permissions)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(!d_base_p);
+
+    const int fd =
+        ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, permissions);
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to open the write-ahead log \"" << path
+                       << "\": " << strerror(errno) << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    // Only one process appends to a log at a time. The lock is released when
+    // the descriptor is closed, including when the process exits.
+    if (flock(fd, LOCK_EX | LOCK_NB)) {
+        BALL_LOG_ERROR << "Unable to lock the write-ahead log \"" << path
+                       << "\", which may be open for writing in another "
+                          "process: "
+                       << strerror(errno) << BALL_LOG_END;
+        close(fd);
+        return 2;                                                     // RETURN
+    }
+
+    struct stat status;
+    if (fstat(fd, &status)) {
+        BALL_LOG_ERROR << "Unable to determine the size of the write-ahead "
+                          "log \""
+                       << path << "\": " << strerror(errno) << BALL_LOG_END;
+        close(fd);
+        return 3;                                                     // RETURN
+    }
+
+    const bool   isNew = status.st_size == 0;
+    const Uint64 size  = isNew ? k_HEADER_SIZE + (capacity & ~bsl::size_t(7))
+                               : Uint64(status.st_size);
+    if (isNew && ftruncate(fd, size)) {
+        BALL_LOG_ERROR << "Unable to extend the write-ahead log \"" << path
+                       << "\" to " << size << " bytes: " << strerror(errno)
+                       << BALL_LOG_END;
+        close(fd);
+        return 4;                                                     // RETURN
+    }
+
+    char *const base = mapLog(fd, size, path);
+    if (!base) {
+        close(fd);
+        return 5;                                                     // RETURN
+    }
+
+    LogHeader& log = *logHeader(base);
+    if (isNew) {
+        log.d_capacity     = size - k_HEADER_SIZE;
+        log.d_head         = 0;
+        log.d_tail         = 0;
+        log.d_usedBytes    = 0;
+        log.d_nextSequence = 1;
+        log.d_magic        = k_MAGIC;
+    }
+    else if (!isValid(base, size)) {
+        BALL_LOG_ERROR << "The file \"" << path
+                       << "\" is not a write-ahead log." << BALL_LOG_END;
+        munmap(base, size);
+        close(fd);
+        return 6;                                                     // RETURN
+    }
+    else {
+        recover(base, path);
+    }
+
+    d_base_p        = base;
+    d_mappingLength = size;
+    d_fd            = fd;
+    d_lastSequence  = log.d_nextSequence - 1;
+    return 0;
+}
+
+int WriteAheadLog::openForReading(const bsl::string& path)
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(!d_base_p);
+
+    // Acknowledging writes to the log, so it's opened for writing.
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        BALL_LOG_ERROR << "Unable to open the write-ahead log \"" << path
+                       << "\": " << strerror(errno) << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    struct stat status;
+    if (fstat(fd, &status)) {
+        BALL_LOG_ERROR << "Unable to determine the size of the write-ahead "
+                          "log \""
+                       << path << "\": " << strerror(errno) << BALL_LOG_END;
+        close(fd);
+        return 2;                                                     // RETURN
+    }
+
+    const Uint64 size = status.st_size;
+    char *const  base = size ? mapLog(fd, size, path) : 0;
+    close(fd);  // The mapping remains valid after the descriptor is closed.
+    if (!base) {
+        return 3;                                                     // RETURN
+    }
+
+    if (!isValid(base, size)) {
+        BALL_LOG_ERROR << "The file \"" << path
+                       << "\" is not a write-ahead log." << BALL_LOG_END;
+        munmap(base, size);
+        return 4;                                                     // RETURN
+    }
+
+    d_base_p        = base;
+    d_mappingLength = size;
+    d_lastSequence  = logHeader(base)->d_nextSequence - 1;
+    return 0;
+}
+
+int WriteAheadLog::append(Location                 *location,
+                          const bslstl::StringRef&  payload,
+                          int                       priority)
+{
+    BSLS_ASSERT(location);
+    BSLS_ASSERT(d_fd != -1);
+
+    const Uint64 size = recordSize(payload.length());
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    LogHeader& log = *logHeader(d_base_p);
+    if (size > log.d_capacity) {
+        return 2;                                                     // RETURN
+    }
+
+    // Reclaim the consumed records at the beginning of the log.
+    while (log.d_usedBytes) {
+        const Uint64 tail = log.d_capacity - log.d_head;
+        if (isSkip(d_base_p, log.d_head)) {
+            log.d_usedBytes -= tail;
+            log.d_head       = 0;
+            continue;
+        }
+
+        const RecordHeader& record = *recordAt(d_base_p, log.d_head);
+        if (Atomics::getInt(&record.d_state) == e_PENDING) {
+            break;
+        }
+
+        const Uint64 recordBytes = recordSize(record.d_length);
+        log.d_usedBytes -= recordBytes;
+        log.d_head       = log.d_head + recordBytes == log.d_capacity
+                               ? 0
+                               : log.d_head + recordBytes;
+    }
+    if (log.d_usedBytes == 0) {
+        log.d_head = 0;
+        log.d_tail = 0;
+    }
+
+    // When the log is empty, both offsets are zero. Otherwise, if the
+    // records do not wrap around the end of the ring, there is room after
+    // the last record and before the first. If they do, there is room only
+    // between the last record and the first.
+    Uint64 offset;
+    if (log.d_usedBytes == 0) {
+        offset = 0;
+    }
+    else if (log.d_tail > log.d_head) {
+        const Uint64 tail = log.d_capacity - log.d_tail;
+        if (size <= tail) {
+            offset = log.d_tail;
+        }
+        else if (size <= log.d_head) {
+            if (tail >= sizeof(RecordHeader)) {
+                Atomics::setInt(&recordAt(d_base_p, log.d_tail)->d_state,
+                                e_SKIP);
+            }
+            log.d_usedBytes += tail;
+            offset           = 0;
+        }
+        else {
+            return 1;                                                 // RETURN
+        }
+    }
+    else if (size <= log.d_head - log.d_tail) {
+        offset = log.d_tail;
+    }
+    else {
+        return 1;                                                     // RETURN
+    }
+
+    // The state is written last, so that the record is pending only once it
+    // is complete.
+    RecordHeader& record = *recordAt(d_base_p, offset);
+    Atomics::setInt(&record.d_state, e_EMPTY);
+    record.d_length   = Uint32(payload.length());
+    record.d_sequence = log.d_nextSequence;
+    record.d_priority = priority;
+    bsl::memcpy(&record + 1, payload.data(), payload.length());
+    record.d_checksum = checksum(record, payload.data());
+    Atomics::setInt(&record.d_state, e_PENDING);
+
+    location->d_offset   = offset;
+    location->d_sequence = log.d_nextSequence;
+
+    log.d_tail       = offset + size;
+    log.d_usedBytes += size;
+    ++log.d_nextSequence;
+    d_lastSequence = location->d_sequence;
+
+    return 0;
+}
+
+int WriteAheadLog::sync()
+{
+    BALL_LOG_SET_CATEGORY(k_LOG_CATEGORY);
+    BSLS_ASSERT(d_fd != -1);
+
+    // The mapping and the file share the page cache, so writing back the
+    // file writes back the records.
+    if (fdatasync(d_fd)) {
+        BALL_LOG_ERROR << "Unable to write the write-ahead log to storage: "
+                       << strerror(errno) << BALL_LOG_END;
+        return 1;                                                     // RETURN
+    }
+
+    return 0;
+}
+
+int WriteAheadLog::acknowledge(const Location& location)
+{
+    if (!d_base_p || location.d_offset % 8 != 0 ||
+        location.d_offset + sizeof(RecordHeader) >
+            logHeader(d_base_p)->d_capacity) {
+        return 1;                                                     // RETURN
+    }
+
+    RecordHeader& record = *recordAt(d_base_p, location.d_offset);
+    if (record.d_sequence != location.d_sequence ||
+        Atomics::testAndSwapInt(&record.d_state, e_PENDING, e_CONSUMED) !=
+            e_PENDING) {
+        return 2;                                                     // RETURN
+    }
+
+    return 0;
+}
+
+void WriteAheadLog::loadPending(bsl::vector<Location> *locations,
+                                bsl::vector<int>      *priorities)
+{
+    BSLS_ASSERT(locations);
+    BSLS_ASSERT(priorities);
+    BSLS_ASSERT(d_fd != -1);
+
+    locations->clear();
+    priorities->clear();
+
+    bslmt::LockGuard<bslmt::Mutex> guard(&d_mutex);
+
+    const LogHeader& log       = *logHeader(d_base_p);
+    Uint64           offset    = log.d_head;
+    Uint64           remaining = log.d_usedBytes;
+    while (remaining) {
+        if (isSkip(d_base_p, offset)) {
+            remaining -= log.d_capacity - offset;
+            offset     = 0;
+            continue;
+        }
+
+        const RecordHeader& record = *recordAt(d_base_p, offset);
+        if (Atomics::getInt(&record.d_state) == e_PENDING) {
+            const Location location = { offset, record.d_sequence };
+            locations->push_back(location);
+            priorities->push_back(record.d_priority);
+        }
+
+        const Uint64 size = recordSize(record.d_length);
+        remaining -= size;
+        offset     = offset + size == log.d_capacity ? 0 : offset + size;
+    }
+}
+
+// ACCESSORS
+int WriteAheadLog::read(bsl::string     *payload,
+                        int             *priority,
+                        const Location&  location) const
+{
+    BSLS_ASSERT(payload);
+    BSLS_ASSERT(priority);
+
+    if (!d_base_p) {
+        return 1;                                                     // RETURN
+    }
+
+    const LogHeader& log = *logHeader(d_base_p);
+    if (location.d_offset % 8 != 0 ||
+        location.d_offset + sizeof(RecordHeader) > log.d_capacity) {
+        return 1;                                                     // RETURN
+    }
+
+    const RecordHeader& shared = *recordAt(d_base_p, location.d_offset);
+    const char *const   data   = reinterpret_cast<const char *>(&shared + 1);
+    if (Atomics::getInt(&shared.d_state) != e_PENDING) {
+        return 2;                                                     // RETURN
+    }
+
+    // Another process may consume the record, and the space be reused, while
+    // it is read. Read each field of the header once, and check the payload
+    // that was copied rather than the one in the log.
+    RecordHeader record;
+    record.d_length   = shared.d_length;
+    record.d_sequence = shared.d_sequence;
+    record.d_priority = shared.d_priority;
+    record.d_checksum = shared.d_checksum;
+    if (record.d_sequence != location.d_sequence ||
+        location.d_offset + recordSize(record.d_length) > log.d_capacity) {
+        return 2;                                                     // RETURN
+    }
+
+    payload->assign(data, record.d_length);
+    if (record.d_checksum != checksum(record, payload->data()) ||
+        Atomics::getInt(&shared.d_state) != e_PENDING ||
+        shared.d_sequence != location.d_sequence) {
+        return 2;                                                     // RETURN
+    }
+
+    *priority = record.d_priority;
+    return 0;
+}
+
+bool WriteAheadLog::isOpen() const
+{
+    return d_base_p != 0;
+}
+
+bsls::Types::Uint64 WriteAheadLog::lastSequence() const
+{
+    return d_lastSequence.load();
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,154 @@
+#ifndef INCLUDED_IPCMQ_WRITEAHEADLOG
+#define INCLUDED_IPCMQ_WRITEAHEADLOG
+
+#include <bsl_cstddef.h>
+#include <bsl_string.h>
+#include <bsl_vector.h>
+
+#include <bslmt_mutex.h>
+
+#include <bsls_atomic.h>
+#include <bsls_types.h>
+
+namespace BloombergLP {
+namespace ipcmq {
+
+                            // ===================
+                            // class WriteAheadLog
+                            // ===================
+
+class WriteAheadLog {
+    // This class is a log of messages kept in a memory-mapped file alongside
+    // a message queue, so that messages in the queue can be recovered after
+    // the queue is lost. A sending process appends each message to the log
+    // before enqueuing a small "location" referring to it, and a receiving
+    // process reads the message from the log using the location and then
+    // marks it consumed. Messages not yet consumed are "pending", and can be
+    // found again by the sending process after a restart.
+    //
+    // The file begins with a header page holding the bounds of the log, and
+    // is followed by a ring of records, each a header holding the state,
+    // length, sequence number, priority, and checksum of a message, followed
+    // by its payload, padded to a multiple of eight bytes. A record that does
+    // not fit between the end of the last record and the end of the file is
+    // instead appended at the beginning, after a record telling the reader to
+    // skip to the beginning. Consumed records at the beginning of the log are
+    // reclaimed as records are appended. Since the file is mapped shared, a
+    // record is safe from the crash of any process as soon as it is written,
+    // and safe from the crash of the system once 'sync' returns. The
+    // checksum lets a record whose pages did not reach storage before a
+    // crash of the system be recognized and ignored.
+    //
+    // Only one process may write to a log at a time, which is enforced by
+    // locking the file. Within that process, any number of threads may
+    // append concurrently. Any number of processes may read and acknowledge.
+
+  public:
+    // PUBLIC TYPES
+    struct Location {
+        // This 'struct' identifies a record of the log.
+
+        bsls::Types::Uint64 d_offset;    // within the ring
+        bsls::Types::Uint64 d_sequence;  // of the record there
+    };
+
+    // PUBLIC CONSTANTS
+    enum { k_ENCODED_LOCATION_SIZE = 16 };
+
+  private:
+    // DATA
+    bslmt::Mutex         d_mutex;     // serializes appending
+    char                *d_base_p;    // zero unless a file is mapped
+    bsl::size_t          d_mappingLength;
+    int                  d_fd;        // -1 unless this object writes
+    bsls::AtomicUint64   d_lastSequence;
+
+    WriteAheadLog(const WriteAheadLog&);             // = delete
+    WriteAheadLog& operator=(const WriteAheadLog&);  // = delete
+
+  public:
+    // CLASS METHODS
+    static void encode(char *buffer, const Location& location);
+        // Write the specified 'location' into the 'k_ENCODED_LOCATION_SIZE'
+        // bytes at the specified 'buffer'.
+
+    static int decode(Location *location, const bslstl::StringRef& encoded);
+        // Load into the specified 'location' the location written into the
+        // specified 'encoded' by 'encode'. Return zero on success or a
+        // nonzero value if 'encoded' is not 'k_ENCODED_LOCATION_SIZE' bytes.
+
+    // CREATORS
+    WriteAheadLog();
+        // Create a 'WriteAheadLog' object that is not open.
+
+    ~WriteAheadLog();
+        // Unmap the file of this object, if any, release its lock, and
+        // destroy this object.
+
+    // MANIPULATORS
+    int openForWriting(const bsl::string& path,
+                       bsl::size_t        capacity,
+                       int                permissions);
+        // Open the log at the specified 'path' for appending, creating it
+        // with room for the specified 'capacity' bytes of records and the
+        // specified 'permissions' if it does not exist. Return zero on
+        // success or a nonzero value if the log cannot be opened or mapped,
+        // is not a log, or is already open for writing in another process.
+        // Note that 'capacity' is ignored if the log exists. The behavior is
+        // undefined unless this object is not open.
+
+    int openForReading(const bsl::string& path);
+        // Open the existing log at the specified 'path' for reading and
+        // acknowledging. Return zero on success or a nonzero value otherwise.
+        // The behavior is undefined unless this object is not open.
+
+    int append(Location                 *location,
+               const bslstl::StringRef&  payload,
+               int                       priority);
+        // Append to this log a pending record of the specified 'payload' and
+        // 'priority', and load its location into the specified 'location'.
+        // Return zero on success, 1 if there is not room in the log until
+        // more records are consumed, or 2 if the record is larger than the
+        // log. The behavior is undefined unless this object is open for
+        // writing.
+
+    int sync();
+        // Block until every record appended so far is on storage. Return zero
+        // on success or a nonzero value otherwise. The behavior is undefined
+        // unless this object is open for writing.
+
+    int acknowledge(const Location& location);
+        // Mark consumed the pending record at the specified 'location'.
+        // Return zero on success, or a nonzero value if 'location' does not
+        // refer to a pending record.
+
+    void loadPending(bsl::vector<Location> *locations,
+                     bsl::vector<int>      *priorities);
+        // Load into the specified 'locations' the location of every pending
+        // record, oldest first, and into the specified 'priorities' the
+        // priority of each. The behavior is undefined unless this object is
+        // open for writing.
+
+    // ACCESSORS
+    int read(bsl::string     *payload,
+             int             *priority,
+             const Location&  location) const;
+        // Load into the specified 'payload' and 'priority' the message of
+        // the pending record at the specified 'location'. Return zero on
+        // success, or a nonzero value if 'location' does not refer to an
+        // intact, pending record, as when the record was already consumed.
+        // Note that 'payload' may be modified even if this function fails,
+        // since the record is checked again after it is copied.
+
+    bool isOpen() const;
+        // Return whether this object has a mapped file.
+
+    bsls::Types::Uint64 lastSequence() const;
+        // Return the sequence number of the last record appended by this
+        // object, or of the last record in the log when it was opened.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
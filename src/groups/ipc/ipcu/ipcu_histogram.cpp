@@ -0,0 +1,193 @@
+
+#include <ipcu_histogram.h>
+
+#include <bdlb_bitutil.h>
+
+#include <bsl_algorithm.h>
+#include <bsl_cmath.h>
+#include <bsl_limits.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace ipcu {
+namespace {
+
+int bucketsForPrecision(int precision)
+    // Return the number of buckets needed by a histogram having the specified
+    // 'precision' to hold any value of 64 bits.
+{
+    // Values below '2 << precision' have a bucket each. Each greater power of
+    // two has '1 << precision' buckets, and the greatest is '2^63'.
+    return (65 - precision) << precision;
+}
+
+}  // close unnamed namespace
+
+                              // ---------------
+                              // class Histogram
+                              // ---------------
+
+// CREATORS
+Histogram::Histogram(bslma::Allocator *basicAllocator)
+: d_counts(bucketsForPrecision(k_DEFAULT_PRECISION), 0, basicAllocator)
+, d_precision(k_DEFAULT_PRECISION)
+, d_count(0)
+, d_min(bsl::numeric_limits<bsls::Types::Uint64>::max())
+, d_max(0)
+, d_sum(0)
+{
+}
+
+Histogram::Histogram(int precision, bslma::Allocator *basicAllocator)
+: d_counts(basicAllocator)
+, d_precision(precision)
+, d_count(0)
+, d_min(bsl::numeric_limits<bsls::Types::Uint64>::max())
+, d_max(0)
+, d_sum(0)
+{
+    BSLS_ASSERT(precision >= 0);
+    BSLS_ASSERT(precision <= 16);
+
+    d_counts.resize(bucketsForPrecision(precision));
+}
+
+Histogram::Histogram(const Histogram&  original,
+                     bslma::Allocator *basicAllocator)
+: d_counts(original.d_counts, basicAllocator)
+, d_precision(original.d_precision)
+, d_count(original.d_count)
+, d_min(original.d_min)
+, d_max(original.d_max)
+, d_sum(original.d_sum)
+{
+}
+
+// MANIPULATORS
+Histogram& Histogram::operator=(const Histogram& rhs)
+{
+    d_counts    = rhs.d_counts;
+    d_precision = rhs.d_precision;
+    d_count     = rhs.d_count;
+    d_min       = rhs.d_min;
+    d_max       = rhs.d_max;
+    d_sum       = rhs.d_sum;
+    return *this;
+}
+
+void Histogram::record(bsls::Types::Uint64 value)
+{
+    record(value, 1);
+}
+
+void Histogram::record(bsls::Types::Uint64 value, bsls::Types::Uint64 count)
+{
+    if (count == 0) {
+        return;                                                       // RETURN
+    }
+
+    d_counts[bucketIndex(value)] += count;
+    d_count += count;
+    d_min    = bsl::min(d_min, value);
+    d_max    = bsl::max(d_max, value);
+    d_sum   += double(value) * double(count);
+}
+
+void Histogram::add(const Histogram& other)
+{
+    BSLS_ASSERT(other.d_precision == d_precision);
+
+    for (bsl::size_t i = 0; i < d_counts.size(); ++i) {
+        d_counts[i] += other.d_counts[i];
+    }
+
+    d_count += other.d_count;
+    d_min    = bsl::min(d_min, other.d_min);
+    d_max    = bsl::max(d_max, other.d_max);
+    d_sum   += other.d_sum;
+}
+
+void Histogram::reset()
+{
+    bsl::fill(d_counts.begin(), d_counts.end(), 0);
+    d_count = 0;
+    d_min   = bsl::numeric_limits<bsls::Types::Uint64>::max();
+    d_max   = 0;
+    d_sum   = 0;
+}
+
+// ACCESSORS
+bsls::Types::Uint64 Histogram::percentile(double percent) const
+{
+    BSLS_ASSERT(percent >= 0);
+    BSLS_ASSERT(percent <= 100);
+
+    if (d_count == 0) {
+        return 0;                                                     // RETURN
+    }
+
+    // The rank of the value at 'percent', counting from one.
+    bsls::Types::Uint64 rank =
+        bsls::Types::Uint64(bsl::ceil(percent / 100 * double(d_count)));
+    rank = bsl::max<bsls::Types::Uint64>(rank, 1);
+
+    bsls::Types::Uint64 seen = 0;
+    for (int i = 0; i < numBuckets(); ++i) {
+        seen += d_counts[i];
+        if (seen >= rank) {
+            return bsl::min(bucketHighest(i), d_max);                 // RETURN
+        }
+    }
+
+    return d_max;
+}
+
+bsls::Types::Uint64 Histogram::bucketLowest(int index) const
+{
+    BSLS_ASSERT(index >= 0);
+    BSLS_ASSERT(index < numBuckets());
+
+    const int half = 1 << d_precision;
+    if (index < 2 * half) {
+        return index;                                                 // RETURN
+    }
+
+    // See 'bucketIndex'.
+    const int shift = index / half - 1;
+    return bsls::Types::Uint64(index - shift * half) << shift;
+}
+
+bsls::Types::Uint64 Histogram::bucketHighest(int index) const
+{
+    BSLS_ASSERT(index >= 0);
+    BSLS_ASSERT(index < numBuckets());
+
+    const int half = 1 << d_precision;
+    if (index < 2 * half) {
+        return index;                                                 // RETURN
+    }
+
+    // The highest value of the last bucket is '2^64 - 1', which the unsigned
+    // arithmetic below yields by wrapping around.
+    const int shift = index / half - 1;
+    return (bsls::Types::Uint64(index - shift * half + 1) << shift) - 1;
+}
+
+int Histogram::bucketIndex(bsls::Types::Uint64 value) const
+{
+    const int half = 1 << d_precision;
+    if (value < bsls::Types::Uint64(2 * half)) {
+        return int(value);                                            // RETURN
+    }
+
+    // Shift 'value' right until only its 'd_precision + 1' most significant
+    // bits remain, which are at least 'half' and less than '2 * half'. Each
+    // shift has its own 'half' buckets, following those of the shift before.
+    const int highestBit = 63 - bdlb::BitUtil::numLeadingUnsetBits(value);
+    const int shift      = highestBit - d_precision;
+    return shift * half + int(value >> shift);
+}
+
+}  // close package namespace
+}  // close enterprise namespace
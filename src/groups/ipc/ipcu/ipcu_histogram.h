@@ -0,0 +1,177 @@
+#ifndef INCLUDED_IPCU_HISTOGRAM
+#define INCLUDED_IPCU_HISTOGRAM
+
+#include <bslma_usesbslmaallocator.h>
+
+#include <bslmf_nestedtraitdeclaration.h>
+
+#include <bsls_types.h>
+
+#include <bsl_vector.h>
+
+namespace BloombergLP {
+namespace bslma { class Allocator; }
+namespace ipcu {
+
+                              // ===============
+                              // class Histogram
+                              // ===============
+
+class Histogram {
+    // This class counts values, such as latencies in nanoseconds, in buckets
+    // whose width grows with the magnitude of the values they hold, in the
+    // manner of an HDR histogram. Each power of two is divided into
+    // '2^precision' equal buckets, so that every value is known to within a
+    // relative error of '2^-precision', and any value of 64 bits can be
+    // recorded in constant time and in a fixed amount of memory. Percentiles
+    // are reported as the largest value in the bucket at that percentile, so
+    // they are never less than the true value.
+
+    // DATA
+    bsl::vector<bsls::Types::Uint64> d_counts;     // indexed by bucket
+    int                              d_precision;
+    bsls::Types::Uint64              d_count;
+    bsls::Types::Uint64              d_min;
+    bsls::Types::Uint64              d_max;
+    double                           d_sum;
+
+  public:
+    // TRAITS
+    BSLMF_NESTED_TRAIT_DECLARATION(Histogram, bslma::UsesBslmaAllocator);
+
+    // PUBLIC CONSTANTS
+    static const int k_DEFAULT_PRECISION = 7;
+
+    // CREATORS
+    explicit Histogram(bslma::Allocator *basicAllocator = 0);
+    explicit Histogram(int precision, bslma::Allocator *basicAllocator = 0);
+        // Create a 'Histogram' having no values. Optionally specify a
+        // 'precision', which is the number of bits of each value that are
+        // kept. If 'precision' is not specified, 'k_DEFAULT_PRECISION' is
+        // used. Optionally specify a 'basicAllocator' used to supply memory.
+        // The behavior is undefined unless '0 <= precision <= 16'.
+
+    Histogram(const Histogram&  original,
+              bslma::Allocator *basicAllocator = 0);
+        // Create a 'Histogram' having the same values and precision as the
+        // specified 'original'. Optionally specify a 'basicAllocator' used to
+        // supply memory.
+
+    // MANIPULATORS
+    Histogram& operator=(const Histogram& rhs);
+        // Make this histogram have the same values and precision as the
+        // specified 'rhs', and return a reference to this histogram.
+
+    void record(bsls::Types::Uint64 value);
+    void record(bsls::Types::Uint64 value, bsls::Types::Uint64 count);
+        // Add the specified 'value' to this histogram, or add it the
+        // optionally specified 'count' times.
+
+    void add(const Histogram& other);
+        // Add every value of the specified 'other' histogram to this
+        // histogram. The behavior is undefined unless 'other' has the same
+        // precision as this histogram.
+
+    void reset();
+        // Remove every value from this histogram.
+
+    // ACCESSORS
+    bsls::Types::Uint64 count() const;
+        // Return the number of values in this histogram.
+
+    bsls::Types::Uint64 min() const;
+        // Return the least value in this histogram, or zero if it is empty.
+
+    bsls::Types::Uint64 max() const;
+        // Return the greatest value in this histogram, or zero if it is empty.
+
+    double mean() const;
+        // Return the mean of the values in this histogram, or zero if it is
+        // empty.
+
+    bsls::Types::Uint64 percentile(double percent) const;
+        // Return the value at the specified 'percent' of this histogram,
+        // which is the largest value in the bucket containing the least value
+        // that is not less than 'percent' percent of the values, limited to
+        // 'max()'. Return zero if this histogram is empty. The behavior is
+        // undefined unless '0 <= percent <= 100'.
+
+    int precision() const;
+        // Return the number of bits of each value that this histogram keeps.
+
+    int numBuckets() const;
+        // Return the number of buckets in this histogram.
+
+    bsls::Types::Uint64 bucketCount(int index) const;
+        // Return the number of values in the bucket at the specified 'index'.
+        // The behavior is undefined unless '0 <= index < numBuckets()'.
+
+    bsls::Types::Uint64 bucketLowest(int index) const;
+        // Return the least value in the bucket at the specified 'index'. The
+        // behavior is undefined unless '0 <= index < numBuckets()'.
+
+    bsls::Types::Uint64 bucketHighest(int index) const;
+        // Return the greatest value in the bucket at the specified 'index'.
+        // The behavior is undefined unless '0 <= index < numBuckets()'.
+
+  private:
+    // PRIVATE ACCESSORS
+    int bucketIndex(bsls::Types::Uint64 value) const;
+        // Return the index of the bucket containing the specified 'value'.
+};
+
+// ============================================================================
+//                 INLINE DEFINITIONS
+// ============================================================================
+
+                              // ---------------
+                              // class Histogram
+                              // ---------------
+
+// ACCESSORS
+inline
+bsls::Types::Uint64 Histogram::count() const
+{
+    return d_count;
+}
+
+inline
+bsls::Types::Uint64 Histogram::min() const
+{
+    return d_count ? d_min : 0;
+}
+
+inline
+bsls::Types::Uint64 Histogram::max() const
+{
+    return d_max;
+}
+
+inline
+double Histogram::mean() const
+{
+    return d_count ? d_sum / double(d_count) : 0;
+}
+
+inline
+int Histogram::precision() const
+{
+    return d_precision;
+}
+
+inline
+int Histogram::numBuckets() const
+{
+    return int(d_counts.size());
+}
+
+inline
+bsls::Types::Uint64 Histogram::bucketCount(int index) const
+{
+    return d_counts[index];
+}
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif
@@ -0,0 +1,306 @@
+
+#include <ipcu_lzutil.h>
+
+#include <bsl_cstring.h>
+
+#include <bsls_assert.h>
+
+namespace BloombergLP {
+namespace ipcu {
+namespace {
+
+// A match is at least this long.
+const bsl::size_t k_MIN_MATCH = 4;
+
+// The last bytes of the input are always literals, so that the match finder
+// can read four bytes at any position it considers.
+const bsl::size_t k_LAST_LITERALS = 5;
+
+// Matches refer back no further than this.
+const bsl::size_t k_MAX_OFFSET = 65535;
+
+// The hash table has '1 << k_HASH_BITS' entries.
+const int k_HASH_BITS = 12;
+
+// Each attempt to find a match advances by one more byte for every
+// '1 << k_SKIP_SHIFT' bytes since the last match, so that input that does
+// not compress is skipped over quickly.
+const int k_SKIP_SHIFT = 6;
+
+unsigned read32(const char *bytes)
+{
+    unsigned value;
+    bsl::memcpy(&value, bytes, sizeof value);
+    return value;
+}
+
+unsigned hash(unsigned sequence)
+{
+    // Multiply by a prime close to 2^32 divided by the golden ratio, and keep
+    // the high bits, which depend on every byte of 'sequence'.
+    return (sequence * 2654435761U) >> (32 - k_HASH_BITS);
+}
+
+class Writer {
+    // This class writes bytes to an output buffer, remembering whether any
+    // write did not fit.
+
+    // DATA
+    char        *d_output_p;
+    bsl::size_t  d_capacity;
+    bsl::size_t  d_length;
+    bool         d_overflowed;
+
+  public:
+    // CREATORS
+    Writer(char *output, bsl::size_t capacity)
+    : d_output_p(output)
+    , d_capacity(capacity)
+    , d_length(0)
+    , d_overflowed(false)
+    {
+    }
+
+    // MANIPULATORS
+    bool writeSequence(const char  *literals,
+                       bsl::size_t  numLiterals,
+                       bsl::size_t  offset,
+                       bsl::size_t  matchLength)
+        // Write a sequence having the specified 'numLiterals' bytes beginning
+        // at the specified 'literals' followed by a match of the specified
+        // 'matchLength' at the specified 'offset'. If 'matchLength' is zero,
+        // write the last sequence, which has no match. Return 'false' if the
+        // sequence does not fit, and 'true' otherwise.
+    {
+        const bsl::size_t extraMatch = matchLength ? matchLength - k_MIN_MATCH
+                                                   : 0;
+
+        // Make sure that the longest possible encoding of the sequence fits,
+        // so that the writes below need not check.
+        const bsl::size_t worstCase = 1 + numLiterals / 255 + 1 +
+                                      numLiterals + 2 + extraMatch / 255 + 1;
+        if (d_capacity - d_length < worstCase) {
+            d_overflowed = true;
+            return false;                                             // RETURN
+        }
+
+        char *const token = d_output_p + d_length++;
+        *token = char((numLiterals < 15 ? numLiterals : 15) << 4);
+        if (numLiterals >= 15) {
+            writeLength(numLiterals - 15);
+        }
+
+        bsl::memcpy(d_output_p + d_length, literals, numLiterals);
+        d_length += numLiterals;
+
+        if (matchLength == 0) {
+            return true;                                              // RETURN
+        }
+
+        d_output_p[d_length++] = char(offset & 0xFF);
+        d_output_p[d_length++] = char(offset >> 8);
+
+        *token |= char(extraMatch < 15 ? extraMatch : 15);
+        if (extraMatch >= 15) {
+            writeLength(extraMatch - 15);
+        }
+
+        return true;
+    }
+
+    void writeLength(bsl::size_t remainder)
+        // Write the continuation bytes of a length whose token nibble is 15
+        // and which exceeds 15 by the specified 'remainder'.
+    {
+        while (remainder >= 255) {
+            d_output_p[d_length++] = char(255);
+            remainder -= 255;
+        }
+        d_output_p[d_length++] = char(remainder);
+    }
+
+    // ACCESSORS
+    bsl::size_t length() const
+    {
+        return d_overflowed ? 0 : d_length;
+    }
+};
+
+int readLength(bsl::size_t *length, const char **cursor, const char *end)
+    // Add to the specified 'length' the continuation bytes of a length
+    // beginning at the specified 'cursor', and advance 'cursor' past them.
+    // Return zero on success or a nonzero value if the specified 'end' is
+    // reached first.
+{
+    unsigned char byte;
+    do {
+        if (*cursor == end) {
+            return 1;                                                 // RETURN
+        }
+        byte = static_cast<unsigned char>(*(*cursor)++);
+        *length += byte;
+    } while (byte == 255);
+
+    return 0;
+}
+
+}  // close unnamed namespace
+
+                                 // -------------
+                                 // struct LzUtil
+                                 // -------------
+
+// CLASS METHODS
+bsl::size_t LzUtil::maxCompressedLength(bsl::size_t length)
+{
+    return length + length / 255 + 16;
+}
+
+bsl::size_t LzUtil::minCompressedLength(bsl::size_t length)
+{
+    // Each continuation byte of a match length covers 255 bytes of input.
+    return length / 255;
+}
+
+bsl::size_t LzUtil::compress(char        *output,
+                             bsl::size_t  capacity,
+                             const char  *input,
+                             bsl::size_t  length)
+{
+    BSLS_ASSERT(output || capacity == 0);
+    BSLS_ASSERT(input || length == 0);
+
+    Writer writer(output, capacity);
+
+    // Each entry is one more than the position of the last sequence of four
+    // bytes having the entry's hash, or zero if there is none.
+    bsl::size_t table[1 << k_HASH_BITS] = {};
+
+    bsl::size_t anchor = 0;  // beginning of the pending literals
+    bsl::size_t position = 0;
+    if (length > k_MIN_MATCH + k_LAST_LITERALS) {
+        const bsl::size_t limit = length - k_LAST_LITERALS - k_MIN_MATCH;
+        while (position <= limit) {
+            const unsigned    sequence  = read32(input + position);
+            bsl::size_t&      entry     = table[hash(sequence)];
+            const bsl::size_t candidate = entry;
+            entry = position + 1;
+
+            if (candidate == 0 || position - (candidate - 1) > k_MAX_OFFSET ||
+                read32(input + candidate - 1) != sequence) {
+                position += 1 + ((position - anchor) >> k_SKIP_SHIFT);
+                continue;
+            }
+
+            // Extend the match as far as it goes, stopping short of the last
+            // literals.
+            const bsl::size_t match       = candidate - 1;
+            const bsl::size_t matchLimit  = length - k_LAST_LITERALS;
+            bsl::size_t       matchLength = k_MIN_MATCH;
+            while (position + matchLength < matchLimit &&
+                   input[match + matchLength] ==
+                       input[position + matchLength]) {
+                ++matchLength;
+            }
+
+            if (!writer.writeSequence(input + anchor,
+                                      position - anchor,
+                                      position - match,
+                                      matchLength)) {
+                return 0;                                             // RETURN
+            }
+
+            position += matchLength;
+            anchor = position;
+        }
+    }
+
+    writer.writeSequence(input + anchor, length - anchor, 0, 0);
+    return writer.length();
+}
+
+int LzUtil::decompress(bsl::size_t *decompressedLength,
+                       char        *output,
+                       bsl::size_t  capacity,
+                       const char  *input,
+                       bsl::size_t  length)
+{
+    BSLS_ASSERT(decompressedLength);
+    BSLS_ASSERT(output || capacity == 0);
+    BSLS_ASSERT(input || length == 0);
+
+    const char  *cursor  = input;
+    const char  *end     = input + length;
+    bsl::size_t  written = 0;
+
+    while (cursor != end) {
+        const unsigned char token = static_cast<unsigned char>(*cursor++);
+
+        bsl::size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && readLength(&numLiterals, &cursor, end)) {
+            return 1;                                                 // RETURN
+        }
+
+        if (bsl::size_t(end - cursor) < numLiterals ||
+            capacity - written < numLiterals) {
+            return 2;                                                 // RETURN
+        }
+
+        bsl::memcpy(output + written, cursor, numLiterals);
+        cursor += numLiterals;
+        written += numLiterals;
+
+        if (cursor == end) {
+            // That was the last sequence.
+            break;
+        }
+
+        if (end - cursor < 2) {
+            return 3;                                                 // RETURN
+        }
+
+        const bsl::size_t offset = static_cast<unsigned char>(cursor[0]) |
+                                   static_cast<unsigned char>(cursor[1]) << 8;
+        cursor += 2;
+        if (offset == 0 || offset > written) {
+            return 4;                                                 // RETURN
+        }
+
+        bsl::size_t matchLength = token & 15;
+        if (matchLength == 15 && readLength(&matchLength, &cursor, end)) {
+            return 5;                                                 // RETURN
+        }
+        matchLength += k_MIN_MATCH;
+
+        if (capacity - written < matchLength) {
+            return 6;                                                 // RETURN
+        }
+
+        const char *source = output + written - offset;
+        char       *target = output + written;
+        if (offset >= matchLength) {
+            bsl::memcpy(target, source, matchLength);
+        }
+        else {
+            // The match overlaps the bytes it produces, as in a run, so it
+            // repeats with a period of 'offset'. Copy whole periods from its
+            // beginning, each copy doubling what is available to the next.
+            bsl::size_t copied = 0;
+            while (copied < matchLength) {
+                const bsl::size_t remaining = matchLength - copied;
+                const bsl::size_t chunk     = offset + copied < remaining
+                                                  ? offset + copied
+                                                  : remaining;
+                bsl::memcpy(target + copied, source, chunk);
+                copied += chunk;
+            }
+        }
+        written += matchLength;
+    }
+
+    *decompressedLength = written;
+    return 0;
+}
+
+}  // close package namespace
+}  // close enterprise namespace
@@ -0,0 +1,69 @@
+#ifndef INCLUDED_IPCU_LZUTIL
+#define INCLUDED_IPCU_LZUTIL
+
+#include <bsl_cstddef.h>
+
+namespace BloombergLP {
+namespace ipcu {
+
+                                 // =============
+                                 // struct LzUtil
+                                 // =============
+
+struct LzUtil {
+    // This 'struct' provides a namespace for functions that compress and
+    // decompress blocks of bytes using a fast member of the LZ77 family of
+    // algorithms, in the manner of LZ4. Compression replaces repeated
+    // sequences of four or more bytes with references to their previous
+    // occurrence within the preceding 64 KiB, found using a small hash table,
+    // and so favors speed over compression ratio.
+    //
+    // A compressed block is a sequence of "sequences." Each sequence is a
+    // token byte, whose high four bits are the number of literal bytes and
+    // whose low four bits are the length of the match minus four, followed by
+    // any further bytes of the literal length, the literal bytes, a two byte
+    // little-endian offset of the match, and any further bytes of the match
+    // length. A length of fifteen in either half of the token is continued in
+    // following bytes, each of which is added to it, until a byte other than
+    // 255. The last sequence has only literals.
+
+    // CLASS METHODS
+    static bsl::size_t maxCompressedLength(bsl::size_t length);
+        // Return the largest number of bytes that compressing the specified
+        // 'length' bytes can produce.
+
+    static bsl::size_t minCompressedLength(bsl::size_t length);
+        // Return the smallest number of bytes that compressing the specified
+        // 'length' bytes can produce.
+
+    static bsl::size_t compress(char        *output,
+                                bsl::size_t  capacity,
+                                const char  *input,
+                                bsl::size_t  length);
+        // Compress the specified 'length' bytes beginning at the specified
+        // 'input' into the specified 'output', which has room for the
+        // specified 'capacity' bytes. Return the number of bytes written to
+        // 'output', or return zero if the compressed bytes would not fit in
+        // 'capacity'. Note that compression stops as soon as it is known not
+        // to fit, so a small 'capacity' bounds the time spent on input that
+        // does not compress well.
+
+    static int decompress(bsl::size_t *decompressedLength,
+                          char        *output,
+                          bsl::size_t  capacity,
+                          const char  *input,
+                          bsl::size_t  length);
+        // Decompress the specified 'length' bytes beginning at the specified
+        // 'input', which were produced by 'compress', into the specified
+        // 'output', which has room for the specified 'capacity' bytes, and
+        // load the number of bytes written into the specified
+        // 'decompressedLength'. Return zero on success or a nonzero value if
+        // 'input' is not a valid compressed block or does not decompress into
+        // 'capacity' bytes. Note that no byte is read outside of 'input' nor
+        // written outside of 'output', whatever the contents of 'input'.
+};
+
+}  // close package namespace
+}  // close enterprise namespace
+
+#endif